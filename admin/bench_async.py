@@ -0,0 +1,47 @@
+#!/usr/bin/env python
+'''
+Compares throughput of an sfspike | sfbandpass | sfwindow pipe with and
+without asynchronous read-ahead/write-behind (--async=y).
+
+Usage:
+    ./admin/bench_async.py [n1=2000] [n2=20000] [repeat=3]
+'''
+# Copyright (C) 2026 University of Texas at Austin
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+from __future__ import print_function
+import sys
+from benchutil import params, scratch, best
+
+def main(argv):
+    par = params(argv,{'n1':2000, 'n2':20000, 'repeat':3})
+    mb = par['n1']*par['n2']*4.0/(1<<20)
+
+    print('sfspike n1=%(n1)d n2=%(n2)d | sfbandpass | sfwindow' % par,
+          '(%.1f MB per stage)' % mb)
+
+    with scratch() as tmp:
+        for flag in 'ny':
+            flow = ('sfspike n1=%d n2=%d k1=100 --async=%s < /dev/null | '
+                    'sfbandpass flo=5 fhi=60 --async=%s | '
+                    'sfwindow j1=2 --async=%s > out.rsf' %
+                    (par['n1'],par['n2'],flag,flag,flag))
+            t = best(flow,par['repeat'],tmp)
+            print('async=%s: best of %d: %.3f s, %.1f MB/s' %
+                  (flag,par['repeat'],t,mb/t))
+
+if __name__ == '__main__':
+    main(sys.argv)
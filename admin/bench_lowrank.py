@@ -0,0 +1,80 @@
+#!/usr/bin/env python
+'''
+Times the lowrank decomposition of the isotropic wave extrapolation
+symbol with sfisolr2 (or sfisolr3 for a 3-D model), comparing the
+original algorithm (rand=n) with threaded blocked sampling and
+randomized rank detection (rand=y). Reports time, rank and the
+relative error estimated on random samples of the symbol.
+
+Without vel=, a smooth 2-D model with a Gaussian anomaly is used.
+For the gallery models, pass their velocity files, for example
+vel=book/data/marmousi/... after fetching them.
+
+Usage:
+    ./admin/bench_lowrank.py [vel=model.rsf] [n1=800] [n2=1000]
+                             [dt=0.002] [npk=50] [eps=1e-5]
+                             [seed=2012] [repeat=1]
+'''
+# Copyright (C) 2026 University of Texas at Austin
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+from __future__ import print_function
+import os, sys, subprocess
+from benchutil import params, scratch, run, best
+
+def main(argv):
+    par = params(argv,{'vel':None, 'n1':800, 'n2':1000, 'dt':0.002,
+                       'npk':50, 'eps':1e-5, 'seed':2012, 'repeat':1},
+                 ('vel',))
+
+    with scratch() as tmp:
+        def get(rsf,key,default=None):
+            out = subprocess.check_output('sfget parform=n %s < %s' %
+                                          (key,rsf),shell=True,cwd=tmp,
+                                          stderr=open(os.devnull,'w')).split()
+            return out and int(out[0]) or default
+
+        if par['vel']:
+            run('sfcp < %s > vel.rsf' % par['vel'],tmp)
+        else:
+            run('sfmath n1=%(n1)d n2=%(n2)d d1=5 d2=5 < /dev/null '
+                'output="1500+1.5*x1+1500*exp(-((x1-2000)^2+(x2-2500)^2)/4e5)" '
+                '> vel.rsf' % par,tmp)
+        if get('vel.rsf','n3',1) > 1:
+            prog = 'sfisolr3'
+            run('sffft1 < vel.rsf | sffft3 axis=2 pad=1 | '
+                'sffft3 axis=3 pad=1 | sfreal > fft.rsf',tmp)
+        else:
+            prog = 'sfisolr2'
+            run('sffft1 < vel.rsf | sffft3 axis=2 pad=1 | sfreal > fft.rsf',
+                tmp)
+
+        print('%s, model %d samples, dt=%g npk=%d eps=%g, best of %d' %
+              (prog,get('vel.rsf','n1')*get('vel.rsf','n2')*get('vel.rsf','n3',1),
+               par['dt'],par['npk'],par['eps'],par['repeat']))
+
+        for rand in ('n','y'):
+            t = best('%s < vel.rsf fft=fft.rsf dt=%g npk=%d eps=%g seed=%d '
+                     'rand=%s left=left.rsf > right.rsf' %
+                     (prog,par['dt'],par['npk'],par['eps'],par['seed'],rand),
+                     par['repeat'],tmp,'log')
+            err = [line.split()[-1] for line in open(os.path.join(tmp,'log'))
+                   if line.startswith('rel err')]
+            print('rand=%s  %8.3f s  rank %d  rel err %s' %
+                  (rand,t,get('left.rsf','n2'),err and err[-1] or '?'))
+
+if __name__ == '__main__':
+    main(sys.argv)
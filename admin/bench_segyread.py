@@ -0,0 +1,62 @@
+#!/usr/bin/env python
+'''
+Compares SEG-Y ingest speed of sfsegyread trace by trace (bulk=0) and
+with bulk reads, and checks that both give identical output.
+
+Usage:
+    ./admin/bench_segyread.py [ns=1500] [ntr=50000] [format=1] [repeat=3]
+'''
+# Copyright (C) 2026 University of Texas at Austin
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+from __future__ import print_function
+import os, sys, filecmp
+from benchutil import params, scratch, run, best, binary
+
+def main(argv):
+    par = params(argv,{'ns':1500, 'ntr':50000, 'format':1, 'repeat':3})
+    mb = par['ntr']*(240+4*par['ns'])/float(1<<20)
+
+    with scratch() as tmp:
+        tape = os.path.join(tmp,'data.segy')
+        run('sfspike n1=%(ns)d n2=%(ntr)d d1=0.002 < /dev/null | '
+            'sfnoise seed=2026 > data.rsf' % par,tmp)
+        run('sfsegyheader < data.rsf > tfile.rsf',tmp)
+        run('sfsegywrite < data.rsf tfile=tfile.rsf format=%d tape=%s' %
+            (par['format'],tape),tmp)
+
+        print('SEG-Y format=%(format)d ns=%(ns)d ntr=%(ntr)d' % par,
+              '(%.1f MB)' % mb)
+
+        outs = []
+        for bulk in ('bulk=0',''):
+            out = 'out%d.rsf' % len(outs)
+            hdr = 'hdr%d.rsf' % len(outs)
+            t = best('sfsegyread tape=%s %s tfile=%s > %s' %
+                     (tape,bulk,hdr,out),par['repeat'],tmp)
+            print('%-8s best of %d: %.3f s, %.0f traces/s, %.1f MB/s' %
+                  (bulk or 'bulk', par['repeat'],t,par['ntr']/t,mb/t))
+            outs.append((out,hdr))
+
+        for k in (0,1):
+            same = filecmp.cmp(binary(os.path.join(tmp,outs[0][k])),
+                               binary(os.path.join(tmp,outs[1][k])),
+                               shallow=False)
+            print('%s: %s' % (('traces','headers')[k],
+                              same and 'identical' or 'DIFFERENT'))
+
+if __name__ == '__main__':
+    main(sys.argv)
@@ -0,0 +1,66 @@
+#!/usr/bin/env python
+'''
+Times triangle smoothing of a 3-D cube along each axis with sfsmooth
+and, optionally, compares with another sfsmooth executable (for
+example one built from an older tree) for speed and identical output.
+
+Smoothing along the slow axes is done in panels of adjacent lines, so
+its cost per sample should be close to that along the fast axis.
+
+Usage:
+    ./admin/bench_smooth.py [n1=200] [n2=200] [n3=200] [rect=5]
+                            [repeat=3] [ref=/path/to/old/sfsmooth]
+'''
+# Copyright (C) 2026 University of Texas at Austin
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+from __future__ import print_function
+import os, sys, filecmp
+from benchutil import params, scratch, run, best, binary
+
+def main(argv):
+    par = params(argv,{'n1':200, 'n2':200, 'n3':200, 'rect':5,
+                       'repeat':3, 'ref':None},('ref',))
+    size = par['n1']*par['n2']*par['n3']
+
+    progs = [('sfsmooth','sfsmooth')]
+    if par['ref']:
+        progs.append(('ref',par['ref']))
+
+    with scratch() as tmp:
+        run('sfspike n1=%(n1)d n2=%(n2)d n3=%(n3)d < /dev/null | '
+            'sfnoise seed=2026 > cube.rsf' % par,tmp)
+        print('cube %(n1)dx%(n2)dx%(n3)d, rect=%(rect)d' % par,
+              '(%.1f MB), best of %d' % (4.0*size/(1<<20),par['repeat']))
+
+        for rect in ('rect1','rect2','rect3','rect1 rect2 rect3'):
+            args = ' '.join(['%s=%d' % (r,par['rect']) for r in rect.split()])
+            line = '%-18s' % args
+            outs = []
+            for name, prog in progs:
+                out = '%s.rsf' % name
+                t = best('%s < cube.rsf %s > %s' % (prog,args,out),
+                         par['repeat'],tmp)
+                line += '  %s %.3f s (%.0f Msamples/s)' % \
+                    (name,t,1.0e-6*size*len(rect.split())/t)
+                outs.append(binary(os.path.join(tmp,out)))
+            if len(outs) > 1:
+                line += filecmp.cmp(outs[0],outs[1],shallow=False) and \
+                    '  identical' or '  DIFFERENT'
+            print(line)
+
+if __name__ == '__main__':
+    main(sys.argv)
@@ -0,0 +1,56 @@
+#!/usr/bin/env python
+'''
+Measures sftransp throughput on a synthetic 4-D cube for several planes,
+in core and out of core. A small memsize= emulates a cube larger than the
+available RAM. Each result is checked by transposing back.
+
+Usage:
+    ./admin/bench_transp.py [n1=100] [n2=200] [n3=100] [n4=10] [memsize=8] [repeat=3]
+'''
+# Copyright (C) 2026 University of Texas at Austin
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+from __future__ import print_function
+import os, sys
+from benchutil import params, scratch, run, best
+
+def main(argv):
+    par = params(argv,{'n1':100, 'n2':200, 'n3':100, 'n4':10,
+                       'memsize':8, 'repeat':3})
+    mb = par['n1']*par['n2']*par['n3']*par['n4']*4.0/(1<<20)
+
+    with scratch() as tmp:
+        run('sfmath n1=%(n1)d n2=%(n2)d n3=%(n3)d n4=%(n4)d '
+            'output="x1+1000*x2+x3/1000+x4" < /dev/null > cube.rsf' % par,tmp)
+        print('%(n1)dx%(n2)dx%(n3)dx%(n4)d cube' % par,'(%.1f MB)' % mb)
+
+        for plane in (12,13,23,34,14):
+            for mem in ('', 'memsize=%d' % par['memsize']):
+                t = best('sftransp plane=%d %s < cube.rsf > out.rsf '
+                         '2> /dev/null' % (plane,mem),par['repeat'],tmp)
+                run('sftransp plane=%d %s < out.rsf > back.rsf 2> /dev/null' %
+                    (plane,mem),tmp)
+                run('sfmath x=cube.rsf y=back.rsf output="abs(x-y)" '
+                    '< /dev/null | sfattr want=max > max.txt',tmp)
+                with open(os.path.join(tmp,'max.txt')) as f:
+                    ok = 0 == float(f.read().split('=')[1].split()[0])
+                run('sfrm out.rsf back.rsf',tmp)
+                print('plane=%d %-12s best of %d: %.3f s, %7.1f MB/s %s' %
+                      (plane,mem or 'in core',par['repeat'],t,mb/t,
+                       'ok' if ok else 'MISMATCH'))
+
+if __name__ == '__main__':
+    main(sys.argv)
@@ -0,0 +1,70 @@
+'''
+Helpers shared by the admin/bench_*.py timing scripts: key=value
+arguments, a scratch DATAPATH, running flows and timing them.
+'''
+# Copyright (C) 2026 University of Texas at Austin
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+import os, sys, time, shutil, tempfile, subprocess, contextlib
+
+def params(argv,par,paths=()):
+    '''key=value arguments over the defaults in par: keys in paths
+    are made absolute, others take the type of their default'''
+    for arg in argv[1:]:
+        key, val = arg.split('=')
+        if key in paths:
+            par[key] = os.path.abspath(val)
+        elif isinstance(par.get(key),float):
+            par[key] = float(val)
+        else:
+            par[key] = int(val)
+    return par
+
+@contextlib.contextmanager
+def scratch():
+    'temporary directory, also used as DATAPATH'
+    tmp = tempfile.mkdtemp()
+    os.environ['DATAPATH'] = tmp + '/'
+    try:
+        yield tmp
+    finally:
+        shutil.rmtree(tmp)
+
+def run(cmd,cwd=None,log=None):
+    'run a shell command, stop on failure'
+    err = log and open(os.path.join(cwd or '.',log),'w') or None
+    if subprocess.call(cmd,shell=True,cwd=cwd,stderr=err):
+        sys.exit('%s failed' % cmd)
+
+def best(cmd,repeat,cwd=None,log=None):
+    'shortest wall time of repeat runs'
+    t = None
+    for i in range(repeat):
+        start = time.time()
+        run(cmd,cwd,log)
+        dt = time.time() - start
+        if t is None or dt < t:
+            t = dt
+    return t
+
+def binary(rsf):
+    'data file of an RSF header'
+    path = None
+    for line in open(rsf):
+        line = line.strip()
+        if line.startswith('in='):
+            path = line[3:].strip('"')
+    return path
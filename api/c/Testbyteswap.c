@@ -0,0 +1,122 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <rpc/types.h>
+#include <rpc/xdr.h>
+
+#include "byteswap.h"
+#include "timer.h"
+
+/* Check the XDR byte swap against xdr_vector and report throughput in
+   GB/s for float, int, and complex data in native and XDR form. */
+
+#define N (1<<22) /* 4-byte words per pass */
+#define NREP 20
+
+static double gbs(sf_timer timer, size_t bytes)
+{
+    return bytes*(double) NREP/(1.0e6*sf_timer_get_total_time(timer));
+}
+
+int main(void)
+{
+    int i, k;
+    unsigned int *in, *out, *ref;
+    const char *type[] = {"float","int","complex"};
+    xdrproc_t proc[] = {(xdrproc_t) xdr_float,
+			(xdrproc_t) xdr_int,
+			(xdrproc_t) xdr_float};
+    size_t bytes;
+    XDR xdr;
+    sf_timer timer;
+
+    in  = (unsigned int*) malloc(N*sizeof(unsigned int));
+    out = (unsigned int*) malloc(N*sizeof(unsigned int));
+    ref = (unsigned int*) malloc(N*sizeof(unsigned int));
+
+    for (i=0; i < N; i++) {
+	in[i] = 2654435761u*(unsigned int) i;
+    }
+    bytes = N*sizeof(unsigned int);
+
+    printf("host is %s-endian\n",sf_bigendian()? "big":"little");
+
+    /* correctness: decode with xdr_vector */
+    xdrmem_create(&xdr,(char*) in,bytes,XDR_DECODE);
+    if (!xdr_vector(&xdr,(char*) ref,N,sizeof(float),(xdrproc_t) xdr_float)) {
+	fprintf(stderr,"xdr_vector failed\n");
+	exit(1);
+    }
+    xdr_destroy(&xdr);
+
+    if (sf_bigendian()) {
+	memcpy(out,in,bytes);
+    } else {
+	sf_byteswap4(in,out,N);
+    }
+    if (0 != memcmp(out,ref,bytes)) {
+	fprintf(stderr,"byte swap does not match xdr_vector\n");
+	exit(1);
+    }
+
+    /* odd lengths exercise the scalar remainder */
+    memcpy(out,in,bytes);
+    sf_byteswap4(out,out,N-3);
+    sf_byteswap4(out,out,N-3);
+    if (0 != memcmp(out,in,bytes)) {
+	fprintf(stderr,"in-place byte swap is not an involution\n");
+	exit(1);
+    }
+
+    printf("%-8s %10s %10s %10s %10s\n",
+	   "type","native","xdr_vector","swap","swap-copy");
+
+    for (k=0; k < 3; k++) {
+	printf("%-8s",type[k]);
+
+	timer = sf_timer_init();
+	for (i=0; i < NREP; i++) {
+	    sf_timer_start(timer);
+	    memcpy(out,in,bytes);
+	    sf_timer_stop(timer);
+	}
+	printf(" %10.2f",gbs(timer,bytes));
+	sf_timer_close(timer);
+
+	timer = sf_timer_init();
+	for (i=0; i < NREP; i++) {
+	    sf_timer_start(timer);
+	    xdrmem_create(&xdr,(char*) in,bytes,XDR_DECODE);
+	    (void) xdr_vector(&xdr,(char*) out,N,4,proc[k]);
+	    xdr_destroy(&xdr);
+	    sf_timer_stop(timer);
+	}
+	printf(" %10.2f",gbs(timer,bytes));
+	sf_timer_close(timer);
+
+	timer = sf_timer_init();
+	for (i=0; i < NREP; i++) {
+	    sf_timer_start(timer);
+	    sf_byteswap4(out,out,N);
+	    sf_timer_stop(timer);
+	}
+	printf(" %10.2f",gbs(timer,bytes));
+	sf_timer_close(timer);
+
+	timer = sf_timer_init();
+	for (i=0; i < NREP; i++) {
+	    sf_timer_start(timer);
+	    sf_byteswap4(in,out,N);
+	    sf_timer_stop(timer);
+	}
+	printf(" %10.2f\n",gbs(timer,bytes));
+	sf_timer_close(timer);
+    }
+
+    free(in);
+    free(out);
+    free(ref);
+
+    exit(0);
+}
@@ -0,0 +1,88 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "divn.h"
+#include "helix.h"
+#include "helicon.h"
+#include "polydiv.h"
+#include "alloc.h"
+
+#define NP 4 /* panels */
+
+/* Reentrant operators: panels processed in parallel with their own
+   handles must give exactly the results of the global-state API. */
+
+int main(void) {
+    int nbox[]={5,3}, ndat[]={100,40}, n12, ip, i;
+    float *num[NP], *den[NP], *rat[NP], *ref[NP], *x, *y, *z;
+    sf_divnsolver dv[NP];
+    sf_polydiv pd;
+    sf_filter aa;
+
+    n12 = ndat[0]*ndat[1];
+    for (ip=0; ip < NP; ip++) {
+	num[ip] = sf_floatalloc(n12);
+	den[ip] = sf_floatalloc(n12);
+	rat[ip] = sf_floatalloc(n12);
+	ref[ip] = sf_floatalloc(n12);
+	for (i=0; i < n12; i++) {
+	    den[ip][i] = 1.0f+0.5f*sinf(0.01f*(ip+1)*i);
+	    num[ip][i] = cosf(0.003f*i)*den[ip][i];
+	}
+    }
+
+    /* global state, one panel at a time */
+    sf_divn_init(2, n12, ndat, nbox, 20, false);
+    for (ip=0; ip < NP; ip++) {
+	sf_divn(num[ip],den[ip],ref[ip]);
+    }
+    sf_divn_close();
+
+    /* handles, panels in parallel */
+    for (ip=0; ip < NP; ip++) {
+	dv[ip] = sf_divn_init_r(2, n12, ndat, nbox, 20, false);
+    }
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+    for (ip=0; ip < NP; ip++) {
+	sf_divn_r(dv[ip],num[ip],den[ip],rat[ip]);
+    }
+    for (ip=0; ip < NP; ip++) {
+	sf_divn_close_r(dv[ip]);
+	if (0 != memcmp(rat[ip],ref[ip],n12*sizeof(float))) {
+	    fprintf(stderr,"divn: panel %d differs\n",ip);
+	    exit(1);
+	}
+    }
+    printf("divn: %d panels identical\n",NP);
+
+    /* helix convolution and its inverse through handles */
+    aa = sf_allocatehelix(2);
+    aa->flt[0] = -0.5f; aa->lag[0] = 1;
+    aa->flt[1] = 0.25f; aa->lag[1] = ndat[0];
+    x = sf_floatalloc(n12);
+    y = sf_floatalloc(n12);
+    z = sf_floatalloc(n12);
+
+    pd = sf_polydiv_init_r(n12,aa);
+    sf_helicon_lop_r(aa,false,false,n12,n12,num[0],y);
+    sf_polydiv_lop_r(pd,false,false,n12,n12,y,x);
+    sf_polydiv_close_r(pd);
+
+    sf_polydiv_init(n12,aa);
+    sf_polydiv_lop(false,false,n12,n12,y,z);
+    sf_polydiv_close();
+
+    for (i=0; i < n12; i++) {
+	if (fabsf(x[i]-num[0][i]) > 1.e-4f || x[i] != z[i]) {
+	    fprintf(stderr,"helicon/polydiv: sample %d differs\n",i);
+	    exit(1);
+	}
+    }
+    printf("helicon/polydiv: inverse recovered\n");
+
+    exit(0);
+}
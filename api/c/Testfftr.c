@@ -0,0 +1,124 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "kiss_fftr.h"
+#include "fftr.h"
+#include "timer.h"
+#include "alloc.h"
+
+/* Batched transforms must give exactly the results of kiss_fftr
+   applied one trace at a time. With an argument, also time both
+   on an n1 x n2 panel, e.g. Testfftr.x 1000 2000. */
+
+static void fill(int n, float *x)
+{
+    int i;
+
+    for (i=0; i < n; i++) {
+	x[i] = sinf(0.37f*i)+0.1f*cosf(1.3f*i*i);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    int sizes[]={2,6,16,94,250,1000}, is, n, nw, ntr, l, n1, n2, i, rep;
+    float *x, *y;
+    kiss_fft_cpx *c, *d;
+    kiss_fftr_cfg forw, invs;
+    sf_fftr pf, pi;
+    sf_timer t;
+
+    for (is=0; is < (int) (sizeof(sizes)/sizeof(int)); is++) {
+	n = sizes[is];
+	nw = n/2+1;
+	forw = kiss_fftr_alloc(n,0,NULL,NULL);
+	invs = kiss_fftr_alloc(n,1,NULL,NULL);
+	pf = sf_fftr_plan(n,false);
+	pi = sf_fftr_plan(n,true);
+
+	if (pf != sf_fftr_plan(n,false)) {
+	    fprintf(stderr,"n=%d: plan not cached\n",n);
+	    exit(1);
+	}
+
+	/* trace distances larger than the transforms */
+	for (ntr=1; ntr < 10; ntr++) {
+	    x = sf_floatalloc((n+1)*ntr);
+	    y = sf_floatalloc((n+1)*ntr);
+	    c = (kiss_fft_cpx*) sf_alloc((nw+1)*ntr,sizeof(kiss_fft_cpx));
+	    d = (kiss_fft_cpx*) sf_alloc((nw+1)*ntr,sizeof(kiss_fft_cpx));
+	    fill((n+1)*ntr,x);
+	    memset(c,0,(nw+1)*ntr*sizeof(kiss_fft_cpx));
+	    memset(d,0,(nw+1)*ntr*sizeof(kiss_fft_cpx));
+
+	    for (l=0; l < ntr; l++) {
+		kiss_fftr(forw,x+l*(n+1),c+l*(nw+1));
+	    }
+	    sf_fftr_many(pf,ntr,x,n+1,d,nw+1);
+	    if (0 != memcmp(c,d,(nw+1)*ntr*sizeof(kiss_fft_cpx))) {
+		fprintf(stderr,"n=%d ntr=%d: forward differs\n",n,ntr);
+		exit(1);
+	    }
+
+	    memcpy(y,x,(n+1)*ntr*sizeof(float));
+	    for (l=0; l < ntr; l++) {
+		kiss_fftri(invs,c+l*(nw+1),x+l*(n+1));
+	    }
+	    sf_fftri_many(pi,ntr,d,nw+1,y,n+1);
+	    if (0 != memcmp(x,y,(n+1)*ntr*sizeof(float))) {
+		fprintf(stderr,"n=%d ntr=%d: inverse differs\n",n,ntr);
+		exit(1);
+	    }
+
+	    free(x);
+	    free(y);
+	    free(c);
+	    free(d);
+	}
+	free(forw);
+	free(invs);
+    }
+    printf("fftr: batched transforms identical to kiss_fftr\n");
+
+    if (argc < 3) exit(0);
+
+    n1 = atoi(argv[1]);
+    n2 = atoi(argv[2]);
+    n = 2*kiss_fft_next_fast_size((n1+1)/2);
+    nw = n/2+1;
+    rep = 5;
+
+    x = sf_floatalloc(n*n2);
+    c = (kiss_fft_cpx*) sf_alloc(nw*n2,sizeof(kiss_fft_cpx));
+    fill(n*n2,x);
+
+    forw = kiss_fftr_alloc(n,0,NULL,NULL);
+    t = sf_timer_init();
+    for (i=0; i < rep; i++) {
+	sf_timer_start(t);
+	for (l=0; l < n2; l++) {
+	    kiss_fftr(forw,x+l*n,c+l*nw);
+	}
+	sf_timer_stop(t);
+    }
+    printf("%d x %d, nfft=%d\n",n1,n2,n);
+    printf("kiss_fftr loop: %8.2f ms (%.1f Msamples/s)\n",
+	   sf_timer_get_average_time(t),
+	   1.0e-3*n*n2/sf_timer_get_average_time(t));
+    sf_timer_close(t);
+
+    pf = sf_fftr_plan(n,false);
+    t = sf_timer_init();
+    for (i=0; i < rep; i++) {
+	sf_timer_start(t);
+	sf_fftr_many(pf,n2,x,n,c,nw);
+	sf_timer_stop(t);
+    }
+    printf("sf_fftr_many:   %8.2f ms (%.1f Msamples/s)\n",
+	   sf_timer_get_average_time(t),
+	   1.0e-3*n*n2/sf_timer_get_average_time(t));
+    sf_timer_close(t);
+
+    exit(0);
+}
@@ -0,0 +1,128 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "parallel.h"
+#include "file.h"
+#include "getpar.h"
+#include "alloc.h"
+#include "error.h"
+#include "files.h"
+
+#define NJOB 4
+#define NOUT (1<<18) /* 1 MB of output per job, many pipe buffers */
+#define NBLK 16
+#define HOLD (1<<18) /* bytes held ahead of turn for all jobs */
+
+static void job(void)
+/* write a large output, the job number comes in the input */
+{
+    int i, b, nb;
+    float k, *buf;
+    sf_file in, out;
+
+    in = sf_input("in");
+    out = sf_output("out");
+
+    sf_floatread(&k,1,in);
+    sf_putint(out,"n1",NOUT);
+
+    nb = NOUT/NBLK;
+    buf = sf_floatalloc(nb);
+    for (b=0; b < NBLK; b++) {
+	for (i=0; i < nb; i++) {
+	    buf[i] = k*NOUT+b*nb+i;
+	}
+	sf_floatwrite(buf,nb,out);
+    }
+}
+
+static void run(int axis, int argc, char* argv[])
+/* stream the jobs and check the output against the serial result, 
+   each job fills its share of HOLD many times over */
+{
+    int i, k, jobs, ndim;
+    off_t n[SF_MAX_DIM];
+    char *iname, *oname;
+    float one, want, *buf;
+    FILE *tmp;
+    sf_file inp, out;
+
+    /* one value per job, split along the second axis */
+    tmp = sf_tempfile(&iname,"w+b");
+    fclose(tmp);
+    inp = sf_output(iname);
+    sf_putint(inp,"n1",1);
+    sf_putint(inp,"n2",NJOB);
+    for (k=0; k < NJOB; k++) {
+	one = k;
+	sf_floatwrite(&one,1,inp);
+    }
+    sf_fileclose(inp);
+
+    tmp = sf_tempfile(&oname,"w+b");
+    fclose(tmp);
+
+    inp = sf_input(iname);
+    out = sf_output(oname);
+
+    ndim = sf_largefiledims(inp,n);
+    if (!sf_stream_split(inp,2,NJOB+1,&jobs,ndim,n,argc,argv)) {
+	printf("parallel: no streaming without pthreads\n");
+	exit(0);
+    }
+    if (NJOB != jobs) sf_error("%d jobs instead of %d",jobs,NJOB);
+    sf_stream_out(out,jobs,axis,HOLD);
+    if (axis > 0) {
+	sf_join(out,axis,jobs);
+    } else {
+	sf_add(out,jobs);
+    }
+    sf_fileclose(out);
+
+    /* joined in order or added */
+    out = sf_input(oname);
+    buf = sf_floatalloc(NOUT);
+    for (k=0; k < ((axis > 0)? NJOB: 1); k++) {
+	sf_floatread(buf,NOUT,out);
+	for (i=0; i < NOUT; i++) {
+	    want = (axis > 0)? 
+		(float) k*NOUT+i: 
+		(float) (NJOB*(NJOB-1)/2)*NOUT+NJOB*i;
+	    if (buf[i] != want)
+		sf_error("join=%d: job %d: sample %d is %g instead of %g",
+			 axis,k,i,buf[i],want);
+	}
+    }
+    free(buf);
+    sf_fileclose(out);
+
+    sf_rm(iname,true,false,false);
+    sf_rm(oname,true,false,false);
+    free(iname);
+    free(oname);
+
+    printf("parallel: join=%d matches the serial result\n",axis);
+}
+
+int main(int argc, char* argv[])
+{
+    bool isjob;
+    char *jargv[3];
+
+    sf_init(argc,argv);
+    if (!sf_getbool("job",&isjob)) isjob=false;
+    if (isjob) {
+	job();
+	exit(0);
+    }
+
+    jargv[0] = argv[0];
+    jargv[1] = argv[0];
+    jargv[2] = "job=y";
+
+    run(2,3,jargv);
+    run(0,3,jargv);
+
+    exit(0);
+}
@@ -1,15 +1,31 @@
 #include <stdlib.h>
 #include <stdio.h>
+#include <math.h>
 
 #include "quantile.h"
 
 #define NX 5
+#define NB 10000
+#define NM 100
+
+static float below(int n, const float *a, float y)
+/* fraction of values below y */
+{
+    int i, lt;
+
+    lt = 0;
+    for (i=0; i < n; i++) {
+	if (a[i] < y) lt++;
+    }
+    return (float) lt/n;
+}
 
 int main (int argc, char* argv[])
 {
-    int i, j;
+    int i, j, q;
     float xx[] = {1.,3.,4.,5.,2.};
-    float yy[NX];
+    float yy[NX], zz[NX], *big, *tmp, y, err;
+    sf_qsketch s, t;
     
     for (i=0; i < NX; i++) {
 	for (j=0; j < NX; j++) {
@@ -17,6 +33,51 @@ int main (int argc, char* argv[])
 	}
 	printf("%d %f\n", i, sf_quantile (i, NX, yy));
     }
+
+    /* a sketch of small blocks is exact */
+    s = sf_qsketch_init(NX);
+    for (j=0; j < NX; j++) {
+	yy[j] = xx[j];
+    }
+    sf_qsketch_add(s,NX,yy);
+    for (i=0; i < NX; i++) {
+	for (j=0; j < NX; j++) {
+	    yy[j] = xx[j];
+	    zz[j] = fabsf(xx[j]-2.5);
+	}
+	if (sf_qsketch_quantile(s,i) != sf_quantile(i,NX,yy) ||
+	    sf_qsketch_absquantile(s,2.5,i) != sf_quantile(i,NX,zz)) {
+	    fprintf(stderr,"sketch: quantile %d differs\n",i);
+	    exit(1);
+	}
+    }
+    sf_qsketch_close(s);
+
+    /* large blocks, merged: rank error below 1/(2m) */
+    big = (float*) malloc(2*NB*sizeof(float));
+    tmp = (float*) malloc(NB*sizeof(float));
+    for (i=0; i < 2*NB; i++) {
+	big[i] = sinf(0.001f*i*i)+0.001f*i;
+    }
+    s = sf_qsketch_init(NM);
+    t = sf_qsketch_init(NM);
+    for (i=0; i < NB; i++) tmp[i] = big[i];
+    sf_qsketch_add(s,NB,tmp);
+    for (i=0; i < NB; i++) tmp[i] = big[NB+i];
+    sf_qsketch_add(t,NB,tmp);
+    sf_qsketch_merge(s,t);
+    sf_qsketch_close(t);
+
+    for (q=0; q < 2*NB; q += 997) {
+	y = sf_qsketch_quantile(s,q);
+	err = fabsf(below(2*NB,big,y)-(float) q/(2*NB));
+	if (err > 0.5f/NM+1.0f/NB) {
+	    fprintf(stderr,"sketch: rank %d error %g\n",q,err);
+	    exit(1);
+	}
+    }
+    printf("sketch: rank error below %g\n",0.5/NM);
+    sf_qsketch_close(s);
     
     exit (0);
 }
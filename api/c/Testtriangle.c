@@ -0,0 +1,116 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "triangle.h"
+#include "trianglen.h"
+#include "decart.h"
+#include "alloc.h"
+#include "_defs.h"
+
+/* Smoothing panels of adjacent lines must give exactly the results
+   of smoothing one line at a time. */
+
+static void fill(int n, float *x)
+{
+    int i;
+
+    for (i=0; i < n; i++) {
+	x[i] = sinf(0.37f*i)+0.1f*cosf(1.3f*i*i);
+    }
+}
+
+int main(void) {
+    int nbox[]={7,3,12}, ndat[]={33,20,9}, s[3], n, nd, i, j, k, m, i0;
+    int ibox, ider, iop;
+    bool box, der;
+    float *x, *y, *w;
+    sf_triangle tr;
+    sf_trianglen trn;
+
+    nd = 1;
+    for (i=0; i < 3; i++) {
+	s[i] = nd;
+	nd *= ndat[i];
+    }
+    x = sf_floatalloc(nd);
+    y = sf_floatalloc(nd);
+    w = sf_floatalloc(nd*2);
+
+    /* all four operators, box and triangle, derivative, every axis;
+       nbox[2] > ndat[2] exercises multiple reflections */
+    for (iop=0; iop < 4; iop++) {
+	for (ibox=0; ibox < 2; ibox++) {
+	    for (ider=0; ider < 2; ider++) {
+		box = (bool) ibox;
+		der = (bool) ider;
+		for (i=0; i < 3; i++) {
+		    n = ndat[i];
+		    tr = sf_triangle_init(nbox[i],n,box);
+
+		    fill(nd,x);
+		    fill(nd,y);
+		    for (j=0; j < nd/n; j++) {
+			i0 = sf_first_index(i,j,3,ndat,s);
+			switch (iop) {
+			    case 0: sf_smooth(tr,i0,s[i],der,x); break;
+			    case 1: sf_dsmooth(tr,i0,s[i],der,x); break;
+			    case 2: sf_smooth2(tr,i0,s[i],der,x); break;
+			    default: sf_dsmooth2(tr,i0,s[i],der,x); break;
+			}
+		    }
+
+		    /* panels of m lines, m not dividing s[i] */
+		    m = (i > 0)? 7: 1;
+		    for (j=0; j < nd/(n*s[i]); j++) {
+			for (k=0; k < s[i]; k += m) {
+			    i0 = j*n*s[i]+k;
+			    switch (iop) {
+				case 0: sf_smooth_lines(tr,i0,s[i],
+							SF_MIN(m,s[i]-k),der,y,w); break;
+				case 1: sf_dsmooth_lines(tr,i0,s[i],
+							 SF_MIN(m,s[i]-k),der,y,w); break;
+				case 2: sf_smooth2_lines(tr,i0,s[i],
+							 SF_MIN(m,s[i]-k),der,y,w); break;
+				default: sf_dsmooth2_lines(tr,i0,s[i],
+							   SF_MIN(m,s[i]-k),der,y,w); break;
+			    }
+			}
+		    }
+		    sf_triangle_close(tr);
+
+		    if (0 != memcmp(x,y,nd*sizeof(float))) {
+			fprintf(stderr,"op=%d box=%d der=%d axis=%d: lines differ\n",
+				iop,ibox,ider,i+1);
+			exit(1);
+		    }
+		}
+	    }
+	}
+    }
+    printf("triangle: panels identical to single lines\n");
+
+    /* N-D smoothing operator against line-by-line reference */
+    fill(nd,x);
+    trn = sf_trianglen_init_r(3,nbox,ndat);
+    sf_trianglen_lop_r(trn,false,false,nd,nd,x,y);
+    sf_trianglen_close_r(trn);
+
+    for (i=0; i < 3; i++) {
+	tr = sf_triangle_init(nbox[i],ndat[i],false);
+	for (j=0; j < nd/ndat[i]; j++) {
+	    i0 = sf_first_index(i,j,3,ndat,s);
+	    sf_smooth2(tr,i0,s[i],false,x);
+	}
+	sf_triangle_close(tr);
+    }
+
+    if (0 != memcmp(x,y,nd*sizeof(float))) {
+	fprintf(stderr,"trianglen differs\n");
+	exit(1);
+    }
+    printf("trianglen: identical to line-by-line smoothing\n");
+
+    exit(0);
+}
@@ -24,6 +24,8 @@
 #include "c99.h"
 
 typedef void (*sf_operator)(bool,bool,int,int,float*,float*);
+typedef void (*sf_operator_r)(void*,bool,bool,int,int,float*,float*);
+/* reentrant operator, first argument is its state */
 typedef void (*sf_solverstep)(bool,int,int,float*,
 			   const float*,float*,const float*);
 typedef void (*sf_weight)(int,const float*,float*);
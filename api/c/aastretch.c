@@ -27,9 +27,67 @@
 #include "error.h"
 #include "adjnull.h"
 
-static int nt, nd, nk, **x;
-static float t0,dt, **w, *a, *tmp, *tmp2;
-static bool *m;
+#ifndef _sf_aastretch_h
+
+typedef struct sf_Aastretch *sf_aastretch;
+/* abstract data type */
+/*^*/
+
+#endif
+
+struct sf_Aastretch {
+    int nt, nd, nk, **x;
+    float t0, dt, **w, *a, *tmp, *tmp2;
+    bool *m;
+};
+
+static struct sf_Aastretch aa0;
+
+static void aastretch_alloc (sf_aastretch aa, bool box, 
+			     int n1, float o1, float d1, int n2)
+{
+    aa->nt = n1; 
+    aa->t0 = o1; 
+    aa->dt = d1; 
+    aa->nd = n2;
+    
+    aa->nk = box? 2:3;
+    
+    aa->x = sf_intalloc2(aa->nk,n2);
+    aa->m = sf_boolalloc(n2);
+    aa->w = sf_floatalloc2(aa->nk,n2);
+    aa->a = sf_floatalloc(n2);
+
+    aa->tmp = sf_floatalloc(n1*aa->nk);
+    aa->tmp2 = sf_floatalloc(n1);
+}
+
+static void aastretch_free (sf_aastretch aa)
+{
+    free (aa->x[0]);
+    free (aa->x);
+    free (aa->m);
+    free (aa->w[0]);
+    free (aa->w);
+    free (aa->a);
+    free (aa->tmp);
+    free (aa->tmp2);
+}
+
+sf_aastretch sf_aastretch_init_r (bool box /* if box instead of triangle */,
+				  int n1   /* trace length */, 
+				  float o1 /* trace origin */, 
+				  float d1 /* trace sampling */, 
+				  int n2   /* number of data samples */)
+/*< initialize a reentrant interpolation, to be used with sf_aastretch_lop_r >*/
+{
+    sf_aastretch aa;
+
+    aa = (sf_aastretch) sf_alloc(1,sizeof(*aa));
+    aastretch_alloc(aa,box,n1,o1,d1,n2);
+
+    return aa;
+}
 
 void sf_aastretch_init (bool box /* if box instead of triangle */,
 			int n1   /* trace length */, 
@@ -38,31 +96,23 @@ void sf_aastretch_init (bool box /* if box instead of triangle */,
 			int n2   /* number of data samples */)
 /*< initialization >*/
 {
-    nt = n1; 
-    t0 = o1; 
-    dt = d1; 
-    nd = n2;
-    
-    nk = box? 2:3;
-    
-    x = sf_intalloc2(nk,nd);
-    m = sf_boolalloc(nd);
-    w = sf_floatalloc2(nk,nd);
-    a = sf_floatalloc(nd);
-
-    tmp = sf_floatalloc(n1*nk);
-    tmp2 = sf_floatalloc(n1);
+    aastretch_alloc(&aa0,box,n1,o1,d1,n2);
 }
 
-void sf_aastretch_define (const float *coord /* data coordinates [nd] */, 
-			  const float *delt  /* antialiasing length [nd] */, 
-			  const float *amp   /* amplitude [nd] */)
-/*< Set up interpolation >*/
+void sf_aastretch_define_r (sf_aastretch aa,
+			    const float *coord /* data coordinates [nd] */, 
+			    const float *delt  /* antialiasing length [nd] */, 
+			    const float *amp   /* amplitude [nd] */)
+/*< Set up reentrant interpolation >*/
 {
-    int id, ix[3], j;
-    float rx[3];
+    int id, ix[3], j, nt, nk, **x;
+    float rx[3], t0, dt, **w, *a;
+    bool *m;
 
-    for (id = 0; id < nd; id++) {
+    nt = aa->nt; nk = aa->nk; t0 = aa->t0; dt = aa->dt;
+    x = aa->x; w = aa->w; a = aa->a; m = aa->m;
+
+    for (id = 0; id < aa->nd; id++) {
 	m[id] = false;
 
 	rx[0] = coord[id] + delt[id] + dt;
@@ -92,15 +142,31 @@ void sf_aastretch_define (const float *coord /* data coordinates [nd] */,
     }
 }
 
-void sf_aastretch_lop (bool adj    /* adjoint flag */,
-		    bool add    /* addition flag */,
-		    int n1, int n2, /* sizes */
-		    float *ord  /* data [nd] */, 
-		    float *modl /* model [nt] */)
-/*< apply interpolation >*/
+void sf_aastretch_define (const float *coord /* data coordinates [nd] */, 
+			  const float *delt  /* antialiasing length [nd] */, 
+			  const float *amp   /* amplitude [nd] */)
+/*< Set up interpolation >*/
+{
+    sf_aastretch_define_r(&aa0,coord,delt,amp);
+}
+
+void sf_aastretch_lop_r (void *data /* sf_aastretch */,
+			 bool adj    /* adjoint flag */,
+			 bool add    /* addition flag */,
+			 int n1, int n2, /* sizes */
+			 float *ord  /* data [nd] */, 
+			 float *modl /* model [nt] */)
+/*< apply interpolation with its own state >*/
 {
-    int id, i1, i2, j, it;
-    float w1, w2, aa;
+    int id, i1, i2, j, it, nt, nd, nk, **x;
+    float w1, w2, aa, **w, *a, *tmp, *tmp2;
+    bool *m;
+    sf_aastretch str;
+
+    str = (sf_aastretch) data;
+    nt = str->nt; nd = str->nd; nk = str->nk;
+    x = str->x; w = str->w; a = str->a; m = str->m;
+    tmp = str->tmp; tmp2 = str->tmp2;
 
     if (n1 != nd || n2 != nt) sf_error("%s: wrong sizes",__FILE__);
 
@@ -164,17 +230,27 @@ void sf_aastretch_lop (bool adj    /* adjoint flag */,
     } 
 }
 
+void sf_aastretch_lop (bool adj    /* adjoint flag */,
+		    bool add    /* addition flag */,
+		    int n1, int n2, /* sizes */
+		    float *ord  /* data [nd] */, 
+		    float *modl /* model [nt] */)
+/*< apply interpolation >*/
+{
+    sf_aastretch_lop_r(&aa0,adj,add,n1,n2,ord,modl);
+}
+
+void sf_aastretch_close_r (sf_aastretch aa)
+/*< free reentrant interpolation >*/
+{
+    aastretch_free(aa);
+    free(aa);
+}
+
 void sf_aastretch_close (void)
 /*< free allocated storage >*/
 {
-    free (x[0]);
-    free (x);
-    free (m);
-    free (w[0]);
-    free (w);
-    free (a);
-    free (tmp);
-    free (tmp2);
+    aastretch_free(&aa0);
 }
 
 /* 	$Id: aastretch.c 7107 2011-04-10 02:04:14Z ivlad $ */
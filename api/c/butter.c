@@ -28,6 +28,12 @@
 #include "c99.h"
 #include "alloc.h"
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#define NL 8 /* traces filtered together in SIMD lanes */
+
 #ifndef _sf_butter_h
 
 typedef struct Sf_Butter *sf_butter;
@@ -130,6 +136,130 @@ void sf_butter_apply (const sf_butter bw, int nx, float *x /* data [nx] */)
     }
 }
 
+static void lanes (const sf_butter bw, bool back, int nx, float *t /* [nx][NL] */)
+/* filter NL interleaved traces in place, back runs the recursion from the end,
+   each lane does exactly the arithmetic of sf_butter_apply */
+{
+    int ix, i, j, l, nn, step;
+    float d0, d1, d2, x0[NL], x1[NL], x2[NL], y0, y1[NL], y2[NL], *tx;
+
+    d1 = bw->mid;
+    nn = bw->nn;
+    i = back? nx-1: 0;
+    step = back? -NL: NL;
+
+    if (nn%2) {
+	d0 = bw->den[nn/2][0];
+	d2 = bw->den[nn/2][1];
+	for (l=0; l < NL; l++) {
+	    x0[l] = y1[l] = 0.;
+	}
+	tx = t+i*NL;
+	if (bw->low) {
+	    for (ix=0; ix < nx; ix++, tx += step) {
+		for (l=0; l < NL; l++) {
+		    x1[l] = x0[l]; x0[l] = tx[l];
+		    y0 = (x0[l] + x1[l] - d2 * y1[l])*d0;
+		    tx[l] = y1[l] = y0;
+		}
+	    }
+	} else {
+	    for (ix=0; ix < nx; ix++, tx += step) {
+		for (l=0; l < NL; l++) {
+		    x1[l] = x0[l]; x0[l] = tx[l];
+		    y0 = (x0[l] - x1[l] - d2 * y1[l])*d0;
+		    tx[l] = y1[l] = y0;
+		}
+	    }
+	}
+    }
+
+    for (j=0; j < nn/2; j++) {
+	d0 = bw->den[j][0];
+	d2 = bw->den[j][1];
+	for (l=0; l < NL; l++) {
+	    x1[l] = x0[l] = y1[l] = y2[l] = 0.;
+	}
+	tx = t+i*NL;
+	if (bw->low) {
+	    for (ix=0; ix < nx; ix++, tx += step) {
+		for (l=0; l < NL; l++) {
+		    x2[l] = x1[l]; x1[l] = x0[l]; x0[l] = tx[l];
+		    y0 = (x0[l] + 2*x1[l] + x2[l] - d1 * y1[l] - d2 * y2[l])*d0;
+		    y2[l] = y1[l]; tx[l] = y1[l] = y0;
+		}
+	    }
+	} else {
+	    for (ix=0; ix < nx; ix++, tx += step) {
+		for (l=0; l < NL; l++) {
+		    x2[l] = x1[l]; x1[l] = x0[l]; x0[l] = tx[l];
+		    y0 = (x0[l] - 2*x1[l] + x2[l] - d1 * y1[l] - d2 * y2[l])*d0;
+		    y2[l] = y1[l]; tx[l] = y1[l] = y0;
+		}
+	    }
+	}
+    }
+}
+
+void sf_butter_apply_many (int nbw           /* number of filters */, 
+			   const sf_butter *bw /* filters, applied in order [nbw] */, 
+			   bool zero           /* zero phase (each filter forward and backward) */,
+			   int nx              /* trace length */, 
+			   int ntr             /* number of traces */, 
+			   float *x            /* data [ntr][nx] */)
+/*< filter many traces (in place), same result as sf_butter_apply
+  (and sf_reverse for zero phase) on each trace. Traces are filtered 
+  in blocks across SIMD lanes, blocks are spread over threads. >*/
+{
+    int nth, ib, nb, ntb, ix, l, k;
+    float **t, *tb, *xb;
+
+#ifdef _OPENMP
+    nth = omp_get_max_threads();
+#else
+    nth = 1;
+#endif
+    nb = (ntr+NL-1)/NL;
+    t = sf_floatalloc2(nx*NL,nth);
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) private(ib,ntb,ix,l,k,tb,xb) if(nb > 1)
+#endif
+    for (ib=0; ib < nb; ib++) {
+#ifdef _OPENMP
+	tb = t[omp_get_thread_num()];
+#else
+	tb = t[0];
+#endif
+	ntb = SF_MIN(NL,ntr-ib*NL);
+	xb = x+(size_t) ib*NL*nx;
+
+	/* transpose the block, unused lanes are zero */
+	for (ix=0; ix < nx; ix++) {
+	    for (l=0; l < ntb; l++) {
+		tb[ix*NL+l] = xb[l*nx+ix];
+	    }
+	    for (; l < NL; l++) {
+		tb[ix*NL+l] = 0.;
+	    }
+	}
+
+	for (k=0; k < nbw; k++) {
+	    lanes(bw[k],false,nx,tb);
+	    if (zero) lanes(bw[k],true,nx,tb);
+	}
+
+	for (l=0; l < ntb; l++) {
+	    for (ix=0; ix < nx; ix++) {
+		xb[l*nx+ix] = tb[ix*NL+l];
+	    }
+	}
+    }
+
+    free(t[0]);
+    free(t);
+}
+
 void sf_reverse (int n1, float* trace)
 /*< reverse a trace >*/
 {
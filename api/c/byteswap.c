@@ -0,0 +1,95 @@
+/* Byte swapping for XDR (big-endian) data. */
+/*
+  Copyright (C) 2026 University of Texas at Austin
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include <string.h>
+
+#if defined(__AVX2__) || defined(__SSSE3__)
+#include <immintrin.h>
+#endif
+
+#include "byteswap.h"
+
+#include "_bool.h"
+/*^*/
+
+#include <stddef.h>
+/*^*/
+
+bool sf_bigendian (void)
+/*< true if the host stores numbers in XDR (big-endian) byte order >*/
+{
+    union {
+	unsigned int i;
+	unsigned char c[sizeof(unsigned int)];
+    } u;
+
+    u.i = 1;
+    return (bool) (0 == u.c[0]);
+}
+
+static unsigned int swap4 (unsigned int w)
+{
+    return
+	((w & 0x000000ffu) << 24) |
+	((w & 0x0000ff00u) <<  8) |
+	((w & 0x00ff0000u) >>  8) |
+	((w & 0xff000000u) >> 24);
+}
+
+void sf_byteswap4 (const void *in, void *out, size_t n)
+/*< reverse byte order of n 4-byte words (float, int), in and out can be the same >*/
+{
+    size_t i;
+    unsigned int w;
+    const unsigned char *src;
+    unsigned char *dst;
+#if defined(__AVX2__)
+    const __m256i mask = _mm256_setr_epi8(
+	3,2,1,0, 7,6,5,4, 11,10,9,8, 15,14,13,12,
+	3,2,1,0, 7,6,5,4, 11,10,9,8, 15,14,13,12);
+    __m256i v;
+#elif defined(__SSSE3__)
+    const __m128i mask = _mm_setr_epi8(
+	3,2,1,0, 7,6,5,4, 11,10,9,8, 15,14,13,12);
+    __m128i v;
+#endif
+
+    src = (const unsigned char*) in;
+    dst = (unsigned char*) out;
+    i = 0;
+
+#if defined(__AVX2__)
+    for (; i+8 <= n; i += 8) {
+	v = _mm256_loadu_si256((const __m256i*) (src+4*i));
+	_mm256_storeu_si256((__m256i*) (dst+4*i),_mm256_shuffle_epi8(v,mask));
+    }
+#elif defined(__SSSE3__)
+    for (; i+4 <= n; i += 4) {
+	v = _mm_loadu_si128((const __m128i*) (src+4*i));
+	_mm_storeu_si128((__m128i*) (dst+4*i),_mm_shuffle_epi8(v,mask));
+    }
+#endif
+
+    /* scalar remainder (or everything without SIMD) */
+    for (; i < n; i++) {
+	memcpy(&w,src+4*i,4);
+	w = swap4(w);
+	memcpy(dst+4*i,&w,4);
+    }
+}
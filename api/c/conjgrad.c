@@ -29,10 +29,80 @@
 #include "_solver.h"
 /*^*/
 
-static int np, nx, nr, nd;
-static float *r, *sp, *sx, *sr, *gp, *gx, *gr;
-static float eps, tol;
-static bool verb, hasp0;
+#ifndef _sf_conjgrad_h
+
+typedef struct sf_Conjgrad *sf_cgsolver;
+/* abstract data type */
+/*^*/
+
+#endif
+
+struct sf_Conjgrad {
+    int np, nx, nr, nd;
+    float *r, *sp, *sx, *sr, *gp, *gx, *gr;
+    float eps, tol;
+    bool verb, hasp0;
+};
+
+struct plainop {
+    sf_operator oper;
+};
+
+static sf_cgsolver cg0;
+
+static void plain_lop (void *data, bool adj, bool add, 
+		       int nx, int ny, float* x, float* y)
+/* operator without state, for the global solver */
+{
+    ((struct plainop*) data)->oper(adj,add,nx,ny,x,y);
+}
+
+sf_cgsolver sf_conjgrad_init_r(int np1     /* preconditioned size */, 
+			       int nx1     /* model size */, 
+			       int nd1     /* data size */, 
+			       int nr1     /* residual size */, 
+			       float eps1  /* scaling */,
+			       float tol1  /* tolerance */, 
+			       bool verb1  /* verbosity flag */, 
+			       bool hasp01 /* if has initial model */) 
+/*< reentrant solver constructor, to be used with sf_conjgrad_r >*/
+{
+    sf_cgsolver cg;
+
+    cg = (sf_cgsolver) sf_alloc(1,sizeof(*cg));
+
+    cg->np = np1; 
+    cg->nx = nx1;
+    cg->nr = nr1;
+    cg->nd = nd1;
+    cg->eps = eps1*eps1;
+    cg->tol = tol1;
+    cg->verb = verb1;
+    cg->hasp0 = hasp01;
+
+    cg->r = sf_floatalloc(nr1);  
+    cg->sp = sf_floatalloc(np1);
+    cg->gp = sf_floatalloc(np1);
+    cg->sx = sf_floatalloc(nx1);
+    cg->gx = sf_floatalloc(nx1);
+    cg->sr = sf_floatalloc(nr1);
+    cg->gr = sf_floatalloc(nr1);
+
+    return cg;
+}
+
+void sf_conjgrad_close_r(sf_cgsolver cg) 
+/*< free a reentrant solver >*/
+{
+    free (cg->r);
+    free (cg->sp);
+    free (cg->gp);
+    free (cg->sx);
+    free (cg->gx);
+    free (cg->sr);
+    free (cg->gr);
+    free (cg);
+}
 
 void sf_conjgrad_init(int np1     /* preconditioned size */, 
 		      int nx1     /* model size */, 
@@ -44,68 +114,59 @@ void sf_conjgrad_init(int np1     /* preconditioned size */,
 		      bool hasp01 /* if has initial model */) 
 /*< solver constructor >*/
 {
-    np = np1; 
-    nx = nx1;
-    nr = nr1;
-    nd = nd1;
-    eps = eps1*eps1;
-    tol = tol1;
-    verb = verb1;
-    hasp0 = hasp01;
-
-    r = sf_floatalloc(nr);  
-    sp = sf_floatalloc(np);
-    gp = sf_floatalloc(np);
-    sx = sf_floatalloc(nx);
-    gx = sf_floatalloc(nx);
-    sr = sf_floatalloc(nr);
-    gr = sf_floatalloc(nr);
+    cg0 = sf_conjgrad_init_r(np1,nx1,nd1,nr1,eps1,tol1,verb1,hasp01);
 }
 
 void sf_conjgrad_close(void) 
 /*< Free allocated space >*/
 {
-    free (r);
-    free (sp);
-    free (gp);
-    free (sx);
-    free (gx);
-    free (sr);
-    free (gr);
+    sf_conjgrad_close_r(cg0);
 }
 
-void sf_conjgrad(sf_operator prec  /* data preconditioning */, 
-		 sf_operator oper  /* linear operator */, 
-		 sf_operator shape /* shaping operator */, 
-		 float* p          /* preconditioned model */, 
-		 float* x          /* estimated model */, 
-		 float* dat        /* data */, 
-		 int niter         /* number of iterations */) 
-/*< Conjugate gradient solver with shaping >*/
+void sf_conjgrad_r(sf_cgsolver cg    /* solver */,
+		   sf_operator_r prec  /* data preconditioning */, 
+		   void *precd         /* state of prec */,
+		   sf_operator_r oper  /* linear operator */, 
+		   void *operd         /* state of oper */,
+		   sf_operator_r shape /* shaping operator */, 
+		   void *shaped        /* state of shape */,
+		   float* p            /* preconditioned model */, 
+		   float* x            /* estimated model */, 
+		   float* dat          /* data */, 
+		   int niter           /* number of iterations */) 
+/*< Conjugate gradient solver with shaping, reentrant version >*/
 {
     double gn, gnp, alpha, beta, g0, dg, r0;
     float *d=NULL;
-    int i, iter;
+    int i, iter, np, nx, nr, nd;
+    float *r, *sp, *sx, *sr, *gp, *gx, *gr, eps, tol;
+    bool verb;
+
+    np = cg->np; nx = cg->nx; nr = cg->nr; nd = cg->nd;
+    r = cg->r; 
+    sp = cg->sp; sx = cg->sx; sr = cg->sr; 
+    gp = cg->gp; gx = cg->gx; gr = cg->gr;
+    eps = cg->eps; tol = cg->tol; verb = cg->verb;
     
     if (NULL != prec) {
 	d = sf_floatalloc(nd); 
 	for (i=0; i < nd; i++) {
 	    d[i] = - dat[i];
 	}
-	prec(false,false,nd,nr,d,r);
+	prec(precd,false,false,nd,nr,d,r);
     } else {
 	for (i=0; i < nr; i++) {
 	    r[i] = - dat[i];
 	}
     }
     
-    if (hasp0) { /* initial p */
-	shape(false,false,np,nx,p,x);
+    if (cg->hasp0) { /* initial p */
+	shape(shaped,false,false,np,nx,p,x);
 	if (NULL != prec) {
-	    oper(false,false,nx,nd,x,d);
-	    prec(false,true,nd,nr,d,r);
+	    oper(operd,false,false,nx,nd,x,d);
+	    prec(precd,false,true,nd,nr,d,r);
 	} else {
-	    oper(false,true,nx,nr,x,r);
+	    oper(operd,false,true,nx,nr,x,r);
 	}
     } else {
 	for (i=0; i < np; i++) {
@@ -120,6 +181,7 @@ void sf_conjgrad(sf_operator prec  /* data preconditioning */,
     r0 = cblas_dsdot(nr,r,1,r,1);
     if (r0 == 0.) {
 	if (verb) sf_warning("zero residual: r0=%g",r0);
+	if (NULL != prec) free (d);
 	return;
     }
 
@@ -132,20 +194,20 @@ void sf_conjgrad(sf_operator prec  /* data preconditioning */,
 	}
 
 	if (NULL != prec) {
-	    prec(true,false,nd,nr,d,r);
-	    oper(true,true,nx,nd,gx,d);
+	    prec(precd,true,false,nd,nr,d,r);
+	    oper(operd,true,true,nx,nd,gx,d);
 	} else {
-	    oper(true,true,nx,nr,gx,r);
+	    oper(operd,true,true,nx,nr,gx,r);
 	}
 
-	shape(true,true,np,nx,gp,gx);
-	shape(false,false,np,nx,gp,gx);
+	shape(shaped,true,true,np,nx,gp,gx);
+	shape(shaped,false,false,np,nx,gp,gx);
 
 	if (NULL != prec) {
-	    oper(false,false,nx,nd,gx,d);
-	    prec(false,false,nd,nr,d,gr);
+	    oper(operd,false,false,nx,nd,gx,d);
+	    prec(precd,false,false,nd,nr,d,gr);
 	} else {
-	    oper(false,false,nx,nr,gx,gr);
+	    oper(operd,false,false,nx,nr,gx,gr);
 	}
 
 	gn = cblas_dsdot(np,gp,1,gp,1);
@@ -202,6 +264,28 @@ void sf_conjgrad(sf_operator prec  /* data preconditioning */,
 
 }
 
+void sf_conjgrad(sf_operator prec  /* data preconditioning */, 
+		 sf_operator oper  /* linear operator */, 
+		 sf_operator shape /* shaping operator */, 
+		 float* p          /* preconditioned model */, 
+		 float* x          /* estimated model */, 
+		 float* dat        /* data */, 
+		 int niter         /* number of iterations */) 
+/*< Conjugate gradient solver with shaping >*/
+{
+    struct plainop pprec, poper, pshape;
+
+    pprec.oper = prec;
+    poper.oper = oper;
+    pshape.oper = shape;
+
+    sf_conjgrad_r(cg0,
+		  (NULL != prec)? plain_lop: NULL,&pprec,
+		  plain_lop,&poper,
+		  plain_lop,&pshape,
+		  p,x,dat,niter);
+}
+
 void sf_conjgrad_adj(bool adj /* adjoint flag */,
 		     sf_operator oper  /* linear operator */, 
 		     sf_operator shape /* shaping operator */, 
@@ -213,7 +297,15 @@ void sf_conjgrad_adj(bool adj /* adjoint flag */,
 {
     double gn, gnp, alpha, beta, g0, dg, r0;
     float *q, *sq, *gq, *y;
-    int i, iter;
+    int i, iter, np, nx, nr, nd;
+    float *r, *sp, *sx, *sr, *gp, *gx, *gr, eps, tol;
+    bool verb;
+
+    np = cg0->np; nx = cg0->nx; nr = cg0->nr; nd = cg0->nd;
+    r = cg0->r; 
+    sp = cg0->sp; sx = cg0->sx; sr = cg0->sr; 
+    gp = cg0->gp; gx = cg0->gx; gr = cg0->gr;
+    eps = cg0->eps; tol = cg0->tol; verb = cg0->verb;
 
     q = sf_floatalloc(nx);
     y = sf_floatalloc(nx);
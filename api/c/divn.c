@@ -27,48 +27,70 @@
 #include "trianglen.h"
 #include "weight.h"
 
-static int niter, n;
-static float *p;
+#ifndef _sf_divn_h
 
-void sf_divn_init(int ndim   /* number of dimensions */, 
-		  int nd     /* data size */, 
-		  int *ndat  /* data dimensions [ndim] */, 
-		  int *nbox  /* smoothing radius [ndim] */, 
-		  int niter1 /* number of iterations */,
-		  bool verb  /* verbosity */) 
-/*< initialize >*/
+typedef struct sf_Divn *sf_divnsolver;
+/* abstract data type */
+/*^*/
+
+#endif
+
+struct sf_Divn {
+    int niter, n;
+    float *p;
+    sf_trianglen tr;
+    sf_cgsolver cg;
+};
+
+static sf_divnsolver dv0;
+
+sf_divnsolver sf_divn_init_r(int ndim   /* number of dimensions */, 
+			     int nd     /* data size */, 
+			     int *ndat  /* data dimensions [ndim] */, 
+			     int *nbox  /* smoothing radius [ndim] */, 
+			     int niter1 /* number of iterations */,
+			     bool verb  /* verbosity */) 
+/*< initialize a reentrant division, to be used with sf_divn_r >*/
 {
-    niter = niter1;
-    n = nd;
+    sf_divnsolver dv;
 
-    sf_trianglen_init(ndim, nbox, ndat);
-    sf_conjgrad_init(nd, nd, nd, nd, 1., 1.e-6, verb, false);
-    p = sf_floatalloc (nd);
+    dv = (sf_divnsolver) sf_alloc(1,sizeof(*dv));
+    dv->niter = niter1;
+    dv->n = nd;
+
+    dv->tr = sf_trianglen_init_r(ndim, nbox, ndat);
+    dv->cg = sf_conjgrad_init_r(nd, nd, nd, nd, 1., 1.e-6, verb, false);
+    dv->p = sf_floatalloc (nd);
+
+    return dv;
 }
 
-void sf_divn_close (void)
-/*< free allocated storage >*/
+void sf_divn_close_r (sf_divnsolver dv)
+/*< free a reentrant division >*/
 {
-    sf_trianglen_close();
-    sf_conjgrad_close();
-    free (p);
+    sf_trianglen_close_r(dv->tr);
+    sf_conjgrad_close_r(dv->cg);
+    free (dv->p);
+    free (dv);
 }
 
-void sf_divn (float* num, float* den,  float* rat)
-/*< smoothly divide rat=num/den >*/
+void sf_divn_r (sf_divnsolver dv, float* num, float* den,  float* rat)
+/*< smoothly divide rat=num/den, reentrant version >*/
 {
-    sf_weight_init(den);
-    sf_conjgrad(NULL, sf_weight_lop,sf_trianglen_lop,p,rat,num,niter); 
+    sf_conjgrad_r(dv->cg, NULL, NULL, sf_weight_lop_r, den,
+		  sf_trianglen_lop_r, dv->tr, dv->p, rat, num, dv->niter); 
 }
 
-void sf_divne (float* num, float* den,  float* rat, float eps)
-/*< smoothly divide rat=num/den with preconditioning >*/
+void sf_divne_r (sf_divnsolver dv, float* num, float* den,  float* rat, float eps)
+/*< smoothly divide rat=num/den with preconditioning, reentrant version >*/
 {
-    int i;
+    int i, nd;
     double norm;
 
+    nd = dv->n;
+
     if (eps > 0.0f) {
-	for (i=0; i < n; i++) {
+	for (i=0; i < nd; i++) {
 	    norm = 1.0/hypot(den[i],eps);
 
 	    num[i] *= norm;
@@ -76,22 +98,50 @@ void sf_divne (float* num, float* den,  float* rat, float eps)
 	}
     } 
 
-    norm = cblas_dsdot(n,den,1,den,1);
+    norm = cblas_dsdot(nd,den,1,den,1);
     if (norm == 0.0) {
-	for (i=0; i < n; i++) {
+	for (i=0; i < nd; i++) {
 	    rat[i] = 0.0;
 	}
 	return;
     }
-    norm = sqrt(n/norm);
+    norm = sqrt(nd/norm);
 
-    for (i=0; i < n; i++) {
+    for (i=0; i < nd; i++) {
 	num[i] *= norm;
 	den[i] *= norm;
     }   
 
-    sf_weight_init(den);
-    sf_conjgrad(NULL, sf_weight_lop,sf_trianglen_lop,p,rat,num,niter); 
+    sf_divn_r(dv,num,den,rat);
+}
+
+void sf_divn_init(int ndim   /* number of dimensions */, 
+		  int nd     /* data size */, 
+		  int *ndat  /* data dimensions [ndim] */, 
+		  int *nbox  /* smoothing radius [ndim] */, 
+		  int niter1 /* number of iterations */,
+		  bool verb  /* verbosity */) 
+/*< initialize >*/
+{
+    dv0 = sf_divn_init_r(ndim,nd,ndat,nbox,niter1,verb);
+}
+
+void sf_divn_close (void)
+/*< free allocated storage >*/
+{
+    sf_divn_close_r(dv0);
+}
+
+void sf_divn (float* num, float* den,  float* rat)
+/*< smoothly divide rat=num/den >*/
+{
+    sf_divn_r(dv0,num,den,rat);
+}
+
+void sf_divne (float* num, float* den,  float* rat, float eps)
+/*< smoothly divide rat=num/den with preconditioning >*/
+{
+    sf_divne_r(dv0,num,den,rat,eps);
 }
 
 
@@ -101,7 +151,7 @@ void sf_divn_combine (const float* one, const float* two, float *prod)
     int i;
     float p;
 
-    for (i=0; i < n; i++) {
+    for (i=0; i < dv0->n; i++) {
 	p = sqrtf(fabsf(one[i]*two[i]));
 	if ((one[i] > 0. && two[i] < 0. && -two[i] >= one[i]) ||
 	    (one[i] < 0. && two[i] > 0. && two[i] >= -one[i])) 
@@ -119,7 +169,7 @@ void sf_divn_combine_sign (const float* one, const float* two, float *prod)
     int i;
     float p;
 
-    for (i=0; i < n; i++) {
+    for (i=0; i < dv0->n; i++) {
 	p = sqrtf(fabsf(one[i]*two[i]));
 	if (one[i] < 0. || two[i] < 0.) 
 	    p = -p;
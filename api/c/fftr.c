@@ -0,0 +1,268 @@
+/* Batched real FFT of many traces, cached by size */
+/*
+  Copyright (C) 2026 University of Texas at Austin
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "kiss_fft.h"
+#include "_bool.h"
+/*^*/
+
+#include "fftr.h"
+#include "kiss_fftr.h"
+#include "kiss_fftv.h"
+#include "alloc.h"
+#include "error.h"
+#include "_defs.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#ifndef _sf_fftr_h
+
+typedef struct sf_Fftr *sf_fftr;
+/* abstract data type */
+/*^*/
+
+#endif
+
+struct sf_Fftr {
+    int nfft, nw, nth, lanes;
+    bool inv;
+    kiss_fftr_cfg *cfg;   /* one per thread */
+    kiss_fftrv_cfg *vcfg; /* one per thread, traces in SIMD lanes */
+    float **work;         /* one per thread, interleaved traces */
+    sf_fftr next;
+};
+
+static sf_fftr plans=NULL;
+
+sf_fftr sf_fftr_plan(int nfft /* transform length (even) */,
+		     bool inv /* inverse transform */)
+/*< real FFT of length nfft, plans are cached and shared >*/
+{
+    int ith;
+    sf_fftr p;
+
+    if (nfft%2) sf_error("%s: need even nfft, got %d",__FILE__,nfft);
+
+#ifdef _OPENMP
+#pragma omp critical(sf_fftr)
+#endif
+    {
+	for (p=plans; NULL != p; p=p->next) {
+	    if (nfft == p->nfft && inv == p->inv) break;
+	}
+
+	if (NULL == p) {
+	    p = (sf_fftr) sf_alloc(1,sizeof(*p));
+	    p->nfft = nfft;
+	    p->nw = nfft/2+1;
+	    p->inv = inv;
+#ifdef _OPENMP
+	    p->nth = omp_get_max_threads();
+#else
+	    p->nth = 1;
+#endif
+	    p->lanes = kiss_fftv_lanes();
+
+	    p->cfg = (kiss_fftr_cfg*) sf_alloc(p->nth,sizeof(kiss_fftr_cfg));
+	    for (ith=0; ith < p->nth; ith++) {
+		p->cfg[ith] = kiss_fftr_alloc(nfft,inv? 1: 0,NULL,NULL);
+	    }
+
+	    if (p->lanes > 0) {
+		p->vcfg = (kiss_fftrv_cfg*) sf_alloc(p->nth,sizeof(kiss_fftrv_cfg));
+		p->work = sf_floatalloc2(p->lanes*(nfft+2*p->nw),p->nth);
+		for (ith=0; ith < p->nth; ith++) {
+		    p->vcfg[ith] = kiss_fftrv_alloc(nfft,inv? 1: 0);
+		}
+	    } else {
+		p->vcfg = NULL;
+		p->work = NULL;
+	    }
+
+	    p->next = plans;
+	    plans = p;
+	}
+    }
+
+    return p;
+}
+
+static int thread(const sf_fftr p)
+/* index of the calling thread */
+{
+    int ith;
+
+#ifdef _OPENMP
+    ith = omp_get_thread_num();
+#else
+    ith = 0;
+#endif
+    if (ith >= p->nth) sf_error("%s: thread %d not planned for",__FILE__,ith);
+
+    return ith;
+}
+
+static void forward(const sf_fftr p, int ith,
+		    int ntr, const float *in, int idist,
+		    kiss_fft_cpx *out, int odist)
+/* transform up to lanes traces */
+{
+    int i, l, k, nl, nt, nw;
+    float *t, *f;
+
+    nt = p->nfft;
+    nw = p->nw;
+
+    if (0 == p->lanes || 1 == ntr) { /* nothing to interleave */
+	for (l=0; l < ntr; l++) {
+	    kiss_fftr(p->cfg[ith],in+l*idist,out+l*odist);
+	}
+	return;
+    }
+
+    nl = p->lanes;
+    t = p->work[ith];
+    f = t+nl*nt;
+
+    /* interleave, unused lanes are zero */
+    for (i=0; i < nt; i++) {
+	for (l=0; l < ntr; l++) {
+	    t[i*nl+l] = in[(size_t) l*idist+i];
+	}
+	for (; l < nl; l++) {
+	    t[i*nl+l] = 0.0f;
+	}
+    }
+
+    kiss_fftrv(p->vcfg[ith],t,f);
+
+    for (l=0; l < ntr; l++) {
+	for (k=0; k < nw; k++) {
+	    out[l*odist+k].r = f[(2*k)*nl+l];
+	    out[l*odist+k].i = f[(2*k+1)*nl+l];
+	}
+    }
+}
+
+static void inverse(const sf_fftr p, int ith,
+		    int ntr, const kiss_fft_cpx *in, int idist,
+		    float *out, int odist)
+/* inverse transform up to lanes traces */
+{
+    int i, l, k, nl, nt, nw;
+    float *t, *f;
+
+    nt = p->nfft;
+    nw = p->nw;
+
+    if (0 == p->lanes || 1 == ntr) {
+	for (l=0; l < ntr; l++) {
+	    kiss_fftri(p->cfg[ith],in+l*idist,out+l*odist);
+	}
+	return;
+    }
+
+    nl = p->lanes;
+    t = p->work[ith];
+    f = t+nl*nt;
+
+    for (k=0; k < nw; k++) {
+	for (l=0; l < ntr; l++) {
+	    f[(2*k)*nl+l]   = in[l*idist+k].r;
+	    f[(2*k+1)*nl+l] = in[l*idist+k].i;
+	}
+	for (; l < nl; l++) {
+	    f[(2*k)*nl+l]   = 0.0f;
+	    f[(2*k+1)*nl+l] = 0.0f;
+	}
+    }
+
+    kiss_fftriv(p->vcfg[ith],f,t);
+
+    for (l=0; l < ntr; l++) {
+	for (i=0; i < nt; i++) {
+	    out[l*odist+i] = t[i*nl+l];
+	}
+    }
+}
+
+void sf_fftr_many(sf_fftr p,
+		  int ntr               /* number of traces */,
+		  const float *in       /* input, trace i at in+i*idist */,
+		  int idist             /* input trace distance (>= nfft) */,
+		  kiss_fft_cpx *out     /* output, trace i at out+i*odist */,
+		  int odist             /* output trace distance (>= nfft/2+1) */)
+/*< forward real FFT of ntr traces, traces share SIMD lanes
+  and are spread over threads unless called from a parallel region >*/
+{
+    int ig, ng, nl;
+
+    if (p->inv) sf_error("%s: inverse plan in forward transform",__FILE__);
+
+    nl = (p->lanes > 0)? p->lanes: 1;
+    ng = (ntr+nl-1)/nl;
+
+#ifdef _OPENMP
+    if (omp_in_parallel()) {
+	for (ig=0; ig < ng; ig++) {
+	    forward(p,thread(p),SF_MIN(nl,ntr-ig*nl),
+		    in+(size_t) ig*nl*idist,idist,out+(size_t) ig*nl*odist,odist);
+	}
+	return;
+    }
+#pragma omp parallel for num_threads(p->nth) schedule(static) if(ng > 1)
+#endif
+    for (ig=0; ig < ng; ig++) {
+	forward(p,thread(p),SF_MIN(nl,ntr-ig*nl),
+		in+(size_t) ig*nl*idist,idist,out+(size_t) ig*nl*odist,odist);
+    }
+}
+
+void sf_fftri_many(sf_fftr p,
+		   int ntr                 /* number of traces */,
+		   const kiss_fft_cpx *in  /* input, trace i at in+i*idist */,
+		   int idist               /* input trace distance (>= nfft/2+1) */,
+		   float *out              /* output, trace i at out+i*odist */,
+		   int odist               /* output trace distance (>= nfft) */)
+/*< inverse real FFT of ntr traces (unnormalized), traces share SIMD lanes
+  and are spread over threads unless called from a parallel region >*/
+{
+    int ig, ng, nl;
+
+    if (!p->inv) sf_error("%s: forward plan in inverse transform",__FILE__);
+
+    nl = (p->lanes > 0)? p->lanes: 1;
+    ng = (ntr+nl-1)/nl;
+
+#ifdef _OPENMP
+    if (omp_in_parallel()) {
+	for (ig=0; ig < ng; ig++) {
+	    inverse(p,thread(p),SF_MIN(nl,ntr-ig*nl),
+		    in+(size_t) ig*nl*idist,idist,out+(size_t) ig*nl*odist,odist);
+	}
+	return;
+    }
+#pragma omp parallel for num_threads(p->nth) schedule(static) if(ng > 1)
+#endif
+    for (ig=0; ig < ng; ig++) {
+	inverse(p,thread(p),SF_MIN(nl,ntr-ig*nl),
+		in+(size_t) ig*nl*idist,idist,out+(size_t) ig*nl*odist,odist);
+    }
+}
@@ -48,11 +48,16 @@
 #include <dirent.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <sys/mman.h>
 
 #include <rpc/types.h>
 /* #include <rpc/rpc.h> */
 #include <rpc/xdr.h>
 
+#ifdef SF_HAS_PTHREADS
+#include <pthread.h>
+#endif
+
 #include "_defs.h"
 #include "file.h"
 #include "getpar.h"
@@ -60,6 +65,7 @@
 #include "error.h"
 #include "simtab.h"
 #include "komplex.h"
+#include "byteswap.h"
 
 #include "_bool.h"
 #include "c99.h"
@@ -93,12 +99,16 @@ typedef enum {SF_ASCII, SF_XDR, SF_NATIVE} sf_dataform;
 struct sf_File {
     FILE *stream, *head; 
     char *dataname, *buf, *headname;
+    size_t bufsiz;
     sf_simtab pars;
     XDR xdr;
     enum xdr_op op;
     sf_datatype type;
     sf_dataform form;
-    bool pipe, rw, dryrun;
+    bool pipe, rw, dryrun, async, seeked;
+    char *map;
+    size_t mapsize;
+    struct AsyncIO *aio;
 };
 
 /*@null@*/ static sf_file *infiles = NULL;
@@ -113,6 +123,11 @@ static char* getdatapath (void);
 static char* gettmpdatapath (void);
 static bool readpathfile (const char* filename, char* datapath);
 static void sf_input_error(sf_file file, const char* message, const char* name);
+static void unmapdata (sf_file file);
+static size_t dataread (void* arr, size_t esize, size_t n, sf_file file);
+static size_t datawrite (const void* arr, size_t esize, size_t n, 
+			 sf_file file);
+static void async_stop (sf_file file, FILE* spill, bool discard);
 
 void sf_file_error(bool err)
 /*< set error on opening files >*/
@@ -138,6 +153,10 @@ sf_file sf_input (/*@null@*/ const char* tag)
 	
     file = (sf_file) sf_alloc(1,sizeof(*file));
     file->dataname = NULL;
+    file->map = NULL;
+    file->mapsize = 0;
+    file->aio = NULL;
+    file->seeked = false;
     
     if (NULL == tag || 0 == strcmp(tag,"in")) {
 	file->stream = stdin;
@@ -225,6 +244,8 @@ sf_file sf_input (/*@null@*/ const char* tag)
 	sf_setformat(file,format);
 	free (format);
     }
+
+    if (!sf_getbool("--async",&(file->async))) file->async=false;
 	
     return file;
 }
@@ -264,6 +285,11 @@ sf_file sf_output (/*@null@*/ const char* tag)
     file->buf = NULL;
     /*    setbuf(file->stream,file->buf); */
 	
+    file->map = NULL;
+    file->mapsize = 0;
+    file->aio = NULL;
+    file->seeked = false;
+
     file->pars = sf_simtab_init (tabsize);
     file->head = NULL;
     file->headname = NULL;
@@ -349,6 +375,7 @@ sf_file sf_output (/*@null@*/ const char* tag)
 	
     if (!sf_getbool("--readwrite",&(file->rw))) file->rw=false;
     if (!sf_getbool("--dryrun",&(file->dryrun))) file->dryrun=false;
+    if (!sf_getbool("--async",&(file->async))) file->async=false;
 	
     return file;
 }
@@ -447,6 +474,7 @@ void sf_setform (sf_file file, sf_dataform form)
 {
     size_t bufsiz;
 	
+    async_stop(file,NULL,false);
     file->form = form;
     
     switch(form) {
@@ -461,6 +489,7 @@ void sf_setform (sf_file file, sf_dataform form)
 	    if (NULL == file->buf) {
 		bufsiz = sf_bufsiz(file);
 		file->buf = sf_charalloc(bufsiz);
+		file->bufsiz = bufsiz;
 		xdrmem_create(&(file->xdr),file->buf,bufsiz,file->op);
 	    }
 	    break;
@@ -652,6 +681,9 @@ void sf_fileclose (sf_file file)
 /*< close a file and free allocated space >*/
 {
     if (NULL == file) return;
+
+    async_stop(file,NULL,true);
+    unmapdata(file);
     
     if (file->stream != stdin && 
 	file->stream != stdout && 
@@ -689,6 +721,9 @@ void sf_fileclosedelete (sf_file file)
 {
     if (NULL == file) return;
 
+    async_stop(file,NULL,true);
+    unmapdata(file);
+
     if (file->stream != stdin &&
     file->stream != stdout &&
     file->stream != NULL) {
@@ -943,9 +978,17 @@ void sf_readwrite(sf_file file, bool flag)
     file->rw = flag;
 }
 
+void sf_async(sf_file file, bool flag)
+/*< set the asynchronous I/O flag (same as --async=y for a single file) >*/
+{
+    if (!flag) async_stop(file,NULL,false);
+    file->async = flag;
+}
+
 void sf_fflush(sf_file file)
 /*< flush file stream >*/
 {
+    async_stop(file,NULL,false);
     if (NULL != file->stream) fflush(file->stream);
 }
 
@@ -1053,11 +1096,349 @@ void sf_setaformat (const char* format /* number format (.i.e "%5g") */,
     aline = (size_t) line;
 }
 
+#ifdef SF_HAS_PTHREADS
+/* Asynchronous I/O: a helper thread moves data between the stream and
+   two chunk buffers, so that reading ahead and writing behind overlap
+   with computation. The stream is touched only by the helper thread
+   while it runs. */
+
+struct AsyncIO {
+    sf_file file;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    char *buf[2];
+    size_t len[2], chunk, pos;
+    bool full[2], last[2], stop, fail;
+    int cur;
+    off_t start, count; /* logical position is start+count */
+    struct AsyncIO *next;
+};
+
+static struct AsyncIO *aiolist = NULL;
+static bool aioexit = false;
+
+static void *async_reader (void *arg)
+/* read-ahead thread */
+{
+    struct AsyncIO *aio;
+    size_t got;
+    int k;
+
+    aio = (struct AsyncIO*) arg;
+    for (k=0; ; k = 1-k) {
+	pthread_mutex_lock(&(aio->lock));
+	while (aio->full[k] && !aio->stop) 
+	    pthread_cond_wait(&(aio->cond),&(aio->lock));
+	if (aio->stop) {
+	    pthread_mutex_unlock(&(aio->lock));
+	    break;
+	}
+	pthread_mutex_unlock(&(aio->lock));
+
+	got = fread(aio->buf[k],1,aio->chunk,aio->file->stream);
+
+	pthread_mutex_lock(&(aio->lock));
+	aio->len[k] = got;
+	aio->last[k] = (bool) (got < aio->chunk);
+	aio->full[k] = true;
+	pthread_cond_broadcast(&(aio->cond));
+	pthread_mutex_unlock(&(aio->lock));
+
+	if (got < aio->chunk) break;
+    }
+    return NULL;
+}
+
+static void *async_writer (void *arg)
+/* write-behind thread */
+{
+    struct AsyncIO *aio;
+    size_t len;
+    int k;
+    bool ok;
+
+    aio = (struct AsyncIO*) arg;
+    for (k=0; ; k = 1-k) {
+	pthread_mutex_lock(&(aio->lock));
+	while (!aio->full[k] && !aio->stop) 
+	    pthread_cond_wait(&(aio->cond),&(aio->lock));
+	if (!aio->full[k]) {
+	    pthread_mutex_unlock(&(aio->lock));
+	    break;
+	}
+	len = aio->len[k];
+	pthread_mutex_unlock(&(aio->lock));
+
+	ok = (bool) (len == fwrite(aio->buf[k],1,len,aio->file->stream));
+
+	pthread_mutex_lock(&(aio->lock));
+	if (!ok) aio->fail = true;
+	aio->len[k] = 0;
+	aio->full[k] = false;
+	pthread_cond_broadcast(&(aio->cond));
+	pthread_mutex_unlock(&(aio->lock));
+    }
+    return NULL;
+}
+
+static void async_exit (void)
+/* drain pending output at exit */
+{
+    struct AsyncIO *aio;
+
+    aioexit = true;
+    do {
+	for (aio = aiolist; NULL != aio; aio = aio->next) {
+	    if (XDR_ENCODE == aio->file->op) break;
+	}
+	if (NULL != aio) async_stop(aio->file,NULL,false);
+    } while (NULL != aio);
+}
+
+static void async_start (sf_file file)
+/* start the helper thread */
+{
+    struct AsyncIO *aio;
+    extern off_t ftello (FILE *stream);
+    static bool registered = false;
+
+    aio = (struct AsyncIO*) sf_alloc(1,sizeof(*aio));
+    aio->file = file;
+    aio->chunk = SF_MAX(sf_bufsiz(file),1<<20);
+    aio->buf[0] = sf_charalloc(aio->chunk);
+    aio->buf[1] = sf_charalloc(aio->chunk);
+    aio->len[0] = aio->len[1] = 0;
+    aio->full[0] = aio->full[1] = false;
+    aio->last[0] = aio->last[1] = false;
+    aio->stop = aio->fail = false;
+    aio->cur = 0;
+    aio->pos = 0;
+    aio->start = ftello(file->stream);
+    aio->count = 0;
+
+    pthread_mutex_init(&(aio->lock),NULL);
+    pthread_cond_init(&(aio->cond),NULL);
+
+    if (0 != pthread_create(&(aio->thread),NULL,
+			    (XDR_DECODE == file->op)? 
+			    async_reader: async_writer,aio)) {
+	/* no thread - fall back to synchronous I/O */
+	pthread_mutex_destroy(&(aio->lock));
+	pthread_cond_destroy(&(aio->cond));
+	free(aio->buf[0]);
+	free(aio->buf[1]);
+	free(aio);
+	file->async = false;
+	return;
+    }
+
+    aio->next = aiolist;
+    aiolist = aio;
+    file->aio = aio;
+
+    if (!registered) {
+	atexit(async_exit);
+	registered = true;
+    }
+}
+
+static size_t async_read (char* arr, size_t size, sf_file file)
+/* take size bytes from the read-ahead buffers */
+{
+    struct AsyncIO *aio;
+    size_t left, nbuf;
+    int k;
+
+    aio = file->aio;
+    pthread_mutex_lock(&(aio->lock));
+    for (left=size; left > 0; left -= nbuf) {
+	k = aio->cur;
+	while (!aio->full[k]) pthread_cond_wait(&(aio->cond),&(aio->lock));
+	nbuf = SF_MIN(left,aio->len[k]-aio->pos);
+	if (0 == nbuf) {
+	    if (aio->last[k]) break; /* end of data */
+	    aio->full[k] = false;
+	    aio->pos = 0;
+	    aio->cur = 1-k;
+	    pthread_cond_broadcast(&(aio->cond));
+	    continue;
+	}
+	memcpy(arr+size-left,aio->buf[k]+aio->pos,nbuf);
+	aio->pos += nbuf;
+    }
+    pthread_mutex_unlock(&(aio->lock));
+
+    aio->count += size-left;
+    return size-left;
+}
+
+static size_t async_write (const char* arr, size_t size, sf_file file)
+/* put size bytes into the write-behind buffers */
+{
+    struct AsyncIO *aio;
+    size_t left, nbuf;
+    int k;
+    bool fail;
+
+    aio = file->aio;
+    pthread_mutex_lock(&(aio->lock));
+    for (left=size; left > 0; left -= nbuf) {
+	k = aio->cur;
+	while (aio->full[k]) pthread_cond_wait(&(aio->cond),&(aio->lock));
+	nbuf = SF_MIN(left,aio->chunk-aio->len[k]);
+	memcpy(aio->buf[k]+aio->len[k],arr+size-left,nbuf);
+	aio->len[k] += nbuf;
+	if (aio->len[k] == aio->chunk) { /* hand over to the writer */
+	    aio->full[k] = true;
+	    aio->cur = 1-k;
+	    pthread_cond_broadcast(&(aio->cond));
+	}
+    }
+    fail = aio->fail;
+    pthread_mutex_unlock(&(aio->lock));
+
+    aio->count += size;
+    return fail? 0: size;
+}
+
+static void async_stop (sf_file file, FILE* spill, bool discard)
+/* stop the helper thread; input read ahead goes to spill if given,
+   or is dropped if discard, or else the stream returns to the logical
+   position */
+{
+    struct AsyncIO *aio, **prev;
+    size_t pending, len;
+    int j, k;
+    bool fail;
+    extern int fseeko(FILE *stream, off_t offset, int whence);
+
+    aio = file->aio;
+    if (NULL == aio) return;
+
+    pthread_mutex_lock(&(aio->lock));
+    k = aio->cur;
+    if (XDR_ENCODE == file->op && aio->len[k] > 0) aio->full[k] = true;
+    aio->stop = true;
+    pthread_cond_broadcast(&(aio->cond));
+    pthread_mutex_unlock(&(aio->lock));
+
+    pthread_join(aio->thread,NULL);
+
+    fail = aio->fail;
+    pending = 0;
+    if (XDR_DECODE == file->op) {
+	/* data read ahead but not consumed */
+	for (k=0; k < 2; k++) {
+	    j = (aio->cur+k)%2;
+	    if (!aio->full[j]) break;
+	    len = aio->len[j];
+	    if (0 == k) len -= aio->pos;
+	    pending += len;
+	    if (NULL != spill && 
+		len != fwrite(aio->buf[j]+aio->len[j]-len,1,len,spill))
+		fail = true;
+	    if (aio->last[j]) break;
+	}
+    }
+
+    for (prev = &aiolist; NULL != *prev; prev = &((*prev)->next)) {
+	if (*prev == aio) {
+	    *prev = aio->next;
+	    break;
+	}
+    }
+    file->aio = NULL;
+
+    pthread_mutex_destroy(&(aio->lock));
+    pthread_cond_destroy(&(aio->cond));
+    free(aio->buf[0]);
+    free(aio->buf[1]);
+
+    if (NULL == spill && !discard && pending > 0 &&
+	0 > fseeko(file->stream,aio->start+aio->count,SEEK_SET)) 
+	sf_error ("%s: cannot return read-ahead data to a pipe",__FILE__);
+    free(aio);
+
+    if (fail && !aioexit) 
+	sf_error ("%s: trouble with asynchronous I/O:",__FILE__);
+}
+
+#else
+
+static void async_stop (sf_file file, FILE* spill, bool discard) {}
+
+#endif
+
+static size_t dataread (void* arr, size_t esize, size_t n, sf_file file)
+/* read n elements of binary data */
+{
+#ifdef SF_HAS_PTHREADS
+    /* random access (seek followed by a single read) stays synchronous */
+    if (file->seeked) {
+	file->seeked = false;
+	return fread(arr,esize,n,file->stream);
+    }
+    if (file->async && NULL == file->aio) async_start(file);
+    if (NULL != file->aio) 
+	return async_read((char*) arr,esize*n,file)/esize;
+#endif
+    return fread(arr,esize,n,file->stream);
+}
+
+static size_t datawrite (const void* arr, size_t esize, size_t n, 
+			 sf_file file)
+/* write n elements of binary data */
+{
+#ifdef SF_HAS_PTHREADS
+    if (file->seeked) {
+	file->seeked = false;
+	return fwrite(arr,esize,n,file->stream);
+    }
+    if (file->async && NULL == file->aio) async_start(file);
+    if (NULL != file->aio) 
+	return async_write((const char*) arr,esize*n,file)/esize;
+#endif
+    return fwrite(arr,esize,n,file->stream);
+}
+
+static void xdrread4 (void* arr, size_t size, sf_file file)
+/* read size XDR 4-byte words (float or int) and convert them in place */
+{
+    size_t got;
+
+    got = dataread(arr,4,size,file);
+    if (got != size) 
+	sf_error ("%s: trouble reading: %lu of %lu",__FILE__,got,size);
+    if (!sf_bigendian()) sf_byteswap4(arr,arr,size);
+}
+
+static void xdrwrite4 (const void* arr, size_t size, sf_file file)
+/* write size native 4-byte words (float or int) in XDR */
+{
+    size_t left, nbuf, bufsiz;
+    const char *buf;
+
+    if (sf_bigendian()) {
+	if (size != datawrite(arr,4,size,file))
+	    sf_error ("%s: trouble writing:",__FILE__);
+	return;
+    }
+
+    bufsiz = file->bufsiz/4;
+    buf = (const char*) arr;
+    for (left = size; left > 0; left -= nbuf) {
+	nbuf = (bufsiz < left)? bufsiz : left;
+	sf_byteswap4(buf+4*(size-left),file->buf,nbuf);
+	if (nbuf != datawrite(file->buf,4,nbuf,file))
+	    sf_error ("%s: trouble writing:",__FILE__);
+    }
+}
+
 void sf_complexwrite (sf_complex* arr, size_t size, sf_file file)
 /*< write a complex array arr[size] to file >*/
 {
-    char* buf;
-    size_t i, left, nbuf, bufsiz;
+    size_t i, left, nbuf;
     sf_complex c;
 	
     if (NULL != file->dataname) sf_fileflush (file,infiles[0]);
@@ -1078,21 +1459,10 @@ void sf_complexwrite (sf_complex* arr, size_t size, sf_file file)
 	    }
 	    break;
 	case SF_XDR:
-	    size *= sizeof(sf_complex);
-	    buf = (char*)arr+size;
-	    bufsiz = sf_bufsiz(file);
-	    for (left = size; left > 0; left -= nbuf) {
-		nbuf = (bufsiz < left)? bufsiz : left;
-		(void) xdr_setpos(&(file->xdr),0);
-		if (!xdr_vector(&(file->xdr),buf-left,
-				nbuf/sizeof(float),sizeof(float),
-				(xdrproc_t) xdr_float))
-		    sf_error ("sf_file: trouble writing xdr");
-		fwrite(file->buf,1,nbuf,file->stream);
-	    }
+	    xdrwrite4(arr,2*size,file);
 	    break;
 	default:
-	    fwrite(arr,sizeof(sf_complex),size,file->stream);
+	    datawrite(arr,sizeof(sf_complex),size,file);
 	    break;
     }
 }
@@ -1100,8 +1470,7 @@ void sf_complexwrite (sf_complex* arr, size_t size, sf_file file)
 void sf_complexread (/*@out@*/ sf_complex* arr, size_t size, sf_file file)
 /*< read a complex array arr[size] from file >*/
 {
-    char* buf;
-    size_t i, left, nbuf, got, bufsiz;
+    size_t i, got;
     float re, im;
 	
     switch (file->form) {
@@ -1113,22 +1482,10 @@ void sf_complexread (/*@out@*/ sf_complex* arr, size_t size, sf_file file)
 	    }
 	    break;
 	case SF_XDR:
-	    size *= sizeof(sf_complex);
-	    buf = (char*)arr+size;
-	    bufsiz = sf_bufsiz(file);
-	    for (left = size; left > 0; left -= nbuf) {
-		nbuf = (bufsiz < left)? bufsiz : left;
-		(void) xdr_setpos(&(file->xdr),0);
-		if (nbuf != fread(file->buf,1,nbuf,file->stream))
-		    sf_error ("%s: trouble reading:",__FILE__);
-		if (!xdr_vector(&(file->xdr),buf-left,
-				nbuf/sizeof(float),sizeof(float),
-				(xdrproc_t) xdr_float))
-		    sf_error ("%s: trouble reading xdr",__FILE__);
-	    }
+	    xdrread4(arr,2*size,file);
 	    break;
 	default:
-	    got = fread(arr,sizeof(sf_complex),size,file->stream);
+	    got = dataread(arr,sizeof(sf_complex),size,file);
 	    if (got != size) 
 		sf_error ("%s: trouble reading: %lu of %lu",__FILE__,got,size);
 	    break;
@@ -1163,11 +1520,11 @@ void sf_charwrite (char* arr, size_t size, sf_file file)
 		(void) xdr_setpos(&(file->xdr),0);
 		if (!xdr_opaque(&(file->xdr),buf-left,nbuf))
 		    sf_error ("sf_file: trouble writing xdr");
-		fwrite(file->buf,1,nbuf,file->stream);
+		datawrite(file->buf,1,nbuf,file);
 	    }
 	    break;
 	default:
-	    fwrite(arr,sizeof(char),size,file->stream);
+	    datawrite(arr,sizeof(char),size,file);
 	    break;
     }
 }
@@ -1200,11 +1557,11 @@ void sf_ucharwrite (unsigned char* arr, size_t size, sf_file file)
 		(void) xdr_setpos(&(file->xdr),0);
 		if (!xdr_opaque(&(file->xdr),buf-left,nbuf))
 		    sf_error ("sf_file: trouble writing xdr");
-		fwrite(file->buf,1,nbuf,file->stream);
+		datawrite(file->buf,1,nbuf,file);
 	    }
 	    break;
 	default:
-	    fwrite(arr,sizeof(unsigned char),size,file->stream);
+	    datawrite(arr,sizeof(unsigned char),size,file);
 	    break;
     }
 }
@@ -1231,14 +1588,14 @@ void sf_charread (/*@out@*/ char* arr, size_t size, sf_file file)
 	    for (left = size; left > 0; left -= nbuf) {
 		nbuf = (bufsiz < left)? bufsiz : left;
 		(void) xdr_setpos(&(file->xdr),0);
-		if (nbuf != fread(file->buf,1,nbuf,file->stream))
+		if (nbuf != dataread(file->buf,1,nbuf,file))
 		    sf_error ("%s: trouble reading:",__FILE__);
 		if (!xdr_opaque(&(file->xdr),buf-left,nbuf))
 		    sf_error ("%s: trouble reading xdr",__FILE__);
 	    }
 	    break;
 	default:
-	    got = fread(arr,sizeof(char),size,file->stream);
+	    got = dataread(arr,sizeof(char),size,file);
 	    if (got != size) 
 		sf_error ("%s: trouble reading: %lu of %lu",__FILE__,got,size);
 	    break;
@@ -1253,7 +1610,7 @@ int sf_try_charread(const char* test, sf_file file)
 
     size = strlen(test);
     arr = sf_charalloc(size+1);
-    got = fread(arr,sizeof(char),size+1,file->stream);
+    got = dataread(arr,sizeof(char),size+1,file);
     if (got != size) return 1;
     arr[size] = '\0';
     cmp = strncmp(arr,test,size);
@@ -1265,7 +1622,7 @@ int sf_try_charread(const char* test, sf_file file)
 int sf_try_charread2 (/*@out@*/ char* arr, size_t size, sf_file file)
 /*< try to read size bytes.  return number bytes read >*/
 {
-    return fread(arr,sizeof(char),size,file->stream);
+    return dataread(arr,sizeof(char),size,file);
 }
 
 void sf_ucharread (/*@out@*/ unsigned char* arr, size_t size, sf_file file)
@@ -1290,14 +1647,14 @@ void sf_ucharread (/*@out@*/ unsigned char* arr, size_t size, sf_file file)
 	    for (left = size; left > 0; left -= nbuf) {
 		nbuf = (bufsiz < left)? bufsiz : left;
 		(void) xdr_setpos(&(file->xdr),0);
-		if (nbuf != fread(file->buf,1,nbuf,file->stream))
+		if (nbuf != dataread(file->buf,1,nbuf,file))
 		    sf_error ("%s: trouble reading:",__FILE__);
 		if (!xdr_opaque(&(file->xdr),buf-left,nbuf))
 		    sf_error ("%s: trouble reading xdr",__FILE__);
 	    }
 	    break;
 	default:
-	    got = fread(arr,sizeof(unsigned char),size,file->stream);
+	    got = dataread(arr,sizeof(unsigned char),size,file);
 	    if (got != size) 
 		sf_error ("%s: trouble reading: %lu of %lu",__FILE__,got,size);
 	    break;
@@ -1307,8 +1664,7 @@ void sf_ucharread (/*@out@*/ unsigned char* arr, size_t size, sf_file file)
 void sf_intwrite (int* arr, size_t size, sf_file file)
 /*< write an int array arr[size] to file >*/
 {
-    char* buf;
-    size_t i, left, nbuf, bufsiz;
+    size_t i, left, nbuf;
 	
     if (NULL != file->dataname) sf_fileflush (file,infiles[0]);
     switch(file->form) {
@@ -1326,21 +1682,10 @@ void sf_intwrite (int* arr, size_t size, sf_file file)
 	    }
 	    break;
 	case SF_XDR:
-	    size *= sizeof(int);
-	    buf = (char*)arr+size;
-	    bufsiz = sf_bufsiz(file);
-	    for (left = size; left > 0; left -= nbuf) {
-		nbuf = (bufsiz < left)? bufsiz : left;
-		(void) xdr_setpos(&(file->xdr),0);
-		if (!xdr_vector(&(file->xdr),buf-left,
-				nbuf/sizeof(int),sizeof(int),
-				(xdrproc_t) xdr_int))
-		    sf_error ("sf_file: trouble writing xdr");
-		fwrite(file->buf,1,nbuf,file->stream);
-	    }
+	    xdrwrite4(arr,size,file);
 	    break;
 	default:
-	    fwrite(arr,sizeof(int),size,file->stream);
+	    datawrite(arr,sizeof(int),size,file);
 	    break;
     }
 }
@@ -1348,8 +1693,7 @@ void sf_intwrite (int* arr, size_t size, sf_file file)
 void sf_intread (/*@out@*/ int* arr, size_t size, sf_file file)
 /*< read an int array arr[size] from file >*/
 {
-    char* buf;
-    size_t i, left, nbuf, got, bufsiz;
+    size_t i, got;
 	
     switch (file->form) {
 	case SF_ASCII:
@@ -1359,22 +1703,10 @@ void sf_intread (/*@out@*/ int* arr, size_t size, sf_file file)
 	    }
 	    break;
 	case SF_XDR:
-	    size *= sizeof(int);
-	    buf = (char*)arr+size;
-	    bufsiz = sf_bufsiz(file);
-	    for (left = size; left > 0; left -= nbuf) {
-		nbuf = (bufsiz < left)? bufsiz : left;
-		(void) xdr_setpos(&(file->xdr),0);
-		if (nbuf != fread(file->buf,1,nbuf,file->stream))
-		    sf_error ("%s: trouble reading:",__FILE__);
-		if (!xdr_vector(&(file->xdr),buf-left,
-				nbuf/sizeof(int),sizeof(int),
-				(xdrproc_t) xdr_int))
-		    sf_error ("%s: trouble reading xdr",__FILE__);
-	    }
+	    xdrread4(arr,size,file);
 	    break;
 	default:
-	    got = fread(arr,sizeof(int),size,file->stream);
+	    got = dataread(arr,sizeof(int),size,file);
 	    if (got != size) 
 		sf_error ("%s: trouble reading: %lu of %lu",__FILE__,got,size);
 	    break;
@@ -1401,7 +1733,7 @@ void sf_shortread (/*@out@*/ short* arr, size_t size, sf_file file)
 	    for (left = size; left > 0; left -= nbuf) {
 		nbuf = (bufsiz < left)? bufsiz : left;
 		(void) xdr_setpos(&(file->xdr),0);
-		if (nbuf != fread(file->buf,1,nbuf,file->stream))
+		if (nbuf != dataread(file->buf,1,nbuf,file))
 		    sf_error ("%s: trouble reading:",__FILE__);
 		if (!xdr_vector(&(file->xdr),buf-left,
 				nbuf/sizeof(short),sizeof(short),
@@ -1410,7 +1742,7 @@ void sf_shortread (/*@out@*/ short* arr, size_t size, sf_file file)
 	    }
 	    break;
 	default:
-	    got = fread(arr,sizeof(short),size,file->stream);
+	    got = dataread(arr,sizeof(short),size,file);
 	    if (got != size) 
 		sf_error ("%s: trouble reading: %lu of %lu",__FILE__,got,size);
 	    break;
@@ -1437,7 +1769,7 @@ void sf_longread (/*@out@*/ off_t* arr, size_t size, sf_file file)
 	    for (left = size; left > 0; left -= nbuf) {
 		nbuf = (bufsiz < left)? bufsiz : left;
 		(void) xdr_setpos(&(file->xdr),0);
-		if (nbuf != fread(file->buf,1,nbuf,file->stream))
+		if (nbuf != dataread(file->buf,1,nbuf,file))
 		    sf_error ("%s: trouble reading:",__FILE__);
 		if (!xdr_vector(&(file->xdr),buf-left,
 				nbuf/sizeof(off_t),sizeof(off_t),
@@ -1446,7 +1778,7 @@ void sf_longread (/*@out@*/ off_t* arr, size_t size, sf_file file)
 	    }
 	    break;
 	default:
-	    got = fread(arr,sizeof(off_t),size,file->stream);
+	    got = dataread(arr,sizeof(off_t),size,file);
 	    if (got != size) 
 		sf_error ("%s: trouble reading: %lu of %lu",__FILE__,got,size);
 	    break;
@@ -1486,11 +1818,11 @@ void sf_shortwrite (short* arr, size_t size, sf_file file)
 				nbuf/sizeof(short),sizeof(short),
 				(xdrproc_t) xdr_int))
 		    sf_error ("sf_file: trouble writing xdr");
-		fwrite(file->buf,1,nbuf,file->stream);
+		datawrite(file->buf,1,nbuf,file);
 	    }
 	    break;
 	default:
-	    fwrite(arr,sizeof(short),size,file->stream);
+	    datawrite(arr,sizeof(short),size,file);
 	    break;
     }
 }
@@ -1498,8 +1830,7 @@ void sf_shortwrite (short* arr, size_t size, sf_file file)
 void sf_floatwrite (float* arr, size_t size, sf_file file)
 /*< write a float array arr[size] to file >*/
 {
-    char* buf;
-    size_t i, left, nbuf, bufsiz;
+    size_t i, left, nbuf;
 	
     if (NULL != file->dataname) sf_fileflush (file,infiles[0]);
     switch(file->form) {
@@ -1517,21 +1848,10 @@ void sf_floatwrite (float* arr, size_t size, sf_file file)
 	    }
 	    break;
 	case SF_XDR:
-	    size *= sizeof(float);
-	    buf = (char*)arr+size;
-	    bufsiz = sf_bufsiz(file);
-	    for (left = size; left > 0; left -= nbuf) {
-		nbuf = (bufsiz < left)? bufsiz : left;
-		(void) xdr_setpos(&(file->xdr),0);
-		if (!xdr_vector(&(file->xdr),buf-left,
-				nbuf/sizeof(float),sizeof(float),
-				(xdrproc_t) xdr_float))
-		    sf_error ("sf_file: trouble writing xdr");
-		fwrite(file->buf,1,nbuf,file->stream);
-	    }
+	    xdrwrite4(arr,size,file);
 	    break;
 	default:
-	    fwrite(arr,sizeof(float),size,file->stream);
+	    datawrite(arr,sizeof(float),size,file);
 	    break;
     }
 }
@@ -1539,8 +1859,7 @@ void sf_floatwrite (float* arr, size_t size, sf_file file)
 void sf_floatread (/*@out@*/ float* arr, size_t size, sf_file file)
 /*< read a float array arr[size] from file >*/
 {
-    char* buf;
-    size_t i, left, nbuf, got, bufsiz;
+    size_t i, got;
 	
     switch (file->form) {
 	case SF_ASCII:
@@ -1550,28 +1869,106 @@ void sf_floatread (/*@out@*/ float* arr, size_t size, sf_file file)
 	    }
 	    break;
 	case SF_XDR:
-	    size *= sizeof(float);
-	    buf = (char*)arr+size;
-	    bufsiz = sf_bufsiz(file);
-	    for (left = size; left > 0; left -= nbuf) {
-		nbuf = (bufsiz < left)? bufsiz : left;
-		(void) xdr_setpos(&(file->xdr),0);
-		if (nbuf != fread(file->buf,1,nbuf,file->stream))
-		    sf_error ("%s: trouble reading:",__FILE__);
-		if (!xdr_vector(&(file->xdr),buf-left,
-				nbuf/sizeof(float),sizeof(float),
-				(xdrproc_t) xdr_float))
-		    sf_error ("%s: trouble reading xdr",__FILE__);
-	    }
+	    xdrread4(arr,size,file);
 	    break;
 	default:
-	    got = fread(arr,sizeof(float),size,file->stream);
+	    got = dataread(arr,sizeof(float),size,file);
 	    if (got != size) 
 		sf_error ("%s: trouble reading: %lu of %lu",__FILE__,got,size);
 	    break;
     }
 }
 
+static bool mapdata (sf_file file, off_t end)
+/* map the data file at least up to byte end */
+{
+    int fd;
+    off_t size;
+    struct stat buf;
+    void *map;
+
+    if (XDR_DECODE != file->op || SF_NATIVE != file->form) return false;
+    if (end <= (off_t) file->mapsize) return true;
+
+    fd = fileno(file->stream);
+    if (fstat(fd,&buf) || !S_ISREG(buf.st_mode)) return false;
+    size = buf.st_size;
+    if (end > size) 
+	sf_error ("%s: trouble mapping: %lld of %lld",__FILE__,
+		  (long long) end,(long long) size);
+    if (0 == size || (off_t) (size_t) size != size) return false;
+
+    unmapdata(file);
+
+    map = mmap(NULL,(size_t) size,PROT_READ,MAP_SHARED,fd,0);
+    if (MAP_FAILED == map) return false;
+    (void) madvise(map,(size_t) size,MADV_SEQUENTIAL);
+
+    file->map = (char*) map;
+    file->mapsize = (size_t) size;
+    return true;
+}
+
+static void unmapdata (sf_file file)
+/* release the data mapping */
+{
+    if (NULL == file->map) return;
+    (void) munmap(file->map,file->mapsize);
+    file->map = NULL;
+    file->mapsize = 0;
+}
+
+const void* sf_mapwindow (sf_file file, off_t offset, size_t size)
+/*< Read-only pointer to size bytes of data starting at offset.
+  ---
+  offset is a position in the sense of sf_seek/sf_tell. The pointer stays
+  valid until the file is closed or unpiped. Returns NULL when the data
+  is not a seekable native-form input, use the sf_*read functions then. >*/
+{
+    if (offset < 0 || !mapdata(file,offset+(off_t) size)) return NULL;
+    return file->map+offset;
+}
+
+const char* sf_charmap (size_t size, sf_file file)
+/*< Map the next size bytes of file and skip past them (NULL if not mappable) >*/
+{
+    off_t pos;
+    const char *map;
+
+    if (SF_NATIVE != file->form) return NULL;
+    pos = sf_tell(file);
+    if (pos < 0) return NULL;
+
+    map = (const char*) sf_mapwindow(file,pos,size);
+    if (NULL != map) sf_seek(file,pos+(off_t) size,SEEK_SET);
+    return map;
+}
+
+static const void* alignedmap (size_t size, size_t align, sf_file file)
+/* sequential mapping of size bytes aligned on align */
+{
+    off_t pos;
+
+    if (SF_NATIVE != file->form) return NULL;
+    pos = sf_tell(file);
+    if (pos < 0 || 0 != pos%((off_t) align)) return NULL;
+
+    return sf_charmap(size,file);
+}
+
+const float* sf_floatmap (size_t size, sf_file file)
+/*< Map the next size floats of file and skip past them (NULL if not mappable) >*/
+{
+    return (const float*) alignedmap(size*sizeof(float),sizeof(float),file);
+}
+
+const sf_complex* sf_complexmap (size_t size, sf_file file)
+/*< Map the next size complex numbers of file and skip past them (NULL if not mappable) >*/
+{
+    return (const sf_complex*) alignedmap(size*sizeof(sf_complex),
+					  sizeof(float),file);
+}
+
 off_t sf_bytes (sf_file file)
 /*< Count the file data size (in bytes) >*/
 {
@@ -1595,6 +1992,11 @@ off_t sf_tell (sf_file file)
 /*< Find position in file >*/
 {
     extern off_t ftello (FILE *stream);
+
+#ifdef SF_HAS_PTHREADS
+    if (NULL != file->aio && file->aio->start >= 0)
+	return file->aio->start+file->aio->count;
+#endif
     return ftello(file->stream);
 }
 
@@ -1628,6 +2030,8 @@ void sf_seek (sf_file file, off_t offset, int whence)
 {
     extern int fseeko(FILE *stream, off_t offset, int whence);
 	
+    async_stop(file,NULL,false);
+    file->seeked = true;
     if (0 > fseeko(file->stream,offset,whence))
 	sf_error ("%s: seek problem:",__FILE__);
 }
@@ -1635,7 +2039,10 @@ void sf_seek (sf_file file, off_t offset, int whence)
 FILE* sf_filestream (sf_file file)
 /*< Returns file descriptor to a stream >*/
 {
-    return file ? file->stream : NULL;
+    if (NULL == file) return NULL;
+    async_stop(file,NULL,false); /* the caller takes over the stream */
+    file->async = false;
+    return file->stream;
 }
 
 void sf_unpipe (sf_file file, off_t size) 
@@ -1655,13 +2062,16 @@ void sf_unpipe (sf_file file, off_t size)
 	
     while (size > 0) {
 	nbuf = (bufsiz < size)? bufsiz : size;
-	if (nbuf != fread(buf,1,nbuf,file->stream) ||
+	if (nbuf != dataread(buf,1,nbuf,file) ||
 	    nbuf != fwrite(buf,1,nbuf,tmp))
 	    sf_error ("%s: trouble unpiping:",__FILE__);
 	size -= nbuf;
     }
 	
     free(buf);
+
+    /* keep whatever was read ahead */
+    async_stop(file,tmp,false);
 	
     if (NULL != file->dataname ) {
 	len = strlen(dataname)+1;
@@ -1674,6 +2084,7 @@ void sf_unpipe (sf_file file, off_t size)
       sf_warning ("%s: trouble removing %s:",__FILE__,file->dataname);
     */
 	
+    unmapdata(file);
     (void) fclose(file->stream);
     file->stream = freopen(dataname,"r+b",tmp);
 	
@@ -32,24 +32,62 @@
 #include "kiss_fftr.h"
 #include "_kiss_fft_guts.h"
 
-static int nfft, nw;
-static kiss_fft_cpx *cdata, *shape=NULL;
-static float *tmp;
-static kiss_fftr_cfg forw, invs;
+#ifndef _sf_freqfilt_h
+
+typedef struct sf_Freqfilter *sf_freqfilter;
+/* abstract data type */
+/*^*/
+
+#endif
+
+struct sf_Freqfilter {
+    int nfft, nw;
+    kiss_fft_cpx *cdata, *shape;
+    float *tmp;
+    kiss_fftr_cfg forw, invs;
+};
+
+static struct sf_Freqfilter ff0 = {0,0,NULL,NULL,NULL,NULL,NULL};
+
+static void freqfilt_alloc(sf_freqfilter ff, int nfft1, int nw1)
+{
+    ff->nfft = nfft1;
+    ff->nw = nw1;
+
+    ff->cdata = (kiss_fft_cpx*) sf_alloc(nw1,sizeof(kiss_fft_cpx));
+    ff->tmp = sf_floatalloc(nfft1);
+    ff->forw = kiss_fftr_alloc(nfft1,0,NULL,NULL);
+    ff->invs = kiss_fftr_alloc(nfft1,1,NULL,NULL);
+    if (NULL == ff->forw || NULL == ff->invs) 
+	sf_error("%s: KISS FFT allocation problem",__FILE__);
+}
+
+static void freqfilt_free(sf_freqfilter ff)
+{
+    free(ff->cdata);
+    free(ff->tmp);
+    free(ff->forw);
+    free(ff->invs);
+}
+
+sf_freqfilter sf_freqfilt_init_r(int nfft1 /* time samples (possibly padded) */, 
+				 int nw1   /* frequency samples */)
+/*< Initialize a reentrant filter, to be used with sf_freqfilt_lop_r >*/
+{
+    sf_freqfilter ff;
+
+    ff = (sf_freqfilter) sf_alloc(1,sizeof(*ff));
+    freqfilt_alloc(ff,nfft1,nw1);
+    ff->shape = NULL;
+
+    return ff;
+}
 
 void sf_freqfilt_init(int nfft1 /* time samples (possibly padded) */, 
 		      int nw1   /* frequency samples */)
 /*< Initialize >*/
 {
-    nfft = nfft1;
-    nw = nw1;
-
-    cdata = (kiss_fft_cpx*) sf_alloc(nw,sizeof(kiss_fft_cpx));
-    tmp = sf_floatalloc(nfft);
-    forw = kiss_fftr_alloc(nfft,0,NULL,NULL);
-    invs = kiss_fftr_alloc(nfft,1,NULL,NULL);
-    if (NULL == forw || NULL == invs) 
-	sf_error("%s: KISS FFT allocation problem",__FILE__);
+    freqfilt_alloc(&ff0,nfft1,nw1);
 }
 
 void sf_freqfilt_set(float *filt /* frequency filter [nw] */)
@@ -57,74 +95,105 @@ void sf_freqfilt_set(float *filt /* frequency filter [nw] */)
 {
     int iw;
     
-    if (NULL==shape) shape = (kiss_fft_cpx*) sf_alloc(nw,sizeof(kiss_fft_cpx));
+    if (NULL==ff0.shape) 
+	ff0.shape = (kiss_fft_cpx*) sf_alloc(ff0.nw,sizeof(kiss_fft_cpx));
 
-    for (iw=0; iw < nw; iw++) {
-	shape[iw].r = filt[iw];
-	shape[iw].i = 0.;
+    for (iw=0; iw < ff0.nw; iw++) {
+	ff0.shape[iw].r = filt[iw];
+	ff0.shape[iw].i = 0.;
     }
 }
 
 /* #ifndef __cplusplus */
 /*^*/
 
+void sf_freqfilt_cset_r(sf_freqfilter ff, 
+			kiss_fft_cpx *filt /* frequency filter [nw] */)
+/*< Initialize reentrant filter (filt is not copied and can be shared) >*/
+{
+    ff->shape = filt;
+}
+
 void sf_freqfilt_cset(kiss_fft_cpx *filt /* frequency filter [nw] */)
 /*< Initialize filter >*/
 {
-    shape = filt;
+    ff0.shape = filt;
+}
+
+void sf_freqfilt_close_r(sf_freqfilter ff) 
+/*< Free reentrant filter (not the shape) >*/
+{
+    freqfilt_free(ff);
+    free(ff);
 }
 
 void sf_freqfilt_close(void) 
 /*< Free allocated storage >*/
 {
-    free(cdata);
-    free(tmp);
-    free(forw);
-    free(invs);
+    freqfilt_free(&ff0);
 }
 
-void sf_freqfilt(int nx, float* x)
-/*< Filtering in place >*/
+void sf_freqfilt_r(sf_freqfilter ff, int nx, float* x)
+/*< Filtering in place with its own state >*/
 {
-    kiss_fft_cpx c;
+    kiss_fft_cpx c, *cdata, *shape;
+    float *tmp;
     int iw;
 
+    cdata = ff->cdata;
+    shape = ff->shape;
+    tmp = ff->tmp;
+
     for (iw=0; iw < nx; iw++) {
 	tmp[iw] = x[iw];
     }
-    for (iw=nx; iw < nfft; iw++) {
+    for (iw=nx; iw < ff->nfft; iw++) {
 	tmp[iw] = 0.;
     }
 
-    kiss_fftr(forw, tmp, cdata);
-    for (iw=0; iw < nw; iw++) {
+    kiss_fftr(ff->forw, tmp, cdata);
+    for (iw=0; iw < ff->nw; iw++) {
 	C_MUL(c,cdata[iw],shape[iw]);
 	cdata[iw]=c;
     }
-    kiss_fftri(invs, cdata, tmp);
+    kiss_fftri(ff->invs, cdata, tmp);
 
     for (iw=0; iw < nx; iw++) {
 	x[iw] = tmp[iw];
     } 
 }
 
-void sf_freqfilt_lop (bool adj, bool add, int nx, int ny, float* x, float* y) 
-/*< Filtering as linear operator >*/
+void sf_freqfilt(int nx, float* x)
+/*< Filtering in place >*/
 {
-    kiss_fft_cpx c;
+    sf_freqfilt_r(&ff0,nx,x);
+}
+
+void sf_freqfilt_lop_r (void *data /* sf_freqfilter */, 
+			bool adj, bool add, int nx, int ny, float* x, float* y) 
+/*< Filtering as linear operator with its own state >*/
+{
+    kiss_fft_cpx c, *cdata, *shape;
+    float *tmp;
     int iw;
+    sf_freqfilter ff;
+
+    ff = (sf_freqfilter) data;
+    cdata = ff->cdata;
+    shape = ff->shape;
+    tmp = ff->tmp;
 
     sf_adjnull(adj,add,nx,ny,x,y);
 
     for (iw=0; iw < nx; iw++) {
 	tmp[iw] = adj? y[iw] : x[iw];
     }
-    for (iw=nx; iw < nfft; iw++) {
+    for (iw=nx; iw < ff->nfft; iw++) {
 	tmp[iw] = 0.;
     }
 
-    kiss_fftr(forw, tmp, cdata);
-    for (iw=0; iw < nw; iw++) {
+    kiss_fftr(ff->forw, tmp, cdata);
+    for (iw=0; iw < ff->nw; iw++) {
         if (adj) {
 	    C_MUL(c,cdata[iw],sf_conjf(shape[iw]));
         } else {
@@ -132,7 +201,7 @@ void sf_freqfilt_lop (bool adj, bool add, int nx, int ny, float* x, float* y)
         }
 	cdata[iw]=c;
     }
-    kiss_fftri(invs, cdata, tmp);
+    kiss_fftri(ff->invs, cdata, tmp);
 
     for (iw=0; iw < nx; iw++) {	    
 	if (adj) {
@@ -143,6 +212,12 @@ void sf_freqfilt_lop (bool adj, bool add, int nx, int ny, float* x, float* y)
     } 
 }
 
+void sf_freqfilt_lop (bool adj, bool add, int nx, int ny, float* x, float* y) 
+/*< Filtering as linear operator >*/
+{
+    sf_freqfilt_lop_r(&ff0,adj,add,nx,ny,x,y);
+}
+
 /* #endif */
 
 /* 	$Id$	 */
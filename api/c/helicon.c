@@ -32,31 +32,41 @@ void sf_helicon_init( sf_filter bb)
     aa = bb;
 }
 
-void sf_helicon_lop( bool adj, bool add, 
-		     int nx, int ny, float* xx, float*yy) 
-/*< linear operator >*/
+void sf_helicon_lop_r(void *data /* sf_filter */, bool adj, bool add, 
+		      int nx, int ny, float* xx, float*yy) 
+/*< linear operator with its own filter >*/
 {
     int ia, iy, ix;
+    sf_filter bb;
+
+    bb = (sf_filter) data;
     
     sf_copy_lop(adj, add, nx, nx, xx, yy);
 
     if(adj) {
-        for (ia = 0; ia < aa->nh; ia++) {
-	    for (iy = aa->lag[ia]; iy < nx; iy++) {
-	        if( aa->mis != NULL && aa->mis[iy]) continue;
-	        ix = iy - aa->lag[ia];
-	        xx[ix] += yy[iy] * aa->flt[ia];
+        for (ia = 0; ia < bb->nh; ia++) {
+	    for (iy = bb->lag[ia]; iy < nx; iy++) {
+	        if( bb->mis != NULL && bb->mis[iy]) continue;
+	        ix = iy - bb->lag[ia];
+	        xx[ix] += yy[iy] * bb->flt[ia];
 	    }
 	}
     } else {
-        for (ia = 0; ia < aa->nh; ia++) {
-	    for (iy = aa->lag[ia]; iy < nx; iy++) {
-	        if( aa->mis != NULL && aa->mis[iy]) continue;
-	        ix = iy - aa->lag[ia];
-	        yy[iy] += xx[ix] * aa->flt[ia];
+        for (ia = 0; ia < bb->nh; ia++) {
+	    for (iy = bb->lag[ia]; iy < nx; iy++) {
+	        if( bb->mis != NULL && bb->mis[iy]) continue;
+	        ix = iy - bb->lag[ia];
+	        yy[iy] += xx[ix] * bb->flt[ia];
 	    }
 	}
     }
 }
 
+void sf_helicon_lop( bool adj, bool add, 
+		     int nx, int ny, float* xx, float*yy) 
+/*< linear operator >*/
+{
+    sf_helicon_lop_r(aa,adj,add,nx,ny,xx,yy);
+}
+
 /* 	$Id$	 */
@@ -0,0 +1,84 @@
+/*
+  kiss_fft and kiss_fftr compiled a second time with USE_SIMD, so that
+  each scalar is a vector of KISS_FFTV_LANES floats and every lane
+  carries an independent trace. The arithmetic in each lane is the
+  same as in the scalar build.
+
+  See kiss_fft.c and kiss_fftr.c for the copyright and license.
+*/
+
+#include "kiss_fftv.h"
+
+#if defined(__SSE__) && !defined(FIXED_POINT)
+
+#define USE_SIMD
+
+/* keep the vector build apart from the scalar one */
+#define kiss_fft_state          kiss_fftv_state
+#define kiss_fft_alloc          kiss_fftv_alloc
+#define kiss_fft_stride         kiss_fftv_stride
+#define kiss_fft                kiss_fftv
+#define kiss_fft_cleanup        kiss_fftv_cleanup
+#define kiss_fft_next_fast_size kiss_fftv_next_fast_size
+#define kiss_fftr_state         kiss_fftrv_state
+#define kiss_fftr_alloc         kiss_fftrv_alloc_mem
+#define kiss_fftr               kiss_fftrv_cpx
+#define kiss_fftri              kiss_fftriv_cpx
+
+#include "kiss_fft.c"
+#include "kiss_fftr.c"
+
+int kiss_fftv_lanes(void)
+{
+    return KISS_FFTV_LANES;
+}
+
+kiss_fftrv_cfg kiss_fftrv_alloc(int nfft,int inverse_fft)
+{
+    return kiss_fftrv_alloc_mem(nfft,inverse_fft,NULL,NULL);
+}
+
+void kiss_fftrv(kiss_fftrv_cfg cfg,const float *timedata,float *freqdata)
+{
+    kiss_fftrv_cpx(cfg,(const kiss_fft_scalar*) timedata,(kiss_fft_cpx*) freqdata);
+}
+
+void kiss_fftriv(kiss_fftrv_cfg cfg,const float *freqdata,float *timedata)
+{
+    kiss_fftriv_cpx(cfg,(const kiss_fft_cpx*) freqdata,(kiss_fft_scalar*) timedata);
+}
+
+void kiss_fftrv_free(kiss_fftrv_cfg cfg)
+{
+    KISS_FFT_FREE(cfg);
+}
+
+#else
+
+#include <stdlib.h>
+
+int kiss_fftv_lanes(void)
+{
+    return 0;
+}
+
+kiss_fftrv_cfg kiss_fftrv_alloc(int nfft,int inverse_fft)
+{
+    return NULL;
+}
+
+void kiss_fftrv(kiss_fftrv_cfg cfg,const float *timedata,float *freqdata)
+{
+    abort();
+}
+
+void kiss_fftriv(kiss_fftrv_cfg cfg,const float *freqdata,float *timedata)
+{
+    abort();
+}
+
+void kiss_fftrv_free(kiss_fftrv_cfg cfg)
+{
+}
+
+#endif
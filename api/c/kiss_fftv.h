@@ -0,0 +1,49 @@
+#ifndef KISS_FFTV_H
+#define KISS_FFTV_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+  kiss_fftr compiled with USE_SIMD: real FFTs of KISS_FFTV_LANES
+  independent traces at once, one trace per SIMD lane.
+
+  Data are interleaved by lanes: sample i of trace l is at
+  timedata[i*KISS_FFTV_LANES+l], the real and imaginary parts of
+  frequency k of trace l are at freqdata[(2*k)*KISS_FFTV_LANES+l] and
+  freqdata[(2*k+1)*KISS_FFTV_LANES+l].
+
+  Where SIMD is not available, kiss_fftv_lanes() returns 0 and the
+  other functions must not be called.
+*/
+
+#define KISS_FFTV_LANES 4
+
+typedef struct kiss_fftrv_state *kiss_fftrv_cfg;
+
+int kiss_fftv_lanes(void);
+
+kiss_fftrv_cfg kiss_fftrv_alloc(int nfft,int inverse_fft);
+/*
+ nfft must be even
+*/
+
+void kiss_fftrv(kiss_fftrv_cfg cfg,const float *timedata,float *freqdata);
+/*
+ input timedata has nfft*KISS_FFTV_LANES scalar points
+ output freqdata has (nfft/2+1)*2*KISS_FFTV_LANES scalar points
+*/
+
+void kiss_fftriv(kiss_fftrv_cfg cfg,const float *freqdata,float *timedata);
+/*
+ input freqdata has (nfft/2+1)*2*KISS_FFTV_LANES scalar points
+ output timedata has nfft*KISS_FFTV_LANES scalar points
+*/
+
+void kiss_fftrv_free(kiss_fftrv_cfg cfg);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
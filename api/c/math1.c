@@ -34,6 +34,10 @@
 #include "file.h"
 /*^*/
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 static float mysign(float f)
 {
     f = (f >= 0  ?  1.0f  :  -1.0f );
@@ -153,288 +157,607 @@ static sf_stack st1, st2;
 
 static void check (void);
 
+#ifndef _sf_math1_h
 
-void sf_math_evaluate (int     len  /* stack length */, 
-		       int     nbuf /* buffer length */, 
-		       float** fbuf /* number buffers */, 
-		       float** fst  /* stack */)
-/*< Evaluate a mathematical expression from stack (float numbers) >*/
+typedef struct sf_Mathprog *sf_mathprog;
+/* compiled expression */
+/*^*/
+
+#endif
+
+#define MATH_BLOCK 256
+/* samples evaluated together, small enough for the stack to stay in cache */
+
+enum {OP_NUM, OP_BUF, OP_AXIS, OP_FUN, OP_NEG, OP_BIN, OP_BINK};
+enum {B_ADD, B_SUB, B_MUL, B_DIV, B_POW, B_ATAN2, B_MOD, B_LEFT};
+
+struct mathop {
+    int op, arg; /* buffer, axis, function, or binary operation */
+    float f;     /* float constant */
+    int i;       /* integer constant */
+};
+
+struct sf_Mathprog {
+    sf_datatype type;
+    int nop, depth, nth, first, dim;
+    struct mathop *ops;
+    off_t n[SF_MAX_DIM], s[SF_MAX_DIM];
+    float o[SF_MAX_DIM], d[SF_MAX_DIM];
+    char *work;
+};
+
+static sf_mathprog fprog=NULL, iprog=NULL, cprog=NULL;
+
+sf_mathprog sf_math_compile (int         len  /* stack length */,
+			     sf_datatype type /* data type */)
+/*< Compile the expression from sf_math_parse into a program evaluated
+  block by block with sf_math_run, sf_int_math_run, or
+  sf_complex_math_run >*/
 {
+    int k, depth;
     char *op;
-    int *indx, i;
-    float *num, f, *farr;
-    func fun;
+    size_t size;
+    sf_mathprog p;
+    struct mathop *q;
+
+    p = (sf_mathprog) sf_alloc(1,sizeof(*p));
+    p->type = type;
+    p->ops = (struct mathop*) sf_alloc(len+1,sizeof(struct mathop));
+    p->first = 0;
+    p->dim = 0;
+
+    depth = p->depth = 0;
+    k = 0;
 
     sf_stack_set(st2,len);
 
     while (sf_full (st2)) {
+	q = p->ops+k;
 	switch (sf_top (st2)) {
-	    case NUM: 
-		farr = *(++fst);
-		num = (float*) sf_pop(st2);
-		f = *num;
-		for (i=0; i < nbuf; i++) { farr[i] = f; }
+	    case NUM:
+		q->op = OP_NUM;
+		if (SF_INT == type) {
+		    q->i = *((int*) sf_pop(st2));
+		} else {
+		    q->f = *((float*) sf_pop(st2));
+		}
+		depth++;
 		break;
 	    case INDX:
-		farr = *(++fst);
-		indx = (int*) sf_pop(st2);
-		/* convert index to number */
-		num = *(fbuf + (*indx));
-		for (i=0; i < nbuf; i++) { farr[i] = num[i]; }
+		q->op = OP_BUF;
+		q->arg = *((int*) sf_pop(st2));
+		depth++;
 		break;
 	    case FUN:
-		indx = (int*) sf_pop(st2);
-		fun = functable[*indx];
-		farr = *fst;
-		for (i=0; i < nbuf; i++) { farr[i] = fun(farr[i]); }
+		q->op = OP_FUN;
+		q->arg = *((int*) sf_pop(st2));
 		break;
 	    case UNARY:
 		op = (char*) sf_pop(st2);
-		farr = *fst;
-		if ('-' == *op) {
-		    for (i=0; i < nbuf; i++) { farr[i] = -farr[i]; }
-		}
+		if ('-' != *op) continue;
+		q->op = OP_NEG;
 		break;
 	    case POW:
 		op = (char*) sf_pop(st2);
-		num = *fst;
-		farr = *(--fst);
+		q->op = OP_BIN;
 		if ('^' == *op) {
-		    for (i=0; i < nbuf; i++) { 
-			farr[i] = powf(farr[i],num[i]);
-		    }
+		    q->arg = B_POW;
+		} else if (SF_FLOAT == type) {
+		    q->arg = B_ATAN2;
+		} else if (SF_COMPLEX == type) {
+		    q->arg = B_LEFT;
 		} else {
-		    for (i=0; i < nbuf; i++) { 
-			farr[i] = atan2f(farr[i],num[i]);
-		    }
+		    sf_error("unsupported \"%s\" operation",op);
 		}
+		depth--;
+		break;
+	    case MOD:
+		if (SF_INT != type) 
+		    sf_error ("%s: syntax error in output",__FILE__);
+		(void) sf_pop(st2);
+		q->op = OP_BIN;
+		q->arg = B_MOD;
+		depth--;
 		break;
 	    case MULDIV:
 		op = (char*) sf_pop(st2);
-		num = *fst;
-		farr = *(--fst);
-		if ('*' == *op) {
-		    for (i=0; i < nbuf; i++) { farr[i] *= num[i]; }
-		} else {
-		    for (i=0; i < nbuf; i++) { farr[i] /= num[i]; }
-		}
+		q->op = OP_BIN;
+		q->arg = ('*' == *op)? B_MUL: B_DIV;
+		depth--;
 		break;
 	    case PLUSMIN:
 		op = (char*) sf_pop(st2);
-		num = *fst;
-		farr = *(--fst);
-		if ('+' == *op) {
-		    for (i=0; i < nbuf; i++) { farr[i] += num[i]; }
-		} else {
-		    for (i=0; i < nbuf; i++) { farr[i] -= num[i]; }
-		}
+		q->op = OP_BIN;
+		q->arg = ('+' == *op)? B_ADD: B_SUB;
+		depth--;
 		break;
 	    default:
 		sf_error ("%s: syntax error in output",__FILE__);
 		break;
 	}
+
+	/* operation with a constant */
+	if (OP_BIN == q->op && k > 0 && OP_NUM == q[-1].op) {
+	    q[-1].op = OP_BINK;
+	    q[-1].arg = q->arg;
+	    k--;
+	}
+
+	if (depth > p->depth) p->depth = depth;
+	k++;
+    }
+    p->nop = k;
+
+#ifdef _OPENMP
+    p->nth = omp_get_max_threads();
+#else
+    p->nth = 1;
+#endif
+
+    switch (type) {
+	case SF_INT: size = sizeof(int); break;
+	case SF_COMPLEX: size = sizeof(sf_complex); break;
+	default: size = sizeof(float); break;
     }
+    p->work = (char*) sf_alloc((size_t) p->nth*p->depth*MATH_BLOCK,size);
+
+    return p;
 }
 
-void sf_int_math_evaluate (int   len  /* stack length */, 
-			   int   nbuf /* buffer length */, 
-			   int** ibuf /* number buffers */, 
-			   int** ist  /* stack */)
-/*< Evaluate a mathematical expression from stack (integer numbers) >*/
+void sf_math_axes (sf_mathprog  p,
+		   int          first /* index of the first coordinate */,
+		   int          dim   /* number of dimensions */,
+		   const off_t* n     /* grid size [dim] */,
+		   const float* o     /* grid origin [dim] */,
+		   const float* d     /* grid sampling [dim] */)
+/*< Generate coordinates x1, x2, ... of a regular grid on the fly
+  instead of reading them from buffers first, first+1, ... >*/
 {
-    char *op;
-    int *indx, i, *num, j, k, *iarr;
-    ifunc fun;
+    int i, k;
 
-    sf_stack_set(st2,len);
+    p->first = first;
+    p->dim = dim;
+    for (i=0; i < dim; i++) {
+	p->n[i] = n[i];
+	p->s[i] = (0==i)? 1: p->s[i-1]*n[i-1];
+	p->o[i] = o[i];
+	p->d[i] = d[i];
+    }
 
-    while (sf_full (st2)) {
-	switch (sf_top (st2)) {
-	    case NUM: 
-		iarr = *(++ist);
-		num = (int*) sf_pop(st2);
-		j = *num;
-		for (i=0; i < nbuf; i++) { iarr[i] = j; }
+    for (k=0; k < p->nop; k++) {
+	if (OP_BUF == p->ops[k].op && 
+	    p->ops[k].arg >= first && p->ops[k].arg < first+dim) {
+	    p->ops[k].op = OP_AXIS;
+	    p->ops[k].arg -= first;
+	}
+    }
+}
+
+void sf_math_close (sf_mathprog p)
+/*< Free a compiled expression >*/
+{
+    free(p->work);
+    free(p->ops);
+    free(p);
+}
+
+static void coord (const sf_mathprog p, int i, off_t j, int nb, float *x)
+/* coordinate i of samples j to j+nb-1 */
+{
+    int k;
+    off_t q, r;
+    float v;
+
+    q = j/p->s[i];
+    r = j%p->s[i];
+    for (k=0; k < nb; q++) {
+	v = p->o[i]+(q%p->n[i])*p->d[i];
+	for (r = p->s[i]-r; r > 0 && k < nb; r--, k++) {
+	    x[k] = v;
+	}
+	r = 0;
+    }
+}
+
+static void float_block (const sf_mathprog p, 
+			 int off          /* offset in buffers */,
+			 off_t j          /* first sample */, 
+			 int nb           /* block size */,
+			 float** fbuf     /* number buffers */, 
+			 float* stk       /* stack [depth][MATH_BLOCK] */, 
+			 float* out       /* output [nb] */)
+{
+    int k, i, t;
+    float *x, *y, *num, f;
+    func fun;
+    const struct mathop *q;
+
+    t = -1;
+    for (k=0; k < p->nop; k++) {
+	q = p->ops+k;
+	x = stk+t*MATH_BLOCK;
+	switch (q->op) {
+	    case OP_NUM:
+		x += MATH_BLOCK;
+		t++;
+		f = q->f;
+		for (i=0; i < nb; i++) { x[i] = f; }
 		break;
-	    case INDX:
-		iarr = *(++ist);
-		indx = (int*) sf_pop(st2);
-		/* convert index to number */
-		num = *(ibuf + (*indx));
-		for (i=0; i < nbuf; i++) { iarr[i] = num[i]; }
+	    case OP_BUF:
+		x += MATH_BLOCK;
+		t++;
+		num = fbuf[q->arg]+off;
+		for (i=0; i < nb; i++) { x[i] = num[i]; }
 		break;
-	    case FUN:
-		indx = (int*) sf_pop(st2);
-		fun = ifunctable[*indx];
-		iarr = *ist;
-		for (i=0; i < nbuf; i++) { iarr[i] = fun(iarr[i]); }
+	    case OP_AXIS:
+		x += MATH_BLOCK;
+		t++;
+		coord(p,q->arg,j,nb,x);
 		break;
-	    case UNARY:
-		op = (char*) sf_pop(st2);
-		iarr = *ist;
-		if ('-' == *op) {
-		    for (i=0; i < nbuf; i++) { iarr[i] = -iarr[i]; }
-		}
+	    case OP_FUN:
+		fun = functable[q->arg];
+		for (i=0; i < nb; i++) { x[i] = fun(x[i]); }
 		break;
-	    case POW:
-		op = (char*) sf_pop(st2);
-		num = *ist;
-		iarr = *(--ist);
-		if ('^' == *op) {
-		    for (i=0; i < nbuf; i++) {
-			j=1;
-			for (k=0; k < num[i]; k++) {
-			    j *= iarr[i];
-			}
-			iarr[i] = j;
-		    }
-		} else {
-		    sf_error("unsupported \"%s\" operation",op);
-		}
+	    case OP_NEG:
+		for (i=0; i < nb; i++) { x[i] = -x[i]; }
 		break;
-	    case MOD:
-		op = (char*) sf_pop(st2);
-		num = *ist;
-		iarr = *(--ist);
-		for (i=0; i < nbuf; i++) {
-		    iarr[i] = iarr[i]%num[i];
+	    case OP_BIN:
+		y = x;
+		x -= MATH_BLOCK;
+		t--;
+		switch (q->arg) {
+		    case B_ADD:
+			for (i=0; i < nb; i++) { x[i] += y[i]; }
+			break;
+		    case B_SUB:
+			for (i=0; i < nb; i++) { x[i] -= y[i]; }
+			break;
+		    case B_MUL:
+			for (i=0; i < nb; i++) { x[i] *= y[i]; }
+			break;
+		    case B_DIV:
+			for (i=0; i < nb; i++) { x[i] /= y[i]; }
+			break;
+		    case B_POW:
+			for (i=0; i < nb; i++) { x[i] = powf(x[i],y[i]); }
+			break;
+		    default:
+			for (i=0; i < nb; i++) { x[i] = atan2f(x[i],y[i]); }
+			break;
 		}
 		break;
-	    case MULDIV:
-		op = (char*) sf_pop(st2);
-		num = *ist;
-		iarr = *(--ist);
-		if ('*' == *op) {
-		    for (i=0; i < nbuf; i++) { iarr[i] *= num[i]; }
-		} else {
-		    for (i=0; i < nbuf; i++) { iarr[i] /= num[i]; }
+	    case OP_BINK:
+		f = q->f;
+		switch (q->arg) {
+		    case B_ADD:
+			for (i=0; i < nb; i++) { x[i] += f; }
+			break;
+		    case B_SUB:
+			for (i=0; i < nb; i++) { x[i] -= f; }
+			break;
+		    case B_MUL:
+			for (i=0; i < nb; i++) { x[i] *= f; }
+			break;
+		    case B_DIV:
+			for (i=0; i < nb; i++) { x[i] /= f; }
+			break;
+		    case B_POW:
+			for (i=0; i < nb; i++) { x[i] = powf(x[i],f); }
+			break;
+		    default:
+			for (i=0; i < nb; i++) { x[i] = atan2f(x[i],f); }
+			break;
 		}
 		break;
-	    case PLUSMIN:
-		op = (char*) sf_pop(st2);
-		num = *ist;
-		iarr = *(--ist);
-		if ('+' == *op) {
-		    for (i=0; i < nbuf; i++) { iarr[i] += num[i]; }
+	}
+    }
+
+    for (i=0; i < nb; i++) { out[i] = stk[i]; }
+}
+
+void sf_math_run (sf_mathprog p, 
+		  off_t       first /* index of the first sample (for coordinates) */,
+		  int         nbuf  /* buffer length */, 
+		  float**     fbuf  /* number buffers */, 
+		  float*      out   /* output [nbuf] */)
+/*< Evaluate a compiled expression (float numbers) >*/
+{
+    int ib, nblock, j, nb;
+    float *stk;
+
+    nblock = (nbuf+MATH_BLOCK-1)/MATH_BLOCK;
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(p->nth) schedule(static) private(ib,j,nb,stk) if(nblock > 16)
+#endif
+    for (ib=0; ib < nblock; ib++) {
+	j = ib*MATH_BLOCK;
+	nb = SF_MIN(MATH_BLOCK,nbuf-j);
+#ifdef _OPENMP
+	stk = (float*) p->work+(size_t) p->depth*MATH_BLOCK*omp_get_thread_num();
+#else
+	stk = (float*) p->work;
+#endif
+	float_block(p,j,first+j,nb,fbuf,stk,out+j);
+    }
+}
+
+static void int_block (const sf_mathprog p, 
+		       int off      /* offset in buffers */,
+		       int nb       /* block size */,
+		       int** ibuf   /* number buffers */, 
+		       int* stk     /* stack [depth][MATH_BLOCK] */, 
+		       int* out     /* output [nb] */)
+{
+    int k, i, t, *x, *y, *num, m, j, l;
+    ifunc fun;
+    const struct mathop *q;
+
+    t = -1;
+    for (k=0; k < p->nop; k++) {
+	q = p->ops+k;
+	x = stk+t*MATH_BLOCK;
+	switch (q->op) {
+	    case OP_NUM:
+		x += MATH_BLOCK;
+		t++;
+		m = q->i;
+		for (i=0; i < nb; i++) { x[i] = m; }
+		break;
+	    case OP_BUF:
+		x += MATH_BLOCK;
+		t++;
+		num = ibuf[q->arg]+off;
+		for (i=0; i < nb; i++) { x[i] = num[i]; }
+		break;
+	    case OP_FUN:
+		fun = ifunctable[q->arg];
+		for (i=0; i < nb; i++) { x[i] = fun(x[i]); }
+		break;
+	    case OP_NEG:
+		for (i=0; i < nb; i++) { x[i] = -x[i]; }
+		break;
+	    case OP_BIN:
+	    case OP_BINK:
+		if (OP_BIN == q->op) {
+		    y = x;
+		    x -= MATH_BLOCK;
+		    t--;
 		} else {
-		    for (i=0; i < nbuf; i++) { iarr[i] -= num[i]; }
+		    /* constant operand */
+		    y = x+MATH_BLOCK;
+		    for (i=0; i < nb; i++) { y[i] = q->i; }
+		}
+		switch (q->arg) {
+		    case B_ADD:
+			for (i=0; i < nb; i++) { x[i] += y[i]; }
+			break;
+		    case B_SUB:
+			for (i=0; i < nb; i++) { x[i] -= y[i]; }
+			break;
+		    case B_MUL:
+			for (i=0; i < nb; i++) { x[i] *= y[i]; }
+			break;
+		    case B_DIV:
+			for (i=0; i < nb; i++) { x[i] /= y[i]; }
+			break;
+		    case B_MOD:
+			for (i=0; i < nb; i++) { x[i] = x[i]%y[i]; }
+			break;
+		    default:
+			for (i=0; i < nb; i++) {
+			    j=1;
+			    for (l=0; l < y[i]; l++) {
+				j *= x[i];
+			    }
+			    x[i] = j;
+			}
+			break;
 		}
-		break;
-	    default:
-		sf_error ("%s: syntax error in output",__FILE__);
 		break;
 	}
     }
+
+    for (i=0; i < nb; i++) { out[i] = stk[i]; }
 }
 
+void sf_int_math_run (sf_mathprog p, 
+		      int         nbuf  /* buffer length */, 
+		      int**       ibuf  /* number buffers */, 
+		      int*        out   /* output [nbuf] */)
+/*< Evaluate a compiled expression (integer numbers) >*/
+{
+    int ib, nblock, j, nb, *stk;
 
-void sf_complex_math_evaluate (int          len  /* stack length */, 
-			       int          nbuf /* buffer length */, 
-			       sf_complex** cbuf /* number buffers */, 
-			       sf_complex** cst  /* stack */)
-/*< Evaluate a mathematical expression from stack (complex numbers) >*/
+    nblock = (nbuf+MATH_BLOCK-1)/MATH_BLOCK;
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(p->nth) schedule(static) private(ib,j,nb,stk) if(nblock > 16)
+#endif
+    for (ib=0; ib < nblock; ib++) {
+	j = ib*MATH_BLOCK;
+	nb = SF_MIN(MATH_BLOCK,nbuf-j);
+#ifdef _OPENMP
+	stk = (int*) p->work+(size_t) p->depth*MATH_BLOCK*omp_get_thread_num();
+#else
+	stk = (int*) p->work;
+#endif
+	int_block(p,j,nb,ibuf,stk,out+j);
+    }
+}
+
+static void complex_block (const sf_mathprog p, 
+			   int off            /* offset in buffers */,
+			   off_t j            /* first sample */, 
+			   int nb             /* block size */,
+			   sf_complex** cbuf  /* number buffers */, 
+			   sf_complex* stk    /* stack [depth][MATH_BLOCK] */, 
+			   sf_complex* out    /* output [nb] */)
 {
-    char *op;
-    int *indx, i;
-    float *fnum;
-    sf_complex *num, c, *carr;
+    int k, i, t;
+    float *r;
+    sf_complex *x, *y, *num, c;
     cfunc fun;
-    
-    sf_stack_set(st2,len);
+    const struct mathop *q;
 
-    while (sf_full (st2)) {
-	switch (sf_top (st2)) {
-	    case NUM: 
-		carr = *(++cst);
-		fnum = (float*) sf_pop(st2);
-		c = sf_cmplx(*fnum,0.);
-		for (i=0; i < nbuf; i++) { carr[i] = c; }
+    t = -1;
+    for (k=0; k < p->nop; k++) {
+	q = p->ops+k;
+	x = stk+t*MATH_BLOCK;
+	switch (q->op) {
+	    case OP_NUM:
+		x += MATH_BLOCK;
+		t++;
+		c = sf_cmplx(q->f,0.);
+		for (i=0; i < nb; i++) { x[i] = c; }
 		break;
-	    case INDX:
-		carr = *(++cst);
-		indx = (int*) sf_pop(st2);
-		/* convert index to number */
-		num = *(cbuf + (*indx));
-		for (i=0; i < nbuf; i++) { carr[i] = num[i]; }
+	    case OP_BUF:
+		x += MATH_BLOCK;
+		t++;
+		num = cbuf[q->arg]+off;
+		for (i=0; i < nb; i++) { x[i] = num[i]; }
 		break;
-	    case FUN:
-		indx = (int*) sf_pop(st2);
-		fun = cfunctable[*indx];
-		carr = *cst;
-		for (i=0; i < nbuf; i++) { carr[i] = fun(carr[i]); }
+	    case OP_AXIS:
+		x += MATH_BLOCK;
+		t++;
+		/* real coordinates in the upper half, then spread */
+		r = (float*) (x+nb)-nb;
+		coord(p,q->arg,j,nb,r);
+		for (i=0; i < nb; i++) { x[i] = sf_cmplx(r[i],0.); }
 		break;
-	    case UNARY:
-		op = (char*) sf_pop(st2);
-		carr = *cst;
-		if ('-' == *op) {
-		    for (i=0; i < nbuf; i++) {
+	    case OP_FUN:
+		fun = cfunctable[q->arg];
+		for (i=0; i < nb; i++) { x[i] = fun(x[i]); }
+		break;
+	    case OP_NEG:
+		for (i=0; i < nb; i++) {
 #ifdef SF_HAS_COMPLEX_H 
-			carr[i] = -carr[i];
+		    x[i] = -x[i];
 #else
-			carr[i] = sf_cneg(carr[i]);
+		    x[i] = sf_cneg(x[i]);
 #endif
-		    }
 		}
 		break;
-	    case POW:
-		op = (char*) sf_pop(st2);
-		num = *cst;
-		carr = *(--cst);
-		if ('^' == *op) {
-		    for (i=0; i < nbuf; i++) { 
-			carr[i] = cpowf(carr[i],num[i]);
-		    }
-		} 
-		break;
-	    case MULDIV:
-		op = (char*) sf_pop(st2);
-		num = *cst;
-		carr = *(--cst);
-		if ('*' == *op) {
-		    for (i=0; i < nbuf; i++) { 
-#ifdef SF_HAS_COMPLEX_H
-			carr[i] *= num[i];
-#else
-			carr[i] = sf_cmul(carr[i],num[i]);
-#endif 
-		    }
+	    case OP_BIN:
+	    case OP_BINK:
+		if (OP_BIN == q->op) {
+		    y = x;
+		    x -= MATH_BLOCK;
+		    t--;
 		} else {
-		    for (i=0; i < nbuf; i++) { 
+		    /* constant operand */
+		    y = x+MATH_BLOCK;
+		    c = sf_cmplx(q->f,0.);
+		    for (i=0; i < nb; i++) { y[i] = c; }
+		}
+		switch (q->arg) {
+		    case B_ADD:
+			for (i=0; i < nb; i++) {
 #ifdef SF_HAS_COMPLEX_H
-			carr[i] /= num[i]; 
+			    x[i] += y[i]; 
 #else
-			carr[i] = sf_cdiv(carr[i],num[i]);
+			    x[i] = sf_cadd(x[i],y[i]);
 #endif
-		    }
-		}
-		break;
-	    case PLUSMIN:
-		op = (char*) sf_pop(st2);
-		num = *cst;
-		carr = *(--cst);
-		if ('+' == *op) {
-		    for (i=0; i < nbuf; i++) {
+			}
+			break;
+		    case B_SUB:
+			for (i=0; i < nb; i++) { 
 #ifdef SF_HAS_COMPLEX_H
-			carr[i] += num[i]; 
+			    x[i] -= y[i]; 
 #else
-			carr[i] = sf_cadd(carr[i],num[i]);
+			    x[i] = sf_csub(x[i],y[i]);
 #endif
-		    }
-		} else {
-		    for (i=0; i < nbuf; i++) { 
+			}
+			break;
+		    case B_MUL:
+			for (i=0; i < nb; i++) { 
 #ifdef SF_HAS_COMPLEX_H
-			carr[i] -= num[i]; 
+			    x[i] *= y[i];
 #else
-			carr[i] = sf_csub(carr[i],num[i]);
+			    x[i] = sf_cmul(x[i],y[i]);
+#endif 
+			}
+			break;
+		    case B_DIV:
+			for (i=0; i < nb; i++) { 
+#ifdef SF_HAS_COMPLEX_H
+			    x[i] /= y[i]; 
+#else
+			    x[i] = sf_cdiv(x[i],y[i]);
 #endif
-		    }
+			}
+			break;
+		    case B_POW:
+			for (i=0; i < nb; i++) { 
+			    x[i] = cpowf(x[i],y[i]);
+			}
+			break;
+		    default:
+			/* '&' keeps the left operand */
+			break;
 		}
 		break;
-	    default:
-		sf_error ("%s: syntax error in output",__FILE__);
-		break;
 	}
     }
+
+    for (i=0; i < nb; i++) { out[i] = stk[i]; }
+}
+
+void sf_complex_math_run (sf_mathprog  p, 
+			  off_t        first /* index of the first sample (for coordinates) */,
+			  int          nbuf  /* buffer length */, 
+			  sf_complex** cbuf  /* number buffers */, 
+			  sf_complex*  out   /* output [nbuf] */)
+/*< Evaluate a compiled expression (complex numbers) >*/
+{
+    int ib, nblock, j, nb;
+    sf_complex *stk;
+
+    nblock = (nbuf+MATH_BLOCK-1)/MATH_BLOCK;
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(p->nth) schedule(static) private(ib,j,nb,stk) if(nblock > 16)
+#endif
+    for (ib=0; ib < nblock; ib++) {
+	j = ib*MATH_BLOCK;
+	nb = SF_MIN(MATH_BLOCK,nbuf-j);
+#ifdef _OPENMP
+	stk = (sf_complex*) p->work+(size_t) p->depth*MATH_BLOCK*omp_get_thread_num();
+#else
+	stk = (sf_complex*) p->work;
+#endif
+	complex_block(p,j,first+j,nb,cbuf,stk,out+j);
+    }
+}
+
+void sf_math_evaluate (int     len  /* stack length */, 
+		       int     nbuf /* buffer length */, 
+		       float** fbuf /* number buffers */, 
+		       float** fst  /* stack */)
+/*< Evaluate a mathematical expression from stack (float numbers) >*/
+{
+    if (NULL == fprog) fprog = sf_math_compile(len,SF_FLOAT);
+    sf_math_run(fprog,0,nbuf,fbuf,fst[1]);
+}
+
+void sf_int_math_evaluate (int   len  /* stack length */, 
+			   int   nbuf /* buffer length */, 
+			   int** ibuf /* number buffers */, 
+			   int** ist  /* stack */)
+/*< Evaluate a mathematical expression from stack (integer numbers) >*/
+{
+    if (NULL == iprog) iprog = sf_math_compile(len,SF_INT);
+    sf_int_math_run(iprog,nbuf,ibuf,ist[1]);
+}
+
+void sf_complex_math_evaluate (int          len  /* stack length */, 
+			       int          nbuf /* buffer length */, 
+			       sf_complex** cbuf /* number buffers */, 
+			       sf_complex** cst  /* stack */)
+/*< Evaluate a mathematical expression from stack (complex numbers) >*/
+{
+    if (NULL == cprog) cprog = sf_math_compile(len,SF_COMPLEX);
+    sf_complex_math_run(cprog,0,nbuf,cbuf,cst[1]);
 }
 
 size_t sf_math_parse (char*       output /* expression */, 
@@ -449,6 +772,12 @@ size_t sf_math_parse (char*       output /* expression */,
     bool hasleft;
 
     len = strlen(output);
+
+    /* forget programs compiled from a previous expression */
+    if (NULL != fprog) { sf_math_close(fprog); fprog = NULL; }
+    if (NULL != iprog) { sf_math_close(iprog); iprog = NULL; }
+    if (NULL != cprog) { sf_math_close(cprog); cprog = NULL; }
+
     st1 = sf_stack_init (len);
     st2 = sf_stack_init (len);
     
@@ -19,6 +19,18 @@
 */
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#ifdef SF_HAS_PTHREADS
+#include <pthread.h>
+#endif
 
 #include "parallel.h"
 
@@ -39,6 +51,35 @@ static off_t size1, size2;
 static int inpargc, outargc;
 static sf_file *ins;
 
+#define FEEDSIZ (1<<16)
+
+struct Feed {
+    sf_file pipe; /* piece header and data going to a job */
+    int fd;       /* data to split */
+    off_t pos, size1, size2, split, skip, chunk;
+};
+
+struct Drain {
+    FILE *from;      /* job output */
+    char *buf;       /* output that arrives ahead of its turn */
+    size_t size;     /* buffer size */
+    size_t beg, len; /* buffered bytes */
+    off_t left;      /* bytes not yet taken from the job */
+    bool turn, busy;
+};
+
+/* streaming jobs */
+static pid_t *pids=NULL;
+static int *outfd=NULL, nfeed=0, njob=0, turn=-1;
+static struct Feed *feeds=NULL;
+static struct Drain *drains=NULL;
+#ifdef SF_HAS_PTHREADS
+static pthread_t *feeders=NULL, *drainers=NULL, reaper;
+static pthread_mutex_t joblock=PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t jobcond=PTHREAD_COND_INITIALIZER;
+static char failure[64]="";
+#endif
+
 static void sizes(sf_file file, int axis, int ndim, 
 		  const off_t *n, off_t *size1, off_t *size2)
 {
@@ -52,46 +93,12 @@ static void sizes(sf_file file, int axis, int ndim,
     }
 }
 
-char** sf_split(sf_file inp          /* input file */, 
-		int axis             /* split axis */,
-		int nodes            /* number of CPUs */,
-		int *tasks           /* number of tasks */,
-		int ndim, off_t *n   /* [ndim] file dimensions */, 
-		int argc, char**argv /* command-line arguments */)
-/*< split the input file along the specified axis
-  and generate parallel system commands >*/
+static void arguments(int argc, char** argv, char** splitinp)
+/* separate command-line arguments into the command and files to split */
 {
-    char **commands, **splitinp, **splitout, okey[5], dkey[5], splitcmd[SF_CMDLEN];
-    char *arg, *eq, *cmdline, *iname=NULL, *oname=NULL, *splitname;
-    off_t i2, *splitsize1=NULL, *splitsize2=NULL, left, nbuf;
-    float d, o, di, oi;
-    int job, jobs, bigjobs, w, split, i, j, k, len, chunk, skip;
-    sf_file *splitfile=NULL, in=NULL;
-    FILE *ifile=NULL, *ofile=NULL;
-
-    if (axis > ndim) axis=ndim;
+    char **splitout, *arg, *eq;
+    int i, j, k, len;
 
-    snprintf(nkey,5,"n%d",axis);
-    snprintf(okey,5,"o%d",axis);
-    snprintf(dkey,5,"d%d",axis);
-    if (!sf_histfloat(inp,okey,&o)) o=0.;
-    if (!sf_histfloat(inp,dkey,&d)) d=1.;
-    
-    axis--;
-    sizes(inp,axis,ndim,n,&size1,&size2);
-    split = n[axis];
-    
-    jobs = nodes-1;
-    if (jobs < split) {
-	w = (int) (1+((float) split)/jobs);
-    } else {
-	w = 1;
-	jobs = split;
-    }
-    bigjobs = split - jobs*(w-1);
-    *tasks = jobs;
-    
-    splitinp = (char**) sf_alloc(argc,sizeof(char*));
     splitout = (char**) sf_alloc(argc,sizeof(char*));
     outargc = 0;
     inpargc = 0;
@@ -102,6 +109,7 @@ char** sf_split(sf_file inp          /* input file */,
 	if (strncmp(arg,"--input=",8) &&
 	    strncmp(arg,"--output=",9) &&
 	    strncmp(arg,"split=",6) &&
+	    strncmp(arg,"stream=",7) &&
 	    strncmp(arg,"join=",5)) {
 
 	    len = strlen(arg);
@@ -154,6 +162,49 @@ char** sf_split(sf_file inp          /* input file */,
     }
     command[j]='\0';
     splitcommand[k]='\0';
+}
+
+char** sf_split(sf_file inp          /* input file */, 
+		int axis             /* split axis */,
+		int nodes            /* number of CPUs */,
+		int *tasks           /* number of tasks */,
+		int ndim, off_t *n   /* [ndim] file dimensions */, 
+		int argc, char**argv /* command-line arguments */)
+/*< split the input file along the specified axis
+  and generate parallel system commands >*/
+{
+    char **commands, **splitinp, okey[5], dkey[5], splitcmd[SF_CMDLEN];
+    char *cmdline, *iname=NULL, *oname=NULL, *splitname;
+    off_t i2, *splitsize1=NULL, *splitsize2=NULL, left, nbuf;
+    float d, o, di, oi;
+    int job, jobs, bigjobs, w, split, i, chunk, skip;
+    sf_file *splitfile=NULL, in=NULL;
+    FILE *ifile=NULL, *ofile=NULL;
+
+    if (axis > ndim) axis=ndim;
+
+    snprintf(nkey,5,"n%d",axis);
+    snprintf(okey,5,"o%d",axis);
+    snprintf(dkey,5,"d%d",axis);
+    if (!sf_histfloat(inp,okey,&o)) o=0.;
+    if (!sf_histfloat(inp,dkey,&d)) d=1.;
+    
+    axis--;
+    sizes(inp,axis,ndim,n,&size1,&size2);
+    split = n[axis];
+    
+    jobs = nodes-1;
+    if (jobs < split) {
+	w = (int) (1+((float) split)/jobs);
+    } else {
+	w = 1;
+	jobs = split;
+    }
+    bigjobs = split - jobs*(w-1);
+    *tasks = jobs;
+    
+    splitinp = (char**) sf_alloc(argc,sizeof(char*));
+    arguments(argc,argv,splitinp);
 
     if (0 < inpargc) { /* files to split other than input */
 	splitsize1 = sf_largeintalloc(inpargc);
@@ -257,12 +308,391 @@ char** sf_split(sf_file inp          /* input file */,
 	    strncpy(splitcmd,cmdline,SF_CMDLEN);
 	}	
 
-	snprintf(cmdline,SF_CMDLEN,"%s %s < %s > %s",command,splitcmd,iname,oname);
+	if (SF_CMDLEN <= snprintf(cmdline,SF_CMDLEN,"%s %s < %s > %s",
+				  command,splitcmd,iname,oname))
+	    sf_error("command line is too long");
     }
 
     return commands;
 }
 
+#ifdef SF_HAS_PTHREADS
+static void fail(const char *format, int id)
+/* report a failure to the main thread */
+{
+    pthread_mutex_lock(&joblock);
+    if ('\0' == failure[0]) snprintf(failure,64,format,id);
+    pthread_cond_broadcast(&jobcond);
+    pthread_mutex_unlock(&joblock);
+}
+
+static void *feed(void *arg)
+/* send a piece of the data to a job */
+{
+    struct Feed *f;
+    FILE *stream;
+    char *buf;
+    off_t i2, left, pos;
+    ssize_t nbuf, nread, nput;
+    int fd;
+
+    f = (struct Feed*) arg;
+    stream = sf_filestream(f->pipe);
+    buf = sf_charalloc(FEEDSIZ);
+
+    /* the header is out, the data go around stdio so that no stream
+       stays locked if a job stops reading */
+    (void) fflush(stream);
+    fd = fileno(stream);
+
+    for (i2=0; i2 < f->size2; i2++) {
+	pos = f->pos+f->size1*(i2*f->split+f->skip);
+	for (left=f->chunk*f->size1; left > 0; left -= nbuf) {
+	    nbuf = (FEEDSIZ < left)? FEEDSIZ: left;
+	    nread = pread(f->fd,buf,nbuf,pos);
+	    if (nread <= 0) {
+		fail("read error at byte %d",(int) pos);
+		i2 = f->size2;
+		break;
+	    }
+	    nbuf = nread;
+	    pos += nbuf;
+
+	    /* stop quietly if the job does not want more */
+	    for (nread=0; nread < nbuf; nread += nput) {
+		nput = write(fd,buf+nread,nbuf-nread);
+		if (nput <= 0) {
+		    i2 = f->size2;
+		    break;
+		}
+	    }
+	    if (i2 == f->size2) break;
+	}
+    }
+
+    free(buf);
+    return NULL;
+}
+
+static void *reap(void *arg)
+/* wait for jobs, a failed job stops everything */
+{
+    int job, status;
+    pid_t pid;
+
+    for (job=0; job < njob; job++) {
+	pid = wait(&status);
+	if (pid < 0) break;
+	if (!WIFEXITED(status) || 0 != WEXITSTATUS(status)) 
+	    fail("job failed (pid %d)",(int) pid);
+    }
+    return NULL;
+}
+
+static void *drain(void *arg)
+/* hold the output of a job that arrives ahead of its turn */
+{
+    struct Drain *d;
+    size_t end, nbuf, nread;
+
+    d = (struct Drain*) arg;
+
+    pthread_mutex_lock(&joblock);
+    for (;;) {
+	/* a job whose turn it is or whose buffer is full waits, 
+	   the output in its turn is taken directly by jobread */
+	while (d->left > 0 && (d->turn || d->len == d->size) && 
+	       '\0' == failure[0])
+	    pthread_cond_wait(&jobcond,&joblock);
+	if (0 == d->left || '\0' != failure[0]) break;
+
+	end = (d->beg+d->len)%d->size;
+	nbuf = ((end < d->beg)? d->beg: d->size)-end;
+	if (nbuf > d->size-d->len) nbuf = d->size-d->len;
+	if (nbuf > FEEDSIZ) nbuf = FEEDSIZ;
+	if (nbuf > d->left) nbuf = d->left;
+	d->busy = true;
+	pthread_mutex_unlock(&joblock);
+
+	nread = fread(d->buf+end,1,nbuf,d->from);
+
+	pthread_mutex_lock(&joblock);
+	d->busy = false;
+	d->len += nread;
+	d->left -= nread;
+	pthread_cond_broadcast(&jobcond);
+	if (nread < nbuf) break;
+    }
+    pthread_mutex_unlock(&joblock);
+
+    return NULL;
+}
+#endif
+
+static void jobwait(int job)
+/* wait for a job to start writing, stop if any job fails */
+{
+#ifdef SF_HAS_PTHREADS
+    struct pollfd p;
+    bool failed;
+
+    p.fd = outfd[job];
+    p.events = POLLIN;
+
+    do {
+	pthread_mutex_lock(&joblock);
+	failed = (bool) ('\0' != failure[0]);
+	pthread_mutex_unlock(&joblock);
+
+	if (failed) sf_error("%s: %s",__FILE__,failure);
+    } while (0 == poll(&p,1,100));
+
+    /* sf_input opens the pipe for writing too, so it would wait 
+       forever for a header from a job that is gone */
+    if (!(p.revents & POLLIN)) 
+	sf_error("%s: no output from job %d",__FILE__,job);
+#endif
+}
+
+static void jobread(char *buf, off_t nbuf, int job)
+/* read the output of a streaming job in order */
+{
+#ifdef SF_HAS_PTHREADS
+    struct Drain *d;
+    size_t nread;
+    bool failed;
+
+    d = drains+job;
+
+    pthread_mutex_lock(&joblock);
+    if (job != turn) {
+	/* the previous job goes back to buffering */
+	if (turn >= 0) drains[turn].turn = false;
+	turn = job;
+	d->turn = true;
+	pthread_cond_broadcast(&jobcond);
+    }
+    while (d->busy && '\0' == failure[0])
+	pthread_cond_wait(&jobcond,&joblock);
+    failed = (bool) ('\0' != failure[0]);
+    pthread_mutex_unlock(&joblock);
+
+    if (failed) sf_error("%s: %s",__FILE__,failure);
+
+    /* while it is the job's turn, nobody else touches its buffer
+       or its stream */
+    for (; nbuf > 0 && d->len > 0; nbuf -= nread) {
+	nread = d->size-d->beg;
+	if (nread > d->len) nread = d->len;
+	if (nread > nbuf) nread = nbuf;
+	memcpy(buf,d->buf+d->beg,nread);
+	buf += nread;
+	d->beg = (d->beg+nread)%d->size;
+	d->len -= nread;
+    }
+
+    if (nbuf > 0) {
+	if (nbuf > d->left || nbuf != fread(buf,1,nbuf,d->from))
+	    sf_error("%s: short output from job %d",__FILE__,job);
+
+	pthread_mutex_lock(&joblock);
+	d->left -= nbuf;
+	if (0 == d->left) pthread_cond_broadcast(&jobcond);
+	pthread_mutex_unlock(&joblock);
+    }
+#endif
+}
+
+bool sf_stream_split(sf_file inp          /* input file */, 
+		     int axis             /* split axis */,
+		     int nodes            /* number of CPUs */,
+		     int *tasks           /* number of tasks */,
+		     int ndim, off_t *n   /* [ndim] file dimensions */, 
+		     int argc, char**argv /* command-line arguments */)
+/*< split the input file along the specified axis and start parallel jobs
+  reading their pieces through pipes, without temporary files.
+  ---
+  Returns false if streaming is not available. >*/
+{
+#ifdef SF_HAS_PTHREADS
+    char **splitinp, okey[5], dkey[5], cmdline[SF_CMDLEN], name[32], *format;
+    off_t pos;
+    float *d, *o;
+    int job, jobs, bigjobs, w, split, i, k, chunk, skip, len, fd;
+    int *infd, *feedfd, p[2];
+    sf_file *files;
+    struct Feed *f;
+
+    if (axis > ndim) axis=ndim;
+
+    snprintf(nkey,5,"n%d",axis);
+    snprintf(okey,5,"o%d",axis);
+    snprintf(dkey,5,"d%d",axis);
+    
+    axis--;
+    split = n[axis];
+    
+    jobs = nodes-1;
+    if (jobs < split) {
+	w = (int) (1+((float) split)/jobs);
+    } else {
+	w = 1;
+	jobs = split;
+    }
+    bigjobs = split - jobs*(w-1);
+    *tasks = jobs;
+
+    splitinp = (char**) sf_alloc(argc,sizeof(char*));
+    arguments(argc,argv,splitinp);
+
+    files = (sf_file*) sf_alloc(inpargc+1,sizeof(sf_file));
+    o = sf_floatalloc(inpargc+1);
+    d = sf_floatalloc(inpargc+1);
+
+    nfeed = jobs*(inpargc+1);
+    feeds = (struct Feed*) sf_alloc(nfeed,sizeof(struct Feed));
+    feeders = (pthread_t*) sf_alloc(nfeed,sizeof(pthread_t));
+    infd = sf_intalloc(nfeed);
+    feedfd = sf_intalloc(nfeed);
+    pids = (pid_t*) sf_alloc(jobs,sizeof(pid_t));
+    outfd = sf_intalloc(jobs);
+
+    /* the data are read directly by pieces */
+    for (i=0; i <= inpargc; i++) {
+	files[i] = (0==i)? inp: sf_input(splitinp[i-1]);
+	ndim = sf_largefiledims(files[i],n);
+	if (i > 0 && (ndim <= axis || n[axis] != split))
+	    sf_error("Wrong dimensions in file %s",splitinp[i-1]);
+	sizes(files[i],axis,ndim,n,&size1,&size2);
+
+	if (!sf_histfloat(files[i],okey,o+i)) o[i]=0.;
+	if (!sf_histfloat(files[i],dkey,d+i)) d[i]=1.;
+
+	/* a job could only get its piece of a pipe after the jobs
+	   before it have read theirs, and the output header waits for
+	   all jobs */
+	pos = sf_tell(files[i]);
+	if (pos < 0) 
+	    sf_error("%s: cannot stream piped input %s to the jobs, "
+		     "give it as a file or use stream=n",
+		     __FILE__,(0==i)? "in": splitinp[i-1]+1);
+
+	for (job=0; job < jobs; job++) {
+	    if (job < bigjobs) {
+		chunk = w;
+		skip = job*w;
+	    } else {
+		chunk = w-1;
+		skip = bigjobs*w+(job-bigjobs)*chunk;
+	    }
+
+	    f = feeds+job*(inpargc+1)+i;
+	    f->fd = fileno(sf_filestream(files[i]));
+	    f->pos = pos;
+	    f->size1 = size1;
+	    f->size2 = size2;
+	    f->split = split;
+	    f->skip = skip;
+	    f->chunk = chunk;
+	}
+    }
+
+    /* keep pipes off the standard descriptors */
+    while (0 <= (fd = open("/dev/null",O_RDWR)) && fd <= 2);
+    if (fd > 2) close(fd);
+
+    /* a SIGPIPE from a job that stopped reading should not kill us */
+    (void) signal(SIGPIPE,SIG_IGN);
+
+    /* start all jobs before opening any streams so that each job 
+       inherits only its own pipes */
+    for (job=0; job < jobs; job++) {
+	k = job*(inpargc+1);
+	len = snprintf(cmdline,SF_CMDLEN,"%s",command);
+
+	for (i=0; i <= inpargc; i++) {
+	    if (0 > pipe(p)) sf_error("%s: cannot make a pipe:",__FILE__);
+	    (void) fcntl(p[0],F_SETFD,FD_CLOEXEC);
+	    (void) fcntl(p[1],F_SETFD,FD_CLOEXEC);
+	    infd[k+i] = p[0];
+	    feedfd[k+i] = p[1];
+
+	    if (i > 0) {
+		len += snprintf(cmdline+len,SF_CMDLEN-len," %s=/dev/fd/%d",
+				splitinp[i-1]+1,p[0]);
+		if (len >= SF_CMDLEN) sf_error("command line is too long");
+	    }
+	}
+
+	if (0 > pipe(p)) sf_error("%s: cannot make a pipe:",__FILE__);
+	(void) fcntl(p[0],F_SETFD,FD_CLOEXEC);
+	(void) fcntl(p[1],F_SETFD,FD_CLOEXEC);
+	outfd[job] = p[0];
+
+	fprintf(stderr,"CPU %d: %s\n",job,cmdline); 
+
+	pids[job] = fork();
+	if (pids[job] < 0) {
+	    sf_error("Failed to fork");
+	} else if (0 == pids[job]) { /* child */
+	    if (0 > dup2(infd[k],0) || 0 > dup2(p[1],1)) _exit(127);
+	    for (i=1; i <= inpargc; i++) {
+		(void) fcntl(infd[k+i],F_SETFD,0);
+	    }
+	    execl("/bin/sh","sh","-c",cmdline,(char*) NULL);
+	    _exit(127);
+	}
+
+	close(p[1]);
+	for (i=0; i <= inpargc; i++) {
+	    close(infd[k+i]);
+	}
+    }
+
+    njob = jobs;
+    if (pthread_create(&reaper,NULL,reap,NULL))
+	sf_error("%s: cannot start a thread:",__FILE__);
+
+    /* headers go from here, data from the feeding threads */
+    for (job=0; job < jobs; job++) {
+	for (i=0; i <= inpargc; i++) {
+	    f = feeds+job*(inpargc+1)+i;
+
+	    /* sf_output opens the pipe for reading too, switch to the
+	       write end so that a job that stops reading is noticed */
+	    fd = feedfd[job*(inpargc+1)+i];
+	    snprintf(name,32,"/dev/fd/%d",fd);
+	    f->pipe = sf_output(name);
+	    if (0 > dup2(fd,fileno(sf_filestream(f->pipe))))
+		sf_error("%s: cannot redirect a pipe:",__FILE__);
+	    close(fd);
+
+	    if (NULL != (format = sf_histstring(files[i],"data_format"))) {
+		sf_setformat(f->pipe,format);
+		free(format);
+	    }
+	    sf_putint(f->pipe,nkey,f->chunk);
+	    sf_putfloat(f->pipe,okey,o[i]+f->skip*d[i]);
+	    sf_fileflush(f->pipe,files[i]);
+	    sf_setform(f->pipe,SF_NATIVE);
+
+	    if (pthread_create(feeders+job*(inpargc+1)+i,NULL,feed,f))
+		sf_error("%s: cannot start a thread:",__FILE__);
+	}
+    }
+
+    free(infd);
+    free(feedfd);
+    free(o);
+    free(d);
+    free(files);
+
+    return true;
+#else
+    return false;
+#endif
+}
+
 void sf_out(sf_file out        /* output file */,
 	    int jobs           /* number of jobs */,
 	    int axis           /* join axis */,
@@ -305,12 +735,117 @@ void sf_out(sf_file out        /* output file */,
     }
 }
 
+void sf_stream_out(sf_file out     /* output file */,
+		   int jobs        /* number of jobs */,
+		   int axis        /* join axis (0 means add) */,
+		   off_t memsize   /* bytes to hold outputs ahead of their turn */)
+/*< prepare output from jobs started by sf_stream_split >*/
+{
+    char name[32], key[16], *format;
+    int ndim, job, ni, i;
+    off_t n[SF_MAX_DIM], nj, size;
+
+    ins = (sf_file*) sf_alloc(jobs,sizeof(sf_file));
+
+    /* job headers arrive first */
+    for (job=0; job < jobs; job++) {
+	jobwait(job);
+	snprintf(name,32,"/dev/fd/%d",outfd[job]);
+	ins[job] = sf_input(name);
+
+	/* likewise, read the data from the read end only so that the
+	   end of the output is seen */
+	if (0 > dup2(outfd[job],fileno(sf_filestream(ins[job]))))
+	    sf_error("%s: cannot redirect a pipe:",__FILE__);
+	close(outfd[job]);
+    }
+
+    ndim = sf_largefiledims (ins[0],n);
+    if (axis > 0) {
+	snprintf(key,16,"n%d",axis);
+	for (nj=job=0; job < jobs; job++) {
+	    if (!sf_histint(ins[job],key,&ni)) ni=1;
+	    nj += ni;
+	}
+	sf_putint(out,key,nj);
+    } 
+    
+    if (axis > ndim) axis=ndim;
+    sizes(ins[0],axis-1,ndim,n,&size1,&size2);
+
+    if (NULL != (format = sf_histstring(ins[0],"data_format"))) {
+	sf_setformat(out,format);
+	free(format);
+    }
+    sf_fileflush(out,ins[0]);
+    sf_setform(out,SF_NATIVE);
+
+#ifdef SF_HAS_PTHREADS
+    /* The job whose turn it is goes straight to the output. The others
+       keep running until their share of memsize is full of output
+       that arrived ahead of its turn, then wait on their pipes. */
+    drains = (struct Drain*) sf_alloc(jobs,sizeof(struct Drain));
+    drainers = (pthread_t*) sf_alloc(jobs,sizeof(pthread_t));
+
+    size = memsize/jobs;
+    if (size < FEEDSIZ) size = FEEDSIZ;
+
+    for (job=0; job < jobs; job++) {
+	ndim = sf_largefiledims(ins[job],n);
+	drains[job].left = sf_esize(ins[job]);
+	for (i=0; i < ndim; i++) {
+	    drains[job].left *= n[i];
+	}
+
+	sf_setform(ins[job],SF_NATIVE);
+	drains[job].from = sf_filestream(ins[job]);
+
+	drains[job].size = (drains[job].left < size)? drains[job].left: size;
+	if (0 == drains[job].size) drains[job].size = 1;
+	drains[job].buf = sf_charalloc(drains[job].size);
+	drains[job].beg = 0;
+	drains[job].len = 0;
+	drains[job].turn = false;
+	drains[job].busy = false;
+
+	if (pthread_create(drainers+job,NULL,drain,drains+job))
+	    sf_error("%s: cannot start a thread:",__FILE__);
+    }
+    turn = -1;
+#endif
+}
+
 static void cleanup(int jobs)
 /* remove temporary files */
 {
     int i, job;
     char *oname;
 
+    if (NULL != pids) { /* streaming jobs */
+#ifdef SF_HAS_PTHREADS
+	for (job=0; job < jobs; job++) {
+	    pthread_join(drainers[job],NULL);
+	    free(drains[job].buf);
+	    sf_fileclose(ins[job]);
+	}
+	free(drainers);
+	free(drains);
+	drains = NULL;
+	for (i=0; i < nfeed; i++) {
+	    pthread_join(feeders[i],NULL);
+	    sf_fileclose(feeds[i].pipe);
+	}
+	free(feeders);
+	pthread_join(reaper,NULL);
+	if ('\0' != failure[0]) sf_error("%s: %s",__FILE__,failure);
+#endif
+	free(feeds);
+	free(pids);
+	free(outfd);
+	free(ins);
+	return;
+    }
+
     for (job=0; job < jobs; job++) {
 	sf_fileclose(ins[job]);
 	sf_rm(inames[job],true,false,false);
@@ -365,11 +900,15 @@ void sf_join(sf_file out /* output file */,
 	for (job=0; job < jobs; job++) {
 	    
 	    in = ins[job];
-	    sf_setform(in,SF_NATIVE);
+	    if (NULL == drains) sf_setform(in,SF_NATIVE);
 	    
 	    for (left = n1*naxis[job]*esize; left > 0; left -= nbuf) {
 		nbuf = (BUFSIZ < left)? BUFSIZ: left;
-		sf_charread (buf,nbuf,in);
+		if (NULL != drains) {
+		    jobread (buf,nbuf,job);
+		} else {
+		    sf_charread (buf,nbuf,in);
+		}
 		sf_charwrite (buf,nbuf,out);
 	    }
 	}
@@ -412,7 +951,11 @@ void sf_add(sf_file out /* output file */,
 	for (job=0; job < jobs; job++) {
 	    switch(type) {
 		case SF_FLOAT:
-		    sf_floatread((float*) buffer,nbuf,ins[job]);
+		    if (NULL != drains) {
+			jobread(buffer,nbuf*sizeof(float),job);
+		    } else {
+			sf_floatread((float*) buffer,nbuf,ins[job]);
+		    }
 		    for (i=0; i < nbuf; i++) {
 			if (job) {
 			    fbuf[i] += ((float*) buffer)[i];
@@ -25,22 +25,44 @@
 #include "helix.h"
 /*^*/
 
-static sf_filter aa;
-static float* tt;
+#ifndef _sf_polydiv_h
 
-void sf_polydiv_init( int nd       /* data size */, 
-		      sf_filter bb /* filter */) 
-/*< initialize >*/
+typedef struct sf_Polydiv *sf_polydiv;
+/* abstract data type */
+/*^*/
+
+#endif
+
+struct sf_Polydiv {
+    sf_filter aa;
+    float *tt;
+};
+
+static sf_polydiv pd0;
+
+sf_polydiv sf_polydiv_init_r( int nd       /* data size */, 
+			      sf_filter bb /* filter */) 
+/*< initialize a reentrant division, to be used with sf_polydiv_lop_r >*/
 {
-    aa = bb;
-    tt = sf_floatalloc (nd);
+    sf_polydiv pd;
+
+    pd = (sf_polydiv) sf_alloc(1,sizeof(*pd));
+    pd->aa = bb;
+    pd->tt = sf_floatalloc (nd);
+
+    return pd;
 }
 
-void sf_polydiv_lop( bool adj, bool add, 
-		     int nx, int ny, float* xx, float*yy) 
-/*< linear operator >*/
+void sf_polydiv_lop_r( void *data /* sf_polydiv */, bool adj, bool add, 
+		       int nx, int ny, float* xx, float*yy) 
+/*< linear operator with its own state >*/
 {
     int ia, iy, ix;
+    sf_filter aa;
+    float *tt;
+
+    aa = ((sf_polydiv) data)->aa;
+    tt = ((sf_polydiv) data)->tt;
     
     sf_adjnull( adj, add, nx, ny, xx, yy);
     
@@ -69,10 +91,31 @@ void sf_polydiv_lop( bool adj, bool add,
     }
 }
 
+void sf_polydiv_close_r (sf_polydiv pd) 
+/*< free a reentrant division >*/
+{
+    free (pd->tt);
+    free (pd);
+}
+
+void sf_polydiv_init( int nd       /* data size */, 
+		      sf_filter bb /* filter */) 
+/*< initialize >*/
+{
+    pd0 = sf_polydiv_init_r(nd,bb);
+}
+
+void sf_polydiv_lop( bool adj, bool add, 
+		     int nx, int ny, float* xx, float*yy) 
+/*< linear operator >*/
+{
+    sf_polydiv_lop_r(pd0,adj,add,nx,ny,xx,yy);
+}
+
 void sf_polydiv_close (void) 
 /*< free allocated storage >*/
 {
-    free (tt);
+    sf_polydiv_close_r(pd0);
 }
 
 /* 	$Id$	 */
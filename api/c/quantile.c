@@ -1,4 +1,4 @@
-/* Computing quantiles by Hoare's algorithm */
+/* Computing quantiles by Hoare's algorithm and by block sketches */
 /*
   Copyright (C) 2004 University of Texas at Austin
   
@@ -17,7 +17,28 @@
   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 */
 
+#include <stdlib.h>
+#include <math.h>
+
 #include "quantile.h"
+#include "alloc.h"
+#include "_defs.h"
+
+#ifndef _sf_quantile_h
+
+typedef struct sf_Qsketch *sf_qsketch;
+/* abstract data type */
+/*^*/
+
+#endif
+
+struct sf_Qsketch {
+    int m;               /* order statistics kept per block */
+    int nb, nbmax;       /* blocks */
+    int nv, nvmax;       /* stored values */
+    int *b0, *bk, *bn;   /* first value, last index and size of each block */
+    float *v;            /* order statistics of all blocks */
+};
 
 float sf_quantile(int q    /* quantile */, 
 		  int n    /* array length */, 
@@ -46,3 +67,285 @@ float sf_quantile(int q    /* quantile */,
     }
     return (*k);
 }
+
+static void multiselect(int n, float *a /* [n] */, 
+			int nr, const int *r /* increasing ranks [nr] */,
+			int r0 /* rank of a[0] */, float *v /* output [nr] */)
+/* several order statistics at once, by recursive partitioning */
+{
+    int ir, k;
+
+    if (0 == nr) return;
+
+    ir = nr/2;
+    k = r[ir]-r0;
+    v[ir] = sf_quantile(k,n,a); /* a is now partitioned around k */
+
+    multiselect(k,a,ir,r,r0,v);
+    multiselect(n-k-1,a+k+1,nr-ir-1,r+ir+1,r0+k+1,v+ir+1);
+}
+
+static double block_rank(int k, int n, int j)
+/* rank in a block of n of its j-th stored order statistic out of k+1 */
+{
+    return floor(((double) j)*(n-1)/k);
+}
+
+static double block_le(sf_qsketch s, int ib, float y)
+/* estimated number of values <= y in a block */
+{
+    int k, n, lo, hi, j;
+    float *v;
+
+    v = s->v + s->b0[ib];
+    k = s->bk[ib];
+    n = s->bn[ib];
+
+    if (y < v[0]) return 0.;
+    if (y >= v[k]) return n;
+
+    /* largest j with v[j] <= y */
+    lo = 0; hi = k;
+    while (hi-lo > 1) {
+	j = (lo+hi)/2;
+	if (v[j] <= y) {
+	    lo = j;
+	} else {
+	    hi = j;
+	}
+    }
+
+    return 0.5*(block_rank(k,n,lo)+1.+block_rank(k,n,hi));
+}
+
+static double block_lt(sf_qsketch s, int ib, float y)
+/* estimated number of values < y in a block */
+{
+    int k, n, lo, hi, j;
+    float *v;
+
+    v = s->v + s->b0[ib];
+    k = s->bk[ib];
+    n = s->bn[ib];
+
+    if (y <= v[0]) return 0.;
+    if (y > v[k]) return n;
+
+    /* smallest j with v[j] >= y */
+    lo = 0; hi = k;
+    while (hi-lo > 1) {
+	j = (lo+hi)/2;
+	if (v[j] >= y) {
+	    hi = j;
+	} else {
+	    lo = j;
+	}
+    }
+
+    return 0.5*(block_rank(k,n,lo)+1.+block_rank(k,n,hi));
+}
+
+static double sketch_le(sf_qsketch s, float y)
+/* estimated number of values <= y */
+{
+    int ib;
+    double c;
+
+    c = 0.;
+    for (ib=0; ib < s->nb; ib++) {
+	c += block_le(s,ib,y);
+    }
+    return c;
+}
+
+static double sketch_abs(sf_qsketch s, float bias, float t)
+/* estimated number of values with |value - bias| <= t */
+{
+    int ib, j;
+    float *v;
+    double c;
+
+    c = 0.;
+    for (ib=0; ib < s->nb; ib++) {
+	if (s->bk[ib] == s->bn[ib]-1) { /* all values kept */
+	    v = s->v + s->b0[ib];
+	    for (j=0; j < s->bn[ib]; j++) {
+		if (fabsf(v[j]-bias) <= t) c += 1.;
+	    }
+	} else {
+	    c += block_le(s,ib,bias+t)-block_lt(s,ib,bias-t);
+	}
+    }
+    return c;
+}
+
+static int float_comp(const void *a, const void *b)
+{
+    float aa, bb;
+
+    aa = *((const float*) a);
+    bb = *((const float*) b);
+
+    if (aa < bb) return -1;
+    if (aa > bb) return 1;
+    return 0;
+}
+
+sf_qsketch sf_qsketch_init(int m /* order statistics per block */)
+/*< initialize a quantile sketch: a block of n values is summarized by m+1
+  of its order statistics, with rank error below n/(2m)+1 >*/
+{
+    sf_qsketch s;
+
+    s = (sf_qsketch) sf_alloc(1,sizeof(*s));
+    s->m = m;
+    s->nb = 0;
+    s->nbmax = 8;
+    s->nv = 0;
+    s->nvmax = 8*(m+1);
+    s->b0 = sf_intalloc(s->nbmax);
+    s->bk = sf_intalloc(s->nbmax);
+    s->bn = sf_intalloc(s->nbmax);
+    s->v = sf_floatalloc(s->nvmax);
+
+    return s;
+}
+
+static void sketch_grow(sf_qsketch s, int nb, int nv)
+/* make room for nb more blocks and nv more values */
+{
+    if (s->nb+nb > s->nbmax) {
+	s->nbmax = 2*(s->nb+nb);
+	s->b0 = (int*) sf_realloc(s->b0,s->nbmax,sizeof(int));
+	s->bk = (int*) sf_realloc(s->bk,s->nbmax,sizeof(int));
+	s->bn = (int*) sf_realloc(s->bn,s->nbmax,sizeof(int));
+    }
+    if (s->nv+nv > s->nvmax) {
+	s->nvmax = 2*(s->nv+nv);
+	s->v = (float*) sf_realloc(s->v,s->nvmax,sizeof(float));
+    }
+}
+
+void sf_qsketch_add(sf_qsketch s, 
+		    int n    /* block length */, 
+		    float *a /* block [n] */)
+/*< add a block of values (caution: a is reordered) >*/
+{
+    int j, k, *r;
+
+    if (n <= 0) return;
+
+    k = SF_MIN(n-1,s->m);
+    sketch_grow(s,1,k+1);
+
+    s->b0[s->nb] = s->nv;
+    s->bk[s->nb] = k;
+    s->bn[s->nb] = n;
+
+    if (0 == k) {
+	s->v[s->nv] = a[0];
+    } else {
+	r = sf_intalloc(k+1);
+	for (j=0; j <= k; j++) {
+	    r[j] = block_rank(k,n,j);
+	}
+	multiselect(n,a,k+1,r,0,s->v+s->nv);
+	free(r);
+    }
+
+    s->nb++;
+    s->nv += k+1;
+}
+
+void sf_qsketch_merge(sf_qsketch s, sf_qsketch t)
+/*< add all values summarized in t to s >*/
+{
+    int ib;
+
+    sketch_grow(s,t->nb,t->nv);
+
+    for (ib=0; ib < t->nb; ib++) {
+	s->b0[s->nb+ib] = s->nv + t->b0[ib];
+	s->bk[s->nb+ib] = t->bk[ib];
+	s->bn[s->nb+ib] = t->bn[ib];
+    }
+    for (ib=0; ib < t->nv; ib++) {
+	s->v[s->nv+ib] = t->v[ib];
+    }
+
+    s->nb += t->nb;
+    s->nv += t->nv;
+}
+
+float sf_qsketch_quantile(sf_qsketch s, 
+			  double q /* rank, from 0 to n-1 */)
+/*< estimate quantile, exact if every block had at most m+1 values >*/
+{
+    int lo, hi, j;
+    float *c, y;
+
+    if (0 == s->nv) return 0.;
+
+    c = sf_floatalloc(s->nv);
+    for (j=0; j < s->nv; j++) {
+	c[j] = s->v[j];
+    }
+    qsort(c,s->nv,sizeof(float),float_comp);
+
+    /* smallest candidate with q+1 values at or below it */
+    lo = -1; hi = s->nv-1;
+    while (hi-lo > 1) {
+	j = (lo+hi)/2;
+	if (sketch_le(s,c[j]) >= q+1.) {
+	    hi = j;
+	} else {
+	    lo = j;
+	}
+    }
+    y = c[hi];
+
+    free(c);
+    return y;
+}
+
+float sf_qsketch_absquantile(sf_qsketch s, 
+			     float bias /* center */, 
+			     double q   /* rank, from 0 to n-1 */)
+/*< estimate quantile of |values - bias| >*/
+{
+    int lo, hi, j;
+    float *c, t;
+
+    if (0 == s->nv) return 0.;
+
+    c = sf_floatalloc(s->nv);
+    for (j=0; j < s->nv; j++) {
+	c[j] = fabsf(s->v[j]-bias);
+    }
+    qsort(c,s->nv,sizeof(float),float_comp);
+
+    /* smallest candidate with q+1 values within it from bias */
+    lo = -1; hi = s->nv-1;
+    while (hi-lo > 1) {
+	j = (lo+hi)/2;
+	if (sketch_abs(s,bias,c[j]) >= q+1.) {
+	    hi = j;
+	} else {
+	    lo = j;
+	}
+    }
+    t = c[hi];
+
+    free(c);
+    return t;
+}
+
+void sf_qsketch_close(sf_qsketch s)
+/*< free allocated storage >*/
+{
+    free(s->b0);
+    free(s->bk);
+    free(s->bn);
+    free(s->v);
+    free(s);
+}
@@ -33,6 +33,10 @@ typedef struct sf_Triangle *sf_triangle;
 
 #endif
 
+#define SF_TRIANGLE_LINES 64
+/* adjacent lines in a panel for sf_smooth_lines and friends */
+/*^*/
+
 struct sf_Triangle {
     float *tmp, wt;
     int np, nb, nx;
@@ -282,6 +286,290 @@ void sf_dsmooth2 (sf_triangle tr  /* smoothing object */,
     fold2 (o,d,tr->nx,tr->nb,tr->np,x,tr->tmp);
 }
 
+/* Panels of m adjacent lines, x[o+k+i*d] for 0 <= k < m. The same
+   operations as above, applied sample by sample, with the lines
+   interleaved in tmp[i*m+k], so that the inner loops are contiguous
+   in both x and tmp. */
+
+static void fold_lines (int o, int d, int nx, int nb, int np, int m,
+			const float *x, float* tmp)
+{
+    int i, j, k;
+    const float *xi;
+    float *ti;
+
+    /* copy middle */
+    for (i=0; i < nx; i++) {
+	xi = x+o+i*d;
+	ti = tmp+(i+nb)*m;
+	for (k=0; k < m; k++) ti[k] = xi[k];
+    }
+    
+    /* reflections from the right side */
+    for (j=nb+nx; j < np; j += nx) {
+	for (i=0; i < nx && i < np-j; i++) {
+	    xi = x+o+(nx-1-i)*d;
+	    ti = tmp+(j+i)*m;
+	    for (k=0; k < m; k++) ti[k] = xi[k];
+	}
+	j += nx;
+	for (i=0; i < nx && i < np-j; i++) {
+	    xi = x+o+i*d;
+	    ti = tmp+(j+i)*m;
+	    for (k=0; k < m; k++) ti[k] = xi[k];
+	}
+    }
+    
+    /* reflections from the left side */
+    for (j=nb; j >= 0; j -= nx) {
+	for (i=0; i < nx && i < j; i++) {
+	    xi = x+o+i*d;
+	    ti = tmp+(j-1-i)*m;
+	    for (k=0; k < m; k++) ti[k] = xi[k];
+	}
+	j -= nx;
+	for (i=0; i < nx && i < j; i++) {
+	    xi = x+o+(nx-1-i)*d;
+	    ti = tmp+(j-1-i)*m;
+	    for (k=0; k < m; k++) ti[k] = xi[k];
+	}
+    }
+}
+
+static void fold2_lines (int o, int d, int nx, int nb, int np, int m,
+			 float *x, const float* tmp)
+{
+    int i, j, k;
+    float *xi;
+    const float *ti;
+
+    /* copy middle */
+    for (i=0; i < nx; i++) {
+	xi = x+o+i*d;
+	ti = tmp+(i+nb)*m;
+	for (k=0; k < m; k++) xi[k] = ti[k];
+    }
+
+    /* reflections from the right side */
+    for (j=nb+nx; j < np; j += nx) {
+	for (i=0; i < nx && i < np-j; i++) {
+	    xi = x+o+(nx-1-i)*d;
+	    ti = tmp+(j+i)*m;
+	    for (k=0; k < m; k++) xi[k] += ti[k];
+	}
+	j += nx;
+	for (i=0; i < nx && i < np-j; i++) {
+	    xi = x+o+i*d;
+	    ti = tmp+(j+i)*m;
+	    for (k=0; k < m; k++) xi[k] += ti[k];
+	}
+    }
+    
+    /* reflections from the left side */
+    for (j=nb; j >= 0; j -= nx) {
+	for (i=0; i < nx && i < j; i++) {
+	    xi = x+o+i*d;
+	    ti = tmp+(j-1-i)*m;
+	    for (k=0; k < m; k++) xi[k] += ti[k];
+	}
+	j -= nx;
+	for (i=0; i < nx && i < j; i++) {
+	    xi = x+o+(nx-1-i)*d;
+	    ti = tmp+(j-1-i)*m;
+	    for (k=0; k < m; k++) xi[k] += ti[k];
+	}
+    }
+}
+
+static void doubint_lines (int nx, int m, float *xx, bool der)
+{
+    int i, k;
+    float *x0, *x1;
+
+    /* integrate backward (starting from t=0, which turns -0 into +0) */
+    x1 = xx+(nx-1)*m;
+    for (k=0; k < m; k++) x1[k] += 0.0f;
+    for (i=nx-2; i >= 0; i--) {
+	x0 = xx+i*m;
+	x1 = x0+m;
+	for (k=0; k < m; k++) x0[k] += x1[k];
+    }
+
+    if (der) return;
+
+    /* integrate forward */
+    for (k=0; k < m; k++) xx[k] += 0.0f;
+    for (i=1; i < nx; i++) {
+	x1 = xx+i*m;
+	x0 = x1-m;
+	for (k=0; k < m; k++) x1[k] += x0[k];
+    }
+}
+
+static void doubint2_lines (int nx, int m, float *xx, bool der)
+{
+    int i, k;
+    float *x0, *x1;
+
+    /* integrate forward */
+    for (k=0; k < m; k++) xx[k] += 0.0f;
+    for (i=1; i < nx; i++) {
+	x1 = xx+i*m;
+	x0 = x1-m;
+	for (k=0; k < m; k++) x1[k] += x0[k];
+    }
+
+    if (der) return;
+
+    /* integrate backward (starting from t=0, which turns -0 into +0) */
+    x1 = xx+(nx-1)*m;
+    for (k=0; k < m; k++) x1[k] += 0.0f;
+    for (i=nx-2; i >= 0; i--) {
+	x0 = xx+i*m;
+	x1 = x0+m;
+	for (k=0; k < m; k++) x0[k] += x1[k];
+    }
+}
+
+static void triple_lines (int o, int d, int nx, int nb, int m, 
+			  float* x, const float* tmp, bool box, bool der, 
+			  float wt)
+{
+    int i, k;
+    float *xi;
+    const float *t0, *t1, *t2;
+
+    for (i=0; i < nx; i++) {
+	xi = x+o+i*d;
+	t0 = tmp+i*m;
+	t2 = tmp+(i+2*nb)*m;
+	if (der) {
+	    for (k=0; k < m; k++) xi[k] = (t0[k] - t2[k])*wt;
+	} else if (box) {
+	    t1 = tmp+(i+1)*m;
+	    for (k=0; k < m; k++) xi[k] = (t1[k] - t2[k])*wt;
+	} else {
+	    t1 = tmp+(i+nb)*m;
+	    for (k=0; k < m; k++) xi[k] = (2.*t1[k] - t0[k] - t2[k])*wt;
+	}
+    }
+}
+
+static void axpy_lines (int nx, int m, float a, 
+			const float *x, int d, float *y)
+/* y += a*x for each line, through BLAS as in triple2, so that rounding
+   is the same as for a single line */
+{
+    int i;
+
+    for (i=0; i < nx; i++) {
+	cblas_saxpy(m,a,x+i*d,1,y+i*m,1);
+    }
+}
+
+static void triple2_lines (int o, int d, int nx, int nb, int m, 
+			   const float* x, float* tmp, bool box, bool der,
+			   float wt)
+{
+    int i;
+
+    for (i=0; i < (nx + 2*nb)*m; i++) {
+	tmp[i] = 0;
+    }
+
+    if (der) {
+	axpy_lines(nx,m,  wt,x+o,d,tmp       );
+	axpy_lines(nx,m, -wt,x+o,d,tmp+2*nb*m);
+    } else if (box) {
+	axpy_lines(nx,m,  +wt,x+o,d,tmp+m     );
+	axpy_lines(nx,m,  -wt,x+o,d,tmp+2*nb*m);
+    } else {
+	axpy_lines(nx,m,  -wt,x+o,d,tmp       );
+	axpy_lines(nx,m,2.*wt,x+o,d,tmp+nb*m  );
+	axpy_lines(nx,m,  -wt,x+o,d,tmp+2*nb*m);
+    }
+}
+
+void sf_smooth_lines (sf_triangle tr  /* smoothing object */, 
+		      int o, int d    /* trace sampling */, 
+		      int m           /* number of adjacent traces */,
+		      bool der        /* if derivative */, 
+		      float *x        /* data (smoothed in place) */,
+		      float *tmp      /* workspace [(ndat+2*nbox)*m] */)
+/*< apply triangle smoothing to traces x[o+k+i*d], k=0...m-1;
+  same result as sf_smooth on each trace, reentrant >*/
+{
+    if (1 == m) {
+	fold (o,d,tr->nx,tr->nb,tr->np,x,tmp);
+	doubint (tr->np,tmp,(bool) (tr->box || der));
+	triple (o,d,tr->nx,tr->nb,x,tmp,tr->box,tr->wt);
+	return;
+    }
+    fold_lines (o,d,tr->nx,tr->nb,tr->np,m,x,tmp);
+    doubint_lines (tr->np,m,tmp,(bool) (tr->box || der));
+    triple_lines (o,d,tr->nx,tr->nb,m,x,tmp,tr->box,false,tr->wt);
+}
+
+void sf_dsmooth_lines (sf_triangle tr  /* smoothing object */, 
+		       int o, int d    /* trace sampling */, 
+		       int m           /* number of adjacent traces */,
+		       bool der        /* if derivative */, 
+		       float *x        /* data (smoothed in place) */,
+		       float *tmp      /* workspace [(ndat+2*nbox)*m] */)
+/*< apply triangle smoothing to traces x[o+k+i*d], k=0...m-1;
+  same result as sf_dsmooth on each trace, reentrant >*/
+{
+    if (1 == m) {
+	fold (o,d,tr->nx,tr->nb,tr->np,x,tmp);
+	doubint (tr->np,tmp,(bool) (tr->box || der));
+	dtriple (o,d,tr->nx,tr->nb,x,tmp,tr->wt);
+	return;
+    }
+    fold_lines (o,d,tr->nx,tr->nb,tr->np,m,x,tmp);
+    doubint_lines (tr->np,m,tmp,(bool) (tr->box || der));
+    triple_lines (o,d,tr->nx,tr->nb,m,x,tmp,tr->box,true,tr->wt);
+}
+
+void sf_smooth2_lines (sf_triangle tr  /* smoothing object */, 
+		       int o, int d    /* trace sampling */, 
+		       int m           /* number of adjacent traces */,
+		       bool der        /* if derivative */,
+		       float *x        /* data (smoothed in place) */,
+		       float *tmp      /* workspace [(ndat+2*nbox)*m] */)
+/*< apply adjoint triangle smoothing to traces x[o+k+i*d], k=0...m-1;
+  same result as sf_smooth2 on each trace, reentrant >*/
+{
+    if (1 == m) {
+	triple2 (o,d,tr->nx,tr->nb,x,tmp,tr->box,tr->wt);
+	doubint2 (tr->np,tmp,(bool) (tr->box || der));
+	fold2 (o,d,tr->nx,tr->nb,tr->np,x,tmp);
+	return;
+    }
+    triple2_lines (o,d,tr->nx,tr->nb,m,x,tmp,tr->box,false,tr->wt);
+    doubint2_lines (tr->np,m,tmp,(bool) (tr->box || der));
+    fold2_lines (o,d,tr->nx,tr->nb,tr->np,m,x,tmp);
+}
+
+void sf_dsmooth2_lines (sf_triangle tr  /* smoothing object */, 
+			int o, int d    /* trace sampling */, 
+			int m           /* number of adjacent traces */,
+			bool der        /* if derivative */,
+			float *x        /* data (smoothed in place) */,
+			float *tmp      /* workspace [(ndat+2*nbox)*m] */)
+/*< apply adjoint triangle smoothing to traces x[o+k+i*d], k=0...m-1;
+  same result as sf_dsmooth2 on each trace, reentrant >*/
+{
+    if (1 == m) {
+	dtriple2 (o,d,tr->nx,tr->nb,x,tmp,tr->wt);
+	doubint2 (tr->np,tmp,(bool) (tr->box || der));
+	fold2 (o,d,tr->nx,tr->nb,tr->np,x,tmp);
+	return;
+    }
+    triple2_lines (o,d,tr->nx,tr->nb,m,x,tmp,tr->box,true,tr->wt);
+    doubint2_lines (tr->np,m,tmp,(bool) (tr->box || der));
+    fold2_lines (o,d,tr->nx,tr->nb,tr->np,m,x,tmp);
+}
+
 void  sf_triangle_close(sf_triangle tr)
 /*< free allocated storage >*/
 {
@@ -26,38 +26,78 @@
 #include "alloc.h"
 #include "error.h"
 #include "adjnull.h"
-#include "decart.h"
+#include "_defs.h"
 
-static int *n, s[SF_MAX_DIM], nd, dim;
-static sf_triangle *tr;
-static float *tmp;
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
-void sf_trianglen_init (int ndim  /* number of dimensions */, 
-			int *nbox /* triangle radius [ndim] */, 
-			int *ndat /* data dimensions [ndim] */)
-/*< initialize >*/
+#ifndef _sf_trianglen_h
+
+typedef struct sf_Trianglen *sf_trianglen;
+/* abstract data type */
+/*^*/
+
+#endif
+
+struct sf_Trianglen {
+    int *n, s[SF_MAX_DIM], nd, dim, nw, nth;
+    sf_triangle *tr;
+    float *tmp, *work;
+};
+
+static sf_trianglen tr0;
+
+sf_trianglen sf_trianglen_init_r (int ndim  /* number of dimensions */, 
+				  int *nbox /* triangle radius [ndim] */, 
+				  int *ndat /* data dimensions [ndim] */)
+/*< initialize a reentrant smoother, to be used with sf_trianglen_lop_r >*/
 {
-    int i;
+    int i, np;
+    sf_trianglen tr;
+
+    tr = (sf_trianglen) sf_alloc(1,sizeof(*tr));
 
-    dim = ndim;
-    n = sf_intalloc(dim);
+    tr->dim = ndim;
+    tr->n = sf_intalloc(ndim);
 
-    tr = (sf_triangle*) sf_alloc(dim,sizeof(sf_triangle));
+    tr->tr = (sf_triangle*) sf_alloc(ndim,sizeof(sf_triangle));
 
-    nd = 1;
-    for (i=0; i < dim; i++) {
-	tr[i] = (nbox[i] > 1)? sf_triangle_init (nbox[i],ndat[i],false): NULL;
-	s[i] = nd;
-	n[i] = ndat[i];
-	nd *= ndat[i];
+    tr->nd = 1;
+    tr->nw = 1;
+    for (i=0; i < ndim; i++) {
+	tr->tr[i] = (nbox[i] > 1)? sf_triangle_init (nbox[i],ndat[i],false): NULL;
+	tr->s[i] = tr->nd;
+	tr->n[i] = ndat[i];
+	tr->nd *= ndat[i];
+
+	/* workspace for a panel of lines along axis i */
+	np = (ndat[i]+2*nbox[i])*(1==tr->s[i]? 1: SF_TRIANGLE_LINES);
+	if (NULL != tr->tr[i] && np > tr->nw) tr->nw = np;
     }
-    tmp = sf_floatalloc (nd);
+    tr->tmp = sf_floatalloc (tr->nd);
+
+#ifdef _OPENMP
+    tr->nth = omp_get_max_threads();
+#else
+    tr->nth = 1;
+#endif
+    tr->work = sf_floatalloc ((size_t) tr->nth*tr->nw);
+
+    return tr;
 }
 
-void sf_trianglen_lop (bool adj, bool add, int nx, int ny, float* x, float* y)
-/*< linear operator >*/
+void sf_trianglen_lop_r (void *data /* sf_trianglen */, 
+			 bool adj, bool add, int nx, int ny, float* x, float* y)
+/*< linear operator with its own state >*/
 {
-    int i, j, i0;
+    int i, j, ip, np, nj, nk, i0, nd, m;
+    float *tmp, *work;
+    sf_trianglen tr;
+
+    tr = (sf_trianglen) data;
+    nd = tr->nd;
+    tmp = tr->tmp;
 
     if (nx != ny || nx != nd) 
 	sf_error("%s: Wrong data dimensions: nx=%d, ny=%d, nd=%d",
@@ -76,12 +116,29 @@ void sf_trianglen_lop (bool adj, bool add, int nx, int ny, float* x, float* y)
     }
 
   
-    for (i=0; i < dim; i++) {
-	if (NULL != tr[i]) {
-	    for (j=0; j < nd/n[i]; j++) {
-		i0 = sf_first_index (i,j,dim,n,s);
-		sf_smooth2 (tr[i], i0, s[i], false, tmp);
-	    }
+    for (i=0; i < tr->dim; i++) {
+	if (NULL == tr->tr[i]) continue;
+
+	/* lines along axis i start at j*n[i]*s[i] + k, k < s[i];
+	   smooth them in panels of up to SF_TRIANGLE_LINES adjacent ones */
+	nj = nd/(tr->n[i]*tr->s[i]);
+	nk = (tr->s[i]+SF_TRIANGLE_LINES-1)/SF_TRIANGLE_LINES;
+	np = nj*nk;
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(tr->nth) schedule(static) private(ip,j,i0,m,work) if(np > 1)
+#endif
+	for (ip=0; ip < np; ip++) {
+	    j = ip/nk;
+	    i0 = (ip%nk)*SF_TRIANGLE_LINES;
+	    m = SF_MIN(SF_TRIANGLE_LINES,tr->s[i]-i0);
+	    i0 += j*tr->n[i]*tr->s[i];
+#ifdef _OPENMP
+	    work = tr->work+(size_t) tr->nw*omp_get_thread_num();
+#else
+	    work = tr->work;
+#endif
+	    sf_smooth2_lines (tr->tr[i], i0, tr->s[i], m, false, tmp, work);
 	}
     }
 	
@@ -96,18 +153,39 @@ void sf_trianglen_lop (bool adj, bool add, int nx, int ny, float* x, float* y)
     }    
 }
 
-void sf_trianglen_close(void)
-/*< free allocated storage >*/
+void sf_trianglen_close_r (sf_trianglen tr)
+/*< free a reentrant smoother >*/
 {
     int i;
 
-    free (tmp);
+    free (tr->tmp);
+    free (tr->work);
 
-    for (i=0; i < dim; i++) {
-	if (NULL != tr[i]) sf_triangle_close (tr[i]);
+    for (i=0; i < tr->dim; i++) {
+	if (NULL != tr->tr[i]) sf_triangle_close (tr->tr[i]);
     }
 
+    free(tr->tr);
+    free(tr->n);
     free(tr);
-    free(n);
 }
 
+void sf_trianglen_init (int ndim  /* number of dimensions */, 
+			int *nbox /* triangle radius [ndim] */, 
+			int *ndat /* data dimensions [ndim] */)
+/*< initialize >*/
+{
+    tr0 = sf_trianglen_init_r(ndim,nbox,ndat);
+}
+
+void sf_trianglen_lop (bool adj, bool add, int nx, int ny, float* x, float* y)
+/*< linear operator >*/
+{
+    sf_trianglen_lop_r(tr0,adj,add,nx,ny,x,y);
+}
+
+void sf_trianglen_close(void)
+/*< free allocated storage >*/
+{
+    sf_trianglen_close_r(tr0);
+}
@@ -32,27 +32,37 @@ void sf_weight_init(float *w1)
     w = w1;
 }
 
-void sf_weight_lop (bool adj, bool add, int nx, int ny, float* xx, float* yy)
-/*< linear operator >*/
+void sf_weight_lop_r (void *data /* weight [nx] */, 
+		      bool adj, bool add, int nx, int ny, float* xx, float* yy)
+/*< linear operator with its own weight >*/
 {
     int i;
+    const float *wt;
 
     if (ny!=nx) sf_error("%s: size mismatch: %d != %d",__FILE__,ny,nx);
 
     sf_adjnull (adj, add, nx, ny, xx, yy);
+
+    wt = (const float*) data;
   
     if (adj) {
         for (i=0; i < nx; i++) {
-	    xx[i] += yy[i] * w[i];
+	    xx[i] += yy[i] * wt[i];
 	}
     } else {
         for (i=0; i < nx; i++) {
-            yy[i] += xx[i] * w[i];
+            yy[i] += xx[i] * wt[i];
 	}
     }
 
 }
 
+void sf_weight_lop (bool adj, bool add, int nx, int ny, float* xx, float* yy)
+/*< linear operator >*/
+{
+    sf_weight_lop_r(w,adj,add,nx,ny,xx,yy);
+}
+
 void sf_cweight_lop (bool adj, bool add, int nx, int ny, 
 		     sf_complex* xx, sf_complex* yy)
 /*< linear operator >*/
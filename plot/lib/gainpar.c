@@ -18,18 +18,37 @@
 */
 
 #include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <sys/types.h>
+#include <sys/stat.h>
 
 #include <rsf.h>
 /*^*/
 
 #include "gainpar.h"
 
-static float get_bias (sf_file in, float **data, int n1, int n2, int step, 
-		       int nt);
+#define SKETCH 1024 /* order statistics kept per panel for mean=y */
+
+#ifndef _vp_gainpar_h
+
+#define VP_GAINIKEYS 7
+/* n1,n2,n3,step,panel,mean,sketch */
+#define VP_GAINFKEYS 5
+/* pclip,phalf and input bias,clip,gpow */
+/*^*/
+
+#endif
 
-static void gain (sf_file in, float **data, int n1, int n2,int step,
+static void read_panel (sf_file in, float **data, int n1, int n2);
+
+static float get_bias (float **data, int n1, int n2, int step, int nt);
+
+static void gain (float **data, int n1, int n2,int step,
 		  float pclip,float phalf,
-		  float *clip, float *gpow, float bias, int nt, float* buf);
+		  float *clip, float *gpow, float bias, int nt, float* buf,
+		  sf_qsketch sketch);
 
 void vp_gainpar (sf_file in, float **data, 
 		 int n1, int n2 /* panel size */,
@@ -42,58 +61,94 @@ void vp_gainpar (sf_file in, float **data,
 		 float *bias, 
 		 int n3         /* number of panels */ ,
 		 int panel      /* gain type */,
-		 int cpanel     /* current panel */)
+		 int cpanel     /* current panel */,
+		 bool onepass   /* mean with all panels from sketches */)
 /*< Find clip and gpow parameters >*/
 {
-    int nt, i3, nclip, nhalf;
+    int nt, i3, nclip, nhalf, i2, it, j;
     float *buf, *clipnp, *gpownp, **data2;
     double sum;
     off_t pos=0;
+    sf_qsketch *sketch;
     /* const float zeroClip = 1e-12; // seems to be a good choise; feel free to change */
 
     nt = n1 / step;
     buf = sf_floatalloc (nt*n2);
   
     if (panel >= 0) { /* gain from a particular panel */
-	if (mean) {
-	    if (NULL != in) pos = sf_tell (in);
-	    *bias = get_bias (in, data, n1, n2, step, nt);
-	    if (NULL != in) sf_seek (in, pos, SEEK_SET);
-	}
+	read_panel (in, data, n1, n2);
+	if (mean) *bias = get_bias (data, n1, n2, step, nt);
 
-	gain (in, data, n1, n2, step, pclip, phalf, clip, 
-	      gpow, *bias, nt, buf);
+	gain (data, n1, n2, step, pclip, phalf, clip, 
+	      gpow, *bias, nt, buf, NULL);
 
 	if (*clip==0.0) {
 	    /* find next non-zero panel */
 	    for (cpanel++; cpanel < n3; cpanel++) { 
-		gain (in, data, n1, n2, step, pclip, phalf, clip, 
-		      gpow, *bias, nt, buf);
+		read_panel (in, data, n1, n2);
+		gain (data, n1, n2, step, pclip, phalf, clip, 
+		      gpow, *bias, nt, buf, NULL);
 		if (*clip > 0.0) break; 
 	    }	
 	}
     } else { /* gainpanel=all */
-	if (mean) {
+	clipnp = sf_floatalloc (n3);
+	gpownp = sf_floatalloc (n3);
+
+	if (mean && !onepass) {
+	    /* exact: one pass for the bias, another for the panels */
 	    if (NULL != in) pos = sf_tell (in);
 	    data2 = data;
 	    sum = 0.0;
 	    for (i3 = 0; i3 < n3; i3++) {
-		sum += get_bias (in, data2, n1, n2, step, nt);		
+		read_panel (in, data2, n1, n2);
+		sum += get_bias (data2, n1, n2, step, nt);
 		if (NULL == in) data2 += n1 * n2; /* next panel */
 	    }
 	    *bias = sum / n3;
 	    if (NULL != in) sf_seek (in, pos, SEEK_SET);
 	}
-	    
-	clipnp = sf_floatalloc (n3);
-	gpownp = sf_floatalloc (n3);
 
-	for (i3 = 0; i3 < n3; i3++) {
-	    clipnp[i3] = 0.;
-	    gpownp[i3] = 0.;
-	    gain (in, data, n1, n2, step, pclip, phalf,
-		  clipnp+i3, gpownp+i3, *bias, nt, buf); 
-	    if (NULL == in) data += n1 * n2; /* next panel */
+	if (mean && onepass) {
+	    /* single pass: the bias is not known until the end,
+	       so each panel is kept as a sketch of its values */
+	    sketch = (sf_qsketch*) sf_alloc (n3,sizeof(sf_qsketch));
+
+	    data2 = data;
+	    sum = 0.0;
+	    for (i3 = 0; i3 < n3; i3++) {
+		read_panel (in, data2, n1, n2);
+		sum += get_bias (data2, n1, n2, step, nt);
+
+		for (j=i2=0; i2<n2; i2++) {
+		    for (it=0; it<nt; it++, j++) {
+			buf[j] = data2[i2][it*step];
+		    }
+		}
+		sketch[i3] = sf_qsketch_init (SKETCH);
+		sf_qsketch_add (sketch[i3], nt*n2, buf);
+
+		if (NULL == in) data2 += n1 * n2; /* next panel */
+	    }
+	    *bias = sum / n3;
+
+	    for (i3 = 0; i3 < n3; i3++) {
+		clipnp[i3] = 0.;
+		gpownp[i3] = 0.;
+		gain (NULL, n1, n2, step, pclip, phalf,
+		      clipnp+i3, gpownp+i3, *bias, nt, buf, sketch[i3]);
+		sf_qsketch_close (sketch[i3]);
+	    }
+	    free (sketch);
+	} else {
+	    for (i3 = 0; i3 < n3; i3++) {
+		clipnp[i3] = 0.;
+		gpownp[i3] = 0.;
+		read_panel (in, data, n1, n2);
+		gain (data, n1, n2, step, pclip, phalf,
+		      clipnp+i3, gpownp+i3, *bias, nt, buf, NULL); 
+		if (NULL == in) data += n1 * n2; /* next panel */
+	    }
 	}
 
 	nclip = SF_MAX (SF_MIN (n3 * pclip / 100. + .5, n3 - 1), 0);
@@ -109,15 +164,17 @@ void vp_gainpar (sf_file in, float **data,
     free (buf);
 }
 
-static float get_bias (sf_file in, float **data, int n1, int n2, int step, 
-		       int nt)
+static void read_panel (sf_file in, float **data, int n1, int n2)
+{
+    if (NULL != in) sf_floatread (data[0],n1*n2,in);
+}
+
+static float get_bias (float **data, int n1, int n2, int step, int nt)
 {
     int i2, it;
     float bias;
     double sum;
 
-    if (NULL != in) sf_floatread (data[0],n1*n2,in);
-
     sum = 0.0;
     for (i2=0; i2<n2; i2++) {
 	for (it=0; it<nt; it++) {
@@ -128,23 +185,44 @@ static float get_bias (sf_file in, float **data, int n1, int n2, int step,
 
     return bias;
 }
+
+static float panel_quantile (int ntest, int n, float *buf, 
+			     sf_qsketch sketch, float bias)
+/* ntest-th smallest |data - bias| in a panel */
+{
+    int j;
+    float q;
+
+    if (NULL != sketch) 
+	return sf_qsketch_absquantile (sketch, bias, 
+				       SF_MAX(SF_MIN(ntest,n-1),0));
+
+    if (ntest >= n) { /* 100% */
+	q = buf[0];		
+	for (j=1; j < n; j++) {
+	    if(buf[j] > q) q=buf[j];
+	}	
+    } else {
+	q = sf_quantile(SF_MAX(ntest,0),n,buf);
+    }
+
+    return q;
+}
  
-static void gain (sf_file in, float **data, int n1, int n2, int step,
+static void gain (float **data, int n1, int n2, int step,
 		  float pclip,float phalf, float *clipp, float *gpowp, 
-		  float bias, int nt, float *buf)
+		  float bias, int nt, float *buf, sf_qsketch sketch)
 {
     int j, i2, it, ntest, n;
     float clip, gpow, half;
-    int panelsize = n1 * n2;
 
     n = n2*nt;
 	
-    if (NULL != in) {
-	sf_floatread (data[0], panelsize, in);
-    }
-    for (j=i2=0; i2<n2; i2++) {
-	for (it=0; it<nt; it++, j++) {
-	    buf[j] = fabsf(data[i2][it*step]- bias);
+    if (NULL == sketch) {
+	for (j=i2=0; i2<n2; i2++) {
+	    for (it=0; it<nt; it++, j++) {
+		buf[j] = fabsf(data[i2][it*step]- bias);
+	    }
 	}
     }
     
@@ -153,27 +231,13 @@ static void gain (sf_file in, float **data, int n1, int n2, int step,
 
     if (clip==0.) {
 	ntest = n*pclip/100. + .5;
-	if (ntest >= n) { /* 100% clip */
-	    clip = buf[0];		
-	    for (j=1; j < n; j++) {
-		if(buf[j] > clip) clip=buf[j];
-	    }	
-	} else {
-	    clip = sf_quantile(SF_MAX(ntest,0),n,buf);
-	}
+	clip = panel_quantile (ntest, n, buf, sketch, bias);
 	*clipp = clip;
     }
     
     if (*gpowp==0.) {
 	ntest = n*phalf/100. + .5;
-	if (ntest >= n) { /* 100% half */
-	    half = buf[0];
-	    for (j=1; j < n; j++) {
-		if(buf[j] > half) half=buf[j];
-	    }	
-	} else {
-	    half = sf_quantile (SF_MAX(ntest,0),n,buf);
-	}
+	half = panel_quantile (ntest, n, buf, sketch, bias);
 	
 	if (clip==0. || half == clip || half/clip < 0.001) {
 	    gpow = 1.;
@@ -188,3 +252,113 @@ static void gain (sf_file in, float **data, int n1, int n2, int step,
 	*gpowp = gpow;
     }
 }
+
+static bool data_stamp (sf_file in, char *stamp, size_t len)
+/* identify the data file of in by device, inode, size and time */
+{
+    char *name;
+    struct stat st;
+    bool ok;
+
+    if (NULL == (name = sf_histstring (in,"in"))) return false;
+    ok = (0 != strcmp (name,"stdin") && 0 == stat (name,&st) &&
+	  S_ISREG (st.st_mode));
+    free (name);
+    if (!ok) return false;
+
+    snprintf (stamp,len,"%lu:%lu:%lld:%ld",
+	      (unsigned long) st.st_dev, (unsigned long) st.st_ino,
+	      (long long) st.st_size, (long) st.st_mtime);
+    return true;
+}
+
+/* The cache serves sfgrey and sfbyte, which scan the data for the gain
+   before plotting it. sfwiggle and sfthplot take the gain from a panel
+   they read for plotting anyway and have no pass to skip. */
+
+bool vp_gaincache_get (const char *tag /* cache file parameter */,
+		       sf_file in /* data the gain is for */,
+		       const int *ikey /* integer parameters [VP_GAINIKEYS] */,
+		       const float *fkey /* float parameters [VP_GAINFKEYS] */,
+		       float *bias, float *clip, float *gpow)
+/*< read bias, clip and gpow computed for the same data and parameters >*/
+{
+    int n, i, ival[VP_GAINIKEYS];
+    char *name, *cached, stamp[256];
+    float val[VP_GAINFKEYS+3];
+    FILE *test;
+    sf_file cache;
+    bool same;
+
+    if (!data_stamp (in,stamp,sizeof(stamp))) return false;
+
+    if (NULL == (name = sf_getstring (tag))) return false;
+    test = fopen (name,"r");
+    free (name);
+    if (NULL == test) return false;
+    fclose (test);
+
+    cache = sf_input (tag);
+    cached = sf_histstring (cache,"data");
+    same = (NULL != cached && 0 == strcmp (cached,stamp));
+    if (NULL != cached) free (cached);
+
+    if (!same || SF_FLOAT != sf_gettype (cache) ||
+	!sf_histint (cache,"n1",&n) || VP_GAINFKEYS+3 != n ||
+	!sf_histints (cache,"keys",ival,VP_GAINIKEYS)) {
+	sf_fileclose (cache);
+	return false;
+    }
+    sf_floatread (val,VP_GAINFKEYS+3,cache);
+    sf_fileclose (cache);
+
+    for (i=0; i < VP_GAINIKEYS; i++) {
+	if (ival[i] != ikey[i]) return false;
+    }
+    for (i=0; i < VP_GAINFKEYS; i++) {
+	if (val[i] != fkey[i]) return false;
+    }
+
+    *bias = val[VP_GAINFKEYS];
+    *clip = val[VP_GAINFKEYS+1];
+    *gpow = val[VP_GAINFKEYS+2];
+    return true;
+}
+
+void vp_gaincache_put (const char *tag /* cache file parameter */,
+		       sf_file in /* data the gain is for */,
+		       const int *ikey /* integer parameters [VP_GAINIKEYS] */,
+		       const float *fkey /* float parameters [VP_GAINFKEYS] */,
+		       float bias, float clip, float gpow)
+/*< save bias, clip and gpow for later runs on the same data >*/
+{
+    int i;
+    char stamp[256];
+    float val[VP_GAINFKEYS+3];
+    sf_file cache;
+
+    if (!data_stamp (in,stamp,sizeof(stamp))) {
+	sf_warning("%s: data is not in a file, not cached",tag);
+	return;
+    }
+
+    for (i=0; i < VP_GAINFKEYS; i++) {
+	val[i] = fkey[i];
+    }
+    val[VP_GAINFKEYS]   = bias;
+    val[VP_GAINFKEYS+1] = clip;
+    val[VP_GAINFKEYS+2] = gpow;
+
+    cache = sf_output (tag);
+    sf_settype (cache,SF_FLOAT);
+    sf_putint (cache,"n1",VP_GAINFKEYS+3);
+    sf_putint (cache,"n2",1);
+    sf_putint (cache,"n3",1);
+    sf_putstring (cache,"data",stamp);
+    sf_putints (cache,"keys",ikey,VP_GAINIKEYS);
+    sf_putfloat (cache,"bias",bias);
+    sf_putfloat (cache,"clip",clip);
+    sf_putfloat (cache,"gpow",gpow);
+    sf_floatwrite (val,VP_GAINFKEYS+3,cache);
+    sf_fileclose (cache);
+}
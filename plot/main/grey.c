@@ -44,10 +44,12 @@ int main(int argc, char* argv[])
     int n1, n2, n3, gainstep, panel, it, nreserve, i1, i2, i3, j, orient;
     float o1, o2, o3, d1, d2, d3, gpow, clip, pclip, phalf, bias=0., minmax[2];
     float pbias, gain=0., x1, y1, x2, y2, **data=NULL, f, barmin, barmax, dat;
+    float fkey[VP_GAINFKEYS];
+    int ikey[VP_GAINIKEYS];
     bool transp, yreverse, xreverse, allpos, polarity, symcp, verb;
-    bool eclip=false, egpow=false, barreverse, mean=false;
+    bool eclip=false, egpow=false, barreverse, mean=false, sketch=false;
     bool scalebar, nomin=true, nomax=true, framenum, sfbyte, sfbar, charin;
-    char *gainpanel, *color, *barfile;
+    char *gainpanel, *color, *barfile, *gaincache;
     unsigned char tbl[TSIZE+1], **buf, tmp, *barbuf[1];
     enum {GAIN_EACH=-3,GAIN_ALL=-2,NO_GAIN=-1};
     off_t pos;
@@ -167,6 +169,10 @@ int main(int argc, char* argv[])
 	/* if y, assume positive data */
 	if (!sf_getbool("mean",&mean)) mean=false;
 	/* if y, bias on the mean value */
+	if (!sf_getbool("gainsketch",&sketch)) sketch=false;
+	/* if y, mean=y gainpanel=all reads the data once and takes clip
+	   and gpow from a sketch of each panel: within 0.05% of the panel
+	   in rank, but not the exact clip */
 	if (!sf_getfloat("bias",&pbias)) pbias=0.;
 	/* value mapped to the center of the color table */
 	if (!sf_getbool("polarity",&polarity)) polarity=false;
@@ -260,17 +266,35 @@ int main(int argc, char* argv[])
 	data = sf_floatalloc2(n1,n2);
 
 	if (GAIN_ALL==panel || panel >= 0) {
-	    pos = sf_tell(in);
-	    if (panel > 0) sf_seek(in,
-				   pos+panel*n1*n2*sizeof(float),
-				   SEEK_SET);
-	    vp_gainpar (in,data,n1,n2,gainstep,
-			pclip,phalf,&clip,&gpow,mean,&pbias,
-			n3,panel,panel);
+	    ikey[0] = n1; ikey[1] = n2; ikey[2] = n3; ikey[3] = gainstep;
+	    ikey[4] = panel; ikey[5] = mean; ikey[6] = sketch;
+	    fkey[0] = pclip; fkey[1] = phalf;
+	    fkey[2] = pbias; fkey[3] = clip; fkey[4] = gpow;
+
+	    gaincache = sf_getstring("gaincache");
+	    /* file keeping bias, clip, and gpow of this data between runs
+	       (sfbyte keeps them for sfgrey3 and sfgrey4 too) */
+
+	    if (NULL == gaincache ||
+		!vp_gaincache_get("gaincache",in,ikey,fkey,
+				  &pbias,&clip,&gpow)) {
+		pos = sf_tell(in);
+		if (panel > 0) sf_seek(in,
+				       pos+panel*n1*n2*sizeof(float),
+				       SEEK_SET);
+		vp_gainpar (in,data,n1,n2,gainstep,
+			    pclip,phalf,&clip,&gpow,mean,&pbias,
+			    n3,panel,panel,sketch);
+		sf_seek(in,pos,SEEK_SET); /* rewind */
+
+		if (NULL != gaincache) 
+		    vp_gaincache_put("gaincache",in,ikey,fkey,
+				     pbias,clip,gpow);
+	    }
+	    if (NULL != gaincache) free(gaincache);
 	    if (verb) sf_warning("panel=%d bias=%g clip=%g gpow=%g",
 				 panel,pbias,clip,gpow);
 	    if (sfbyte) sf_putfloat(out,"clip",clip);
-	    sf_seek(in,pos,SEEK_SET); /* rewind */
 	}
     }
 
@@ -290,7 +314,7 @@ int main(int argc, char* argv[])
 		if (egpow) gpow=0.;
 		vp_gainpar (in,data,n1,n2,gainstep,
 			    pclip,phalf,&clip,&gpow,
-			    mean,&pbias,n3,0,n3);
+			    mean,&pbias,n3,0,n3,false);
 		if (verb) sf_warning("bias=%g clip=%g gpow=%g",pbias,clip,gpow);
 	    } else {
 		sf_floatread(data[0],n1*n2,in);
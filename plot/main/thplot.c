@@ -161,7 +161,7 @@ int main(int argc, char* argv[])
 	/* subtract bias from data */
 
 	vp_gainpar (NULL,fff[0],nx,ny,gainstep,
-		    pclip,100.,&clip,&gg,false,&pbias,n3,-2,0);
+		    pclip,100.,&clip,&gg,false,&pbias,n3,-2,0,false);
     }
 
     if (!sf_getfloat ("dclip",&dclip)) dclip=1.;
@@ -168,7 +168,7 @@ int main(int argc, char* argv[])
 	if (zdata <= 0.) {
 	    vp_gainpar (in,pdata,n1,n2,1,
 			pclip,pclip,&zdata,&gpow,false,&bias,
-			n3,0,n3);
+			n3,0,n3,false);
 	    if (verb) sf_warning("clip=%g",zdata);
 	} else {	    
 	  sf_floatread(pdata[0],n1*n2,in);
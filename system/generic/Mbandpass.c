@@ -23,13 +23,15 @@ http://ahay.org/blog/2012/11/03/program-of-the-month-sfbandpass/
 
 #include <rsf.h>
 
+#define NB 256 /* panel of traces */
+
 int main (int argc, char* argv[]) 
 {
     bool phase, verb;
-    int i2, n1, n2, nplo, nphi;
+    int i2, n1, n2, nplo, nphi, nb, mb, nbw;
     float d1, flo, fhi, *trace;
     const float eps=0.0001;
-    sf_butter blo=NULL, bhi=NULL;
+    sf_butter blo=NULL, bhi=NULL, bw[2];
     sf_file in, out;
 
     sf_init (argc, argv); 
@@ -83,35 +85,21 @@ int main (int argc, char* argv[])
     if (verb) sf_warning("flo=%g fhi=%g nplo=%d nphi=%d",
 			 flo,fhi,nplo,nphi);
 
-    trace = sf_floatalloc(n1);
-
-    if (flo > eps)     blo = sf_butter_init(false, flo, nplo);
-    if (fhi < 0.5-eps) bhi = sf_butter_init(true,  fhi, nphi);
-
-    for (i2=0; i2 < n2; i2++) {
-	sf_floatread(trace,n1,in);
-
-	if (NULL != blo) {
-	    sf_butter_apply (blo, n1, trace); 
+    nb = SF_MAX(1,SF_MIN(n2,NB));
+    trace = sf_floatalloc(n1*nb);
 
-	    if (!phase) {
-		sf_reverse (n1, trace);
-		sf_butter_apply (blo, n1, trace); 
-		sf_reverse (n1, trace);	
-	    }
-	}
+    nbw = 0;
+    if (flo > eps)     bw[nbw++] = blo = sf_butter_init(false, flo, nplo);
+    if (fhi < 0.5-eps) bw[nbw++] = bhi = sf_butter_init(true,  fhi, nphi);
 
-	if (NULL != bhi) {
-	    sf_butter_apply (bhi, n1, trace); 
+    /* filter a panel of traces at a time */
+    for (i2=0; i2 < n2; i2 += nb) {
+	mb = SF_MIN(nb,n2-i2);
+	sf_floatread(trace,n1*mb,in);
 
-	    if (!phase) {
-		sf_reverse (n1, trace);
-		sf_butter_apply (bhi, n1, trace); 
-		sf_reverse (n1, trace);		
-	    }
-	}
+	sf_butter_apply_many (nbw, bw, !phase, n1, mb, trace);
  
-	sf_floatwrite(trace,n1,out);
+	sf_floatwrite(trace,n1*mb,out);
     }
 
     if (NULL != blo) sf_butter_close(blo);
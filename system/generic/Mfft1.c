@@ -45,7 +45,7 @@ int main (int argc, char *argv[])
     fftwf_plan    *ompcfg;
 #endif
 #else
-    kiss_fftr_cfg *ompcfg;
+    sf_fftr       ompcfg;
 #endif
 
     long int nbuf, ibuf, left, n2buf;
@@ -170,9 +170,7 @@ int main (int argc, char *argv[])
 	else     ompcfg[ibuf] = fftwf_plan_dft_r2c_1d(nt, ompP[ibuf], (fftwf_complex *) ompQ[ibuf],            FFTW_ESTIMATE);    
 #endif
 #else
-    ompcfg  = (kiss_fftr_cfg*) sf_alloc(ompnth,sizeof(kiss_fftr_cfg));
-    for(ompith=0; ompith<ompnth; ompith++)
-	ompcfg[ompith] = kiss_fftr_alloc(nt,inv?1:0,NULL,NULL);
+    ompcfg = sf_fftr_plan(nt,inv);
     ompith=0;
 #endif
 
@@ -211,11 +209,24 @@ int main (int argc, char *argv[])
 		;        for(i1=n1; i1<nt; i1++) ompP[ibuf][i1]  = 0.0;
 #ifdef SF_HAS_FFTW
 		fftwf_execute(ompcfg[ibuf]);
-#else
-		kiss_fftr(ompcfg[ompith],ompP[ibuf],ompQ[ibuf]);
 #endif
 #endif
+	    }
 
+#ifndef SF_HAS_FFTW
+	    /* traces in SIMD lanes, spread over threads */
+	    sf_fftr_many(ompcfg,nbuf,ompP[0],nt,ompQ[0],nw);
+#endif
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)			\
+    private(ibuf,i1,ompith,shift)				\
+    shared( nbuf,nw,dw,o1,ompQ,ompE)
+#endif
+	    for(ibuf=0; ibuf<nbuf; ibuf++) {
+#ifdef _OPENMP
+		ompith = omp_get_thread_num();
+#endif
 		if (0. != o1) { shift = -2.0*SF_PI*dw*o1;
 		    for (i1=0; i1<nw; i1++) {
 			ompE[ompith].r = cosf(shift*i1);
@@ -268,11 +279,20 @@ int main (int argc, char *argv[])
 		}
 #ifdef SF_HAS_FFTW
 		fftwf_execute(ompcfg[ibuf]);
-#else
-		kiss_fftri(ompcfg[ompith],ompQ[ibuf],ompP[ibuf]);
 #endif
+#endif
+	    }
+
+#ifndef SF_HAS_FFTW
+	    sf_fftri_many(ompcfg,nbuf,ompQ[0],nw,ompP[0],nt);
 #endif
 
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)			\
+    private(ibuf,i1)						\
+    shared( nbuf,n1,wght,ompP)
+#endif
+	    for(ibuf=0; ibuf<nbuf; ibuf++) {
 		for(i1=0; i1<n1; i1++) ompP[ibuf][i1] *= wght;
 	    }
 
@@ -22,14 +22,37 @@ http://ahay.org/blog/2012/01/01/program-of-the-month-sfsmooth/
 */
 
 #include <rsf.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+static void smooth_panel (sf_triangle tr, int ip, int nk, int n, int s, 
+			  int nrep, bool adj, bool diff, 
+			  float *data, float *tmp)
+/* smooth ip-th panel of adjacent lines, nk panels per n*s block */
+{
+    int i0, m, irep;
+
+    i0 = (ip%nk)*SF_TRIANGLE_LINES;
+    m = SF_MIN(SF_TRIANGLE_LINES,s-i0);
+    i0 += (ip/nk)*n*s;
+
+    for (irep=0; irep < nrep; irep++) {
+	if (adj) {
+	    sf_smooth_lines (tr,i0,s,m,diff,data,tmp);
+	} else {
+	    sf_smooth2_lines (tr,i0,s,m,diff,data,tmp);
+	}
+    }
+}
 
 int main (int argc, char* argv[]) 
 {
-    int dim, dim1, i, j, n[SF_MAX_DIM], rect[SF_MAX_DIM], s[SF_MAX_DIM];
-    int nrep, irep, n1, n2, i2, i0;
+    int dim, dim1, i, n[SF_MAX_DIM], rect[SF_MAX_DIM], s[SF_MAX_DIM];
+    int nrep, n1, n2, i2, ip, np, nj, nk, m, nw, nth;
     bool adj, diff[SF_MAX_DIM], box[SF_MAX_DIM];
     char key[6];
-    float* data;
+    float *data, *work, *tmp;
     sf_triangle tr;
     sf_file in, out;
 
@@ -66,6 +89,21 @@ int main (int argc, char* argv[])
 
     data = sf_floatalloc (n1);
 
+    /* workspace for a panel of lines */
+    nw = 1;
+    for (i=0; i <= dim1; i++) {
+	if (rect[i] <= 1) continue;
+	m = (n[i]+2*rect[i])*(1==s[i]? 1: SF_TRIANGLE_LINES);
+	if (m > nw) nw = m;
+    }
+
+#ifdef _OPENMP
+    nth = omp_get_max_threads();
+#else
+    nth = 1;
+#endif
+    work = sf_floatalloc ((size_t) nth*nw);
+
     if (!sf_getint("repeat",&nrep)) nrep=1;
     /* repeat filtering several times */
 
@@ -78,14 +116,26 @@ int main (int argc, char* argv[])
 	for (i=0; i <= dim1; i++) {
 	    if (rect[i] <= 1) continue;
 	    tr = sf_triangle_init (rect[i],n[i],box[i]);
-	    for (j=0; j < n1/n[i]; j++) {
-		i0 = sf_first_index (i,j,dim1+1,n,s);
-		for (irep=0; irep < nrep; irep++) {
-		    if (adj) {
-			sf_smooth (tr,i0,s[i],diff[i],data);
-		    } else {
-			sf_smooth2 (tr,i0,s[i],diff[i],data);
-		    }
+
+	    /* lines along axis i start at j*n[i]*s[i] + k, k < s[i];
+	       smooth them in panels of up to SF_TRIANGLE_LINES adjacent ones */
+	    nj = n1/(n[i]*s[i]);
+	    nk = (s[i]+SF_TRIANGLE_LINES-1)/SF_TRIANGLE_LINES;
+	    np = nj*nk;
+
+	    if (1 == np) {
+		smooth_panel (tr,0,nk,n[i],s[i],nrep,adj,diff[i],data,work);
+	    } else {
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) private(ip,tmp)
+#endif
+		for (ip=0; ip < np; ip++) {
+#ifdef _OPENMP
+		    tmp = work+(size_t) nw*omp_get_thread_num();
+#else
+		    tmp = work;
+#endif
+		    smooth_panel (tr,ip,nk,n[i],s[i],nrep,adj,diff[i],data,tmp);
 		}
 	    }
 	    sf_triangle_close(tr);
@@ -27,11 +27,13 @@ http://ahay.org/blog/2012/03/18/program-of-the-month-sfspectra/
 #include <fftw3.h>
 #endif
 
+#define NB 256 /* panel of traces */
+
 int main (int argc, char* argv[]) 
 {
-    int n1, n2, ni, nfft, nw, i, i1, i2;
-    float d1, o1, dw, *spec=NULL, *trace=NULL, scale;
-    kiss_fft_cpx *fft=NULL;
+    int n1, n2, ni, nfft, nw, i, i1, i2, nb, ib, mb;
+    float d1, o1, dw, *spec=NULL, **trace=NULL, scale;
+    kiss_fft_cpx **fft=NULL;
     char key[3], *label=NULL;
     bool sum, opt;
     sf_file in=NULL, out=NULL;
@@ -39,7 +41,7 @@ int main (int argc, char* argv[])
 #ifdef SF_HAS_FFTW
     fftwf_plan cfg;
 #else
-    kiss_fftr_cfg cfg;
+    sf_fftr cfg;
 #endif
 
     sf_init (argc, argv); 
@@ -72,8 +74,14 @@ int main (int argc, char* argv[])
     nw = nfft/2+1;
     dw = 1./(nfft*d1);
 
-    trace = sf_floatalloc (nfft);
-    fft = (kiss_fft_cpx*) sf_complexalloc (nw);
+#ifdef SF_HAS_FFTW
+    nb = 1;
+#else
+    nb = SF_MIN(n2,NB); /* traces transformed together */
+#endif
+
+    trace = sf_floatalloc2 (nfft,nb);
+    fft = (kiss_fft_cpx**) sf_complexalloc2 (nw,nb);
     spec = sf_floatalloc (nw);
 
     sf_putint(out,"n1",nw);
@@ -91,40 +99,47 @@ int main (int argc, char* argv[])
 	}
     }
 
-    for (i1=n1; i1 < nfft; i1++) {
-	trace[i1] = 0.; /* pad with zeros */
+    for (ib=0; ib < nb; ib++) {
+	for (i1=n1; i1 < nfft; i1++) {
+	    trace[ib][i1] = 0.; /* pad with zeros */
+	}
     }
 
     scale = sqrtf(1./nfft); /* FFT scaling */ 
 
 #ifdef SF_HAS_FFTW
-    cfg = fftwf_plan_dft_r2c_1d(nfft, trace, 
-				(fftwf_complex *) fft,
+    cfg = fftwf_plan_dft_r2c_1d(nfft, trace[0], 
+				(fftwf_complex *) fft[0],
 				FFTW_ESTIMATE);
 #else
-    cfg = kiss_fftr_alloc(nfft,0,NULL,NULL);
+    cfg = sf_fftr_plan(nfft,false);
 #endif
 
     /*  loop over all traces */
-    for (i2=0; i2 < n2; i2++) {
-	sf_floatread(trace,n1,in);
+    for (i2=0; i2 < n2; i2 += nb) {
+	mb = SF_MIN(nb,n2-i2);
+	for (ib=0; ib < mb; ib++) {
+	    sf_floatread(trace[ib],n1,in);
+	}
 
 	/* Fourier transform */
 #ifdef SF_HAS_FFTW
 	fftwf_execute(cfg);
 #else
-	kiss_fftr (cfg,trace,fft);
+	sf_fftr_many(cfg,mb,trace[0],nfft,fft[0],nw);
 #endif
 
-	if (sum) {
-	    for (i1=0; i1 < nw; i1++) {
-		spec[i1] += sf_cabsf(fft[i1]);
-	    }
-	} else {
-	    for (i1=0; i1 < nw; i1++) {
-		spec[i1] = sf_cabsf(fft[i1])*scale;
+	for (ib=0; ib < mb; ib++) {
+	    if (sum) {
+		for (i1=0; i1 < nw; i1++) {
+		    spec[i1] += sf_cabsf(fft[ib][i1]);
+		}
+	    } else {
+		for (i1=0; i1 < nw; i1++) {
+		    spec[i1] = sf_cabsf(fft[ib][i1])*scale;
+		}
+		sf_floatwrite(spec,nw,out);
 	    }
-	    sf_floatwrite(spec,nw,out);
 	}
     }
 
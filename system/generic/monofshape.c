@@ -28,7 +28,7 @@
 static int nfft, nw;
 static kiss_fft_cpx *cdata;
 static float *shape, *tmp, dw;
-static kiss_fftr_cfg forw, invs;
+static sf_fftr forw, invs;
 
 void monofshape_init(int n1)
 /*< initialize with data length >*/
@@ -42,10 +42,8 @@ void monofshape_init(int n1)
     shape = sf_floatalloc(nw);
     tmp = sf_floatalloc(nfft);
     
-    forw = kiss_fftr_alloc(nfft,0,NULL,NULL);
-    invs = kiss_fftr_alloc(nfft,1,NULL,NULL);
-    if (NULL == forw || NULL == invs) 
-	sf_error("%s: KISS FFT allocation problem",__FILE__);
+    forw = sf_fftr_plan(nfft,false);
+    invs = sf_fftr_plan(nfft,true);
 }
 
 void monofshape_set(float a0       /* initial value for Gaussian */, 
@@ -66,7 +64,7 @@ void monofshape_set(float a0       /* initial value for Gaussian */,
 
     scale = sqrtf(1./nfft); /* FFT scaling */ 
 
-    kiss_fftr(forw, tmp,cdata);
+    sf_fftr_many(forw,1,tmp,nfft,cdata,nw);
     max = 0.;
     i0 = 0;
     for (iw=0; iw < nw; iw++) {
@@ -96,8 +94,6 @@ void monofshape_close(void)
     free(cdata);
     free(shape);
     free(tmp);
-    free(forw);
-    free(invs);
 }
 
 void monofshape_lop (bool adj, bool add, int nx, int ny, float* x, float* y) 
@@ -115,11 +111,11 @@ void monofshape_lop (bool adj, bool add, int nx, int ny, float* x, float* y)
 	tmp[iw] = 0.;
     }
 
-    kiss_fftr(forw, tmp, cdata);
+    sf_fftr_many(forw,1,tmp,nfft,cdata,nw);
     for (iw=0; iw < nw; iw++) {
 	cdata[iw] = sf_crmul(cdata[iw],shape[iw]);
     }
-    kiss_fftri(invs, cdata, tmp);
+    sf_fftri_many(invs,1,cdata,nw,tmp,nfft);
 
     for (iw = 0; iw < nx; iw++) {
 	if (adj) {
@@ -0,0 +1,200 @@
+/* Regression test for the out-of-core path of sfheadersort.
+
+memsize=1 forces the keys into several sorted runs and a multi-pass
+merge. The output must be identical to the in-memory sort, and traces
+with equal keys must keep their input order. Int, float and two-key
+headers are tried, all with many ties.
+
+Runs the sfheadersort built next to it, or the program given as the
+first argument.
+*/
+/*
+  Copyright (C) 2026 University of Texas at Austin
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <unistd.h>
+
+#include <rsf.h>
+
+#define N1 4      /* samples per trace, all equal to the trace number */
+#define N2 300000 /* traces */
+
+static char dir[] = "/tmp/headersortXXXXXX";
+
+static void write_rsf(const char *name, const char *form,
+		      int n1, int n2, const void *data)
+/* native RSF file in dir */
+{
+    char path[128];
+    FILE *file;
+
+    snprintf(path,sizeof(path),"%s/%s@",dir,name);
+    file = fopen(path,"wb");
+    if (NULL == file ||
+	(size_t) n1*n2 != fwrite(data,4,(size_t) n1*n2,file))
+	sf_error("cannot write %s:",path);
+    fclose(file);
+
+    snprintf(path,sizeof(path),"%s/%s",dir,name);
+    file = fopen(path,"w");
+    if (NULL == file) sf_error("cannot write %s:",path);
+    fprintf(file,"n1=%d n2=%d\ndata_format=\"native_%s\"\nin=\"%s/%s@\"\n",
+	    n1,n2,form,dir,name);
+    fclose(file);
+}
+
+static void read_order(const char *name, int *order)
+/* trace numbers in the order of an output file */
+{
+    int i2;
+    float *trace;
+    char path[1024], line[1024], *in;
+    FILE *file;
+
+    trace = sf_floatalloc(N1*N2);
+
+    /* the data file is the last in= in the header */
+    snprintf(path,sizeof(path),"%s/%s",dir,name);
+    file = fopen(path,"r");
+    if (NULL == file) sf_error("cannot read %s:",path);
+    path[0] = '\0';
+    while (NULL != fgets(line,sizeof(line),file)) {
+	if (NULL != (in = strstr(line,"in=\"")))
+	    sscanf(in+4,"%1023[^\"]",path);
+    }
+    fclose(file);
+
+    file = fopen(path,"rb");
+    if (NULL == file ||
+	N1*N2 != fread(trace,sizeof(float),N1*N2,file))
+	sf_error("cannot read %s:",path);
+    fclose(file);
+
+    for (i2=0; i2 < N2; i2++) {
+	order[i2] = trace[i2*N1];
+    }
+    free(trace);
+}
+
+static int key_order(int nkey, const float *fkey, const int *ikey,
+		     int i, int j)
+/* compare keys of traces i and j, ties broken by trace number */
+{
+    int k;
+
+    for (k=0; k < nkey; k++) {
+	if (NULL != fkey) {
+	    if (fkey[i*nkey+k] != fkey[j*nkey+k])
+		return (fkey[i*nkey+k] < fkey[j*nkey+k])? -1: 1;
+	} else {
+	    if (ikey[i*nkey+k] != ikey[j*nkey+k])
+		return (ikey[i*nkey+k] < ikey[j*nkey+k])? -1: 1;
+	}
+    }
+    return (i < j)? -1: (i > j)? 1: 0;
+}
+
+int main(int argc, char* argv[])
+{
+    const char *heads[] = {"int","float","two"}, *mems[] = {"","memsize=1"};
+    int i2, j, ih, im, nkey, *seen, *mem, *ext, *ikey, *two;
+    float *trace, *fkey;
+    bool same, stable, fail;
+    char prog[1024], cmd[2048], *slash;
+
+    if (argc > 1) {
+	snprintf(prog,sizeof(prog),"%s",argv[1]);
+    } else if (NULL != (slash = strrchr(argv[0],'/'))) {
+	snprintf(prog,sizeof(prog),"%.*ssfheadersort",
+		 (int) (slash+1-argv[0]),argv[0]);
+    } else {
+	snprintf(prog,sizeof(prog),"./sfheadersort");
+    }
+
+    if (NULL == mkdtemp(dir)) sf_error("cannot make %s:",dir);
+
+    trace = sf_floatalloc(N1*N2);
+    ikey = sf_intalloc(N2);
+    fkey = sf_floatalloc(N2);
+    two = sf_intalloc(2*N2);
+
+    for (i2=0; i2 < N2; i2++) {
+	for (j=0; j < N1; j++) {
+	    trace[i2*N1+j] = i2;
+	}
+	ikey[i2] = (i2*7919L)%1000;
+	fkey[i2] = ikey[i2]/8.0;
+	two[2*i2]   = (i2*7919L)%500;
+	two[2*i2+1] = (i2*31L)%40;
+    }
+
+    write_rsf("traces.rsf","float",N1,N2,trace);
+    write_rsf("int.rsf","int",N2,1,ikey);
+    write_rsf("float.rsf","float",N2,1,fkey);
+    write_rsf("two.rsf","int",2,N2,two);
+    free(trace);
+
+    mem = sf_intalloc(N2);
+    ext = sf_intalloc(N2);
+    seen = sf_intalloc(N2);
+
+    fail = false;
+    for (ih=0; ih < 3; ih++) {
+	for (im=0; im < 2; im++) {
+	    snprintf(cmd,sizeof(cmd),
+		     "DATAPATH=%s/ %s head=%s/%s.rsf %s "
+		     "< %s/traces.rsf > %s/%s.rsf",
+		     dir,prog,dir,heads[ih],mems[im],
+		     dir,dir,im? "ext": "mem");
+	    if (0 != system(cmd)) sf_error("failed: %s",cmd);
+	}
+
+	read_order("mem.rsf",mem);
+	read_order("ext.rsf",ext);
+
+	same = (bool) (0 == memcmp(mem,ext,N2*sizeof(int)));
+
+	nkey = (2==ih)? 2: 1;
+	stable = true;
+	memset(seen,0,N2*sizeof(int));
+	for (i2=0; i2 < N2; i2++) {
+	    if (mem[i2] < 0 || mem[i2] >= N2 || seen[mem[i2]]++) {
+		stable = false;
+		break;
+	    }
+	    if (i2 > 0 &&
+		key_order(nkey,(1==ih)? fkey: NULL,
+			  (0==ih)? ikey: two,mem[i2-1],mem[i2]) >= 0) {
+		stable = false;
+		break;
+	    }
+	}
+
+	printf("%-5s key: memsize=1 %s in-memory sort, %s\n",heads[ih],
+	       same? "matches": "DIFFERS FROM",stable? "stable": "NOT STABLE");
+	fail = (bool) (fail || !same || !stable);
+    }
+
+    snprintf(cmd,sizeof(cmd),"rm -rf %s",dir);
+    if (0 != system(cmd)) sf_warning("cannot remove %s",dir);
+
+    exit(fail? 1: 0);
+}
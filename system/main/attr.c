@@ -49,7 +49,8 @@ static void location(size_t loc, size_t dim, const off_t *n);
 int main(int argc, char* argv[])
 {
     sf_file in=NULL;
-    char *want=NULL, *buf;
+    char *want=NULL, *buf, *mem;
+    const char *map;
     off_t n[SF_MAX_DIM], nsiz, nzero;
     int lval;
     size_t i, nbuf, nleft, dim, minloc=0, maxloc=0;
@@ -83,11 +84,15 @@ int main(int argc, char* argv[])
 	nsiz *= n[i];
     }
     bufsiz = sf_bufsiz(in);
-    buf = sf_charalloc(bufsiz);
+    mem = sf_charalloc(bufsiz);
     bufsiz /= sf_esize(in);
 
     type = sf_gettype (in);
 
+    /* zero-copy access for seekable native data */
+    map = (0 == sf_tell(in)%((off_t) sf_esize(in)))? 
+	sf_charmap(nsiz*sf_esize(in),in): NULL;
+
     cmin1 = sf_cmplx(+FLT_MAX,0.); cmin2 = sf_cmplx(0.,+FLT_MAX);
     cmax1 = sf_cmplx(-FLT_MAX,0.); cmax2 = sf_cmplx(0.,-FLT_MAX);
 
@@ -99,26 +104,31 @@ int main(int argc, char* argv[])
 
     for (nleft=nsiz; nleft > 0; nleft -= nbuf) {
 	nbuf = (bufsiz < nleft)? bufsiz: nleft;
-	switch (type) {
-	    case SF_FLOAT: 
-		sf_floatread((float*) buf,nbuf,in);
-		break;
-	    case SF_INT:
-		sf_intread((int*) buf,nbuf,in);
-		break;
-            case SF_SHORT:
-                sf_shortread((short*) buf,nbuf,in);
-		break;
-	    case SF_COMPLEX:
-		sf_complexread((sf_complex*) buf,nbuf,in);
-		break;
-	    case SF_UCHAR:
-		sf_ucharread((unsigned char*) buf,nbuf,in);
-		break;
-	    case SF_CHAR:
-	    default:
-		sf_charread(buf,nbuf,in);
-		break;
+	if (NULL != map) {
+	    buf = (char*) map + (nsiz-nleft)*sf_esize(in);
+	} else {
+	    buf = mem;
+	    switch (type) {
+		case SF_FLOAT: 
+		    sf_floatread((float*) buf,nbuf,in);
+		    break;
+		case SF_INT:
+		    sf_intread((int*) buf,nbuf,in);
+		    break;
+		case SF_SHORT:
+		    sf_shortread((short*) buf,nbuf,in);
+		    break;
+		case SF_COMPLEX:
+		    sf_complexread((sf_complex*) buf,nbuf,in);
+		    break;
+		case SF_UCHAR:
+		    sf_ucharread((unsigned char*) buf,nbuf,in);
+		    break;
+		case SF_CHAR:
+		default:
+		    sf_charread(buf,nbuf,in);
+		    break;
+	    }
 	}
 	for (i=0; i < nbuf; i++) {
 	    switch (type) {
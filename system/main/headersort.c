@@ -1,121 +1,417 @@
-/* Sort a dataset according to a header key. */
+/* Sort a dataset according to a header key.
+
+The header file can hold several keys per trace (nkey=), for example
+cdp and offset: traces are sorted by the first key, then by the
+second, and so on. Traces with equal keys keep their input order.
+
+Keys that do not fit in memory are sorted out of core, by merging
+sorted runs through a temporary file. Traces are gathered into output
+buckets that fit in memory, each filled by sequential sweeps over the
+input.
+*/
 /*
   Copyright (C) 2004 University of Texas at Austin
-  
+
   This program is free software; you can redistribute it and/or modify
   it under the terms of the GNU General Public License as published by
   the Free Software Foundation; either version 2 of the License, or
   (at your option) any later version.
-  
+
   This program is distributed in the hope that it will be useful,
   but WITHOUT ANY WARRANTY; without even the implied warranty of
   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
   GNU General Public License for more details.
-  
+
   You should have received a copy of the GNU General Public License
   along with this program; if not, write to the Free Software
   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 */
+
+#ifndef _LARGEFILE_SOURCE
+#define _LARGEFILE_SOURCE
+#endif
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <rsf.h>
 
-struct skey {
-    int ikey;
-    float fkey;
-    off_t pos;
-};
+#define GAP (1<<20)  /* bytes cheaper to read through than to seek over */
+#define MINBUF 4096  /* fewest records buffered per run when merging */
+
+/* A record is the trace position followed by nkey 4-byte keys,
+   padded to a multiple of sizeof(off_t). */
+static int nkey;
+static bool fkey;
+static size_t rs;
+
+static int key_compare (const void *r1, const void *r2)
+{
+    int k;
+    off_t p1, p2;
+    const int *i1, *i2;
+    const float *f1, *f2;
+
+    if (fkey) {
+	f1 = (const float*) ((const off_t*) r1 + 1);
+	f2 = (const float*) ((const off_t*) r2 + 1);
+	for (k=0; k < nkey; k++) {
+	    if (f1[k] < f2[k]) return -1;
+	    if (f1[k] > f2[k]) return 1;
+	}
+    } else {
+	i1 = (const int*) ((const off_t*) r1 + 1);
+	i2 = (const int*) ((const off_t*) r2 + 1);
+	for (k=0; k < nkey; k++) {
+	    if (i1[k] < i2[k]) return -1;
+	    if (i1[k] > i2[k]) return 1;
+	}
+    }
+
+    /* equal keys: keep input order */
+    p1 = *((const off_t*) r1);
+    p2 = *((const off_t*) r2);
+    return (p1 < p2)? -1: (p1 > p2)? 1: 0;
+}
+
+static int pos_compare (const void *r1, const void *r2)
+{
+    off_t p1 = *((const off_t*) r1);
+    off_t p2 = *((const off_t*) r2);
+    return (p1 < p2)? -1: (p1 > p2)? 1: 0;
+}
+
+static void chunkread (char* buf, off_t size, off_t pos, FILE* file)
+/* read size bytes at position pos */
+{
+    extern int fseeko(FILE *stream, off_t offset, int whence);
+
+    if (0 > fseeko(file,pos,SEEK_SET)) sf_error ("seek error:");
+    if (size != fread(buf,1,size,file)) sf_error ("read error:");
+}
+
+static void chunkwrite (const char* buf, off_t size, off_t pos, FILE* file)
+/* write size bytes at position pos */
+{
+    extern int fseeko(FILE *stream, off_t offset, int whence);
+
+    if (0 > fseeko(file,pos,SEEK_SET)) sf_error ("seek error:");
+    if (size != fwrite(buf,1,size,file)) sf_error ("write error:");
+}
+
+/* k-way merge of sorted runs of records in a file */
 
-static int int_key_compare (const void *k1, const void *k2)
+typedef struct Merge {
+    FILE *file;
+    int nrun, nbuf, nheap;
+    off_t *next, *end; /* next record to load, end of run */
+    char **buf;        /* buffered records of each run */
+    int *len, *cur, *heap;
+} *merge;
+
+static char *merge_rec (merge m, int r)
+{
+    return m->buf[r] + (size_t) m->cur[r]*rs;
+}
+
+static void merge_load (merge m, int r)
+/* refill the buffer of run r */
 {
-    int f1 = ((struct skey*) k1)->ikey;
-    int f2 = ((struct skey*) k2)->ikey;
-    return (f1 < f2)? -1: (f1 > f2)? 1: 0;
+    m->len[r] = SF_MIN(m->nbuf,m->end[r]-m->next[r]);
+    m->cur[r] = 0;
+    chunkread(m->buf[r],(off_t) m->len[r]*rs,m->next[r]*rs,m->file);
+    m->next[r] += m->len[r];
 }
 
+static void merge_down (merge m, int i)
+/* restore heap order below i */
+{
+    int c, r;
+
+    r = m->heap[i];
+    for (c = 2*i+1; c < m->nheap; i = c, c = 2*i+1) {
+	if (c+1 < m->nheap &&
+	    key_compare(merge_rec(m,m->heap[c+1]),merge_rec(m,m->heap[c])) < 0)
+	    c++;
+	if (key_compare(merge_rec(m,m->heap[c]),merge_rec(m,r)) >= 0) break;
+	m->heap[i] = m->heap[c];
+    }
+    m->heap[i] = r;
+}
 
-static int float_key_compare (const void *k1, const void *k2)
+static merge merge_init (FILE *file, int nrun, const off_t *bound, size_t mem)
+/* merge runs [bound[i],bound[i+1]) using about mem bytes of buffers */
 {
-    float f1 = ((struct skey*) k1)->fkey;
-    float f2 = ((struct skey*) k2)->fkey;
-    return (f1 < f2)? -1: (f1 > f2)? 1: 0;
+    int r;
+    merge m;
+
+    m = (merge) sf_alloc(1,sizeof(*m));
+    m->file = file;
+    m->nrun = nrun;
+    m->nbuf = SF_MAX(1,mem/(nrun*rs));
+    m->next = (off_t*) sf_alloc(nrun,sizeof(off_t));
+    m->end  = (off_t*) sf_alloc(nrun,sizeof(off_t));
+    m->buf  = (char**) sf_alloc(nrun,sizeof(char*));
+    m->len  = sf_intalloc(nrun);
+    m->cur  = sf_intalloc(nrun);
+    m->heap = sf_intalloc(nrun);
+
+    m->nheap = 0;
+    for (r=0; r < nrun; r++) {
+	m->next[r] = bound[r];
+	m->end[r] = bound[r+1];
+	m->buf[r] = sf_charalloc((size_t) m->nbuf*rs);
+	if (m->next[r] < m->end[r]) {
+	    merge_load(m,r);
+	    m->heap[m->nheap++] = r;
+	}
+    }
+    for (r = m->nheap/2-1; r >= 0; r--) {
+	merge_down(m,r);
+    }
+
+    return m;
+}
+
+static bool merge_next (merge m, char *rec)
+/* take the smallest record, false when all runs are done */
+{
+    int r;
+
+    if (0 == m->nheap) return false;
+
+    r = m->heap[0];
+    memcpy(rec,merge_rec(m,r),rs);
+    if (++(m->cur[r]) == m->len[r]) {
+	if (m->next[r] < m->end[r]) {
+	    merge_load(m,r);
+	} else {
+	    m->heap[0] = m->heap[--(m->nheap)];
+	}
+    }
+    if (m->nheap > 0) merge_down(m,0);
+
+    return true;
+}
+
+static void merge_close (merge m)
+{
+    int r;
+
+    for (r=0; r < m->nrun; r++) {
+	free(m->buf[r]);
+    }
+    free(m->buf);
+    free(m->next);
+    free(m->end);
+    free(m->len);
+    free(m->cur);
+    free(m->heap);
+    free(m);
 }
 
 int main(int argc, char* argv[])
 {
-    int n1, n2, i2, esize;
-    off_t pos;
+    int n1, esize, nrun, fanin, mem, i, r, *ikeys;
+    off_t pos, n2, ntr, i2, j2, k2, o2, nr, nb, nt, nm, nw, p0;
+    off_t *bound, *pair;
+    size_t memsize;
     sf_datatype type;
-    struct skey *sorted;
-    int *input=NULL;
-    float *finput=NULL;
-    char *trace, *header;
+    char *sorted, *rec, *trace, *stage, *header, *tmpf, *tmpf2, *key;
+    float *fkeys;
     sf_file in, head, out;
+    FILE *tmp, *tmp2;
+    merge m;
 
     sf_init (argc,argv);
     in = sf_input ("in");
     out = sf_output ("out");
- 
+
     header = sf_getstring("head");
     /* header file */
-    if (NULL == header) { 
+    if (NULL == header) {
 	header = sf_histstring(in,"head");
 	if (NULL == header) sf_error("Need head=");
     }
 
+    if (!sf_getint("memsize",&mem))
+        mem=sf_memsize();
+    /* Max amount of RAM (in Mb) to be used */
+    memsize = (size_t) mem * (1<<20); /* convert Mb to bytes */
+
     head = sf_input(header);
-    n2 = sf_filesize(head);
     type = sf_gettype(head);
-    
-    if (SF_FLOAT == type) {
-	finput = sf_floatalloc(n2);
-    } else if (SF_INT == type) {
-	input = sf_intalloc(n2);
-    } else {	
+
+    if (SF_FLOAT != type && SF_INT != type)
 	sf_error("Need int or float header");
+    fkey = (bool) (SF_FLOAT == type);
+
+    if (!sf_histint(in,"n1",&n1)) n1=1;
+    ntr = sf_leftsize(in,1);
+
+    if (!sf_getint("nkey",&nkey)) {
+	/* number of keys per trace in the header file (default is n1
+	   of head if head has n1 keys for every trace, otherwise 1) */
+	if (!sf_histint(head,"n1",&nkey) ||
+	    (off_t) nkey*ntr != sf_filesize(head)) nkey=1;
     }
+    if (nkey < 1) sf_error("Need nkey >= 1");
 
-    sorted = (struct skey*) sf_alloc(n2,sizeof(struct skey));
+    n2 = sf_filesize(head)/nkey;
+    rs = sizeof(off_t)*(1+(4*nkey+sizeof(off_t)-1)/sizeof(off_t));
 
-    if (SF_FLOAT == type) {
-	sf_floatread(finput,n2,head);
-	for (i2 = 0; i2 < n2; i2++) {
-	    sorted[i2].fkey = finput[i2];
-	    sorted[i2].pos = i2;
-	}
-	free (finput);
+    /* sorted runs of at most nr records */
+    nr = SF_MAX(1,memsize/(rs+4*nkey));
+    nrun = (n2+nr-1)/nr;
+    rec = sf_charalloc(rs);
+    if (fkey) {
+	fkeys = sf_floatalloc(SF_MIN(nr,n2)*nkey);
+	ikeys = NULL;
+    } else {
+	ikeys = sf_intalloc(SF_MIN(nr,n2)*nkey);
+	fkeys = NULL;
+    }
+
+    if (nrun > 1) {
+	tmp = sf_tempfile(&tmpf,"w+b");
+	nb = nr;
     } else {
-	sf_intread(input,n2,head);
-	for (i2 = 0; i2 < n2; i2++) {
-	    sorted[i2].ikey = input[i2];
-	    sorted[i2].pos = i2;
+	tmp = NULL;
+	tmpf = NULL;
+	nb = SF_MAX(1,n2);
+    }
+    sorted = sf_charalloc(nb*rs);
+    memset(sorted,0,nb*rs); /* no garbage in padding */
+
+    bound = (off_t*) sf_alloc(nrun+1,sizeof(off_t));
+    for (r=0; r < nrun; r++) {
+	bound[r] = r*nr;
+	nb = SF_MIN(nr,n2-bound[r]);
+
+	if (fkey) {
+	    sf_floatread(fkeys,nb*nkey,head);
+	} else {
+	    sf_intread(ikeys,nb*nkey,head);
+	}
+	for (i2=0; i2 < nb; i2++) {
+	    key = sorted+i2*rs;
+	    *((off_t*) key) = bound[r]+i2;
+	    memcpy(key+sizeof(off_t),
+		   fkey? (char*) (fkeys+i2*nkey): (char*) (ikeys+i2*nkey),
+		   4*nkey);
 	}
-	free (input);
+	qsort(sorted,nb,rs,key_compare);
+
+	if (NULL != tmp) chunkwrite(sorted,nb*rs,bound[r]*rs,tmp);
     }
+    bound[nrun] = n2;
     sf_fileclose(head);
-	
-    qsort(sorted,n2,sizeof(struct skey),
-	  (SF_FLOAT==type)? float_key_compare: int_key_compare);
+    if (fkey) {
+	free(fkeys);
+    } else {
+	free(ikeys);
+    }
+
+    if (NULL != tmp) {
+	free(sorted);
+	sorted = NULL;
+
+	/* merge passes until the remaining runs can be merged at once */
+	fanin = SF_MAX(2,memsize/(4*rs*MINBUF));
+	while (nrun > fanin) {
+	    tmp2 = sf_tempfile(&tmpf2,"w+b");
+	    sorted = sf_charalloc(MINBUF*rs);
+	    for (o2=0, i=0, r=0; r < nrun; r += fanin, i++) {
+		m = merge_init(tmp,SF_MIN(fanin,nrun-r),bound+r,memsize/2);
+		for (nw=0; merge_next(m,sorted+nw*rs); ) {
+		    if (++nw == MINBUF) {
+			chunkwrite(sorted,nw*rs,o2*rs,tmp2);
+			o2 += nw;
+			nw = 0;
+		    }
+		}
+		if (nw > 0) chunkwrite(sorted,nw*rs,o2*rs,tmp2);
+		o2 += nw;
+		merge_close(m);
+		bound[i] = bound[r];
+	    }
+	    bound[i] = n2;
+	    nrun = i;
+	    free(sorted);
+	    sorted = NULL;
+
+	    fclose(tmp);
+	    unlink(tmpf);
+	    tmp = tmp2;
+	    tmpf = tmpf2;
+	}
+
+	m = merge_init(tmp,nrun,bound,memsize/4);
+    } else {
+	m = NULL;
+    }
 
-    if (!sf_histint(in,"n1",&n1)) n1=1;
     esize = sf_esize(in);
     n1 *= esize;
 
-    trace = sf_charalloc(n1);
-
-    sf_unpipe(in,((off_t) n1)*((off_t) n2));
+    sf_unpipe(in,((off_t) n1)*((off_t) ntr));
     sf_fileflush(out,in);
     sf_setform(in,SF_NATIVE);
     sf_setform(out,SF_NATIVE);
 
     pos = sf_tell(in);
-    for (i2=0; i2<n2; i2++) {
-	sf_seek(in,pos+(sorted[i2].pos)*n1,SEEK_SET);
-	sf_charread(trace,n1,in);
-	sf_charwrite(trace,n1,out);
+
+    /* Gather output in buckets of nb traces. The input positions of a
+       bucket are visited in increasing order, and nearby traces are
+       read together with one read of at most nm traces. */
+    nb = SF_MAX(1,SF_MIN(n2,memsize/(2*n1)));
+    nm = SF_MAX(1,memsize/(4*n1));
+
+    trace = sf_charalloc(nb*n1);
+    stage = sf_charalloc(nm*n1);
+    pair = (off_t*) sf_alloc(2*nb,sizeof(off_t));
+
+    for (o2=0; o2 < n2; o2 += nt) {
+	nt = SF_MIN(nb,n2-o2);
+
+	/* (input position, output slot) pairs */
+	for (i2=0; i2 < nt; i2++) {
+	    if (NULL != m) {
+		if (!merge_next(m,rec)) sf_error("%s: merge failed",__FILE__);
+		pair[2*i2] = *((off_t*) rec);
+	    } else {
+		pair[2*i2] = *((off_t*) (sorted+(o2+i2)*rs));
+	    }
+	    pair[2*i2+1] = i2;
+	}
+	qsort(pair,nt,2*sizeof(off_t),pos_compare);
+
+	for (i2=0; i2 < nt; i2 = j2) {
+	    p0 = pair[2*i2];
+	    for (j2=i2+1; j2 < nt; j2++) {
+		if (pair[2*j2]-p0 >= nm ||
+		    (pair[2*j2]-pair[2*j2-2]-1)*n1 >= GAP) break;
+	    }
+
+	    sf_seek(in,pos+p0*n1,SEEK_SET);
+	    sf_charread(stage,(pair[2*j2-2]-p0+1)*n1,in);
+
+	    for (k2=i2; k2 < j2; k2++) {
+		memcpy(trace+pair[2*k2+1]*n1,stage+(pair[2*k2]-p0)*n1,n1);
+	    }
+	}
+
+	sf_charwrite(trace,nt*n1,out);
     }
 
+    if (NULL != m) {
+	merge_close(m);
+	fclose(tmp);
+	unlink(tmpf);
+    }
 
     exit(0);
 }
-
@@ -53,6 +53,9 @@ See also: sfheadermath.*/
 
 #include <rsf.h>
 
+#define MATH_CHUNK 65536
+/* samples read per chunk, evaluated in parallel blocks */
+
 static void check_compat (size_t       nin, 
 			  sf_file*     in, 
 			  int          dim, 
@@ -64,14 +67,15 @@ static void check_compat (size_t       nin,
 int main (int argc, char* argv[])
 {
     int nin, i, k, dim, nbuf;
-    off_t j, nsiz, ii[SF_MAX_DIM], n[SF_MAX_DIM]; 
+    off_t j, nsiz, n[SF_MAX_DIM]; 
     size_t len, bufsiz;
     sf_file *in, out;
     char *eq, *output, *key, *arg, xkey[8], *ctype, *label, *unit;
-    float **fbuf, **fst, d[SF_MAX_DIM], o[SF_MAX_DIM];
+    float **fbuf, *fout, d[SF_MAX_DIM], o[SF_MAX_DIM];
     bool nostdin;
-    sf_complex **cbuf, **cst;
+    sf_complex **cbuf, *cout;
     sf_datatype type;
+    sf_mathprog prog;
 
 
     /* init RSF */
@@ -208,21 +212,39 @@ int main (int argc, char* argv[])
     /* Mathematical description of the output */
     
     len = sf_math_parse (output,out,type);
+
+    /* the expression is evaluated block by block, 
+       coordinates are generated on the fly */
+    prog = sf_math_compile (len,type);
+    sf_math_axes (prog,nin,dim,n,o,d);
     
     if (SF_FLOAT == type) { /* float type */
-	nbuf = bufsiz/sizeof(float);
+	nbuf = SF_MAX(bufsiz/sizeof(float),MATH_CHUNK);
+	if (nbuf > nsiz) nbuf = nsiz;
 	
-	fbuf = sf_floatalloc2(nbuf,nin+dim);
-	fst  = sf_floatalloc2(nbuf,len+2);
+	fbuf = (float**) sf_alloc(nin+dim,sizeof(float*));
+	for (i=0; i < nin; i++) {
+	    fbuf[i] = sf_floatalloc(nbuf);
+	}
+	fout = sf_floatalloc(nbuf);
 	cbuf = NULL;
-	cst  = NULL; 
+	cout = NULL; 
     } else {                /* complex type */
-	nbuf = bufsiz/sizeof(sf_complex);
+	nbuf = SF_MAX(bufsiz/sizeof(sf_complex),MATH_CHUNK);
+	if (nbuf > nsiz) nbuf = nsiz;
 	
 	fbuf = NULL;
-	fst  = NULL;
-	cbuf = sf_complexalloc2(nbuf,nin+dim+1);
-	cst  = sf_complexalloc2(nbuf,len+2);
+	fout = NULL;
+	cbuf = (sf_complex**) sf_alloc(nin+dim+1,sizeof(sf_complex*));
+	for (i=0; i < nin; i++) {
+	    cbuf[i] = sf_complexalloc(nbuf);
+	}
+	/* fill I */
+	cbuf[nin+dim] = sf_complexalloc(nbuf);
+	for (k=0; k < nbuf; k++) {
+	    cbuf[nin+dim][k] = sf_cmplx(0.,1.);
+	}
+	cout = sf_complexalloc(nbuf);
     }
 
     if (nin) {
@@ -234,45 +256,30 @@ int main (int argc, char* argv[])
     }
     
     if (SF_FLOAT == type) {
-	for (j=0; nsiz > 0; nsiz -= nbuf) {
+	for (j=0; nsiz > 0; nsiz -= nbuf, j += nbuf) {
 	    if (nbuf > nsiz) nbuf = nsiz;
 	    for (i=0; i < nin; i++) {
 		sf_floatread(fbuf[i],nbuf,in[i]);
 	    }
-            /* fill x1, x2, etc */
-	    for (k=0; k < nbuf; k++, j++) {
-		sf_large_line2cart(dim,n,j,ii);
-		for (i=0; i < dim; i++) {
-		    fbuf[nin+i][k] = o[i]+ii[i]*d[i];
-		}
-	    }
 	    
-	    sf_math_evaluate (len, nbuf, fbuf, fst);
+	    sf_math_run (prog, j, nbuf, fbuf, fout);
 	    
-	    sf_floatwrite(fst[1],nbuf,out);
+	    sf_floatwrite(fout,nbuf,out);
 	}
     } else {
-	for (j=0; nsiz > 0; nsiz -= nbuf) {
+	for (j=0; nsiz > 0; nsiz -= nbuf, j += nbuf) {
 	    if (nbuf > nsiz) nbuf = nsiz;
 	    for (i=0; i < nin; i++) {
 		sf_complexread(cbuf[i],nbuf,in[i]);
 	    }
-	    /* fill x1, x2, etc */
-	    for (k=0; k < nbuf; k++, j++) {
-		sf_large_line2cart(dim,n,j,ii);
-		for (i=0; i < dim; i++) {
-		    cbuf[nin+i][k] = sf_cmplx(o[i]+ii[i]*d[i],0.);
-		}
-		/* fill I */
-		cbuf[nin+dim][k] = sf_cmplx(0.,1.);
-	    }
 	    
-	    sf_complex_math_evaluate (len, nbuf, cbuf, cst);
+	    sf_complex_math_run (prog, j, nbuf, cbuf, cout);
 	    
-	    sf_complexwrite(cst[1],nbuf,out);
+	    sf_complexwrite(cout,nbuf,out);
 	}
     }
     
+    sf_math_close(prog);
 
     exit(0);
 }
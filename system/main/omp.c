@@ -29,6 +29,7 @@ int main(int argc, char* argv[])
     int axis, axis2, rank, nodes, ndim, jobs;
     off_t n[SF_MAX_DIM];
     char *iname=NULL, **cmdline;
+    bool stream;
     FILE *tmp;
     sf_file inp, out, inp2;
 
@@ -49,6 +50,28 @@ int main(int argc, char* argv[])
     if (!sf_getint("split",&axis)) axis=ndim;
     /* axis to split */
 
+    if (!sf_getint("join",&axis2)) axis2=axis;
+    /* axis to join (0 means add) */
+
+    if (!sf_getbool("stream",&stream)) stream=true;
+    /* if y, feed the jobs through pipes and collect their outputs
+       while they run (the input must be a file, RSFMEMSIZE limits the
+       output held ahead of its turn) */
+
+    if (stream && sf_stream_split(inp,axis,nodes+1,&jobs,ndim,n,argc,argv)) {
+	sf_warning("Running %d jobs",jobs);
+
+	sf_stream_out(out,jobs,axis2,(off_t) sf_memsize()*(1<<20));
+
+	if (axis2 > 0) {
+	    sf_join(out,axis2,jobs);
+	} else {
+	    sf_add(out,jobs);
+	}
+
+	exit(0);
+    }
+
     tmp = sf_tempfile(&iname,"w+b");
     fclose(tmp);
 
@@ -75,9 +98,6 @@ int main(int argc, char* argv[])
 	}
     }
     
-    if (!sf_getint("join",&axis2)) axis2=axis;
-    /* axis to join (0 means add) */
-    
     sf_out(out,jobs,axis2,iname);
     sf_rm(iname,true,false,false);
 
@@ -33,6 +33,13 @@ memsize=1 command-line parameter to force out-of-core operation.
 
 #include <rsf.h>
 
+#define TILE 16384 /* bytes in a cache-resident tile */
+#define RUN (1<<16)  /* shortest run for direct out-of-core reads */
+
+static void transpose (const char* in, off_t sin, char* out, off_t sout, 
+		       off_t esize, off_t na, off_t nb);
+static void chunkread (char* buf, off_t size, off_t pos, FILE* file);
+static void chunkwrite (const char* buf, off_t size, off_t pos, FILE* file);
 static off_t make_map (int dim1, int dim2, const off_t* n, off_t i2);
 
 int main(int argc, char* argv[])
@@ -40,10 +47,11 @@ int main(int argc, char* argv[])
     int i, dim, n3;
     int dim1, dim2;
     int mem; /* for avoiding int to off_t typecast warning */
-    off_t n[SF_MAX_DIM], pos, memsize, n1, n2, nsiz, i2, i3, *map, nbuf, n12;
-    char key1[7], key2[7], *val, **dat1, **dat2, *buf, *mapf;
+    off_t n[SF_MAX_DIM], pos, memsize, n1, n2, i2, i3, n12;
+    off_t na, nm, nb, ca, cb, cc, cg, ib, im, ja, jb;
+    char key1[7], key2[7], *val, *dat1, *dat2, *tmpf;
     sf_file in, out;
-    FILE *mapfile;
+    FILE *tmpfile;
     float f;
 
     sf_init (argc,argv);
@@ -116,106 +124,192 @@ int main(int argc, char* argv[])
     sf_setform(in,SF_NATIVE);
     sf_setform(out,SF_NATIVE);
     
+    /* The data are n3 slabs of [nb][nm][na] blocks of n1 bytes
+       (slow to fast) to be transposed to [na][nm][nb]. */
     n1=sf_esize(in);
-    n2=n3=1;
+    n3=1;
+    na=nm=nb=1;
     for (i=0; i < dim; i++) {
 	if (i < dim1-1) {
 	    n1 *= n[i]; /* block size */
-	} else if (i >= dim2) {
-	    n3 *= n[i]; /* loop over */
+	} else if (i == dim1-1) {
+	    na = n[i];
+	} else if (i < dim2-1) {
+	    nm *= n[i];
+	} else if (i == dim2-1) {
+	    nb = n[i];
 	} else {
-	    n2 *= n[i]; /* read n2 blocks at a time */
+	    n3 *= n[i]; /* loop over */
 	}
     }
+    n2 = na*nm*nb;
     n12 = n1*n2;
 
-    if (n12 + n2*sizeof(off_t) < memsize) { /* keep map incore */
-	map = (off_t*) sf_alloc (n2, sizeof(off_t));
-	nbuf = 0;
-
-	for (i2=0; i2 < n2; i2++) {
-	    map[i2] = make_map (dim1, dim2, n, i2);
+    if (n12 < memsize) { /* cache-blocked in-core transpose */
+	dat1 = sf_charalloc (n12);
+	dat2 = sf_charalloc (n12);
+	
+	for (i3=0; i3 < n3; i3++) {
+	    sf_charread(dat1,n12,in);
+	    for (im=0; im < nm; im++) {
+		transpose(dat1+im*na*n1,nm*na*n1,
+			  dat2+im*nb*n1,nm*nb*n1,n1,na,nb);
+	    }
+	    sf_charwrite(dat2,n12,out);
 	}
 
-	mapfile = NULL;
-    } else { /* put map out of core */
-	nbuf = BUFSIZ/sizeof(off_t);
-	map = (off_t*)sf_alloc(nbuf, sizeof(off_t));
-	mapfile = sf_tempfile(&mapf,"w+b");
+	exit (0);
+    } 
 
-	for (i2=0, nsiz=n2; nsiz > 0; nsiz -= nbuf) {
-	    if (nbuf > nsiz) nbuf=nsiz;
-	    for (i=0; i < nbuf; i++, i2++) {
-		map[i] = make_map (dim1, dim2, n, i2);
+    sf_warning("Going out of core... "
+	       "(increase memsize=%zu for in-core)",memsize/(1 << 20));
+
+    /* output is written in strips of ca rows of the na axis, 
+       input is read in chunks of cb rows of the nb axis */
+    ca = memsize/(2*nm*nb*n1);
+    cb = memsize/(2*nm*na*n1);
+    if (ca > na) ca = na;
+    if (cb > nb) cb = nb;
+    
+    if (ca < 1 || cb < 1) { /* cannot fit a row: move one block at a time */
+	sf_unpipe(in,n12*(off_t)n3);
+
+	dat1 = sf_charalloc (n1);
+	
+	pos = sf_tell(in);
+	for (i3=0; i3 < n3; i3++) {
+	    for (i2=0; i2 < n2; i2++) {
+		sf_seek(in,pos+(make_map(dim1,dim2,n,i2)+i3*n2)*n1,SEEK_SET);
+		sf_charread (dat1,n1,in);
+		sf_charwrite(dat1,n1,out);
 	    }
-	    if (nbuf != fwrite(map,sizeof(off_t),nbuf,mapfile)) 
-		sf_error("map write error:");
 	}
+
+	exit (0);
     }
 
-    if (n12 < memsize) {
-	dat1 = sf_charalloc2 (n1,n2);
-	dat2 = sf_charalloc2 (n1,n2);
-	
-	for (i3=0; i3 < n3; i3++) {
-	    sf_charread(dat1[0],n12,in);
-	    if (NULL == mapfile) {
-		for (i2=0; i2 < n2; i2++) {
-		    memcpy(dat2[i2],dat1[map[i2]],n1); 
-		}
-	    } else {
-		if (0 > fseeko(mapfile,0,SEEK_SET))
-		    sf_error ("map seek error:");
-
-		for (i2=0, nsiz=n2; nsiz > 0; nsiz -= nbuf, i2 += nbuf) {
-		    if (nbuf > nsiz) nbuf=nsiz;
-		    if (nbuf != fread(map,sizeof(off_t),nbuf,mapfile)) 
-			sf_error("map read error:");
-		    for (i=0; i < nbuf; i++) {
-			memcpy(dat2[i2+i],dat1[map[i]],n1); 
+    dat1 = sf_charalloc (ca*nm*nb*n1 > cb*nm*na*n1? 
+			 ca*nm*nb*n1: cb*nm*na*n1);
+    dat2 = sf_charalloc (ca*nm*nb*n1 > cb*nm*na*n1? 
+			 ca*nm*nb*n1: cb*nm*na*n1);
+
+    if (ca*n1 >= RUN) { /* single pass with long direct reads */
+	sf_unpipe(in,n12*(off_t)n3);
+	tmpfile = sf_filestream(in);
+	tmpf = NULL;
+	pos = sf_tell(in);
+    } else { /* two passes through a temporary file */
+	tmpfile = sf_tempfile(&tmpf,"w+b");
+	pos = 0;
+    }
+
+    for (i3=0; i3 < n3; i3++) {
+	if (NULL != tmpf) {
+	    /* pass 1: regroup the slab as strips of [nb][nm][cg] */
+	    for (jb=0; jb < nb; jb += cb) {
+		cc = SF_MIN(cb,nb-jb);
+		sf_charread(dat1,cc*nm*na*n1,in);
+		for (i2=0, ja=0; ja < na; ja += ca) {
+		    cg = SF_MIN(ca,na-ja);
+		    for (ib=0; ib < cc; ib++) {
+			for (im=0; im < nm; im++, i2 += cg*n1) {
+			    memcpy(dat2+i2,dat1+((ib*nm+im)*na+ja)*n1,cg*n1);
+			}
 		    }
+		    chunkwrite(dat2+i2-cc*nm*cg*n1,cc*nm*cg*n1,
+			       (ja*nb+jb*cg)*nm*n1,tmpfile);
 		}
 	    }
-	    sf_charwrite(dat2[0],n12,out);
 	}
-    } else {
-	sf_warning("Going out of core... "
-		   "(increase memsize=%zu for in-core)",memsize/(1 << 20));
-	sf_unpipe(in,n12*(off_t)n3);
 
-	buf = sf_charalloc (n1);
-	
-	pos = sf_tell(in);
-	for (i3=0; i3 < n3; i3++) {
-	    if (NULL == mapfile) {
-		for (i2=0; i2 < n2; i2++) {
-		    sf_seek(in,pos+(map[i2]+i3*n2)*n1,SEEK_SET);
-		    sf_charread (buf,n1,in);
-		    sf_charwrite(buf,n1,out);
-		}
+	/* pass 2: transpose each strip in core */
+	for (ja=0; ja < na; ja += ca) {
+	    cg = SF_MIN(ca,na-ja);
+	    if (NULL != tmpf) {
+		chunkread(dat1,nb*nm*cg*n1,ja*nb*nm*n1,tmpfile);
 	    } else {
-		if (0 > fseeko(mapfile,0,SEEK_SET))
-		    sf_error ("map seek error:");
-
-		for (nsiz=n2; nsiz > 0; nsiz -= nbuf) {
-		    if (nbuf > nsiz) nbuf=nsiz;
-		    if (nbuf != fread(map,sizeof(off_t),nbuf,mapfile)) 
-			sf_error("map read error:");
-		    for (i=0; i < nbuf; i++) {
-			sf_seek(in,pos+(map[i]+i3*n2)*n1,SEEK_SET);
-			sf_charread (buf,n1,in);
-			sf_charwrite(buf,n1,out);
+		for (i2=ib=0; ib < nb; ib++) {
+		    for (im=0; im < nm; im++, i2 += cg*n1) {
+			chunkread(dat1+i2,cg*n1,
+				  pos+i3*n12+((ib*nm+im)*na+ja)*n1,tmpfile);
 		    }
 		}
 	    }
+	    for (im=0; im < nm; im++) {
+		transpose(dat1+im*cg*n1,nm*cg*n1,
+			  dat2+im*nb*n1,nm*nb*n1,n1,cg,nb);
+	    }
+	    sf_charwrite(dat2,cg*nm*nb*n1,out);
 	}
+    }
 
-	if (NULL != mapfile) unlink(mapf);
+    if (NULL != tmpf) {
+	fclose(tmpfile);
+	unlink(tmpf);
     }
 
     exit (0);
 }
 
+static void transpose (const char* in, off_t sin, char* out, off_t sout, 
+		       off_t esize, off_t na, off_t nb)
+/* cache-oblivious out[a][b] = in[b][a] for elements of esize bytes,
+   sin and sout are row strides in bytes */
+{
+    off_t ia, ib, h;
+    const char *p;
+    char *q;
+
+    if (na*nb*esize > TILE && (na > 1 || nb > 1)) {
+	/* split the longer side */
+	if (na >= nb) {
+	    h = na/2;
+	    transpose(in,sin,out,sout,esize,h,nb);
+	    transpose(in+h*esize,sin,out+h*sout,sout,esize,na-h,nb);
+	} else {
+	    h = nb/2;
+	    transpose(in,sin,out,sout,esize,na,h);
+	    transpose(in+h*sin,sin,out+h*esize,sout,esize,na,nb-h);
+	}
+	return;
+    }
+
+    for (ia=0; ia < na; ia++) {
+	p = in+ia*esize;
+	q = out+ia*sout;
+	switch (esize) {
+	    case 4:
+		for (ib=0; ib < nb; ib++, p += sin, q += 4) memcpy(q,p,4);
+		break;
+	    case 8:
+		for (ib=0; ib < nb; ib++, p += sin, q += 8) memcpy(q,p,8);
+		break;
+	    default:
+		for (ib=0; ib < nb; ib++, p += sin, q += esize) 
+		    memcpy(q,p,esize);
+		break;
+	}
+    }
+}
+
+static void chunkread (char* buf, off_t size, off_t pos, FILE* file)
+/* read size bytes at position pos */
+{
+    extern int fseeko(FILE *stream, off_t offset, int whence);
+
+    if (0 > fseeko(file,pos,SEEK_SET)) sf_error ("seek error:");
+    if (size != fread(buf,1,size,file)) sf_error ("read error:");
+}
+
+static void chunkwrite (const char* buf, off_t size, off_t pos, FILE* file)
+/* write size bytes at position pos */
+{
+    extern int fseeko(FILE *stream, off_t offset, int whence);
+
+    if (0 > fseeko(file,pos,SEEK_SET)) sf_error ("seek error:");
+    if (size != fwrite(buf,1,size,file)) sf_error ("write error:");
+}
+
 static off_t make_map (int dim1, int dim2, const off_t* n, off_t i2)
 {
     off_t i, j, ii[SF_MAX_DIM];
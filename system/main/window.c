@@ -35,6 +35,7 @@ int main (int argc, char *argv[])
     off_t n[SF_MAX_DIM], m[SF_MAX_DIM], f[SF_MAX_DIM], *table, maxsize;
     float a, d[SF_MAX_DIM], o[SF_MAX_DIM];
     char key[7], *label[SF_MAX_DIM], *unit[SF_MAX_DIM], *buf;
+    const char *map, *src;
     bool squeeze, verb;
     sf_file in, out;
 
@@ -205,18 +206,29 @@ int main (int argc, char *argv[])
 
     sf_unpipe(in,maxsize);
 
+    /* window directly from the mapped input when possible */
+    map = (const char*) sf_mapwindow(in,sf_tell(in),maxsize);
+
     for (i2=0; i2 < n2; i2++) {
-	if (table[i2]) sf_seek(in,table[i2],SEEK_CUR);
-	sf_charread(buf,n1,in);
+	if (NULL != map) {
+	    map += table[i2];
+	    src = map;
+	    map += n1;
+	} else {
+	    if (table[i2]) sf_seek(in,table[i2],SEEK_CUR);
+	    sf_charread(buf,n1,in);
+	    src = buf;
+	}
 	if (jump) {
 	    for (i1=j1=0; i1 < m1; j1 += jump) {
 		for (i=0; i < esize; i++, i1++, j1++) {
-		    buf[i1] = buf[j1];
+		    buf[i1] = src[j1];
 		}
 	    }
+	    src = buf;
 	}
 
-	sf_charwrite(buf,m1,out);
+	sf_charwrite((char*) src,m1,out);
     }
 
 
@@ -25,21 +25,110 @@ http://ahay.org/blog/2012/10/03/program-of-the-month-sfkirmod/
 
 #include <rsf.h>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #include "kirmod.h"
 #include "kirmod2.h"
+#include "kirtrace.h"
 #include "ricker.h"
 
+static int nx, nc, nh;
+static float dx, **rfl, **rgd;
+static bool adj, lin, cmp;
+static surface inc, ref;
+
+static void kirmod_shot(kirtrace kt,
+			ktable *tss, ktable *tgs /* table workspace [nc*nx] */,
+			int is                   /* shot number */,
+			float **trace            /* traces [nh][nt] */,
+			float **pick, float **slope /* picks or NULL [nh][nc] */,
+			float **rflh             /* adjoint reflectivity [nh][nc*nx] */)
+/* model or migrate one shot (CMP) gather */
+{
+    int ih, ic, ix, i, minix;
+    float theta, ava, amp, obl, mint;
+    ktable ts, tg;
+
+    for (ih=0; ih < nh; ih++) {
+	for (ic=0; ic < nc; ic++) {
+	    for (ix=0; ix < nx; ix++) {
+		if (cmp) {
+		    ts = kirmod2_map(inc,is,2*ih,  ix,ic);
+		    tg = kirmod2_map(ref,is,2*ih+1,ix,ic);
+		} else {
+		    ts = kirmod2_map(inc,is,nh,ix,ic);
+		    tg = kirmod2_map(ref,is,ih,ix,ic);
+		}
+
+		i = ic*nx+ix;
+		kt->time[i] = ts->t + tg->t;
+		kt->delt[i] = fabsf(ts->tx+tg->tx)*dx;
+
+		tss[i] = ts;
+		tgs[i] = tg;
+	    }
+	}
+
+	if (adj) kirtrace_lop(kt,true,trace[ih]);
+
+	for (ic=0; ic < nc; ic++) {
+	    for (ix=0; ix < nx; ix++) {
+		i = ic*nx+ix;
+		ts = tss[i];
+		tg = tgs[i];
+
+		obl = 0.5*(ts->tn + tg->tn);
+		amp = ts->a * tg->a * sqrtf(ts->ar + tg->ar) + FLT_EPSILON;
+
+		if (lin) {
+		    if (adj) {
+			rflh[ih][i] = kt->ampl[i]*obl*dx/amp;
+		    } else {
+			kt->ampl[i] = rfl[ic][ix]*obl*dx/amp;
+		    }
+		} else {
+		    theta = 0.5*(SF_SIG(tg->tx)*tg->an - 
+				 SF_SIG(ts->tx)*ts->an);
+		    theta = sinf(theta);
+			
+		    ava = rfl[ic][ix]+rgd[ic][ix]*theta*theta;
+		    if (ref != inc) ava *= theta;
+			
+		    kt->ampl[i] = ava*obl*dx/amp;
+		}
+	    }
+	    /* Pick traveltime and/or receiver slope */
+	    if (NULL != pick || NULL != slope) {
+		mint = SF_HUGE;
+		minix = 0;
+		for (ix=0; ix < nx; ix++) {
+		    if (kt->time[ic*nx+ix] < mint) {
+			mint = kt->time[ic*nx+ix];
+			minix = ix;
+		    }
+		}
+		i = ic*nx+minix;
+		if (NULL != pick) pick[ih][ic] = tss[i]->t + tgs[i]->t;
+		if (NULL != slope) slope[ih][ic] = fabsf(tgs[i]->tx);
+	    }
+	}
+
+	if (!adj) kirtrace_lop(kt,false,trace[ih]);
+    }
+}
+
 int main(int argc, char* argv[]) 
 {
-    int nx, nt, ns, nh, nc, nxc, is, ih, ix, ic, minix;
-    float **rfl, **rgd, **crv, **dip, *trace, *trace2;
-    float **time, **ampl, **delt, freq, theta, ava, amp, obl;
-    float slow, dx, x0, dt, t0, ds, s0, dh, h0, r0, mint;
+    int nt, ns, nxc, is, ih, ix, ic, i, nb, ib, nth, ith;
+    float **crv, **dip, ***trace, ***pick = NULL, ***slope = NULL, ***rflh = NULL;
+    float freq, slow, x0, dt, t0, ds, s0, dh, h0, r0;
     const char *type, *type2;
-    bool twod, verb, adj, lin, cmp, absoff;
-    surface inc, ref;
+    bool twod, verb, absoff;
     velocity vel, vel2;
-    ktable ts, tg, **tss, **tgs;
+    ktable **tss, **tgs;
+    kirtrace *kt;
     sf_file data, refl, curv, modl, picks = NULL, slopes = NULL;
 
     sf_init(argc,argv);
@@ -146,9 +235,6 @@ int main(int argc, char* argv[])
     if (!sf_getbool("verb",&verb)) verb=false;
     /* verbosity flag */
 
-    trace = sf_floatalloc(nt);
-    trace2 = sf_floatalloc(nt);
-
     /*** Initialize reflector ***/
 
     crv = sf_floatalloc2(nx,nc);
@@ -340,13 +426,6 @@ int main(int argc, char* argv[])
 	ref = inc;
     }
     
-    /*** Initialize stretch ***/
-    sf_aastretch_init (false, nt, t0, dt, nxc);
-
-    time = sf_floatalloc2(nx,nc);
-    ampl = sf_floatalloc2(nx,nc);
-    delt = sf_floatalloc2(nx,nc);
-
     if (!sf_getfloat("freq",&freq)) freq=0.2/dt;
     /* peak frequency for Ricker wavelet */
     ricker_init(nt*2,freq*dt,2);
@@ -368,106 +447,61 @@ int main(int argc, char* argv[])
 	}
     }
 
-    tss = (ktable**) sf_alloc(nc,sizeof(ktable*));
-    tgs = (ktable**) sf_alloc(nc,sizeof(ktable*));
-    for (ic=0; ic < nc; ic++) {
-	tss[ic] = (ktable*) sf_alloc(nx,sizeof(ktable));
-	tgs[ic] = (ktable*) sf_alloc(nx,sizeof(ktable));
+    /*** Shots are modeled in batches of one per thread ***/
+    nth = kirtrace_threads();
+    nb = SF_MIN(nth,ns);
+
+    kt = (kirtrace*) sf_alloc(nth,sizeof(kirtrace));
+    tss = (ktable**) sf_alloc(nth,sizeof(ktable*));
+    tgs = (ktable**) sf_alloc(nth,sizeof(ktable*));
+    for (ith=0; ith < nth; ith++) {
+	kt[ith] = kirtrace_init(nt,t0,dt,nxc);
+	tss[ith] = (ktable*) sf_alloc(nxc,sizeof(ktable));
+	tgs[ith] = (ktable*) sf_alloc(nxc,sizeof(ktable));
     }
 
-    /*** Main loop ***/
-    for (is=0; is < ns; is++) {
-	if (verb) sf_warning("%s %d of %d;",cmp?"cmp":"shot",is+1,ns);
-
-	for (ih=0; ih < nh; ih++) {
-
-	    for (ic=0; ic < nc; ic++) {
-		for (ix=0; ix < nx; ix++) {
-		    if (cmp) {
-			ts = kirmod2_map(inc,is,2*ih,  ix,ic);
-			tg = kirmod2_map(ref,is,2*ih+1,ix,ic);
-		    } else {
-			ts = kirmod2_map(inc,is,nh,ix,ic);
-			tg = kirmod2_map(ref,is,ih,ix,ic);
-		    }
-
-		    time[ic][ix] = ts->t + tg->t;
-		    delt[ic][ix] = fabsf(ts->tx+tg->tx)*dx;
-
-		    tss[ic][ix] = ts;
-		    tgs[ic][ix] = tg;
-		}
-	    }
-
-	    sf_aastretch_define (time[0],delt[0],NULL);
+    trace = sf_floatalloc3(nt,nh,nb);
+    if (NULL != picks) pick = sf_floatalloc3(nc,nh,nb);
+    if (NULL != slopes) slope = sf_floatalloc3(nc,nh,nb);
+    if (adj) rflh = sf_floatalloc3(nxc,nh,nb);
 
-	    if (adj) {
-		sf_floatread(trace2,nt,modl);
+    /*** Main loop ***/
+    for (is=0; is < ns; is += nb) {
+	if (nb > ns-is) nb = ns-is;
 
-		/* convolve with Ricker wavelet */
-		sf_freqfilt_lop(true,false,nt,nt,trace,trace2);
-	    
-		sf_aastretch_lop (true,false,nxc,nt,ampl[0],trace); 
+	for (ib=0; ib < nb; ib++) {
+	    if (verb) sf_warning("%s %d of %d;",cmp?"cmp":"shot",is+ib+1,ns);
+	    if (adj) sf_floatread(trace[ib][0],nt*nh,modl);
+	}
 
-                /* aastretch_lop (true,false,nxc,nt,ampl[0],trace2); */
-	    }
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) private(ith)
+#endif
+	for (ib=0; ib < nb; ib++) {
+#ifdef _OPENMP
+	    ith = omp_get_thread_num();
+#else
+	    ith = 0;
+#endif
+	    kirmod_shot(kt[ith],tss[ith],tgs[ith],is+ib,trace[ib],
+			(NULL != pick)? pick[ib]: NULL,
+			(NULL != slope)? slope[ib]: NULL,
+			adj? rflh[ib]: NULL);
+	}
 
-	    for (ic=0; ic < nc; ic++) {
-		for (ix=0; ix < nx; ix++) {
-		    ts = tss[ic][ix];
-		    tg = tgs[ic][ix];
-
-		    obl = 0.5*(ts->tn + tg->tn);
-		    amp = ts->a * tg->a * sqrtf(ts->ar + tg->ar) + FLT_EPSILON;
-
-		    if (lin) {
-			if (adj) {
-			    rfl[ic][ix] += ampl[ic][ix]*obl*dx/amp;
-			} else {
-			    ampl[ic][ix] = rfl[ic][ix]*obl*dx/amp;
-			}
-		    } else {
-			theta = 0.5*(SF_SIG(tg->tx)*tg->an - 
-				     SF_SIG(ts->tx)*ts->an);
-			theta = sinf(theta);
-			
-			ava = rfl[ic][ix]+rgd[ic][ix]*theta*theta;
-			if (ref != inc) ava *= theta;
-			
-			ampl[ic][ix] = ava*obl*dx/amp;
-		    }
-		}
-		/* Pick traveltime and/or receiver slope */
-		if (picks || slopes) {
-		    mint = SF_HUGE;
-		    minix = 0;
-		    for (ix=0; ix < nx; ix++) {
-		        if (time[ic][ix] < mint) {
-		            mint = time[ic][ix];
-		            minix = ix;
-		        }
-		    }
-		    if (picks) {
-		        amp = tss[ic][minix]->t + tgs[ic][minix]->t;
-		        sf_floatwrite(&amp,1,picks);
-		    }
-		    if (slopes) {
-		        amp = fabsf(tgs[ic][minix]->tx);
-		        sf_floatwrite(&amp,1,slopes);
+	if (adj) {
+	    /* stack in the serial order */
+	    for (ib=0; ib < nb; ib++) {
+		for (ih=0; ih < nh; ih++) {
+		    for (i=0; i < nxc; i++) {
+			rfl[0][i] += rflh[ib][ih][i];
 		    }
 		}
 	    }
-
-	    if (!adj) {
-		sf_aastretch_lop (false,false,nxc,nt,ampl[0],trace);
-
-		/* convolve with Ricker wavelet */
-		sf_freqfilt_lop(false,false,nt,nt,trace,trace2);
-	    
-		sf_floatwrite(trace2,nt,modl); 
-
-                /* sf_floatwrite(trace,nt,modl); */
-	    }
+	} else {
+	    sf_floatwrite(trace[0][0],nt*nh*nb,modl); 
+	    if (NULL != picks) sf_floatwrite(pick[0][0],nc*nh*nb,picks);
+	    if (NULL != slopes) sf_floatwrite(slope[0][0],nc*nh*nb,slopes);
 	}
     }
     sf_warning(".");
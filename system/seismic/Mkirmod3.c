@@ -21,22 +21,95 @@
 
 #include <rsf.h>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #include "kirmod.h"
 #include "kirmod3.h"
+#include "kirtrace.h"
 #include "ricker.h"
 
+static int nx, ny, nc, nh, nt;
+static float fx, dx, fy, dy, dt, t0, aper, ***rfl, ***rgd;
+
+static void kirmod3_shot(kirtrace kt, 
+			 ktable ts, ktable tg /* ray attribute workspace */,
+			 float **geom         /* geometry [nh+1][2] */,
+			 float **trace        /* traces [nh][nt] */)
+/* model one shot gather */
+{
+    int ih, ix, iy, ic, i;
+    float x, y, dx1, dy1, dx2, dy2, theta, ava, amp, obl;
+
+    for (ih=0; ih < nh; ih++) { 
+	/* loop over surface */
+	for (iy=0; iy < ny; iy++) { for (ix=0; ix < nx; ix++) {
+	    x = fx+ix*dx; dx1 = x-geom[nh][0]; dx2 = x-geom[ih][0];
+	    y = fy+iy*dy; dy1 = y-geom[nh][1]; dy2 = y-geom[ih][1];
+
+	    /* skip if outside the aperture */
+	    if (aper < dx1*dx1 + dy1*dy1 ||
+		aper < dx2*dx2 + dy2*dy2) {
+		for (ic=0; ic < nc; ic++) {
+		    i = (ic*ny+iy)*nx+ix;
+		    kt->time[i] = t0+2.*nt*dt;
+		    kt->ampl[i] = 0.;
+		    kt->delt[i] = dt;
+		}
+		continue;
+	    }
+
+	    /* loop over surface number */
+	    for (ic=0; ic < nc; ic++) {
+		i = (ic*ny+iy)*nx+ix;
+
+		kirmod3_map(ts,geom[nh],ix,iy,ic);
+		kirmod3_map(tg,geom[ih],ix,iy,ic);
+		    
+		kt->time[i] = ts->t + tg->t;
+		    
+		tg->an /= sqrtf(1.-(tg->tn)*(tg->tn));
+		ts->an /= sqrtf(1.-(ts->tn)*(ts->tn));
+		if (rgd[ic][iy][ix] != 0.) { 
+		    theta = hypotf((tg->an)*(tg->tx)-(ts->an)*(ts->tx),
+				   (tg->an)*(tg->ty)-(ts->an)*(ts->ty));
+
+		    /* AVA */
+		    theta = sinf(0.5*theta);
+		    ava = rfl[ic][iy][ix]+rgd[ic][iy][ix]*theta*theta;
+		} else
+		    ava = rfl[ic][iy][ix];
+
+		/* obliguity */
+		obl = 0.5*(ts->tn + tg->tn);
+		    
+		/* Geometrical spreading */
+		amp = ts->a * tg->a + FLT_EPSILON;
+		    
+		kt->ampl[i] = ava*obl*dx/amp;
+		kt->delt[i] = SF_MAX(fabsf(ts->tx+tg->tx)*dx,
+				     fabsf(ts->ty+tg->ty)*dy); 
+	    }
+	}}
+
+	/* stretch and convolve with Ricker wavelet */
+	kirtrace_lop(kt,false,trace[ih]);
+    } /* ih */
+}
+
 int main(int argc, char* argv[]) 
 {
-    int nx,ny, nt, nsx,nsy, nhx,nhy, nc, nxyc, isx,isy, ihx,ihy, ix,iy, ic;
-    int ns,nh, two, is, ih;
+    int nsx,nsy, nhx,nhy, nxyc, isx,isy, ihx,ihy, ix,iy, ic;
+    int ns, two, is, ih, nb, ib, nth, ith;
     bool absoff, verb;
-    float ***rfl, ***rgd, ***crv, ***dipx, ***dipy, *trace;
-    float slow, dx, x0, dy, y0, dt, t0, aper, x, y, dx1, dy1, dx2, dy2;
-    float dsx, dsy, s0x, s0y, dhx, h0x, dhy, h0y, r0;
-    float theta, ava, amp, obl, ***time, ***ampl, ***delt, **geom, freq;
+    float ***crv, ***dipx, ***dipy, ***trace;
+    float slow, dsx, dsy, s0x, s0y, dhx, h0x, dhy, h0y, r0;
+    float ***geom, **g, freq;
     const char *type;
     velocity3 vel;
-    ktable ts, tg;
+    ktable *ts, *tg;
+    kirtrace *kt;
     sf_file refl, curv, modl, head;
     
     sf_init(argc,argv);
@@ -46,10 +119,10 @@ int main(int argc, char* argv[])
     if (SF_FLOAT != sf_gettype(curv)) sf_error("Need float input");
     if (!sf_histint  (curv,"n1",&nx)) sf_error("No n1= in input");
     if (!sf_histfloat(curv,"d1",&dx)) sf_error("No d1= in input");
-    if (!sf_histfloat(curv,"o1",&x0)) sf_error("No o1= in input");
+    if (!sf_histfloat(curv,"o1",&fx)) sf_error("No o1= in input");
     if (!sf_histint  (curv,"n2",&ny)) sf_error("No n2= in input");
     if (!sf_histfloat(curv,"d2",&dy)) sf_error("No d2= in input");
-    if (!sf_histfloat(curv,"o2",&y0)) sf_error("No o2= in input");
+    if (!sf_histfloat(curv,"o2",&fy)) sf_error("No o2= in input");
     if (!sf_histint  (curv,"n3",&nc)) nc=1; /* number of reflectors */
     nxyc = nx*ny*nc;
 
@@ -68,8 +141,6 @@ int main(int argc, char* argv[])
     if (!sf_getbool("absoff",&absoff)) absoff=false;
     /* y - h0x, h0y - are not in shot coordinate system */
 
-    trace = sf_floatalloc(nt+1);
-
     sf_putint  (modl,"n1",nt);
     sf_putfloat(modl,"d1",dt);
     sf_putfloat(modl,"o1",t0);
@@ -98,7 +169,7 @@ int main(int argc, char* argv[])
 
 	if (!sf_getint("nsx",&nsx)) nsx=nx;
 	/* number of inline shots */
-	if (!sf_getfloat("s0x",&s0x)) s0x=x0;
+	if (!sf_getfloat("s0x",&s0x)) s0x=fx;
 	/* first inline shot */
 	if (!sf_getfloat("dsx",&dsx)) dsx=dx;
 	/* inline shot increment */
@@ -109,7 +180,7 @@ int main(int argc, char* argv[])
     
 	if (!sf_getint("nsy",&nsy)) nsy=ny;
 	/* number of crossline shots */
-	if (!sf_getfloat("s0y",&s0y)) s0y=y0;
+	if (!sf_getfloat("s0y",&s0y)) s0y=fy;
 	/* first crossline shot */
 	if (!sf_getfloat("dsy",&dsy)) dsy=dy;
 	/* crossline shot increment */
@@ -249,8 +320,8 @@ int main(int argc, char* argv[])
 	sf_error("Unknown type=%s",type);
     }
 	
-    if (!sf_getfloat("refx",&(vel->x0))) (vel->x0)=x0;
-    if (!sf_getfloat("refy",&(vel->y0))) (vel->y0)=y0;
+    if (!sf_getfloat("refx",&(vel->x0))) (vel->x0)=fx;
+    if (!sf_getfloat("refy",&(vel->y0))) (vel->y0)=fy;
     if (!sf_getfloat("refz",&(vel->z0))) (vel->z0)=0.;
     /* reference coordinates for velocity */
 
@@ -259,108 +330,74 @@ int main(int argc, char* argv[])
     aper *= aper;
     
     /*** Allocate space ***/    
-    kirmod3_init(x0, dx, y0, dy, vel, type[0], crv, dipx, dipy);
-    ts = (ktable) sf_alloc(1,sizeof(*ts));
-    tg = (ktable) sf_alloc(1,sizeof(*tg));
-
-
-    /*** Initialize stretch ***/
-    sf_aastretch_init (false, nt, t0, dt, nxyc);
-
-    time = sf_floatalloc3(nx,ny,nc);
-    ampl = sf_floatalloc3(nx,ny,nc);
-    delt = sf_floatalloc3(nx,ny,nc);
-    geom = sf_floatalloc2(2,nh+1);
+    kirmod3_init(fx, dx, fy, dy, vel, type[0], crv, dipx, dipy);
 
     if (!sf_getfloat("freq",&freq)) freq=0.2/dt;
     /* peak frequency for Ricker wavelet */
     ricker_init(nt*2,freq*dt,2);
 
-    /*** Main loop ***/
-    /* loop over sources */
-    for (is=0; is < ns; is++) { 
-	if (NULL == head) { /* regular */
-	    isy = is/nsx;
-	    isx = is - isy*nsx;
-
-	    geom[nh][0] = s0x + isx*dsx;
-	    geom[nh][1] = s0y + isy*dsy;
-	} else { /* irregular */
-	    sf_floatread(geom[0],2*(nh+1),head);
-	}
-
+    /*** Shots are modeled in batches of one per thread ***/
+    nth = kirtrace_threads();
+    nb = SF_MIN(nth,ns);
+
+    kt = (kirtrace*) sf_alloc(nth,sizeof(kirtrace));
+    ts = (ktable*) sf_alloc(nth,sizeof(ktable));
+    tg = (ktable*) sf_alloc(nth,sizeof(ktable));
+    for (ith=0; ith < nth; ith++) {
+	kt[ith] = kirtrace_init(nt,t0,dt,nxyc);
+	ts[ith] = (ktable) sf_alloc(1,sizeof(*ts[ith]));
+	tg[ith] = (ktable) sf_alloc(1,sizeof(*tg[ith]));
+    }
 
-	/* loop over offsets */
-	for (ih=0; ih < nh; ih++) { 
-            if (verb && 0==ih%(nh/10+1)) sf_warning("source %d of %d, receiver %d of %d;",is+1,ns,ih+1,nh);
-	    if (NULL == head) { /* regular */		
-		ihy = ih/nhx;
-		ihx = ih - ihy*nhx;
+    geom = sf_floatalloc3(2,nh+1,nb);
+    trace = sf_floatalloc3(nt,nh,nb);
 
-		if (absoff) {
-                    geom[ih][0] = h0x + ihx*dhx;
-                    geom[ih][1] = h0y + ihy*dhy;
-		} else {
-		    geom[ih][0] = geom[nh][0] + h0x + ihx*dhx;
-  		    geom[ih][1] = geom[nh][1] + h0y + ihy*dhy;
-		}
-	    }	
-
-	    /* loop over surface */
-	    for (iy=0; iy < ny; iy++) { for (ix=0; ix < nx; ix++) {
-		x = x0+ix*dx; dx1 = x-geom[nh][0]; dx2 = x-geom[ih][0];
-		y = y0+iy*dy; dy1 = y-geom[nh][1]; dy2 = y-geom[ih][1];
-
-		/* skip if outside the aperture */
-		if (aper < dx1*dx1 + dy1*dy1 ||
-		    aper < dx2*dx2 + dy2*dy2) {
-		    for (ic=0; ic < nc; ic++) {
-			time[ic][iy][ix] = t0+2.*nt*dt;
-			ampl[ic][iy][ix] = 0.;
-			delt[ic][iy][ix] = dt;
+    /*** Main loop ***/
+    /* loop over sources */
+    for (is=0; is < ns; is += nb) { 
+	if (nb > ns-is) nb = ns-is;
+
+	for (ib=0; ib < nb; ib++) {
+	    if (verb) sf_warning("source %d of %d;",is+ib+1,ns);
+
+	    g = geom[ib];
+	    if (NULL == head) { /* regular */
+		isy = (is+ib)/nsx;
+		isx = is+ib - isy*nsx;
+
+		g[nh][0] = s0x + isx*dsx;
+		g[nh][1] = s0y + isy*dsy;
+
+		for (ih=0; ih < nh; ih++) { 
+		    ihy = ih/nhx;
+		    ihx = ih - ihy*nhx;
+
+		    if (absoff) {
+			g[ih][0] = h0x + ihx*dhx;
+			g[ih][1] = h0y + ihy*dhy;
+		    } else {
+			g[ih][0] = g[nh][0] + h0x + ihx*dhx;
+			g[ih][1] = g[nh][1] + h0y + ihy*dhy;
 		    }
-		    continue;
 		}
+	    } else { /* irregular */
+		sf_floatread(g[0],2*(nh+1),head);
+	    }
+	}
 
-		/* loop over surface number */
-		for (ic=0; ic < nc; ic++) {
-		    kirmod3_map(ts,geom[nh],ix,iy,ic);
-		    kirmod3_map(tg,geom[ih],ix,iy,ic);
-		    
-		    time[ic][iy][ix] = ts->t + tg->t;
-		    
-		    tg->an /= sqrtf(1.-(tg->tn)*(tg->tn));
-		    ts->an /= sqrtf(1.-(ts->tn)*(ts->tn));
-                    if (rgd[ic][iy][ix] != 0.) { 
-			theta = hypotf((tg->an)*(tg->tx)-(ts->an)*(ts->tx),
-					(tg->an)*(tg->ty)-(ts->an)*(ts->ty));
-
-			/* AVA */
-			theta = sinf(0.5*theta);
-			ava = rfl[ic][iy][ix]+rgd[ic][iy][ix]*theta*theta;
-		    } else
-			ava = rfl[ic][iy][ix];
-
-		    /* obliguity */
-		    obl = 0.5*(ts->tn + tg->tn);
-		    
-		    /* Geometrical spreading */
-		    amp = ts->a * tg->a + FLT_EPSILON;
-		    
-		    ampl[ic][iy][ix] = ava*obl*dx/amp;
-		    delt[ic][iy][ix] = SF_MAX(fabsf(ts->tx+tg->tx)*dx,
-					      fabsf(ts->ty+tg->ty)*dy); 
-		}
-	    }}
-	    sf_aastretch_define (time[0][0],delt[0][0],NULL);
-	    sf_aastretch_lop (false,false,nxyc,nt,ampl[0][0],trace);
-	    
-	    /* convolve with Ricker wavelet */
-	    sf_freqfilt(nt,trace);
-	    
-	    sf_floatwrite(trace,nt,modl);
-	} /* ih */
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) private(ith)
+#endif
+	for (ib=0; ib < nb; ib++) {
+#ifdef _OPENMP
+	    ith = omp_get_thread_num();
+#else
+	    ith = 0;
+#endif
+	    kirmod3_shot(kt[ith],ts[ith],tg[ith],geom[ib],trace[ib]);
+	}
 
+	sf_floatwrite(trace[0][0],nt*nh*nb,modl);
     } /* is */
     if (verb) sf_warning(".");
 
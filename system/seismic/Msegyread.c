@@ -283,22 +283,167 @@ additional keys can be created in the output trace headers
 #include <unistd.h>
 
 #include <stdio.h>
+#include <string.h>
+
+#ifdef SF_HAS_PTHREADS
+#include <pthread.h>
+#endif
 
 #include <rsf.h>
 
 #include "segy.h"
 
+/* Bulk reading: blocks of traces are read by a helper thread, while
+   the previous block is converted (in parallel over traces) and
+   written out. */
+
+typedef struct Bulk {
+    FILE *file;
+    off_t nsegy;
+    int ntr, nbulk, next; /* next = first trace of the next block */
+    char *buf[2];
+    int nb[2];            /* traces in buffer */
+    size_t got[2];        /* bytes read into buffer */
+    bool full[2];
+    int cur;
+#ifdef SF_HAS_PTHREADS
+    bool threaded;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+#endif
+} *bulk;
+
+static void bulk_fill(bulk b, int k)
+/* read the next block into buffer k */
+{
+    b->nb[k] = SF_MIN(b->nbulk,b->ntr - b->next);
+    b->got[k] = fread(b->buf[k],1,b->nb[k]*b->nsegy,b->file);
+    b->next += b->nb[k];
+}
+
+#ifdef SF_HAS_PTHREADS
+static void *bulk_reader(void *arg)
+/* read-ahead thread */
+{
+    bulk b;
+    int k;
+
+    b = (bulk) arg;
+    for (k=0; b->next < b->ntr; k = 1-k) {
+	pthread_mutex_lock(&(b->lock));
+	while (b->full[k]) pthread_cond_wait(&(b->cond),&(b->lock));
+	pthread_mutex_unlock(&(b->lock));
+
+	bulk_fill(b,k);
+
+	pthread_mutex_lock(&(b->lock));
+	b->full[k] = true;
+	pthread_cond_broadcast(&(b->cond));
+	pthread_mutex_unlock(&(b->lock));
+
+	if (b->got[k] < b->nb[k]*b->nsegy) break; /* short read */
+    }
+    return NULL;
+}
+#endif
+
+static bulk bulk_init(FILE *file, off_t nsegy, int ntr, int nbulk, size_t pad)
+/* start reading ntr traces of nsegy bytes, nbulk traces at a time */
+{
+    bulk b;
+
+    b = (bulk) sf_alloc(1,sizeof(*b));
+    b->file = file;
+    b->nsegy = nsegy;
+    b->ntr = ntr;
+    b->nbulk = nbulk;
+    b->next = 0;
+    b->buf[0] = sf_charalloc(nbulk*nsegy+pad);
+    b->buf[1] = sf_charalloc(nbulk*nsegy+pad);
+    b->full[0] = b->full[1] = false;
+    b->cur = 0;
+
+#ifdef SF_HAS_PTHREADS
+    pthread_mutex_init(&(b->lock),NULL);
+    pthread_cond_init(&(b->cond),NULL);
+    b->threaded = (bool) (0 == pthread_create(&(b->thread),NULL,bulk_reader,b));
+#endif
+
+    return b;
+}
+
+static char *bulk_get(bulk b, int itr, int *nb)
+/* wait for the next block, starting at trace itr */
+{
+    int k;
+
+    k = b->cur;
+#ifdef SF_HAS_PTHREADS
+    if (b->threaded) {
+	pthread_mutex_lock(&(b->lock));
+	while (!b->full[k]) pthread_cond_wait(&(b->cond),&(b->lock));
+	pthread_mutex_unlock(&(b->lock));
+    } else 
+#endif
+    {
+	bulk_fill(b,k);
+	b->full[k] = true;
+    }
+
+    if (b->got[k] < b->nb[k]*b->nsegy) 
+	sf_error("Error reading trace %d",itr+(int) (b->got[k]/b->nsegy)+1);
+
+    *nb = b->nb[k];
+    return b->buf[k];
+}
+
+static void bulk_release(bulk b)
+/* done with the current block */
+{
+    int k;
+
+    k = b->cur;
+#ifdef SF_HAS_PTHREADS
+    if (b->threaded) {
+	pthread_mutex_lock(&(b->lock));
+	b->full[k] = false;
+	pthread_cond_broadcast(&(b->cond));
+	pthread_mutex_unlock(&(b->lock));
+    } else
+#endif
+    {
+	b->full[k] = false;
+    }
+    b->cur = 1-k;
+}
+
+static void bulk_close(bulk b)
+{
+#ifdef SF_HAS_PTHREADS
+    if (b->threaded) pthread_join(b->thread,NULL);
+    pthread_mutex_destroy(&(b->lock));
+    pthread_cond_destroy(&(b->cond));
+#endif
+    free(b->buf[0]);
+    free(b->buf[1]);
+    free(b);
+}
+
 int main(int argc, char *argv[])
 {
     bool verbose, su, xdr, suxdr;
     const char *read, *headname;
     char ahead[SF_EBCBYTES], bhead[SF_BNYBYTES];
-    char *filename, *trace, *prog, key[7], *name;
+    char *filename, *trace, *prog, key[7], *name, *blk, *tr, *cblk;
     sf_file out, hdr, msk=NULL;
     int format, ns, itr, ntr, n2, itrace[SF_MAXKEYS], *mask, nkeys=SF_NKEYS, ik;
+    int nbulk, nb, nk, i, *keep, *hblk;
     off_t pos, start, nsegy=0;
+    size_t nbytes;
     FILE *head, *file;
-    float *ftrace, dt=0.0, t0;
+    float *ftrace, dt=0.0, t0, *fblk;
+    bulk b;
     extern int fseeko(FILE *stream, off_t offset, int whence);
     extern off_t ftello (FILE *stream);
 
@@ -555,6 +700,57 @@ int main(int argc, char *argv[])
 
     if (NULL != out) sf_fileflush(out,NULL);
 
+    if (!sf_getint("bulk",&nbulk)) nbulk = SF_MAX(1,(1<<24)/nsegy);
+    /* number of traces per bulk read (default: about 16 MB), 
+       0 reads trace by trace. Headers only (read=h) are read trace by trace. */
+
+    if (nbulk > 0 && read[0] != 'h') {
+	nbulk = SF_MAX(1,SF_MIN(nbulk,ntr));
+	nbytes = ns*sizeof(float); /* raw trace for native data */
+
+	keep = sf_intalloc(nbulk);
+	hblk = (NULL != hdr)? sf_intalloc(nkeys*nbulk): NULL;
+	fblk = (NULL != out && suxdr)? sf_floatalloc(ns*nbulk): NULL;
+	cblk = (NULL != out && !suxdr)? sf_charalloc(nbytes*nbulk): NULL;
+
+	/* write behind while reading ahead */
+	if (NULL != out) sf_async(out,true);
+	if (NULL != hdr) sf_async(hdr,true);
+
+	b = bulk_init(file,nsegy,ntr,nbulk,nbytes);
+
+	for (itr=0; itr < ntr; itr += nb) {
+	    blk = bulk_get(b,itr,&nb);
+
+	    /* traces selected by the mask */
+	    for (nk=i=0; i < nb; i++) {
+		if (NULL == mask || mask[itr+i]) keep[nk++] = i;
+	    }
+
+#ifdef _OPENMP
+#pragma omp parallel for private(tr)
+#endif
+	    for (i=0; i < nk; i++) {
+		tr = blk + keep[i]*nsegy;
+		if (NULL != hblk) segy2head(tr, hblk+i*nkeys, nkeys);
+		if (NULL != fblk) {
+		    segy2trace(tr + SF_HDRBYTES, fblk+(size_t) i*ns, ns, format);
+		} else if (NULL != cblk) {
+		    memcpy(cblk+i*nbytes, tr + SF_HDRBYTES, nbytes);
+		}
+	    }
+
+	    bulk_release(b);
+
+	    if (NULL != hblk) sf_intwrite(hblk, nk*nkeys, hdr);
+	    if (NULL != fblk) sf_floatwrite(fblk, (size_t) nk*ns, out);
+	    if (NULL != cblk) sf_charwrite(cblk, nk*nbytes, out);
+	}
+
+	bulk_close(b);
+	exit(0);
+    }
+
     switch (read[0]) {
 	case 'h': /* header only */
 	    trace = sf_charalloc (SF_HDRBYTES);
@@ -25,63 +25,395 @@ http://www.ahay.org/blog/2013/05/04/program-of-the-month-sfvscan/
 
 #include <math.h>
 #include <rsf.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #include "fint1.h"
 
-static float v, h, v1, s;
+typedef void (*nmomap)(float *tt, float v, float h, float s);
+/* map output times to input times, in samples, for one velocity */
 
-static float hyperb(float t, int it) 
+typedef struct {
+    fint1 nmo;
+    float *trace, *tt, ***stack, ***stack2, ***stackh, ***stack2h;
+    double *tn, *td, *ln, *ld, *rn, *rd;
+} *vscan;
+/* workspace for one thread */
+
+static bool half, slow, weight, trend, ratio, dsum;
+static int nt, nh, nv, ns, nb, CDPtype;
+static float dt, t0, h0, dh, v0, dv, ds, v1, str, **bb;
+static char type;
+static nmomap nmofunc;
+
+static void hyperb(float *tt, float v, float h, float s) 
 {
-    return hypotf(t,v);
+    int it;
+    float t;
+
+    for (it=0; it < nt; it++) {
+	t = t0+it*dt;
+	t = hypotf(t,v);
+	tt[it] = (t-t0)/dt;
+    }
 }
 
-static float nonhyperb(float t, int it) 
+static void nonhyperb(float *tt, float v, float h, float s) 
 {
+    int it;
+    float t;
+
     /* shifted hyperbola */
-    return t*(1.0-1.0/s) + sqrtf(t*t+s*v*v)/s;
+    for (it=0; it < nt; it++) {
+	t = t0+it*dt;
+	t = t*(1.0-1.0/s) + sqrtf(t*t+s*v*v)/s;
+	tt[it] = (t-t0)/dt;
+    }
 }
 
-static float hyperb1(float t, int it) 
+static void hyperb1(float *tt, float v, float h, float s) 
 {
-    return sqrtf(t*t+v*v-v1*v1*h*h);
+    int it;
+    float t;
+
+    for (it=0; it < nt; it++) {
+	t = t0+it*dt;
+	t = sqrtf(t*t+v*v-v1*v1*h*h);
+	tt[it] = (t-t0)/dt;
+    }
 }
 
-static float nonhyperb1(float t, int it) 
+static void nonhyperb1(float *tt, float v, float h, float s) 
 {
-    return t*(1.0-1.0/s) + sqrtf(t*t+s*(v*v-v1*v1*h*h))/s;
+    int it;
+    float t;
+
+    for (it=0; it < nt; it++) {
+	t = t0+it*dt;
+	t = t*(1.0-1.0/s) + sqrtf(t*t+s*(v*v-v1*v1*h*h))/s;
+	tt[it] = (t-t0)/dt;
+    }
 }
 
-static float curved(float t, int it) 
+static void curved(float *tt, float v, float h, float s) 
 {
-    return sqrtf(t*t+v*h);
+    int it;
+    float t;
+
+    for (it=0; it < nt; it++) {
+	t = t0+it*dt;
+	t = sqrtf(t*t+v*h);
+	tt[it] = (t-t0)/dt;
+    }
 }
 
-static float noncurved(float t, int it) 
+static void noncurved(float *tt, float v, float h, float s) 
 {
-    return t*(1.0-1.0/s) + sqrtf(t*t+s*v*h)/s;
+    int it;
+    float t;
+
+    for (it=0; it < nt; it++) {
+	t = t0+it*dt;
+	t = t*(1.0-1.0/s) + sqrtf(t*t+s*v*h)/s;
+	tt[it] = (t-t0)/dt;
+    }
 }
 
-static float curved1(float t, int it) 
+static void curved1(float *tt, float v, float h, float s) 
 {
-    return sqrtf(t*t+v*h-v1*h*h);
+    int it;
+    float t;
+
+    for (it=0; it < nt; it++) {
+	t = t0+it*dt;
+	t = sqrtf(t*t+v*h-v1*h*h);
+	tt[it] = (t-t0)/dt;
+    }
+}
+
+static void noncurved1(float *tt, float v, float h, float s) 
+{
+    int it;
+    float t;
+
+    for (it=0; it < nt; it++) {
+	t = t0+it*dt;
+	t = t*(1.0-1.0/s) + sqrtf(t*t+s*(v*h-v1*h*h))/s;
+	tt[it] = (t-t0)/dt;
+    }
+}
+
+static void block_sums(int nw, const double *t, double *l, double *r)
+/* partial sums of t within blocks of nw samples: l from the start of
+   the block, r to its end */
+{
+    int i0, i1, i;
+
+    for (i0=0; i0 < nt; i0 += nw) {
+	i1 = SF_MIN(i0+nw,nt);
+	l[i0] = t[i0];
+	for (i=i0+1; i < i1; i++) {
+	    l[i] = l[i-1]+t[i];
+	}
+	r[i1-1] = t[i1-1];
+	for (i=i1-2; i >= i0; i--) {
+	    r[i] = r[i+1]+t[i];
+	}
+    }
 }
 
-static float noncurved1(float t, int it) 
+static double window_sum(int nw, int ib, int ie, 
+			 const double *l, const double *r)
+/* sum over [ib,ie) for ie-ib <= nw, from at most two partial sums:
+   O(1) per window and no cancellation as in a running difference */
 {
-    return t*(1.0-1.0/s) + sqrtf(t*t+s*(v*h-v1*h*h))/s;
+    if (ib/nw == (ie-1)/nw) return (0 == ib%nw)? l[ie-1]: r[ib];
+    return r[ib]+l[ie-1];
+}
+
+static vscan vscan_init(int mute, int nw)
+/* allocate workspace */
+{
+    vscan w;
+
+    w = (vscan) sf_alloc(1,sizeof(*w));
+    w->nmo = fint1_init(nw,nt,mute);
+    w->trace = sf_floatalloc(nt);
+    w->tt = sf_floatalloc(nt);
+
+    w->stack =  sf_floatalloc3(nt,nv,ns);
+    w->stack2 = ('p' != type)? sf_floatalloc3(nt,nv,ns): NULL;
+    w->stackh = trend? sf_floatalloc3(nt,nv,ns): NULL;
+    w->stack2h = ('w' == type)? sf_floatalloc3(nt,nv,ns): NULL;
+
+    w->tn = (double*) sf_alloc(6*nt,sizeof(double));
+    w->td = w->tn+nt;
+    w->ln = w->td+nt;
+    w->ld = w->ln+nt;
+    w->rn = w->ld+nt;
+    w->rd = w->rn+nt;
+
+    return w;
+}
+
+static void vscan_cmp(vscan w, 
+		      int ix          /* CMP number */, 
+		      float *data     /* CMP gather [nh][nt], destroyed */, 
+		      const float *hh /* offsets [nh] or NULL */, 
+		      const int *mask /* mask [nh] or NULL */, 
+		      float *scan     /* output [ns][nv][nt] */)
+/* velocity scan of one CMP gather */
+{
+    int it, ih, iv, is, ib, ie, i;
+    float amp, amp2, num, den, h, s, v, sh=0., sh2=0.;
+    float *trace, *tt, *a, *b, *c, *d, *e;
+    double *tn, *td;
+
+    trace = w->trace;
+    tt = w->tt;
+    tn = w->tn;
+    td = w->td;
+
+    for (it=0; it < nt*nv*ns; it++) {
+	w->stack[0][0][it] = 0.;
+	if (NULL != w->stack2) w->stack2[0][0][it] = 0.;
+	if (trend) w->stackh[0][0][it] = 0.;
+	if ('w' == type) w->stack2h[0][0][it] = 0.;
+    }
+
+    for (ih=0; ih < nh; ih++) {
+	if (NULL != mask && 0==mask[ih]) continue;
+	    
+	h = (NULL != hh)? hh[ih]: 
+	    h0 + ih * dh + (dh/CDPtype)*(ix%CDPtype);
+	if (half) h *= 2.;
+
+	if (trend) {
+	    sh  += h;    /* sf  */
+	    sh2 += h*h;  /* sf2 */
+	}
+
+	e = data+ih*nt;
+	for (it=0; it < nt; it++) {
+	    e[it] /= nt*nh;
+	}
+	fint1_set(w->nmo,e);
+	
+	for (is=0; is < ns; is++) {
+	    s = 1.0 + is*ds;
+
+	    for (iv=0; iv < nv; iv++) {
+		v = v0 + iv * dv;
+		v = slow? h*v: h/v;
+
+		nmofunc(tt,v,h,s);
+		fint1_stretch(w->nmo,nt,nt,tt,trace,str);
+
+		if (weight) {
+		    amp = fabsf(v);
+		    for (it=0; it < nt; it++) {
+			trace[it] *= amp;
+		    }
+		}
+		if (NULL != bb) {
+		    for (it=0; it < nt; it++) {
+			trace[it] *= (1.0-bb[iv][it]*h);
+		    }
+		}
+
+		a = w->stack[is][iv];
+		b = (NULL != w->stack2)? w->stack2[is][iv]: NULL;
+		c = trend? w->stackh[is][iv]: NULL;
+		d = ('w' == type)? w->stack2h[is][iv]: NULL;
+
+		switch(type) {
+		    case 'd':
+			if (ih > 0) {
+			    for (it=0; it < nt; it++) {
+				amp2 = trace[it] - b[it];
+				a[it] += amp2*amp2;
+			    }
+			}
+			for (it=0; it < nt; it++) {
+			    b[it] = trace[it];
+			}
+			break;
+		    case 's':
+			for (it=0; it < nt; it++) {
+			    amp = trace[it];
+			    b[it] += amp*amp;
+			    a[it] += amp;
+			}
+			break;
+		    case 'a': 
+			for (it=0; it < nt; it++) {
+			    amp = trace[it];
+			    c[it] += amp*h;    /* saf */
+			    b[it] += amp*amp;  /* sa2 */
+			    a[it] += amp;      /* sa1 */
+			}
+			break;
+		    case 'w':
+			for (it=0; it < nt; it++) {
+			    amp = trace[it];
+			    c[it] += amp*h;       /* saf */
+			    d[it] += amp*amp*h;   /* sfa2 */
+			    b[it] += amp*amp;     /* sa2 */
+			    a[it] += amp;         /* sa1 */
+			}
+			break;
+		    case 'p':
+		    default:
+			for (it=0; it < nt; it++) {
+			    a[it] += trace[it];
+			}
+			break;				
+		} 
+	    } /* v */
+	} /* s */
+    } /* h */
+	
+    if (!ratio) {
+	for (it=0; it < nt*nv*ns; it++) {
+	    scan[it] = w->stack[0][0][it];
+	}
+	return;
+    }
+
+    for (is=0; is < ns; is++) {
+	for (iv=0; iv < nv; iv++) {
+	    a = w->stack[is][iv];
+	    b = w->stack2[is][iv];
+	    c = trend? w->stackh[is][iv]: NULL;
+	    d = ('w' == type)? w->stack2h[is][iv]: NULL;
+
+	    if (dsum) {
+		for (i=0; i < nt; i++) {
+		    switch(type) {
+			case 'a':
+			    /* (N*saf^2 + sa1^2*sf2 - 2*sa1*saf*sf)/((N*sf2 - sf^2)*sa2) */
+
+			    tn[i] = nh*c[i]*c[i] + sh2*a[i]*a[i] - 2.*sh*a[i]*c[i];
+			    td[i] = b[i];
+			    break;
+			case 'w':
+			    /* 4*(sa1*sfa2 - sa2*saf)*(N*saf - sa1*sf)/(N*sfa2 - sa2*sf)^2 */
+
+			    tn[i] = (a[i]*d[i]-b[i]*c[i])*(nh*c[i]-a[i]*sh);
+			    td[i] = (nh*d[i]-b[i]*sh)*(nh*d[i]-b[i]*sh);
+			    break;
+			case 's':
+			default:
+			    tn[i] = a[i]*a[i];
+			    td[i] = b[i];
+			    break;
+		    }
+		}
+		block_sums(2*nb+1,tn,w->ln,w->rn);
+		block_sums(2*nb+1,td,w->ld,w->rd);
+	    }
+
+	    e = scan+(is*nv+iv)*nt;
+	    for (it=0; it < nt; it++) {
+		ib = it-nb;
+		ie = it+nb+1;
+		if (ib < 0) ib=0;
+		if (ie > nt) ie=nt;
+
+		if (dsum) {
+		    num = window_sum(2*nb+1,ib,ie,w->ln,w->rn);
+		    den = window_sum(2*nb+1,ib,ie,w->ld,w->rd);
+		} else {
+		    num = 0.;
+		    den = 0.;
+		    for (i=ib; i < ie; i++) {
+			switch(type) {
+			    case 'a':
+				num += nh*c[i]*c[i] + sh2*a[i]*a[i] - 2.*sh*a[i]*c[i];
+				den += b[i];
+				break;
+			    case 'w':
+				num += (a[i]*d[i]-b[i]*c[i])*(nh*c[i]-a[i]*sh);
+				den += (nh*d[i]-b[i]*sh)*(nh*d[i]-b[i]*sh);
+				break;
+			    case 's':
+			    default:
+				num += a[i]*a[i];
+				den += b[i];
+				break;
+			}
+		    }
+		}
+			    
+		switch(type) {
+		    case 'a':
+			den *= (nh*sh2-sh*sh);
+			break;
+		    case 'w':
+			num *= 4.0f;
+			break;
+		    case 's':
+			den *= nh;
+			break;
+		}
+
+		e[it] = (den > 0.)? num/den: 0.;
+	    }
+	} /* v */
+    } /* s */
 }
 
 int main(int argc, char* argv[])
 {
-    fint1 nmo;
-    bool sembl, half, slow, dsembl, asembl, weight, squared, trend, ratio;
-    int it,ih,ix,iv, nt,nh,nx,nv, ib,ie,nb,i, nw, is, ns, CDPtype, mute, *mask;
-    float amp, amp2, dt, dh, t0, h0, v0, dv, ds, smax, num, den, dy, str, sh=0., sh2=0.;
-    float *trace, ***stack, ***stack2, ***stack2h, ***stackh, *hh, **bb;
+    bool sembl, dsembl, asembl, squared;
+    int ix, nx, nw, mute, ic, nc, nth, ith, **mask;
+    float smax, dy, **data, **hh, **out;
     char *time, *space, *unit;
-    const char *type;
+    const char *tname;
     size_t len;
     sf_file cmp, scan, offset, msk, grd;
-    mapfunc nmofunc;
+    vscan *work;
 
     sf_init (argc,argv);
     cmp = sf_input("in");
@@ -98,26 +430,34 @@ int main(int argc, char* argv[])
     if (sembl || dsembl || !sf_getbool("avosemblance",&asembl)) asembl=false;
     /* if y, compute AVO-friendly semblance */
 
-    if (NULL == (type = sf_getstring("type"))) {
+    if (NULL == (tname = sf_getstring("type"))) {
 	/* type of semblance (avo,diff,sembl,power,weighted) */
 	if (asembl) {
-	    type="avo";
+	    tname="avo";
 	} else if (dsembl) {
-	    type="diff";
+	    tname="diff";
 	} else if (sembl) {
-	    type="sembl";
+	    tname="sembl";
 	} else {
-	    type="power";
+	    tname="power";
 	}
     }
+    type = tname[0];
 
-    trend = (bool) ('a' == type[0] || 'w' == type[0]);
-    ratio = (bool) ('p' != type[0] && 'd' != type[0]);
+    trend = (bool) ('a' == type || 'w' == type);
+    ratio = (bool) ('p' != type && 'd' != type);
 
     if (!sf_getint("nb",&nb)) nb=2;
     /* semblance averaging */
     if (!sf_getbool("weight",&weight)) weight=true;
     /* if y, apply pseudo-unitary weighting */
+    if (!sf_getbool("dsum",&dsum)) dsum=true;
+    /* if y, sum semblance windows in double precision from partial
+       sums, O(1) per sample. dsum=n sums each window term by term in
+       float, O(nb) per sample, as older sfvscan did; use it only to
+       reproduce that output bit for bit. The two differ by float
+       round-off, except type=weighted, whose numerator cancels and
+       loses about 1e-4 relative in float */
 
     if (!sf_histfloat(cmp,"o1",&t0)) sf_error("No o1= in input");
     if (!sf_histfloat(cmp,"d1",&dt)) sf_error("No d1= in input");
@@ -128,7 +468,6 @@ int main(int argc, char* argv[])
     CDPtype=1;
     if (NULL != sf_getstring("offset")) {
 	offset = sf_input("offset");
-	hh = sf_floatalloc(nh);
 
 	h0 = dh = 0.;
     } else {
@@ -149,16 +488,13 @@ int main(int argc, char* argv[])
 	}
 
 	offset = NULL;
-	hh = NULL;
     }
 
     if (NULL != sf_getstring("mask")) {
 	/* optional mask file */ 
 	msk = sf_input("mask");
-	mask = sf_intalloc(nh);
     } else {
 	msk = NULL;
-	mask = NULL;
     }
 
     if (!sf_getfloat("v0",&v0) && !sf_histfloat(cmp,"v0",&v0)) 
@@ -235,11 +571,6 @@ int main(int argc, char* argv[])
 	bb = NULL;
     }
 
-    stack =  sf_floatalloc3(nt,nv,ns);
-    stack2 = ('p' != type[0])? sf_floatalloc3(nt,nv,ns): NULL;
-    stackh = trend? sf_floatalloc3(nt,nv,ns): NULL;
-    stack2h = ('w' == type[0])? sf_floatalloc3(nt,nv,ns): NULL;
-
     if (!sf_getint("extend",&nw)) nw=4;
     /* trace extension */
 
@@ -249,146 +580,52 @@ int main(int argc, char* argv[])
     if (!sf_getfloat("str",&str)) str=0.5;
     /* maximum stretch allowed */
 
-    trace = sf_floatalloc(nt);
-    nmo = fint1_init(nw,nt,mute);
-
-    for (ix=0; ix < nx; ix++) {
-	sf_warning("cmp %d of %d;",ix+1,nx);
-
-	for (it=0; it < nt*nv*ns; it++) {
-	    stack[0][0][it] = 0.;
-	    if (ratio) stack2[0][0][it] = 0.;
-	    if (trend) stackh[0][0][it] = 0.;
-	}
-
-	if (NULL != offset) sf_floatread(hh,nh,offset);
-	if (NULL != msk) sf_intread(mask,nh,msk);
-
-	if (trend) sh = sh2 = 0.;
+#ifdef _OPENMP
+    nth = omp_get_max_threads();
+#else
+    nth = 1;
+#endif
 
-	for (ih=0; ih < nh; ih++) {
-	    sf_floatread(trace,nt,cmp); 
-	    if (NULL != msk && 0==mask[ih]) continue;
-
-	    h = (NULL != offset)? hh[ih]: 
-		h0 + ih * dh + (dh/CDPtype)*(ix%CDPtype);
-	    if (half) h *= 2.;
-
-	    if (trend) {
-		sh  += h;    /* sf  */
-		sh2 += h*h;  /* sf2 */
-	    }
+    /* CMPs are read in batches of one per thread and scanned in parallel */
+    nc = SF_MIN(nth,nx);
 
-	    for (it=0; it < nt; it++) {
-		trace[it] /= nt*nh;
-	    }
-	    fint1_set(nmo,trace);
+    work = (vscan*) sf_alloc(nth,sizeof(vscan));
+    for (ith=0; ith < nth; ith++) {
+	work[ith] = vscan_init(mute,nw);
+    }
 
-	    for (is=0; is < ns; is++) {
-		s = 1.0 + is*ds;
+    data = sf_floatalloc2(nt*nh,nc);
+    hh = (NULL != offset)? sf_floatalloc2(nh,nc): NULL;
+    mask = (NULL != msk)? sf_intalloc2(nh,nc): NULL;
+    out = sf_floatalloc2(nt*nv*ns,nc);
 
-		for (iv=0; iv < nv; iv++) {
-		    v = v0 + iv * dv;
-		    v = slow? h*v: h/v;
+    for (ix=0; ix < nx; ix += nc) {
+	if (nc > nx-ix) nc = nx-ix;
 
-		    stretch(nmo,nmofunc,nt,dt,t0,nt,dt,t0,trace,str);
+	for (ic=0; ic < nc; ic++) {
+	    sf_warning("cmp %d of %d;",ix+ic+1,nx);
 
-		    for (it=0; it < nt; it++) {
-			amp = weight? fabsf(v)*trace[it]: trace[it];
-			if (NULL != bb) amp *= (1.0-bb[iv][it]*h);
-			
-			switch(type[0]) {
-			    case 'd':
-				if (ih > 0) {
-				    amp2 = amp - stack2[is][iv][it];
-				    stack[is][iv][it] += amp2*amp2;
-				}
-				stack2[is][iv][it] = amp;
-				break;
-			    case 's':
-				stack2[is][iv][it] += amp*amp;
-				stack[is][iv][it] += amp;
-				break;
-			    case 'a': 
-				stackh[is][iv][it] += amp*h;    /* saf */
-				stack2[is][iv][it] += amp*amp;  /* sa2 */
-				stack[is][iv][it] += amp;       /* sa1 */
-				break;
-			    case 'w':
-				stackh[is][iv][it] += amp*h;       /* saf */
-				stack2h[is][iv][it] += amp*amp*h;  /* sfa2 */
-				stack2[is][iv][it] += amp*amp;     /* sa2 */
-				stack[is][iv][it] += amp;          /* sa1 */
-				break;
-			    case 'p':
-			    default:
-				stack[is][iv][it] += amp;
-				break;				
-			} 
-		    } /* t */
-		} /* v */
-	    } /* s */
-	} /* h */
-	
-	if (ratio) {
-	    for (is=0; is < ns; is++) {
-		for (iv=0; iv < nv; iv++) {
-		    for (it=0; it < nt; it++) {
-			ib = it-nb;
-			ie = it+nb+1;
-			if (ib < 0) ib=0;
-			if (ie > nt) ie=nt;
-			num = 0.;
-			den = 0.;
-			for (i=ib; i < ie; i++) {
-			    switch(type[0]) {
-				case 'a':
-				    /* (N*saf^2 + sa1^2*sf2 - 2*sa1*saf*sf)/((N*sf2 - sf^2)*sa2) */
-
-				    num += nh*stackh[is][iv][i]*stackh[is][iv][i] + 
-					sh2*stack[is][iv][i]*stack[is][iv][i] - 
-					2.*sh*stack[is][iv][i]*stackh[is][iv][i];
-				    den += stack2[is][iv][i];
-				    break;
-				case 'w':
-				    /* 4*(sa1*sfa2 - sa2*saf)*(N*saf - sa1*sf)/(N*sfa2 - sa2*sf)^2 */
-
-				    num += 
-					(stack[is][iv][i]*stack2h[is][iv][i]-
-					 stack2[is][iv][i]*stackh[is][iv][i])*
-					(nh*stackh[is][iv][i]-stack[is][iv][i]*sh);
-				    den += 
-					(nh*stack2h[is][iv][i]-stack2[is][iv][i]*sh)*
-					(nh*stack2h[is][iv][i]-stack2[is][iv][i]*sh);
-				    break;
-				case 's':
-				default:
-				    num += stack[is][iv][i]*stack[is][iv][i];
-				den += stack2[is][iv][i];
-				break;
-			    }
-			}
-			    
-			switch(type[0]) {
-			    case 'a':
-				den *= (nh*sh2-sh*sh);
-				break;
-			    case 'w':
-				num *= 4.0f;
-				break;
-			    case 's':
-				den *= nh;
-				break;
-			}
+	    if (NULL != offset) sf_floatread(hh[ic],nh,offset);
+	    if (NULL != msk) sf_intread(mask[ic],nh,msk);
+	    sf_floatread(data[ic],nt*nh,cmp);
+	}
 
-			trace[it] = (den > 0.)? num/den: 0.;
-		    }
-		    sf_floatwrite(trace,nt,scan);
-		} /* v */
-	    } /* s */
-	} else {
-	    sf_floatwrite (stack[0][0],nt*nv*ns,scan);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) private(ith)
+#endif
+	for (ic=0; ic < nc; ic++) {
+#ifdef _OPENMP
+	    ith = omp_get_thread_num();
+#else
+	    ith = 0;
+#endif
+	    vscan_cmp(work[ith],ix+ic,data[ic],
+		      (NULL != offset)? hh[ic]: NULL,
+		      (NULL != msk)? mask[ic]: NULL,
+		      out[ic]);
 	}
+
+	sf_floatwrite(out[0],nc*nt*nv*ns,scan);
     } /* x */
     sf_warning(".");
     
@@ -20,6 +20,10 @@
 #include <rsf.h>
 /*^*/
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #include "fint1.h"
 #include "extend.h"
 
@@ -239,3 +243,142 @@ void stretch(fint1 str                  /* interpolation object */,
 	tp = t;
     }
 }
+
+static void spline4_many(int n, const float *t, int n1, const float *spl,
+			 float *trace)
+/* trace[i] = spline interpolation at t[i], zero outside [0,n1); bit for
+   bit the arithmetic of sf_spline4_int and fint1_apply */
+{
+    int i, j, it[4];
+    float x, x2, w[4][4], f;
+    const float *s;
+#ifdef __SSE2__
+    __m128 tt, ti, xx, x2x, x3x;
+    __m128i ii;
+    __m128d xd[2], x2d[2], x3d[2], a, b, c;
+    const __m128d one = _mm_set1_pd(1.), two = _mm_set1_pd(2.),
+	three = _mm_set1_pd(3.), four = _mm_set1_pd(4.), six = _mm_set1_pd(6.);
+#endif
+
+    i = 0;
+#ifdef __SSE2__
+    /* weights of four samples at a time, in double as in sf_spline4_int */
+    for (; i+4 <= n; i += 4) {
+	tt = _mm_loadu_ps(t+i);
+	/* floor = truncation, minus one where that rounded up */
+	ii = _mm_cvttps_epi32(tt);
+	ii = _mm_add_epi32(ii,_mm_castps_si128(
+			       _mm_cmplt_ps(tt,_mm_cvtepi32_ps(ii))));
+	ti = _mm_cvtepi32_ps(ii);
+	_mm_storeu_si128((__m128i*) it,ii);
+
+	xx = _mm_sub_ps(tt,ti);
+	x2x = _mm_mul_ps(xx,xx);
+	x3x = _mm_mul_ps(x2x,xx);
+
+	xd[0] = _mm_cvtps_pd(xx);
+	xd[1] = _mm_cvtps_pd(_mm_movehl_ps(xx,xx));
+	x2d[0] = _mm_cvtps_pd(x2x);
+	x2d[1] = _mm_cvtps_pd(_mm_movehl_ps(x2x,x2x));
+	x3d[0] = _mm_cvtps_pd(x3x);
+	x3d[1] = _mm_cvtps_pd(_mm_movehl_ps(x3x,x3x));
+
+	for (j=0; j < 2; j++) {
+	    /* (1. + x*((3. - x)*x-3.))/6. */
+	    a = _mm_mul_pd(_mm_sub_pd(three,xd[j]),xd[j]);
+	    a = _mm_mul_pd(xd[j],_mm_sub_pd(a,three));
+	    a = _mm_div_pd(_mm_add_pd(one,a),six);
+	    _mm_storel_pi((__m64*) (w[0]+2*j),_mm_cvtpd_ps(a));
+
+	    /* (4. + 3.*(x -2.)*x2)/6. */
+	    b = _mm_mul_pd(three,_mm_sub_pd(xd[j],two));
+	    b = _mm_div_pd(_mm_add_pd(four,_mm_mul_pd(b,x2d[j])),six);
+	    _mm_storel_pi((__m64*) (w[1]+2*j),_mm_cvtpd_ps(b));
+
+	    /* (1. + 3.*x*(1. + (1. - x)*x))/6. */
+	    c = _mm_add_pd(one,_mm_mul_pd(_mm_sub_pd(one,xd[j]),xd[j]));
+	    c = _mm_mul_pd(_mm_mul_pd(three,xd[j]),c);
+	    c = _mm_div_pd(_mm_add_pd(one,c),six);
+	    _mm_storel_pi((__m64*) (w[2]+2*j),_mm_cvtpd_ps(c));
+
+	    /* x2*x/6. */
+	    _mm_storel_pi((__m64*) (w[3]+2*j),
+			  _mm_cvtpd_ps(_mm_div_pd(x3d[j],six)));
+	}
+
+	for (j=0; j < 4; j++) {
+	    if (it[j] < 0 || it[j] >= n1) {
+		trace[i+j] = 0.;
+		continue;
+	    }
+	    s = spl+it[j];
+	    f = 0.;
+	    f += w[0][j]*s[0];
+	    f += w[1][j]*s[1];
+	    f += w[2][j]*s[2];
+	    f += w[3][j]*s[3];
+	    trace[i+j] = f;
+	}
+    }
+#endif
+
+    for (; i < n; i++) {
+	it[0] = floorf(t[i]);
+	if (it[0] < 0 || it[0] >= n1) {
+	    trace[i] = 0.;
+	    continue;
+	}
+	x = t[i]-it[0];
+	x2 = x*x;
+	w[0][0] = (1. + x*((3. - x)*x-3.))/6.;
+	w[1][0] = (4. + 3.*(x -2.)*x2)/6.;
+	w[2][0] = (1. + 3.*x*(1. + (1. - x)*x))/6.;
+	w[3][0] = x2*x/6.;
+
+	s = spl+it[0];
+	f = 0.;
+	f += w[0][0]*s[0];
+	f += w[1][0]*s[1];
+	f += w[2][0]*s[2];
+	f += w[3][0]*s[3];
+	trace[i] = f;
+    }
+}
+
+void fint1_stretch(fint1 str      /* interpolation object */, 
+		   int n1         /* old trace length */,
+		   int n2         /* new trace length */,
+		   const float *t /* old sample positions (in samples) [n2] */,
+		   float *trace   /* new trace [n2] */,
+		   float maxstr   /* maximum stretch */)
+/*< trace interpolation at precomputed positions, as in stretch >*/
+{
+    int i2, it, im, ip, i;
+    float tp;
+
+    spline4_many(n2,t,n1,str->spl+str->nw/2+1,trace);
+
+    /* mute where stretched too much, taper the edges */
+    tp = -1.;
+    ip = -1;
+    im = str->nt;
+
+    for (i2=0; i2 < n2; i2++) {
+	it = floorf(t[i2]);
+	if (it < 0 || it >= n1 || 
+	    (tp > 0. && fabsf(t[i2]-tp) < maxstr)) { /* too much stretch */
+	    trace[i2]=0.;
+	    if (ip < 0 || ip != i2-1) {
+		for (i=i2-1, im=0; i >=0 && im < str->nt; i--, im++) {
+		    trace[i] *= str->t[im];
+		}
+	    }
+	    ip = i2;
+	    im=0;
+	} else if (im < str->nt) {
+	    trace[i2] *= str->t[im];
+	    im++;
+	}
+	tp = t[i2];
+    }
+}
@@ -26,9 +26,9 @@
 #include "pshift.h"
 
 static float eps, *vt, *vz, *eta, dw, dz;
-static int nz, nw;
+static int nz, nw, nfft;
 static sf_complex *pp;
-static kiss_fftr_cfg forw, invs;
+static sf_fftr forw, invs;
 
 void gazdag_init (float eps1  /* regularization */, 
 		  int nt      /* time samples */, 
@@ -50,11 +50,12 @@ void gazdag_init (float eps1  /* regularization */,
     eta = eta1;
 
     /* determine frequency sampling */
+    nfft = nt;
     nw = nt/2+1;
     dw = 2.0*SF_PI/(nt*dt);
     
-    forw = kiss_fftr_alloc(nt,0,NULL,NULL);
-    invs = kiss_fftr_alloc(nt,1,NULL,NULL);
+    forw = sf_fftr_plan(nt,false);
+    invs = sf_fftr_plan(nt,true);
     
     /* allocate workspace */
     pp = sf_complexalloc (nw);
@@ -65,8 +66,6 @@ void gazdag_close ()
 /*< Free allocated storage >*/
 {    
     free (pp);  
-    free (forw);
-    free (invs);
 }
 
 void gazdag (bool inv  /* modeling (or migration) */,
@@ -98,9 +97,9 @@ void gazdag (bool inv  /* modeling (or migration) */,
             }
         }
 
-        kiss_fftri(invs,(const kiss_fft_cpx *) pp, p);
+        sf_fftri_many(invs,1,(const kiss_fft_cpx *) pp,nw,p,nfft);
     } else { /* migration */
-	kiss_fftr(forw, p, (kiss_fft_cpx *) pp);
+	sf_fftr_many(forw,1,p,nfft,(kiss_fft_cpx *) pp,nw);
     
         /* loop over migrated times z */
         for (iz=0; iz<nz-1; iz++) {
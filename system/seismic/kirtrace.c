@@ -0,0 +1,103 @@
+/* Kirchhoff modeling of one trace with its own stretch and filter state */
+/*
+  Copyright (C) 2026 University of Texas at Austin
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+#include <stdlib.h>
+
+#include <rsf.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "kirtrace.h"
+#include "ricker.h"
+
+#ifndef _kirtrace_h
+
+typedef struct Kirtrace {
+    int nt, nd;
+    float *time /* traveltime [nd] */;
+    float *delt /* antialiasing length [nd] */;
+    float *ampl /* amplitude [nd] */;
+    float *tmp  /* trace before filtering [nt] */;
+    sf_aastretch str;
+    sf_freqfilter flt;
+} *kirtrace;
+/* one per thread */
+/*^*/
+
+#endif
+
+kirtrace kirtrace_init(int nt, float t0, float dt /* time axis */,
+		       int nd /* number of reflector points */)
+/*< initialize (after ricker_init) >*/
+{
+    kirtrace kt;
+
+    kt = (kirtrace) sf_alloc(1,sizeof(*kt));
+    kt->nt = nt;
+    kt->nd = nd;
+
+    kt->time = sf_floatalloc(nd);
+    kt->delt = sf_floatalloc(nd);
+    kt->ampl = sf_floatalloc(nd);
+    kt->tmp  = sf_floatalloc(nt);
+
+    kt->str = sf_aastretch_init_r(false,nt,t0,dt,nd);
+    kt->flt = ricker_filter();
+
+    return kt;
+}
+
+void kirtrace_close(kirtrace kt)
+/*< free allocated storage >*/
+{
+    free(kt->time);
+    free(kt->delt);
+    free(kt->ampl);
+    free(kt->tmp);
+    sf_aastretch_close_r(kt->str);
+    sf_freqfilt_close_r(kt->flt);
+    free(kt);
+}
+
+void kirtrace_lop(kirtrace kt, bool adj, float *trace /* [nt] */)
+/*< forward: kt->ampl to trace, adjoint: trace to kt->ampl >*/
+{
+    sf_aastretch_define_r(kt->str,kt->time,kt->delt,NULL);
+
+    if (adj) {
+	/* correlate with Ricker wavelet */
+	sf_freqfilt_lop_r(kt->flt,true,false,kt->nt,kt->nt,kt->tmp,trace);
+	sf_aastretch_lop_r(kt->str,true,false,kt->nd,kt->nt,kt->ampl,kt->tmp);
+    } else {
+	sf_aastretch_lop_r(kt->str,false,false,kt->nd,kt->nt,kt->ampl,kt->tmp);
+	/* convolve with Ricker wavelet */
+	sf_freqfilt_lop_r(kt->flt,false,false,kt->nt,kt->nt,kt->tmp,trace);
+    }
+}
+
+int kirtrace_threads(void)
+/*< number of threads, one kirtrace each >*/
+{
+#ifdef _OPENMP
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
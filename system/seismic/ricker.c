@@ -23,6 +23,7 @@
 
 #include "ricker.h"
 
+static int nfft0, nw0;
 static kiss_fft_cpx *shape;
 
 void ricker_init(int nfft   /* time samples */, 
@@ -60,10 +61,24 @@ void ricker_init(int nfft   /* time samples */,
 	}
     }
 
+    nfft0 = nfft;
+    nw0 = nw;
+
     sf_freqfilt_init(nfft,nw);
     sf_freqfilt_cset(shape);
 }
 
+sf_freqfilter ricker_filter(void)
+/*< reentrant copy of the wavelet filter (after ricker_init) >*/
+{
+    sf_freqfilter ff;
+
+    ff = sf_freqfilt_init_r(nfft0,nw0);
+    sf_freqfilt_cset_r(ff,shape);
+
+    return ff;
+}
+
 void ricker_close(void) 
 /*< free allocated storage >*/
 {
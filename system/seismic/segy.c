@@ -23,6 +23,10 @@
 
 #include <rsf.h>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #include "segy.h"
 
 #ifndef _segy_h
@@ -331,6 +335,25 @@ static const segy standard_segy_key[] = {
 
 static segy segy_key[SF_MAXKEYS];
 
+/* header byte offsets, after remapping, for the first segy_nbyte keys */
+static int segy_byte[SF_MAXKEYS];
+static int segy_nbyte = 0;
+
+static void segy_offsets(int nkeys)
+/* find header offsets once, so that segy2head does not look up
+   parameters for every trace */
+{
+    int ik, byte, pos;
+
+    segy_nbyte = 0;
+    for (pos=ik=0; ik < nkeys; ik++) {
+	if (2 != segy_key[ik].size && 4 != segy_key[ik].size) break;
+	segy_byte[ik] = sf_getint(segy_key[ik].name,&byte)? byte: pos;
+	pos += segy_key[ik].size;
+	segy_nbyte++;
+    }
+}
+
 void segy_init(int nkeys, sf_file hdr)
 /*< initialize trace headers >*/
 {
@@ -385,6 +408,8 @@ void segy_init(int nkeys, sf_file hdr)
 	    strncpy((char*) segy_key[ik].desc,desc,namelen);
 	}
     }
+
+    segy_offsets(nkeys);
 }
 
 void other_init(int nkeys, sf_file hdr)
@@ -424,20 +449,20 @@ void other_init(int nkeys, sf_file hdr)
 	segy_key[ik].desc = sf_charalloc(namelen);
 	strncpy((char*) segy_key[ik].desc,desc,namelen);
     }
+
+    segy_offsets(nkeys);
 }
 
 
 /* Big-endian to Little-endian conversion and back */
 static int convert2(const char* buf);
 static int convert4(const char* buf);
-static float fconvert4(const char* buf);
 static void insert2(int y, char* buf);
 static void insert4(int y, char* buf);
 static void finsert4(float y, char* buf);
 static void swapb(byte *x, byte *y);
 
 /* IBM to IEEE float conversion and back */
-static float ibm2float (const char* num);
 static void float2ibm (float y, char* num);
 
 static void swapb(byte *x, byte *y) 
@@ -498,24 +523,6 @@ static int convert4(const char* buf)
     return x.s;
 }
 
-static float fconvert4(const char* buf)
-/* convert buf to 4-byte float */
-{
-    union {
-	byte b[4];
-	float s;
-    } x;
-
-    memcpy(x.b,buf,4);
-
-    if (little_endian) {
-	swapb(x.b,x.b+3);
-	swapb(x.b+1,x.b+2);
-    }
-
-    return x.s;
-}
-
 static void insert4(int y, char* buf)
 /* convert 4-byte int to buf */
 {
@@ -668,18 +675,15 @@ static void float2ibm (float y, char* num)
     insert4(s,num);
 }
 
-static float ibm2float (const char* num)
-/* floating point conversion from IBM format */
+static unsigned int ibm2ieee (unsigned int x)
+/* bit pattern of IEEE float from IBM float x, in host byte order */
 {
-    unsigned int x, s, f;
+    unsigned int s, f;
     const unsigned int fMAXIEEE = 0x7F7FFFFF;
     int e;         
-    float y;
                                                                      
-    x = convert4 (num);
-    
     /* check for special case of zero */
-    if ((x & 0x7fffffff) == 0) return 0.0; 
+    if ((x & 0x7fffffff) == 0) return 0; 
 
     /* fetch the sign, exponent (removing excess 64), and fraction */   
     s =   x & 0x80000000;                                               
@@ -714,8 +718,73 @@ static float ibm2float (const char* num)
 	s |= (e << 23) | f; 	    
     }    
 
-    memcpy (&y,&s,4);
-    return y;
+    return s;
+}
+
+static void load4 (const char* buf, float* trace, int ns)
+/* copy ns 4-byte words from buf to trace, in host byte order */
+{
+    if (little_endian) {
+	sf_byteswap4(buf,trace,ns);
+    } else {
+	memcpy(trace,buf,ns*4);
+    }
+}
+
+static void ibm2float_many (float* trace, int ns)
+/* in-place conversion of ns IBM floats in host byte order, 
+   bit for bit the same as ibm2float */
+{
+    int i;
+    unsigned int x;
+#ifdef __SSE2__
+    __m128i v, s, e, f, m, lz, z, ovf, pos, r;
+    const __m128i smask = _mm_set1_epi32((int) 0x80000000);
+    const __m128i amask = _mm_set1_epi32(0x7fffffff);
+    const __m128i fmask = _mm_set1_epi32(0x00ffffff);
+    const __m128i mmask = _mm_set1_epi32(0x007fffff);
+    const __m128i emask = _mm_set1_epi32(0x7f);
+    const __m128i fmax  = _mm_set1_epi32(0x7f7fffff);
+    const __m128i c150  = _mm_set1_epi32(150);
+    const __m128i c130  = _mm_set1_epi32(130);
+    const __m128i c254  = _mm_set1_epi32(254);
+    const __m128i zero  = _mm_setzero_si128();
+#endif
+
+    i = 0;
+#ifdef __SSE2__
+    /* Branch-free version of ibm2ieee. The fraction (< 2^24) converts
+       exactly to float, which normalizes it: the float exponent gives
+       the shift count and the float mantissa the shifted fraction. */
+    for (; i+4 <= ns; i += 4) {
+	v = _mm_loadu_si128((const __m128i*) (trace+i));
+	s = _mm_and_si128(v,smask);
+	f = _mm_and_si128(v,fmask);
+	m = _mm_castps_si128(_mm_cvtepi32_ps(f));
+	/* shift count, 0 for zero fraction */
+	lz = _mm_andnot_si128(_mm_cmpeq_epi32(f,zero),
+			      _mm_sub_epi32(c150,_mm_srli_epi32(m,23)));
+	m = _mm_and_si128(m,mmask);
+	/* 4*(e-64) - 1 - lz + 127 */
+	e = _mm_and_si128(_mm_srli_epi32(v,24),emask);
+	e = _mm_sub_epi32(_mm_sub_epi32(_mm_slli_epi32(e,2),c130),lz);
+	ovf = _mm_cmpgt_epi32(e,c254);
+	pos = _mm_andnot_si128(ovf,_mm_cmpgt_epi32(e,zero));
+	r = _mm_or_si128(_mm_and_si128(ovf,fmax),
+			 _mm_and_si128(pos,_mm_or_si128(_mm_slli_epi32(e,23),m)));
+	r = _mm_or_si128(s,r);
+	/* zero, including negative zero */
+	z = _mm_cmpeq_epi32(_mm_and_si128(v,amask),zero);
+	r = _mm_andnot_si128(z,r);
+	_mm_storeu_si128((__m128i*) (trace+i),r);
+    }
+#endif
+
+    for (; i < ns; i++) {
+	memcpy(&x,trace+i,4);
+	x = ibm2ieee(x);
+	memcpy(trace+i,&x,4);
+    }
 }
 
 void segy2trace(const char* buf, float* trace, int ns, int format)
@@ -724,18 +793,31 @@ void segy2trace(const char* buf, float* trace, int ns, int format)
 format: 1: IBM, 2: int4, 3: int2, 5: IEEE
 >*/
 {
-    int i, nb;
-
-    nb = (3==format)? 2:4;
-
-    for (i=0; i < ns; i++, buf += nb) {
-	switch (format) {
-	    case 1: trace[i] = ibm2float (buf);       break; /* IBM float */
-	    case 2: trace[i] = (float) convert4(buf); break; /* int4 */
-	    case 3: trace[i] = (float) convert2(buf); break; /* int2 */
-	    case 5: trace[i] = fconvert4(buf);        break; /* IEEE float */
-	    default: sf_error("Unknown format %d",format); break;
-	}
+    int i, k;
+
+    switch (format) {
+	case 1: /* IBM float */
+	    load4(buf,trace,ns);
+	    ibm2float_many(trace,ns);
+	    break;
+	case 2: /* int4 */
+	    load4(buf,trace,ns);
+	    for (i=0; i < ns; i++) {
+		memcpy(&k,trace+i,4);
+		trace[i] = (float) k;
+	    }
+	    break;
+	case 3: /* int2 */
+	    for (i=0; i < ns; i++, buf += 2) {
+		trace[i] = (float) convert2(buf);
+	    }
+	    break;
+	case 5: /* IEEE float */
+	    load4(buf,trace,ns);
+	    break;
+	default: 
+	    if (ns > 0) sf_error("Unknown format %d",format); 
+	    break;
     }
 }
 
@@ -786,6 +868,14 @@ void segy2head(const char* buf, int* trace, int nk)
     int i, byte;
     const char *buf0, *bufi;
 
+    if (nk <= segy_nbyte) { /* offsets known */
+	for (i=0; i < nk; i++) {
+	    bufi = buf+segy_byte[i];
+	    trace[i] = (2 == segy_key[i].size)? convert2(bufi): convert4(bufi);
+	}
+	return;
+    }
+
     buf0 = buf;
     for (i=0; i < nk; i++) {
 	/* allow to remap header keys */
@@ -21,10 +21,10 @@
 #include "fint1.h"
 
 static int nt, nx, n2, n3, nw;
-static float dt, dx, t0, *strace, o2, d2, dw;
-static sf_complex *ctrace;
+static float dt, dx, t0, **strace, o2, d2, dw;
+static sf_complex **ctrace;
 static fint1 str, istr;
-static kiss_fftr_cfg forw, invs;
+static sf_fftr forw, invs;
 
 
 void velcon_init(int nt1   /* time samples */,
@@ -55,10 +55,8 @@ void velcon_init(int nt1   /* time samples */,
     istr = fint1_init(next,n2,0);
 
     /* FFT in time */
-    forw = kiss_fftr_alloc(n3,0,NULL,NULL);
-    invs = kiss_fftr_alloc(n3,1,NULL,NULL);
-    if (NULL == forw || NULL == invs) 
-	sf_error("KISS FFT allocation error");
+    forw = sf_fftr_plan(n3,false);
+    invs = sf_fftr_plan(n3,true);
 
     nw = n3/2+1;
     dw = 2*SF_PI/(n3*d2);
@@ -67,18 +65,19 @@ void velcon_init(int nt1   /* time samples */,
     sf_cosft_init(nx);
     dx = SF_PI/(kiss_fft_next_fast_size(nx-1)*dx1);
 
-    strace = sf_floatalloc(n3);
-    ctrace = sf_complexalloc(nw);
+    /* all traces, transformed together */
+    strace = sf_floatalloc2(n3,nx);
+    ctrace = sf_complexalloc2(nw,nx);
 }
 
 void velcon_close(void)
 /*< free allocated storage >*/
 {
+    free(*ctrace);
     free(ctrace);
+    free(*strace);
     free(strace);
     sf_cosft_close();
-    free(invs);
-    free(forw);
     fint1_close(istr);
     fint1_close(str);
 }
@@ -97,10 +96,6 @@ void velcon(float ** data /* [nx][nt] */,
     }
 
     for (ix=0; ix < nx; ix++) {
-	/* loop over wavenumbers */
-	k = ix*dx;
-	k *= k*(v0*v0 - v1*v1)/16;
-
 	trace = data[ix];
 
 	/* stretch t -> t^2 */
@@ -117,23 +112,29 @@ void velcon(float ** data /* [nx][nt] */,
 	    t = (t-t0)/dt;
 	    it = t;
 	    if (it >= 0 && it < nt) {
-		strace[i2] = fint1_apply(str,it,t-it,false);
+		strace[ix][i2] = fint1_apply(str,it,t-it,false);
 	    } else {
-		strace[i2] = 0.;
+		strace[ix][i2] = 0.;
 	    }
 	}
 
 	for (i2=n2; i2 < n3; i2++) {
-	    strace[i2] = 0.;
+	    strace[ix][i2] = 0.;
 	}
+    }
+
+    /* FFT */
 
-	/* FFT */
+    sf_fftr_many(forw,nx,strace[0],n3,(kiss_fft_cpx *) ctrace[0],nw);
 
-	kiss_fftr(forw,strace, (kiss_fft_cpx *) ctrace);
+    for (ix=0; ix < nx; ix++) {
+	/* loop over wavenumbers */
+	k = ix*dx;
+	k *= k*(v0*v0 - v1*v1)/16;
 
 	/* velocity continuation */
 
-	ctrace[0]=sf_cmplx(0.,0.); /* dc */
+	ctrace[ix][0]=sf_cmplx(0.,0.); /* dc */
 
 	for (iw=1; iw < nw; iw++) {
 	    w = iw*dw;
@@ -141,19 +142,23 @@ void velcon(float ** data /* [nx][nt] */,
 	    shift = sf_cmplx(cosf(w)/n3,sinf(w)/n3);
 
 #ifdef SF_HAS_COMPLEX_H
-	    ctrace[iw] *= shift;
+	    ctrace[ix][iw] *= shift;
 #else
-	    ctrace[iw] = sf_cmul(ctrace[iw],shift);
+	    ctrace[ix][iw] = sf_cmul(ctrace[ix][iw],shift);
 #endif
 	}
+    }
 
-	/* Inverse FFT */
+    /* Inverse FFT */
 
-	kiss_fftri(invs,(const kiss_fft_cpx *) ctrace, strace);
+    sf_fftri_many(invs,nx,(const kiss_fft_cpx *) ctrace[0],nw,strace[0],n3);
+
+    for (ix=0; ix < nx; ix++) {
+	trace = data[ix];
 
 	/* inverse stretch t^2->t */
 
-	fint1_set(istr,strace);
+	fint1_set(istr,strace[ix]);
 
 	for (it=0; it < nt; it++) {
 	    t = t0+it*dt;
@@ -32,6 +32,14 @@ void acd_timestep(std::vector<RDOM *> dom,
 		  int iv, 
 		  void* fdpars);
 
+bool acd_partstep(std::vector<RDOM *> dom, 
+		  bool fwd, 
+		  int iv, 
+		  void* fdpars,
+		  int part,
+		  IPNT wl,
+		  IPNT wr);
+
 int acd_create_sten(void *, 
 		    FILE *, 
 		    int, 
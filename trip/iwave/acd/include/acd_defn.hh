@@ -16,6 +16,7 @@ FIELD IWaveInfo::iwave_fields[]
 FD_MODELINIT IWaveInfo::minit = acd_modelinit;
 FD_MODELDEST IWaveInfo::mdest = acd_modeldest;
 FD_TIMESTEP IWaveInfo::timestep = acd_timestep;
+FD_PARTSTEP IWaveInfo::partstep = acd_partstep;
 FD_TIMEGRID IWaveInfo::timegrid = acd_timegrid;
 FD_STENCIL IWaveInfo::createstencil = acd_create_sten;
 FD_CHECK IWaveInfo::check = acd_check;
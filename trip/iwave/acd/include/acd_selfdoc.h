@@ -84,12 +84,31 @@ const char * sdoc[] = {
   "                              adjoint=1, otherwise ignored",
   " ",
   " ------------------------------------------------------------------------",
+  " Checkpoint info (adjoint only):",
+  " ",
+  "         nsnaps = <int>       number of reference field checkpoints",
+  "         cpcomp = 0           checkpoint compression - 0 (none), ",
+  "                              1 (lossless), 2 (lossy)",
+  "          cptol = 1.e-5       lossy error bound, relative to max ",
+  "                              absolute value of each field",
+  "          cpmem = 0           memory for checkpoints (MB), 0 = unlimited;",
+  "                              checkpoints beyond it are written to disk",
+  "          cpdir = $DATAPATH   directory for checkpoint scratch file",
+  " ",
+  " ------------------------------------------------------------------------",
   " MPI info:",
   " ",
   "        mpi_np1 = 1           number of subdomains along axis 1",
   "        mpi_np2 = 1           number of subdomains along axis 2",
   "        mpi_np3 = 1           number of subdomains along axis 3",
   "        partask = 1           number of shots to execute in parallel",
+  "       dynsched = 0           1 = each group of processes pulls the next",
+  "                              shot when done, 0 = fixed blocks of shots.",
+  "                              with 1, stacked outputs (gradients, migrated",
+  "                              images) may differ in the last bits between",
+  "                              runs, as shots are stacked in timing order",
+  "        overlap = 0           1 = overlap subdomain boundary exchange",
+  "                              with interior update (forward only)",
   " ",
   " ------------------------------------------------------------------------",
   " Output info:",
@@ -45,7 +45,7 @@ void acd_3d_4(float *** uc,
     for (i1=s[1];i1<=e[1];i1++) {
 #pragma ivdep
       for (i0=s0;i0<=e0;i0++) {
-	up[e[2]+2][i1][i0]=-up[e[2]][i2][i0];
+	up[e[2]+2][i1][i0]=-up[e[2]][i1][i0];
       }
     }
   }
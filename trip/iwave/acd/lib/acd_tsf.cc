@@ -2,6 +2,7 @@
 
 // defined in fd_acd.cc
 int acd_step(RDOM *, int, void*);
+int acd_part(RDOM *, int, IPNT, IPNT, void*);
 
 // interface to IWaveSim::run() 
 void acd_timestep(std::vector<RDOM *> iw, bool fwd, int iv, void *fdpars){
@@ -54,3 +55,17 @@ void acd_timestep(std::vector<RDOM *> iw, bool fwd, int iv, void *fdpars){
   }
 }
 
+
+// split step for exchange overlap - reference simulation only
+bool acd_partstep(std::vector<RDOM *> iw, bool fwd, int iv, void *fdpars,
+		  int part, IPNT wl, IPNT wr) {
+  if (iw.size() != 1 || !fwd || iv != 0) return false;
+  int err = acd_part(iw[0], part, wl, wr, fdpars);
+  if (err < 0) return false;
+  if (err > 0) {
+    RVLException e;
+    e<<"Error: acd_partstep(). acd_part returned error "<<err<<"\n";
+    throw e;
+  }
+  return true;
+}
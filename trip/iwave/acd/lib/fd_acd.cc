@@ -455,44 +455,27 @@ int acd_timegrid(PARARRAY *pars,
     return 0;
 }
 
-int acd_step(RDOM* dom, int iv, void * tspars) {
-
-    /* pointers for 2D case */
-    ireal ** restrict uc2;
-    ireal ** restrict up2;
-    ireal ** restrict csq2;
-    /* pointers for 3D case */
-    ireal *** restrict uc3;
-    ireal *** restrict up3;
-    ireal *** restrict csq3;
-    int ndim;                       /* problem dmn */
-    IPNT s, s0;                     /* loop starts  */
-    IPNT e, e0;                     /* loop ends */
-
-    ireal tmp;
-    IPNT i;
-
-    /* acd struct */
-    ACD_TS_PARS * acdpars = (ACD_TS_PARS *)tspars;
+/*----------------------------------------------------------------------------*/
+/* update up on the part of the grid between s and e, applying the boundary
+   conditions flagged in lbc and rbc */
+static int acd_kernel(RDOM * dom, 
+		      ACD_TS_PARS * acdpars, 
+		      int ndim, 
+		      int * s, 
+		      int * e, 
+		      int * lbc, 
+		      int * rbc) {
 
-    /* extract dimn info */
-    ra_ndim(&(dom->_s[D_UC]),&ndim);
-    ra_gse(&(dom->_s[D_UC]),s,e);
-    ra_a_gse(&(dom->_s[D_UC]),s0,e0);
     if (ndim == 2) {
 
-
 	/* 2D computational arrays */
-	uc2   = (dom->_s)[D_UC ]._s2;
-	up2   = (dom->_s)[D_UP ]._s2;
-	csq2  = (dom->_s)[D_CSQ]._s2;
+	ireal ** restrict uc2  = (dom->_s)[D_UC ]._s2;
+	ireal ** restrict up2  = (dom->_s)[D_UP ]._s2;
+	ireal ** restrict csq2 = (dom->_s)[D_CSQ]._s2;
 
 	/* 2nd order case */
 	if (acdpars->k == 1) {
-	  //	    acd_2d_2(uc2, up2, csq2, 
-	  acd_2d_2((dom->_s)[D_UC ]._s2,
-		   (dom->_s)[D_UP ]._s2,
-		   (dom->_s)[D_CSQ]._s2,
+	    acd_2d_2(uc2, up2, csq2, 
 		     s, e,
 		     acdpars->c0, 
 		     acdpars->c1);
@@ -503,7 +486,7 @@ int acd_step(RDOM* dom, int iv, void * tspars) {
 		     s, e, 
 		     acdpars->c0, 
 		     acdpars->c1, acdpars->c2,
-		     acdpars->lbc, acdpars->rbc);
+		     lbc, rbc);
 	}
 	/* 8th order case */
 	else if (acdpars->k == 4) {
@@ -512,30 +495,19 @@ int acd_step(RDOM* dom, int iv, void * tspars) {
 		     acdpars->c0, 
 		     acdpars->c1, acdpars->c2,
 		     acdpars->c3, acdpars->c4,
-		     acdpars->lbc, acdpars->rbc);
+		     lbc, rbc);
 	}
 	else {
 	    fprintf(stderr,"ERROR: acd_step\n");
 	    fprintf(stderr,"called with half-order != 1, 2, 4\n");
 	    return E_BADINPUT;
 	}
-
-	int s00=s0[0]; int e00=e0[0];
-	for (i[1]=s0[1];i[1]<=e0[1];i[1]++) {
-#pragma ivdep
-	    for (i[0]=s00;i[0]<=e00;i[0]++) {
-		tmp=((dom->_s)[D_UC]._s2)[i[1]][i[0]];
-		((dom->_s)[D_UC]._s2)[i[1]][i[0]]=((dom->_s)[D_UP]._s2)[i[1]][i[0]];
-		((dom->_s)[D_UP]._s2)[i[1]][i[0]]=tmp;
-	    }
-	}
-
     }
     else if (ndim == 3) {
     
-	uc3   = (dom->_s)[D_UC ]._s3;
-	up3   = (dom->_s)[D_UP ]._s3;
-	csq3  = (dom->_s)[D_CSQ]._s3;
+	ireal *** restrict uc3  = (dom->_s)[D_UC ]._s3;
+	ireal *** restrict up3  = (dom->_s)[D_UP ]._s3;
+	ireal *** restrict csq3 = (dom->_s)[D_CSQ]._s3;
 
 	/* 2nd order case */
 	if (acdpars->k == 1) {
@@ -550,7 +522,7 @@ int acd_step(RDOM* dom, int iv, void * tspars) {
 		     s, e, 
 		     acdpars->c0, 
 		     acdpars->c1, acdpars->c2,
-		     acdpars->lbc, acdpars->rbc);
+		     lbc, rbc);
 	}
 	/* 8th order case */
 	else if (acdpars->k == 4) {
@@ -559,17 +531,47 @@ int acd_step(RDOM* dom, int iv, void * tspars) {
 		     acdpars->c0, 
 		     acdpars->c1, acdpars->c2,
 		     acdpars->c3, acdpars->c4,
-		     acdpars->lbc, acdpars->rbc);
+		     lbc, rbc);
 	}
 	else {
 	    fprintf(stderr,"ERROR: acd_step\n");
 	    fprintf(stderr,"called with half-order != 1, 2, 4\n");
 	    return E_BADINPUT;
 	}
+    }
+    else {
+	fprintf(stderr,"ERROR: acd_step\n");
+	fprintf(stderr,"called with space dim != 2 or 3\n");
+	return E_BADINPUT;
+    }
+    return 0;
+}
 
-	for (i[2]=s0[2];i[2]<=e0[2];i[2]++) {
-	    for (i[1]=s0[1];i[1]<=e0[1];i[1]++) {
-		for (i[0]=s0[0];i[0]<=e0[0];i[0]++) {
+/*----------------------------------------------------------------------------*/
+/* exchange uc and up on the box [s,e] */
+static void acd_swap(RDOM * dom, 
+		     int ndim, 
+		     IPNT s, 
+		     IPNT e) {
+
+    ireal tmp;
+    IPNT i;
+
+    if (ndim == 2) {
+	int s00=s[0]; int e00=e[0];
+	for (i[1]=s[1];i[1]<=e[1];i[1]++) {
+#pragma ivdep
+	    for (i[0]=s00;i[0]<=e00;i[0]++) {
+		tmp=((dom->_s)[D_UC]._s2)[i[1]][i[0]];
+		((dom->_s)[D_UC]._s2)[i[1]][i[0]]=((dom->_s)[D_UP]._s2)[i[1]][i[0]];
+		((dom->_s)[D_UP]._s2)[i[1]][i[0]]=tmp;
+	    }
+	}
+    }
+    else {
+	for (i[2]=s[2];i[2]<=e[2];i[2]++) {
+	    for (i[1]=s[1];i[1]<=e[1];i[1]++) {
+		for (i[0]=s[0];i[0]<=e[0];i[0]++) {
 		    tmp=((dom->_s)[D_UC]._s3)[i[2]][i[1]][i[0]];
 		    ((dom->_s)[D_UC]._s3)[i[2]][i[1]][i[0]]=((dom->_s)[D_UP]._s3)[i[2]][i[1]][i[0]];
 		    ((dom->_s)[D_UP]._s3)[i[2]][i[1]][i[0]]=tmp;
@@ -577,11 +579,160 @@ int acd_step(RDOM* dom, int iv, void * tspars) {
 	    }
 	}
     }
+}
+
+/*----------------------------------------------------------------------------*/
+/* cut the part of the box [s,e] outside [s+l,e-r] into at most 2*ndim 
+   boxes [bs[i],be[i]], slowest axis first; returns the number of boxes */
+static int acd_frame(int ndim, 
+		     IPNT s, 
+		     IPNT e, 
+		     IPNT l, 
+		     IPNT r, 
+		     IPNT bs[], 
+		     IPNT be[]) {
+
+    int n = 0;
+    int d;
+    IPNT a, b;
+
+    IASN(a,s);
+    IASN(b,e);
+    for (d=ndim-1; d>=0; d--) {
+	if (l[d] > 0) {
+	    IASN(bs[n],a);
+	    IASN(be[n],b);
+	    be[n][d] = a[d]+l[d]-1;
+	    a[d] += l[d];
+	    n++;
+	}
+	if (r[d] > 0) {
+	    IASN(bs[n],a);
+	    IASN(be[n],b);
+	    bs[n][d] = b[d]-r[d]+1;
+	    b[d] -= r[d];
+	    n++;
+	}
+    }
+    return n;
+}
+
+/* update the box [bs,be] of the computational domain [s,e], with the 
+   boundary conditions of the faces it shares with the domain */
+static int acd_box(RDOM * dom, 
+		   ACD_TS_PARS * acdpars, 
+		   int ndim, 
+		   IPNT s, 
+		   IPNT e, 
+		   IPNT bs, 
+		   IPNT be) {
+
+    IPNT lbc, rbc;
+    int d;
+
+    IASN(lbc,IPNT_0);
+    IASN(rbc,IPNT_0);
+    for (d=0; d<ndim; d++) {
+	if (bs[d] == s[d]) lbc[d] = acdpars->lbc[d];
+	if (be[d] == e[d]) rbc[d] = acdpars->rbc[d];
+    }
+    return acd_kernel(dom,acdpars,ndim,bs,be,lbc,rbc);
+}
+
+/* split variant of the time step, for overlap of the ghost exchange with
+   computation. Part 0 updates strips of the computational domain next to
+   the faces with send areas (widths wl, wr), thick enough that the rest
+   of the domain reads uc only inside them, and swaps the send areas and
+   the ghost cells on faces shared with other subdomains, so the new uc
+   can be sent and the receives, posted next, land on swapped arrays as
+   in acd_step. Part 1 updates the interior and swaps the rest of the 
+   domain.
+
+   Returns -1 if the step cannot be split: the interior must be at least
+   2k thick for the boundary conditions, and acd_3d_8 cannot be cut into 
+   boxes, as it finishes each plane in a second pass that reads up on 
+   the neighbouring planes after the first pass. */
+int acd_part(RDOM * dom, int part, IPNT wl, IPNT wr, void * tspars) {
+
+    int ndim;                       /* problem dmn */
+    IPNT s, s0;                     /* loop starts  */
+    IPNT e, e0;                     /* loop ends */
+    IPNT bl, br;                    /* strip widths */
+    IPNT xs, xe;                    /* part 1 swap, less wl, wr */
+    IPNT fl, fr;                    /* part 0 swap widths */
+    IPNT bs[2*RARR_MAX_NDIM];       /* strips */
+    IPNT be[2*RARR_MAX_NDIM];
+    int n, i, d, k, err;
+
+    /* acd struct */
+    ACD_TS_PARS * acdpars = (ACD_TS_PARS *)tspars;
+
+    /* extract dimn info */
+    ra_ndim(&(dom->_s[D_UC]),&ndim);
+    ra_gse(&(dom->_s[D_UC]),s,e);
+    ra_a_gse(&(dom->_s[D_UC]),s0,e0);
+    k = acdpars->k;
+
+    if (ndim == 3 && k == 4) return -1;
+
+    IASN(bl,IPNT_0);
+    IASN(br,IPNT_0);
+    for (d=0; d<ndim; d++) {
+	if (wl[d] > 0) bl[d] = iwave_max(wl[d]+k,2*k);
+	if (wr[d] > 0) br[d] = iwave_max(wr[d]+k,2*k);
+	if (e[d]-s[d]+1-bl[d]-br[d] < 2*k) return -1;
+    }
+
+    /* allocated domain less ghost cells on shared faces */
+    for (d=0; d<ndim; d++) {
+	xs[d] = (wl[d] > 0) ? s[d] : s0[d];
+	xe[d] = (wr[d] > 0) ? e[d] : e0[d];
+	fl[d] = xs[d]-s0[d]+wl[d];
+	fr[d] = e0[d]-xe[d]+wr[d];
+    }
+
+    if (part == 0) {
+	n = acd_frame(ndim,s,e,bl,br,bs,be);
+	for (i=0; i<n; i++) 
+	    if ((err=acd_box(dom,acdpars,ndim,s,e,bs[i],be[i]))) return err;
+	n = acd_frame(ndim,s0,e0,fl,fr,bs,be);
+	for (i=0; i<n; i++) acd_swap(dom,ndim,bs[i],be[i]);
+    }
     else {
-	fprintf(stderr,"ERROR: acd_step\n");
-	fprintf(stderr,"called with space dim != 2 or 3\n");
-	return E_BADINPUT;
+	for (d=0; d<ndim; d++) {
+	    bs[0][d] = s[d]+bl[d];
+	    be[0][d] = e[d]-br[d];
+	}
+	if ((err=acd_box(dom,acdpars,ndim,s,e,bs[0],be[0]))) return err;
+	for (d=0; d<ndim; d++) {
+	    bs[0][d] = xs[d]+wl[d];
+	    be[0][d] = xe[d]-wr[d];
+	}
+	acd_swap(dom,ndim,bs[0],be[0]);
     }
+
+    return 0;
+}
+
+int acd_step(RDOM* dom, int iv, void * tspars) {
+
+    int ndim;                       /* problem dmn */
+    IPNT s, s0;                     /* loop starts  */
+    IPNT e, e0;                     /* loop ends */
+    int err;
+
+    /* acd struct */
+    ACD_TS_PARS * acdpars = (ACD_TS_PARS *)tspars;
+
+    /* extract dimn info */
+    ra_ndim(&(dom->_s[D_UC]),&ndim);
+    ra_gse(&(dom->_s[D_UC]),s,e);
+    ra_a_gse(&(dom->_s[D_UC]),s0,e0);
+
+    if ((err=acd_kernel(dom,acdpars,ndim,s,e,acdpars->lbc,acdpars->rbc))) 
+	return err;
+
+    acd_swap(dom,ndim,s0,e0);
   
     return 0;
 }
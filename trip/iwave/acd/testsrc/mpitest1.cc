@@ -0,0 +1,183 @@
+#include "acd_defn.hh"
+#include "istate.hh"
+
+using RVL::RVLException;
+using TSOpt::IWaveEnvironment;
+using TSOpt::IWaveSim;
+
+int xargc;
+char ** xargv;
+
+/* forward acd with the subdomain ghost exchange overlapped with the
+   interior update (overlap=1) must give wavefields identical to the
+   blocking exchange (overlap=0). Run under mpirun -np 2 or 4: the
+   domain is split in two along axis 2, or in four along axes 1 and 2 */
+
+IOKEY IWaveInfo::iwave_iokeys[]
+= {
+  {"csq",    0, true,  true },
+  {"init",   1, true,  false},
+  {"movie",  1, false, false},
+  {"",       0, false, false}
+};
+
+#define N 41
+#define NT 6
+
+static void writersf(char const * name, int dim, int nt, bool init) {
+  char hname[64], dname[64];
+  int n[3]={N,N,1};
+  int i, ntot=1;
+  if (dim>2) n[2]=N;
+  for (i=0;i<dim;i++) ntot *= n[i];
+  snprintf(hname,64,"%s.rsf",name);
+  snprintf(dname,64,"%s.rsf@",name);
+
+  FILE * fp = fopen(hname,"w");
+  for (i=0;i<dim;i++)
+    fprintf(fp,"n%d=%d d%d=10 o%d=0 id%d=%d\n",i+1,n[i],i+1,i+1,i+1,i);
+  if (nt) {
+    fprintf(fp,"n%d=%d d%d=%d o%d=0 id%d=%d dim=%d gdim=%d\n",
+	    dim+1,nt,dim+1,(nt>1) ? 20 : 1,dim+1,dim+1,dim,dim,dim+1);
+    ntot *= nt;
+  }
+  fprintf(fp,"data_format=native_float esize=4 in=%s\n",dname);
+  fclose(fp);
+
+  /* csq increases with depth, init is a Gaussian bump off the
+     center, so waves cross every subdomain boundary; the movie
+     is written by the simulation */
+  float * a = new float[ntot];
+  int i0, i1, i2, k=0;
+  for (i2=0;i2<n[2];i2++) {
+    for (i1=0;i1<n[1];i1++) {
+      for (i0=0;i0<n[0];i0++,k++) {
+	float r2 = (i0-18)*(i0-18)+(i1-22)*(i1-22);
+	if (dim>2) r2 += (i2-19)*(i2-19);
+	if (nt==0) a[k] = 3.0f+2.0f*i0/N;
+	else if (init) a[k] = exp(-r2/8.0f);
+	else a[k] = 0.0f;
+      }
+    }
+  }
+  for (;k<ntot;k++) a[k]=0.0f;
+  fp = fopen(dname,"w");
+  fwrite(a,sizeof(float),ntot,fp);
+  fclose(fp);
+  delete [] a;
+}
+
+int main(int argc, char ** argv) {
+
+  int rk=0;
+  int sz=1;
+
+  try {
+
+#ifdef IWAVE_USE_MPI
+    int ts=0;
+    MPI_Init_thread(&argc,&argv,MPI_THREAD_FUNNELED,&ts);
+    MPI_Comm_rank(MPI_COMM_WORLD,&rk);
+    MPI_Comm_size(MPI_COMM_WORLD,&sz);
+#endif
+
+    if (rk==0) {
+      cout<<"ACD Overlap Regression Test 1"<<endl;
+      cout<<"forward acd in 2D (order 1, 2, 4) and 3D (order 1, 2),"<<endl;
+      cout<<"domain split over all ranks, overlap=0 versus overlap=1"<<endl;
+      writersf("csq2",2,0,false);
+      writersf("init2",2,1,true);
+      writersf("movie2",2,NT,false);
+      writersf("csq3",3,0,false);
+      writersf("init3",3,1,true);
+      writersf("movie3",3,NT,false);
+    }
+#ifdef IWAVE_USE_MPI
+    MPI_Barrier(MPI_COMM_WORLD);
+#endif
+
+    /* split axes 1 and 2: 1 x sz, or 2 x 2 for sz=4 */
+    char np1[16], np2[16];
+    snprintf(np1,16,"mpi_np1=%d",(sz==4) ? 2 : 1);
+    snprintf(np2,16,"mpi_np2=%d",(sz==4) ? 2 : sz);
+    PARARRAY * par = NULL;
+    FILE * stream = NULL;
+    char * args[] = {argv[0], np1, np2, (char *)"cfl=0.5", 
+		     (char *)"cmin=1.0", (char *)"cmax=3.0", 
+		     (char *)"sampord=1"};
+    IWaveEnvironment(7,args,0,&par,&stream);
+
+    int orders[2][3] = {{1,2,4},{1,2,0}};
+    for (int dim=2; dim<4; dim++) {
+      char key[16];
+      snprintf(key,16,"csq%d.rsf",dim);
+      ps_slcstring(*par,"csq",key);
+      snprintf(key,16,"init%d.rsf",dim);
+      ps_slcstring(*par,"init",key);
+      snprintf(key,16,"movie%d.rsf",dim);
+      ps_slcstring(*par,"movie",key);
+
+      for (int io=0; io<3 && orders[dim-2][io]; io++) {
+	ps_slint(*par,"order",orders[dim-2][io]);
+
+	std::vector<ireal> ref;
+	int ndiff=0;
+	float umax=0.0f;
+	for (int ov=0; ov<2; ov++) {
+	  ps_slint(*par,"overlap",ov);
+	  IWaveInfo ic;
+	  /* rank banners come in any order - keep them out of the report */
+	  std::ostringstream ann;
+	  IWaveSim sim(0,true,*par,stream,ic,0,0,false,cerr,ann);
+	  sim.run();
+
+	  /* all dynamic arrays on this rank, ghost cells included */
+	  IMODEL & m = sim.getStateArray()[0]->model;
+	  size_t k=0;
+	  for (int ia=0; ia<RDOM_MAX_NARR; ia++) {
+	    if (!(fd_isarr(ia,m,ic) && fd_isdyn(ia,ic))) continue;
+	    size_t n=0;
+	    ra_a_datasize(&(m.ld_a._s[ia]),&n);
+	    ireal * u = m.ld_a._s[ia]._s0;
+	    for (size_t j=0; j<n; j++, k++) {
+	      if (ov==0) {
+		ref.push_back(u[j]);
+		umax = iwave_max(umax,fabs(u[j]));
+	      }
+	      else if (k>=ref.size() ||
+		       memcmp(&(ref[k]),&(u[j]),sizeof(ireal))) ndiff++;
+	    }
+	  }
+	}
+
+#ifdef IWAVE_USE_MPI
+	int itmp=ndiff;
+	MPI_Reduce(&itmp,&ndiff,1,MPI_INT,MPI_SUM,0,MPI_COMM_WORLD);
+	float ftmp=umax;
+	MPI_Reduce(&ftmp,&umax,1,MPI_FLOAT,MPI_MAX,0,MPI_COMM_WORLD);
+#endif
+	if (rk==0) {
+	  cout<<dim<<"D order="<<orders[dim-2][io]
+	      <<": wavefield nonzero = "<<((umax>0.0f) ? "yes" : "no")
+	      <<", overlap identical = "<<((ndiff==0) ? "yes" : "no")<<endl;
+	}
+      }
+    }
+
+    ps_delete(&par);
+    fclose(stream);
+
+#ifdef IWAVE_USE_MPI
+    MPI_Finalize();
+#endif
+
+    return(0);
+  }
+  catch (RVLException & e) {
+    e.write(cerr);
+#ifdef IWAVE_USE_MPI
+    MPI_Abort(MPI_COMM_WORLD,0);
+#endif
+    exit(1);
+  }
+}
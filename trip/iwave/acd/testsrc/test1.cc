@@ -0,0 +1,165 @@
+#include "acd_defn.hh"
+#include "istate.hh"
+
+using RVL::RVLException;
+using TSOpt::IWaveEnvironment;
+using TSOpt::IWaveSim;
+
+int xargc;
+char ** xargv;
+
+/* adjoint first derivative of acd (csq_b1) with the reference field
+   recomputed from Revolve checkpoints: storing the checkpoints with
+   lossless compression (cpcomp=1), also spilled to disk (small
+   cpmem), must give output identical to uncompressed checkpoints
+   (cpcomp=0) */
+
+IOKEY IWaveInfo::iwave_iokeys[]
+= {
+  {"csq",    0, true,  true },
+  {"init",   1, true,  false},
+  {"movie",  1, false, true },
+  {"",       0, false, false}
+};
+
+#define N 41
+#define NT 11
+
+/* nt=0: csq (val=1) or csq_b1 (val=0), nt=1: init, nt>1: movie */
+static void writersf(char const * name, int dim, int nt, float val) {
+  char hname[64], dname[64];
+  int n[3]={N,N,1};
+  int i, ntot=1;
+  if (dim>2) n[2]=N;
+  for (i=0;i<dim;i++) ntot *= n[i];
+  snprintf(hname,64,"%s.rsf",name);
+  snprintf(dname,64,"%s.rsf@",name);
+
+  FILE * fp = fopen(hname,"w");
+  for (i=0;i<dim;i++)
+    fprintf(fp,"n%d=%d d%d=10 o%d=0 id%d=%d\n",i+1,n[i],i+1,i+1,i+1,i);
+  if (nt) {
+    fprintf(fp,"n%d=%d d%d=%d o%d=0 id%d=%d dim=%d gdim=%d\n",
+	    dim+1,nt,dim+1,(nt>1) ? 20 : 1,dim+1,dim+1,dim,dim,dim+1);
+    ntot *= nt;
+  }
+  fprintf(fp,"data_format=native_float esize=4 in=%s\n",dname);
+  fclose(fp);
+
+  /* csq increases with depth; init and every movie frame are
+     Gaussian bumps, off center in different directions */
+  float * a = new float[ntot];
+  int i0, i1, it, k=0;
+  for (it=0;it<iwave_max(nt,1);it++) {
+    for (i1=0;i1<n[1];i1++) {
+      for (i0=0;i0<n[0];i0++,k++) {
+	float r2 = (i0-18)*(i0-18)+(i1-22)*(i1-22);
+	float s2 = (i0-25)*(i0-25)+(i1-15-it)*(i1-15-it);
+	if (nt==0) a[k] = val*(3.0f+2.0f*i0/N);
+	else if (nt==1) a[k] = exp(-r2/8.0f);
+	else a[k] = exp(-s2/8.0f);
+      }
+    }
+  }
+  fp = fopen(dname,"w");
+  fwrite(a,sizeof(float),ntot,fp);
+  fclose(fp);
+  delete [] a;
+}
+
+static void readrsf(char const * name, std::vector<float> & a) {
+  char dname[64];
+  snprintf(dname,64,"%s.rsf@",name);
+  a.resize(N*N);
+  FILE * fp = fopen(dname,"r");
+  if (!fp || fread(&(a[0]),sizeof(float),a.size(),fp) != a.size()) {
+    RVLException e;
+    e<<"Error: failed to read "<<dname<<"\n";
+    throw e;
+  }
+  fclose(fp);
+}
+
+int main(int argc, char ** argv) {
+
+  int rk=0;
+
+  try {
+
+#ifdef IWAVE_USE_MPI
+    int ts=0;
+    MPI_Init_thread(&argc,&argv,MPI_THREAD_FUNNELED,&ts);
+    MPI_Comm_rank(MPI_COMM_WORLD,&rk);
+#endif
+
+    if (rk==0) {
+      cout<<"ACD Checkpoint Regression Test 1"<<endl;
+      cout<<"adjoint derivative of acd in 2D (order 2), 11 frames, 3 checkpoints,"<<endl;
+      cout<<"compressed checkpoints versus cpcomp=0"<<endl;
+      writersf("csq",2,0,1.0f);
+      writersf("init",2,1,0.0f);
+      writersf("movie",2,NT,0.0f);
+    }
+#ifdef IWAVE_USE_MPI
+    MPI_Barrier(MPI_COMM_WORLD);
+#endif
+
+    PARARRAY * par = NULL;
+    FILE * stream = NULL;
+    char * args[] = {argv[0], (char *)"csq=csq.rsf", (char *)"init=init.rsf",
+		     (char *)"movie=movie.rsf", (char *)"csq_b1=csq_b1.rsf",
+		     (char *)"order=2", (char *)"cfl=0.5", (char *)"cmin=1.0",
+		     (char *)"cmax=3.0", (char *)"sampord=1", (char *)"cpdir=."};
+    IWaveEnvironment(11,args,0,&par,&stream);
+
+    /* cpcomp, cpmem */
+    double runs[3][2] = {{0, 0.0}, {1, 0.0}, {1, 0.01}};
+    std::vector<float> ref;
+    for (int ir=0; ir<3; ir++) {
+      ps_slint(*par,"cpcomp",(int)runs[ir][0]);
+      ps_sldouble(*par,"cpmem",runs[ir][1]);
+      if (rk==0) writersf("csq_b1",2,0,0.0f);
+#ifdef IWAVE_USE_MPI
+      MPI_Barrier(MPI_COMM_WORLD);
+#endif
+      {
+	IWaveInfo ic;
+	std::ostringstream ann;
+	IWaveSim sim(1,false,*par,stream,ic,0,3,false,cerr,ann);
+	sim.run();
+      }
+      if (rk==0) {
+	std::vector<float> g;
+	readrsf("csq_b1",g);
+	if (ir==0) {
+	  ref=g;
+	  float gmax=0.0f;
+	  for (size_t i=0; i<g.size(); i++) gmax=iwave_max(gmax,fabs(g[i]));
+	  cout<<"cpcomp=0: gradient nonzero = "<<((gmax>0.0f) ? "yes" : "no")<<endl;
+	}
+	else {
+	  cout<<"cpcomp=1";
+	  if (runs[ir][1]>0.0) cout<<" cpmem="<<runs[ir][1];
+	  cout<<": gradient identical = "
+	      <<(memcmp(&(ref[0]),&(g[0]),g.size()*sizeof(float)) ? "no" : "yes")<<endl;
+	}
+      }
+    }
+
+    ps_delete(&par);
+    fclose(stream);
+
+#ifdef IWAVE_USE_MPI
+    MPI_Finalize();
+#endif
+
+    return(0);
+  }
+  catch (RVLException & e) {
+    e.write(cerr);
+#ifdef IWAVE_USE_MPI
+    MPI_Abort(MPI_COMM_WORLD,0);
+#endif
+    exit(1);
+  }
+}
@@ -21,6 +21,7 @@ FIELD IWaveInfo::iwave_fields[]
 FD_MODELINIT IWaveInfo::minit = asg_modelinit;
 FD_MODELDEST IWaveInfo::mdest = asg_modeldest;
 FD_TIMESTEP IWaveInfo::timestep = asg_timestep;
+FD_PARTSTEP IWaveInfo::partstep = NULL;
 FD_TIMEGRID IWaveInfo::timegrid = asg_timegrid;
 FD_STENCIL IWaveInfo::createstencil = asg_create_sten;
 FD_CHECK IWaveInfo::check = asg_check;
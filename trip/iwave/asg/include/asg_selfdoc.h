@@ -130,6 +130,11 @@ const char * sdoc[] = {
   "        mpi_np2 = 1           number of subdomains along axis 2",
   "        mpi_np3 = 1           number of subdomains along axis 3",
   "        partask = 1           number of shots to execute in parallel",
+  "       dynsched = 0           1 = each group of processes pulls the next",
+  "                              shot when done, 0 = fixed blocks of shots.",
+  "                              with 1, stacked outputs (gradients, migrated",
+  "                              images) may differ in the last bits between",
+  "                              runs, as shots are stacked in timing order",
   " ",
   " ------------------------------------------------------------------------",
   " Output info:",
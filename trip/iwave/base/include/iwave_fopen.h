@@ -33,6 +33,13 @@ first time by iwave_fopen. Subsequent calls which return pointers to
 the same file (switching from inuse=0 to inuse=1, for temp files) do
 not truncate the existing file.
 
+A file may also be bound to a memory image of its contents (\ref
+iwave_fbind), typically the buffer of a data container which holds
+the entire file in core. While bound, readers and writers which
+access the file through the database (\ref iwave_fmem) use the image
+instead of the file, and the file itself may be stale until \ref
+iwave_fsync writes the image back.
+
 */
 
 #ifndef __IWAVE_FOPEN__
@@ -115,4 +122,33 @@ void iwave_fprintall(FILE * stream);
     or NULL if none found */
 const char * iwave_getproto(const char * name);
 
+/** Binds memory image to an open file: the first nbytes bytes of
+    mem stand for the first nbytes bytes of the file, which may be
+    stale until the image is synced. The image is owned by the
+    calling unit, which must unbind it before it is freed.
+    @param fp file pointer returned by iwave_fopen
+    @param mem image of file contents
+    @param nbytes length of image in bytes
+    @return 0 on success, E_FILE if fp is not in the database
+*/
+int iwave_fbind(FILE * fp, void * mem, size_t nbytes);
+
+/** returns memory image bound to named file, or NULL if the file
+    is not in the database or not bound. 
+    @param name filename, as recorded in the database
+    @param nbytes length of image in bytes (output)
+    @param wr if set, image is flagged as newer than file
+*/
+void * iwave_fmem(const char * name, size_t * nbytes, int wr);
+
+/** writes memory image bound to fp back to file, if flagged as newer
+    than file. No-op if fp is not bound or not in the database.
+    @return 0 on success, E_FILE on failed write
+*/
+int iwave_fsync(FILE * fp);
+
+/** detaches memory image from fp, without writing it back - call
+    iwave_fsync first if file is to be made current. */
+void iwave_funbind(FILE * fp);
+
 #endif
@@ -18,6 +18,9 @@ static struct filestat {
   char * md;                        /* MODE */
   int istmp;                        /* temp flag */
   int inuse;                        /* availability flag */
+  void * mem;                       /* bound memory image, or NULL */
+  size_t mlen;                      /* length of image (bytes) */
+  int dirty;                        /* image newer than file */
 } * filestatlist = (struct filestat *)NULL;
 
 static struct filestat *fpr, **oldfpr;
@@ -167,6 +170,9 @@ FILE * iwave_fopen(char ** name,
       strcpy(fpr->md,"w+");
       fpr->istmp=1;
       fpr->inuse=1;
+      fpr->mem=NULL;
+      fpr->mlen=0;
+      fpr->dirty=0;
       fpr->nextfpr = (struct filestat *)NULL;
 
       /* determine length of proto file */
@@ -411,6 +417,9 @@ FILE * iwave_fopen(char ** name,
       strcpy(fpr->md,mode);
       fpr->istmp=0;
       fpr->inuse=1;
+      fpr->mem=NULL;
+      fpr->mlen=0;
+      fpr->dirty=0;
       fpr->nextfpr = (struct filestat *)NULL;
     }
 
@@ -562,6 +571,16 @@ void iwave_fprintall(FILE * stream) {
 	  iptr,istmp,inuse);
 }
 
+/* write back bound image, if newer than file */
+static int iwave_fwrmem(struct filestat * f) {
+  if (!(f->mem) || !(f->dirty)) return 0;
+  if (fseeko(f->fp,0L,SEEK_SET) ||
+      (f->mlen != fwrite(f->mem,sizeof(char),f->mlen,f->fp)) ||
+      fflush(f->fp)) return E_FILE;
+  f->dirty=0;
+  return 0;
+}
+
 /* destructor */
 void iwave_fdestroy() {
   /* workspace to hold temp copy of next pointer */
@@ -569,6 +588,8 @@ void iwave_fdestroy() {
 
   for (fpr=filestatlist; fpr != ((struct filestat *)NULL); 
        fpr = tmpnext) {
+    /* archival files still bound: write back image */
+    if (fpr->fp && !fpr->istmp) iwave_fwrmem(fpr);
     if (fpr->fp)  { fclose(fpr->fp); fpr->fp=NULL; }
 #ifdef UNLINK_TMPS
     if (fpr->istmp && fpr->nm) unlink(fpr->nm);
@@ -590,3 +611,48 @@ const char * iwave_getproto(const char * name) {
     if (!(strcmp(fpr->nm,name))) return fpr->pr;
   return NULL;
 }
+
+/* memory images - looked up by FILE* (owner) or name (readers) */
+static struct filestat * iwave_ffind(FILE * fp) {
+  struct filestat * f;
+  if (!fp) return NULL;
+  for (f=filestatlist; f != ((struct filestat *)NULL); f = f->nextfpr)
+    if (fp==f->fp) return f;
+  return NULL;
+}
+
+int iwave_fbind(FILE * fp, void * mem, size_t nbytes) {
+  struct filestat * f = iwave_ffind(fp);
+  if (!f) return E_FILE;
+  f->mem=mem;
+  f->mlen=nbytes;
+  f->dirty=0;
+  return 0;
+}
+
+void * iwave_fmem(const char * name, size_t * nbytes, int wr) {
+  struct filestat * f;
+  if (!name) return NULL;
+  for (f=filestatlist; f != ((struct filestat *)NULL); f = f->nextfpr) {
+    if ((f->mem) && (f->nm) && !(strcmp(name,f->nm))) {
+      if (nbytes) *nbytes=f->mlen;
+      if (wr) f->dirty=1;
+      return f->mem;
+    }
+  }
+  return NULL;
+}
+
+int iwave_fsync(FILE * fp) {
+  struct filestat * f = iwave_ffind(fp);
+  if (!f) return 0;
+  return iwave_fwrmem(f);
+}
+
+void iwave_funbind(FILE * fp) {
+  struct filestat * f = iwave_ffind(fp);
+  if (!f) return;
+  f->mem=NULL;
+  f->mlen=0;
+  f->dirty=0;
+}
@@ -0,0 +1,86 @@
+#ifndef __IW_CPSTORE__
+#define __IW_CPSTORE__
+
+#include "except.hh"
+#include "parser.h"
+#include "iwave.h"
+
+namespace TSOpt {
+  using RVL::parse;
+  using RVL::RVLException;
+
+  struct cprecord;
+
+  /** Storage for the checkpoints of the Revolve adjoint loop in
+      IWaveSim. A checkpoint consists of nrec dynamic arrays (one
+      record per array), all checkpoints having the same record
+      lengths. Records are kept in memory until a byte budget is
+      exhausted, after which they spill to a scratch file, written
+      asynchronously. Optionally records are compressed, losslessly or
+      with a bound on the pointwise error, so that more checkpoints fit
+      in the same memory.
+
+      Parameters (read from the IWaveSim parameter table):
+      <ul>
+      <li>cpcomp = 0: no compression, 1: lossless, 2: lossy</li>
+      <li>cptol = 1.e-5: lossy error bound, relative to the max
+      absolute value of each record</li>
+      <li>cpmem = 0: memory budget for checkpoints in MB, 0 = unlimited</li>
+      <li>cpdir: directory for the scratch file, default DATAPATH or
+      working directory</li>
+      </ul>
+  */
+  class CheckpointStore {
+
+  private:
+    int snaps;
+    int nrec;
+    std::vector<size_t> len;  // record lengths, in ireals
+    std::vector<off_t> off;   // record offsets in scratch file
+    off_t cpbytes;            // raw bytes per checkpoint
+
+    int comp;
+    double tol;
+    size_t memlimit;
+    string dir;
+
+    cprecord * rec;
+    std::vector<int> pending; // records with writes in flight, oldest first
+    size_t pendbytes;
+    unsigned char * scratch;
+    int fd;
+
+    // statistics
+    size_t memused;
+    size_t mempeak;
+    size_t nput;
+    size_t ndisk;
+    double rawtotal;
+    double enctotal;
+
+    void release(int r);
+    void finish(int r);
+    void reap(bool all);
+    void spill(int r, unsigned char * buf);
+
+    CheckpointStore();
+    CheckpointStore(CheckpointStore const &);
+
+  public:
+    /** snaps = number of checkpoints, len[i] = number of ireals in
+	record i of each checkpoint */
+    CheckpointStore(PARARRAY const & pars, int snaps,
+		    std::vector<size_t> const & len);
+    ~CheckpointStore();
+
+    /** store allocated data of a in record r of checkpoint cp */
+    void put(int cp, int r, RARR const & a);
+    /** restore allocated data of a from record r of checkpoint cp */
+    void get(int cp, int r, RARR & a);
+
+    ostream & write(ostream & str) const;
+  };
+
+}
+
+#endif
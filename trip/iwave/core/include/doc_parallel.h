@@ -47,6 +47,16 @@ shots: toggled by a nonzero value of the partask parameter:
 <li> partask = [int] [Default = 0] if set, load as many
 as possible given the size of MPI_COMM_WORLD,
 <i> but at most partask</i>, simulations.</li> 
+<li> dynsched = [int] [Default = 0] if set, each group of processes
+pulls the index of the next shot from a shared queue as soon as it has
+finished the current one, so that slow shots do not hold up the other
+groups. Otherwise each group simulates a fixed block of shots. Output
+traces land in their places in the output file, and gradients are
+stacked over groups, in either case. With dynsched=0 the result is
+reproducible. With dynsched=1 the assignment of shots to groups, hence
+the order in which stacked outputs (gradients, migrated images) are
+summed, depends on timing, so these outputs may differ in the last bits
+from run to run. Traces are not affected.</li>
 </ul>
 
 For example, if mpi_np1=mpi_np2=mpi_np3=2 and 32 processors are assigned to the simulation, then setting partask to be at least 4 will cause up to 4 shots to be loaded at a time, simulated, and written to the output file, until no shots remain to be simulated. If partask is less than 4, but greater than zero, then partask simulations will be loaded. If 33 processors were assigned and partask is at least 4, IWAVE will still load 4 shots at a time, but the 33rd process will be flagged as inactive, that is, not used in the simulation. If 31 processors are assigned and partask is at least three, then IWAVE loads 3 shots at a time and flags the 25th-31st processes as inactive.
@@ -10,6 +10,7 @@
 #include "grid.h"
 #include "traceio.h"
 #include "revolve.h"
+#include "cpstore.hh"
 
 namespace TSOpt {
   using RVL::parse;
@@ -120,9 +121,15 @@ namespace TSOpt {
     int order;
     int snaps;
     int ndyn;
-    RARR *** cps;
+    CheckpointStore * cps;
     int narr;
 
+    // overlap exchange with computation
+    int overlap;
+
+    // pull shots from a shared queue (partask)
+    int dynsched;
+
     bool dryrun;
     ostream & drystr;
 
@@ -51,6 +51,25 @@ C functions.
  */
 typedef void (*FD_TIMESTEP)(std::vector<RDOM *> dom, bool fwd, int iv, void* fdpars);
 
+/** Optional split time step, for overlap of the ghost cell exchange
+    with computation. Called twice per (sub)step in place of
+    FD_TIMESTEP: part 0 updates the fields on strips next to the
+    subdomain faces and leaves the data to be sent final, part 1
+    updates the rest of the domain and completes the step. Between
+    the calls IWaveSim posts nonblocking sends and receives, so part 1
+    must not write the receive (ghost) areas of the dynamic fields on
+    faces shared with other subdomains. wl, wr give the widths of the
+    send areas on the left and right faces along each axis, 0 for
+    faces on the physical boundary.
+    @return false from part 0 if the step cannot be split (derivative
+    order, scheme, subdomain too thin), in which case nothing has been
+    updated and IWaveSim falls back to FD_TIMESTEP and blocking
+    exchange; the return value of part 1 is ignored
+    called in IWaveSim::run if overlap=1 and model defines it, else
+    set to NULL
+ */
+typedef bool (*FD_PARTSTEP)(std::vector<RDOM *> dom, bool fwd, int iv, void* fdpars,
+			    int part, IPNT wl, IPNT wr);
 /** FD model internals initializer - creates appropriate data
     structure to serve as fdpars parameter struct for \ref IMODEL
     specialization, initialize data members of \ref IMODEL.fdpars
@@ -220,6 +239,7 @@ public:
   static FD_MODELINIT minit;
   static FD_MODELDEST mdest;
   static FD_TIMESTEP timestep;
+  static FD_PARTSTEP partstep;
   static FD_TIMEGRID timegrid;
   static FD_STENCIL createstencil;
   static FD_CHECK check;
@@ -232,6 +252,7 @@ public:
   FD_MODELDEST get_mdest() const { return this->mdest; }
   FD_TIMEGRID get_timegrid() const { return this->timegrid; }
   FD_TIMESTEP get_timestep() const { return this->timestep; }
+  FD_PARTSTEP get_partstep() const { return this->partstep; }
   FD_STENCIL get_stencil() const { return this->createstencil;}
   FD_CHECK get_check() const { return this->check; }
   // defined
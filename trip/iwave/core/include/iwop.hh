@@ -32,6 +32,7 @@ namespace TSOpt {
   using RVL::Operator;
   using RVL::Writeable;
   using RVL::AssignParams;
+  using RVL::BindParams;
   
   class IWaveSpace: public ProductSpace<ireal> {
 
@@ -86,7 +87,8 @@ namespace TSOpt {
     ostream & announce;
 
     // convenience filename transfer - weak sanity check, presume 
-    // that membership is already established
+    // that membership is already established. See param_set in 
+    // iwop.cc for in-core grid components
     void param_set(RVL::Vector<ireal> const & x, 
 		   PARARRAY & pars, 
 		   IWaveSpace const & sp,
@@ -0,0 +1,452 @@
+#include "cpstore.hh"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <limits>
+
+#if defined(_POSIX_ASYNCHRONOUS_IO) && (_POSIX_ASYNCHRONOUS_IO > 0)
+#include <aio.h>
+#define IWAVE_CP_AIO
+#endif
+
+namespace TSOpt {
+
+  // record encodings
+  enum { CP_RAW, CP_PACKED, CP_QUANT };
+
+  struct cprecord {
+    int how;              // encoding
+    double step;          // quantization step, CP_QUANT only
+    size_t nbytes;        // encoded length
+    unsigned char * mem;  // in-memory copy, or NULL
+    unsigned char * wbuf; // buffer of write in flight, or NULL
+    bool ondisk;
+#ifdef IWAVE_CP_AIO
+    struct aiocb * cb;    // request of write in flight
+#endif
+  };
+
+  // unsigned word of the same size as ireal
+  template<size_t> struct cpword;
+  template<> struct cpword<4> { typedef uint32_t type; };
+  template<> struct cpword<8> { typedef uint64_t type; };
+  typedef cpword<sizeof(ireal)>::type word;
+
+  // longest varint of a 64 bit symbol
+#define CP_VARMAX 10
+
+  template<typename W>
+  static inline unsigned char * putvar(W x, unsigned char * p) {
+    while (x >= 0x80) {
+      *p++ = (unsigned char)(x | 0x80);
+      x >>= 7;
+    }
+    *p++ = (unsigned char)x;
+    return p;
+  }
+
+  template<typename W>
+  static inline unsigned char const * getvar(W & x, unsigned char const * p) {
+    int s = 0;
+    x = 0;
+    while (*p & 0x80) {
+      x |= (W)(*p++ & 0x7f) << s;
+      s += 7;
+    }
+    x |= (W)(*p++) << s;
+    return p;
+  }
+
+  // lossless symbols: xor of successive bit patterns, zero where
+  // neighbouring values repeat, small where they share sign, exponent
+  // and leading mantissa bits
+  class xorsym {
+    ireal const * x;
+  public:
+    xorsym(ireal const * _x): x(_x) {}
+    word operator()(size_t i) const {
+      word a = 0, b;
+      if (i) memcpy(&a, x+i-1, sizeof(word));
+      memcpy(&b, x+i, sizeof(word));
+      return a ^ b;
+    }
+  };
+
+  class xordst {
+    ireal * x;
+    word prev;
+  public:
+    xordst(ireal * _x): x(_x), prev(0) {}
+    void operator()(size_t i, word u) {
+      prev ^= u;
+      memcpy(x+i, &prev, sizeof(word));
+    }
+  };
+
+  // lossy symbols: zigzag coded differences of quantized values
+  class quantsym {
+    ireal const * x;
+    double rstep;
+  public:
+    quantsym(ireal const * _x, double step): x(_x), rstep(1.0/step) {}
+    int64_t q(size_t i) const { return (int64_t)llrint(x[i]*rstep); }
+    uint64_t operator()(size_t i) const {
+      int64_t d = q(i) - (i ? q(i-1) : 0);
+      return ((uint64_t)d << 1) ^ (uint64_t)(d >> 63);
+    }
+  };
+
+  class quantdst {
+    ireal * x;
+    double step;
+    int64_t q;
+  public:
+    quantdst(ireal * _x, double _step): x(_x), step(_step), q(0) {}
+    void operator()(size_t i, uint64_t u) {
+      q += (int64_t)(u >> 1) ^ -(int64_t)(u & 1);
+      x[i] = (ireal)(q*step);
+    }
+  };
+
+  // code n symbols as varints, a zero symbol being followed by the
+  // length of the zero run. Returns the code length, or 0 if it would
+  // exceed cap bytes.
+  template<typename W, typename S>
+  static size_t pack(S const & sym, size_t n, unsigned char * out, size_t cap) {
+    if (cap < 2*CP_VARMAX+1) return 0;
+    unsigned char * p = out;
+    unsigned char * end = out + cap - 2*CP_VARMAX;
+    size_t i = 0;
+    while (i < n) {
+      if (p > end) return 0;
+      W u = sym(i);
+      if (u) {
+	p = putvar(u, p);
+	i++;
+      }
+      else {
+	size_t j = i+1;
+	while (j < n && !sym(j)) j++;
+	*p++ = 0;
+	p = putvar((uint64_t)(j-i-1), p);
+	i = j;
+      }
+    }
+    return p - out;
+  }
+
+  template<typename W, typename D>
+  static void unpack(unsigned char const * p, size_t n, D & dst) {
+    size_t i = 0;
+    while (i < n) {
+      W u;
+      p = getvar(u, p);
+      if (u) dst(i++, u);
+      else {
+	uint64_t r;
+	p = getvar(r, p);
+	for (uint64_t k=0; k<=r; k++) dst(i++, 0);
+      }
+    }
+  }
+
+  CheckpointStore::CheckpointStore(PARARRAY const & pars, int _snaps,
+				   std::vector<size_t> const & _len)
+    : snaps(_snaps), nrec(_len.size()), len(_len), off(_len.size()),
+      cpbytes(0), comp(0), tol(1.e-5), memlimit(0), dir(""), rec(NULL),
+      pendbytes(0), scratch(NULL), fd(-1),
+      memused(0), mempeak(0), nput(0), ndisk(0), rawtotal(0.0), enctotal(0.0) {
+
+    if (snaps <= 0 || nrec <= 0) {
+      RVLException e;
+      e<<"Error: CheckpointStore constructor\n";
+      e<<"  snaps = "<<snaps<<" records = "<<nrec<<", both must be positive\n";
+      throw e;
+    }
+    for (int r=0; r<nrec; r++) {
+      off[r] = cpbytes;
+      cpbytes += len[r]*sizeof(ireal);
+    }
+
+    parse(pars, "cpcomp", comp);
+    if (comp < 0 || comp > 2) {
+      RVLException e;
+      e<<"Error: CheckpointStore constructor\n";
+      e<<"  cpcomp = "<<comp<<", must be 0 (none), 1 (lossless) or 2 (lossy)\n";
+      throw e;
+    }
+    parse(pars, "cptol", tol);
+    double mb = 0.0;
+    parse(pars, "cpmem", mb);
+    if (mb > 0.0) memlimit = (size_t)(mb*1048576.0);
+    if (!parse(pars, "cpdir", dir)) {
+      char * dpath = getenv("DATAPATH");
+      dir = (dpath && strlen(dpath)) ? dpath : ".";
+    }
+
+    rec = new cprecord[snaps*nrec];
+    for (int g=0; g<snaps*nrec; g++) {
+      rec[g].how = CP_RAW;
+      rec[g].step = 0.0;
+      rec[g].nbytes = 0;
+      rec[g].mem = NULL;
+      rec[g].wbuf = NULL;
+      rec[g].ondisk = false;
+#ifdef IWAVE_CP_AIO
+      rec[g].cb = NULL;
+#endif
+    }
+  }
+
+  CheckpointStore::~CheckpointStore() {
+    try {
+      reap(true);
+    }
+    catch (RVLException & e) {
+      e.write(cerr);
+    }
+    for (int g=0; g<snaps*nrec; g++) free(rec[g].mem);
+    delete [] rec;
+    free(scratch);
+    if (fd >= 0) close(fd);
+  }
+
+  // wait for the write of record g to complete
+  void CheckpointStore::finish(int g) {
+    cprecord & c = rec[g];
+    if (!c.wbuf) return;
+#ifdef IWAVE_CP_AIO
+    struct aiocb const * list[1] = { c.cb };
+    while (aio_error(c.cb) == EINPROGRESS) aio_suspend(list, 1, NULL);
+    ssize_t nw = aio_return(c.cb);
+    delete c.cb;
+    c.cb = NULL;
+    if (nw != (ssize_t)c.nbytes) {
+      RVLException e;
+      e<<"Error: CheckpointStore: write of record "<<g<<" to scratch file failed\n";
+      e<<"  "<<strerror(nw < 0 ? errno : ENOSPC)<<"\n";
+      throw e;
+    }
+#endif
+    free(c.wbuf);
+    c.wbuf = NULL;
+    pendbytes -= c.nbytes;
+    for (size_t i=0; i<pending.size(); i++) {
+      if (pending[i] == g) {
+	pending.erase(pending.begin()+i);
+	break;
+      }
+    }
+  }
+
+  // retire completed writes, all of them if all = true, and keep at
+  // most one checkpoint worth of data in flight
+  void CheckpointStore::reap(bool all) {
+    std::vector<int> done;
+    for (size_t i=0; i<pending.size(); i++) {
+#ifdef IWAVE_CP_AIO
+      if (!all && aio_error(rec[pending[i]].cb) == EINPROGRESS) continue;
+#endif
+      done.push_back(pending[i]);
+    }
+    for (size_t i=0; i<done.size(); i++) finish(done[i]);
+    while (pending.size() && pendbytes > (size_t)cpbytes) finish(pending.front());
+  }
+
+  // forget the previous contents of record g
+  void CheckpointStore::release(int g) {
+    cprecord & c = rec[g];
+    finish(g);
+    if (c.mem) {
+      free(c.mem);
+      memused -= c.nbytes;
+      c.mem = NULL;
+    }
+    c.ondisk = false;
+  }
+
+  // write encoded record g to the scratch file, taking ownership of buf
+  void CheckpointStore::spill(int g, unsigned char * buf) {
+    cprecord & c = rec[g];
+    if (fd < 0) {
+      string name = dir + "/cp.XXXXXX";
+      std::vector<char> tmp(name.begin(), name.end());
+      tmp.push_back('\0');
+      if ((fd = mkstemp(&tmp[0])) < 0) {
+	RVLException e;
+	e<<"Error: CheckpointStore: failed to open scratch file in "<<dir<<"\n";
+	e<<"  "<<strerror(errno)<<"\n";
+	throw e;
+      }
+      // gone from the directory, space reclaimed on close
+      unlink(&tmp[0]);
+    }
+    off_t pos = (off_t)(g/nrec)*cpbytes + off[g%nrec];
+#ifdef IWAVE_CP_AIO
+    c.cb = new struct aiocb;
+    memset(c.cb, 0, sizeof(struct aiocb));
+    c.cb->aio_fildes = fd;
+    c.cb->aio_offset = pos;
+    c.cb->aio_buf = buf;
+    c.cb->aio_nbytes = c.nbytes;
+    c.cb->aio_sigevent.sigev_notify = SIGEV_NONE;
+    if (0 == aio_write(c.cb)) {
+      c.wbuf = buf;
+      pending.push_back(g);
+      pendbytes += c.nbytes;
+      c.ondisk = true;
+      return;
+    }
+    // out of request slots - write in place
+    delete c.cb;
+    c.cb = NULL;
+#endif
+    size_t nw = 0;
+    while (nw < c.nbytes) {
+      ssize_t k = pwrite(fd, buf+nw, c.nbytes-nw, pos+nw);
+      if (k < 0 && errno == EINTR) continue;
+      if (k <= 0) {
+	free(buf);
+	RVLException e;
+	e<<"Error: CheckpointStore: write of record "<<g<<" to scratch file failed\n";
+	e<<"  "<<strerror(k < 0 ? errno : ENOSPC)<<"\n";
+	throw e;
+      }
+      nw += k;
+    }
+    free(buf);
+    c.ondisk = true;
+  }
+
+  void CheckpointStore::put(int cp, int r, RARR const & a) {
+    size_t n = 0;
+    ra_a_datasize(&a, &n);
+    if (cp < 0 || cp >= snaps || r < 0 || r >= nrec || n != len[r]) {
+      RVLException e;
+      e<<"Error: CheckpointStore::put\n";
+      e<<"  checkpoint "<<cp<<" record "<<r<<" length "<<n<<" does not fit\n";
+      e<<"  store of "<<snaps<<" checkpoints of "<<nrec<<" records\n";
+      throw e;
+    }
+    int g = cp*nrec + r;
+    cprecord & c = rec[g];
+    release(g);
+    reap(false);
+
+    size_t raw = n*sizeof(ireal);
+    unsigned char * buf = (unsigned char *)malloc(raw);
+    if (!buf) {
+      RVLException e;
+      e<<"Error: CheckpointStore::put: failed to allocate "<<raw<<" bytes\n";
+      throw e;
+    }
+
+    c.how = CP_RAW;
+    c.nbytes = 0;
+    if (comp == 2) {
+      // error bound relative to the largest value
+      double amax = 0.0;
+      for (size_t i=0; i<n; i++) {
+	// picks up nan, which disables quantization below
+	if (!(fabs(a._s0[i]) <= amax)) amax = fabs(a._s0[i]);
+      }
+      // half a step, plus the rounding of the restored value to
+      // ireal, within tol*amax
+      c.step = 2.0*(tol-std::numeric_limits<ireal>::epsilon())*amax;
+      // leave 10 bits of headroom in the quantized values
+      if (c.step > 0.0 && amax/c.step < 9.e15) {
+	c.nbytes = pack<uint64_t>(quantsym(a._s0, c.step), n, buf, raw);
+	if (c.nbytes) c.how = CP_QUANT;
+      }
+    }
+    if (comp && !c.nbytes) {
+      c.nbytes = pack<word>(xorsym(a._s0), n, buf, raw);
+      if (c.nbytes) c.how = CP_PACKED;
+    }
+    if (!c.nbytes) {
+      memcpy(buf, a._s0, raw);
+      c.nbytes = raw;
+    }
+    else {
+      unsigned char * tmp = (unsigned char *)realloc(buf, c.nbytes);
+      if (tmp) buf = tmp;
+    }
+
+    nput++;
+    rawtotal += raw;
+    enctotal += c.nbytes;
+    if (!memlimit || memused + c.nbytes <= memlimit) {
+      c.mem = buf;
+      memused += c.nbytes;
+      mempeak = iwave_max(mempeak, memused);
+    }
+    else {
+      ndisk++;
+      spill(g, buf);
+    }
+  }
+
+  void CheckpointStore::get(int cp, int r, RARR & a) {
+    size_t n = 0;
+    ra_a_datasize(&a, &n);
+    int g = cp*nrec + r;
+    if (cp < 0 || cp >= snaps || r < 0 || r >= nrec || n != len[r] ||
+	!(rec[g].mem || rec[g].ondisk)) {
+      RVLException e;
+      e<<"Error: CheckpointStore::get\n";
+      e<<"  checkpoint "<<cp<<" record "<<r<<" length "<<n<<" not stored\n";
+      throw e;
+    }
+    cprecord & c = rec[g];
+
+    unsigned char const * src = c.mem ? c.mem : c.wbuf;
+    if (!src) {
+      // on disk, write complete
+      if (!scratch) scratch = (unsigned char *)malloc(cpbytes);
+      off_t pos = (off_t)cp*cpbytes + off[r];
+      size_t nr = 0;
+      while (nr < c.nbytes) {
+	ssize_t k = pread(fd, scratch+nr, c.nbytes-nr, pos+nr);
+	if (k < 0 && errno == EINTR) continue;
+	if (k <= 0) {
+	  RVLException e;
+	  e<<"Error: CheckpointStore::get: read of checkpoint "<<cp
+	   <<" record "<<r<<" from scratch file failed\n";
+	  throw e;
+	}
+	nr += k;
+      }
+      src = scratch;
+    }
+
+    if (c.how == CP_PACKED) {
+      xordst dst(a._s0);
+      unpack<word>(src, n, dst);
+    }
+    else if (c.how == CP_QUANT) {
+      quantdst dst(a._s0, c.step);
+      unpack<uint64_t>(src, n, dst);
+    }
+    else memcpy(a._s0, src, c.nbytes);
+  }
+
+  ostream & CheckpointStore::write(ostream & str) const {
+    str<<"CheckpointStore: "<<snaps<<" checkpoints of "<<nrec<<" records, "
+       <<cpbytes/1048576.0<<" MB each\n";
+    str<<"  compression = ";
+    if (comp == 0) str<<"none\n";
+    else if (comp == 1) str<<"lossless\n";
+    else str<<"lossy, relative error bound "<<tol<<"\n";
+    str<<"  memory budget = ";
+    if (memlimit) str<<memlimit/1048576.0<<" MB\n";
+    else str<<"unlimited\n";
+    str<<"  records stored = "<<nput<<", spilled to "<<dir<<" = "<<ndisk<<"\n";
+    if (enctotal > 0.0)
+      str<<"  compression ratio = "<<rawtotal/enctotal<<"\n";
+    str<<"  peak memory = "<<mempeak/1048576.0<<" MB\n";
+    return str;
+  }
+
+}
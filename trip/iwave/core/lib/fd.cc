@@ -208,8 +208,11 @@ int fd_setcompdom(FILE * stream, IPNT cdims, IPNT crank,
     for (i = 0;i < RDOM_MAX_NARR;i ++) {
       if (fd_isarr(i,*model,ic)) {
 	for (idim = 0;idim < ndim;idim ++) {
-	  dgs[i][idim] = ls[idim]+fd_isdyn(i,ic);
-	  dge[i][idim] = le[idim]-fd_isdyn(i,ic);
+	  /* boundary pnts only at the physical ends, not at subdomain seams */
+	  dgs[i][idim] = ls[idim];
+	  dge[i][idim] = le[idim];
+	  if (crank[idim] == 0) dgs[i][idim] += fd_isdyn(i,ic);
+	  if (crank[idim] == cdims[idim]-1) dge[i][idim] -= fd_isdyn(i,ic);
 	  if (crank[idim] == 0 && gtype[i][idim] == DUAL_GRID)
 	    dgs[i][idim] --;
 	  //	  fprintf(stream,"fd_setcompdom: iarr=%d isdyn=%d dgs[%d]=%d, dge[%d]=%d\n",i,fd_isdyn(i,ic),idim,dgs[i][idim],idim,dge[i][idim]); 
@@ -245,6 +245,96 @@ namespace TSOpt {
 #endif
   }
 
+#ifdef IWAVE_USE_MPI
+  // split version of forward synch, for overlap with computation:
+  // synch_post starts receives and sends of the arrays updated in 
+  // substep iv, synch_wait completes all requests posted so far. Tags
+  // identify substep, array and neighbor, so several states may be
+  // in flight at once, posted in the same order on every rank.
+  void synch_post(IWAVE * pstate,
+		  int iv,
+		  IWaveInfo const & ic,
+		  FILE * stream,
+		  std::vector<MPI_Request> & req) {
+
+    int err = 0;
+    int nnei = (pstate->model).nnei;
+
+    for (int ia=0;ia<RDOM_MAX_NARR;ia++) {
+      if (fd_update(ia,iv,ic)) {
+	if ( (pstate->printact > 1) ) {
+	  fprintf(stream,"\n------ synch_post array=%d -------------\n",ia);
+	  fflush(stream); 
+	}
+	for (int i = 0; i < nnei; ++i ) {
+	  int tag = (iv*RDOM_MAX_NARR + ia)*nnei + i;
+	  MPI_Request r;
+	  if ( (pstate->pinfo).reinfo[ia][i].type != MPI_DATATYPE_NULL ) {
+	    err = MPI_Irecv((pstate->pinfo).reinfo[ia][i].buf, 1, 
+			    (pstate->pinfo).reinfo[ia][i].type,
+			    (pstate->pinfo).rranks[i], tag,
+			    (pstate->pinfo).ccomm, &r);
+	    if ( err != MPI_SUCCESS ) {
+	      RVLException e;
+	      e<<"Error: synch_post from MPI_Irecv, err="<<err<<", nei="<<i<<", iv="<<iv<<", arr="<<ia<<"\n";
+	      throw e;
+	    }
+	    req.push_back(r);
+	  }
+	  if ( (pstate->pinfo).seinfo[ia][i].type != MPI_DATATYPE_NULL ) {
+	    err = MPI_Isend((pstate->pinfo).seinfo[ia][i].buf, 1, 
+			    (pstate->pinfo).seinfo[ia][i].type,
+			    (pstate->pinfo).sranks[i], tag,
+			    (pstate->pinfo).ccomm, &r);
+	    if ( err != MPI_SUCCESS ) {
+	      RVLException e;
+	      e<<"Error: synch_post from MPI_Isend, err="<<err<<", nei="<<i<<", iv="<<iv<<", arr="<<ia<<"\n";
+	      throw e;
+	    }
+	    req.push_back(r);
+	  }
+	}
+      }
+    }
+  }
+
+  void synch_wait(std::vector<MPI_Request> & req) {
+    if (req.size() == 0) return;
+    int err = MPI_Waitall(req.size(), &(req[0]), MPI_STATUSES_IGNORE);
+    req.clear();
+    if ( err != MPI_SUCCESS ) {
+      RVLException e;
+      e<<"Error: synch_wait from MPI_Waitall, err="<<err<<"\n";
+      throw e;
+    }
+  }
+
+  // widths of the send areas of the arrays updated in substep iv, 
+  // on the left and right faces of their computational domains 
+  void synch_widths(IWAVE * pstate,
+		    int iv,
+		    IWaveInfo const & ic,
+		    IPNT wl,
+		    IPNT wr) {
+    IPNT cs, ce, gs, ge;
+    IASN(wl,IPNT_0);
+    IASN(wr,IPNT_0);
+    for (int ia=0;ia<RDOM_MAX_NARR;ia++) {
+      if (!fd_update(ia,iv,ic)) continue;
+      rd_gse(&((pstate->model).ld_c),ia,cs,ce);
+      int ndim = (pstate->model).g.dim;
+      for (int i=0; i<(pstate->model).nnei; ++i) {
+	if ( (pstate->pinfo).seinfo[ia][i].type == MPI_DATATYPE_NULL ) continue;
+	rd_gse(&(((pstate->model).ld_s)[i]),ia,gs,ge);
+	for (int d=0; d<ndim; d++) {
+	  if (ge[d] < ce[d]) wl[d] = iwave_max(wl[d], ge[d]-cs[d]+1);
+	  if (gs[d] > cs[d]) wr[d] = iwave_max(wr[d], ce[d]-gs[d]+1);
+	}
+      }
+    }
+  }
+#endif
+
   IWaveSampler::IWaveSampler(IWAVE * state, string key, PARARRAY & pars, FILE * stream)
     : axes(0), prev_panelindex(-1), tg(NULL), dump_term(0) {
     
@@ -537,10 +627,11 @@ namespace TSOpt {
 	  panelindex=0;
 	}
 
-	// compute group panelindex limits
+	// compute group panelindex limits - last is known only once
+	// the group has claimed its next panel (dynamic scheduling)
 	int first;
 	int last;
-	calc_group(&first, &last, panelnum);
+	task_group(&first, &last, panelnum);
 	if ((panelindex < first) ||
 	    (panelindex > last)) {
 	  RVLException e;
@@ -1041,7 +1132,7 @@ namespace TSOpt {
 		     ostream & _announce)
     : ic(_ic), fwd(_fwd), stream(_stream),  
       printact(_printact), order(_order), snaps(_snaps),
-      cps(NULL), narr(0), 
+      cps(NULL), narr(0), overlap(0), dynsched(0), 
       dryrun(_dryrun), drystr(_drystr), 
       announce(_announce) {
     try {
@@ -1064,6 +1155,17 @@ namespace TSOpt {
       }
 
       
+      // overlap ghost exchange with computation, if the model can 
+      // split its time step
+      parse(pars,"overlap",overlap);
+
+      // with task parallelism, groups pull the next shot from a 
+      // shared queue as they finish, rather than simulating fixed
+      // blocks of shots. Off by default: which group stacks which
+      // shot then depends on timing, so stacked outputs change in
+      // the last bits from run to run
+      parse(pars,"dynsched",dynsched);
+
       // cerr<<"step 1: create list of i/o tasks\n";
       IOTask(t,order,fwd,ic);
 #ifdef IWAVE_VERBOSE
@@ -1130,45 +1232,30 @@ namespace TSOpt {
 	throw e;
       }
 
-      // cerr<<"step 2b: in adjoint case, allocate checkpoint buffers\n";
+      // cerr<<"step 2b: in adjoint case, set up checkpoint store\n";
       // IWAVEs 0,...,order-1 contain the reference data for the 
-      // adjoint computation, so need order * snaps * ndyn RARRAYs.
+      // adjoint computation, so need order * snaps * ndyn RARRAYs,
+      // stored as records j*ndyn+l of each checkpoint
       if (!fwd) {
-	typedef RARR* RP;
-	typedef RARR** RPP;
 	narr = snaps*pow2(order-1)*ndyn;
-	RARR * cpstmp = new RARR[narr];
-	RARR ** cpstmp2 = new RP[snaps*pow2(order-1)];
-	for (size_t i=0;i<snaps*pow2(order-1);i++) cpstmp2[i]=&(cpstmp[i*ndyn]);
-	cps = new RPP[snaps];
-	for (int i=0;i<snaps;i++) cps[i]=&(cpstmp2[i*pow2(order-1)]);
-	int l=0;
+	std::vector<size_t> len;
 	for (int k=0;k<(w->getRefStateArray())[0]->model.ld_a.narr;k++) {
 	  if (fd_isarr(k,(w->getRefStateArray())[0]->model,ic) && fd_isdyn(k,ic)) {
-	    // pull out gs, ge for kth rarr in w->getRefStateArray[0] 
-	    IPNT gs;
-	    IPNT ge;
-	    ra_a_gse(&((w->getRefStateArray())[0]->model.ld_a._s[k]),gs,ge);
-	    int ndim = (w->getRefStateArray())[0]->model.ld_a._s[k].ndim;
-	    for (int i=0;i<snaps;i++) {
-	      for (size_t j=0;j<pow2(order-1);j++) {
-		// ra_create cps[i][j][l] -- check l
-		if (l<0 || l>ndyn-1) {
-		  RVLException e;
-		  e<<"Error: IWaveSim: construct checkpoint array\n";
-		  e<<"  bad news - index into rarray "<<l<<" out of range [0,"<<ndyn<<"\n";
-		  throw e;
-		}
-		if (int err=ra_create(&(cps[i][j][l]),ndim,gs,ge)) {
-		  RVLException e;
-		  e<<"Error: IWaveSim from ra_create - checkpoint array\n";
-		  e<<"  err = "<<err<<"\n";
-		}
-	      }
-	    }
-	    l++;
+	    size_t n=0;
+	    ra_a_datasize(&((w->getRefStateArray())[0]->model.ld_a._s[k]),&n);
+	    len.push_back(n);
 	  }
 	}
+	if ((int)len.size() != ndyn) {
+	  RVLException e;
+	  e<<"Error: IWaveSim: construct checkpoint store\n";
+	  e<<"  found "<<len.size()<<" dynamic arrays in reference state, expected "<<ndyn<<"\n";
+	  throw e;
+	}
+	std::vector<size_t> cplen;
+	for (size_t j=0;j<pow2(order-1);j++) 
+	  cplen.insert(cplen.end(),len.begin(),len.end());
+	cps = new CheckpointStore(pars,snaps,cplen);
       }
 
       // cerr<<"step 3: construct list of samplers, axes\n";
@@ -1299,19 +1386,7 @@ namespace TSOpt {
       //      cerr<<"destroy iotask "<<i<<endl;
       if (t.at(i)) delete t.at(i); 
     }
-    if (cps) {
-      //      cerr<<"destroy checkpoints\n";
-      for (int i=0;i<snaps;i++) {
-	for (size_t j=0;j<pow2(order-1);j++) {
-	  for (int k=0;k<ndyn;k++) {
-	    ra_destroy(&(cps[i][j][k]));
-	  }
-	}
-      }
-      delete [] &(cps[0][0][0]);
-      delete [] &(cps[0][0]);
-      delete [] &(cps[0]);
-    }
+    if (cps) delete cps;
   }
 
   void IWaveSim::run() {
@@ -1325,27 +1400,15 @@ namespace TSOpt {
       get_ge(stop, g);
       // initially, assign step = start
       IASN(step,start);
-      // next, work out first and last panels for extended
-      // axes, this process
-      int first;
-      int last;
+      // next, count panels for extended axes. Panels are handed 
+      // out to groups by the task scheduler (traceio.h): either
+      // fixed blocks, or each group pulls the next panel when done
       int panelnum=1;
       int panelindex=0;
+      int first=0;
       for (int i=g.dim+1; i<g.gdim; i++) {
 	panelnum *= stop[i]-start[i]+1;
       }
-      calc_group(&first, &last, panelnum);
-      // increment step until at first panel
-      while (panelindex < first) {
-	// update step array
-	for (int i=g.dim+1;i<g.gdim;i++) {
-	  if (step[i]<stop[i]) step[i]++;
-	  else {
-	    if (i<g.gdim-1) step[i]=start[i];
-	  }
-	}
-	panelindex++;
-      }
 
       // pull out fdpars for use in time step - same in every
       // step, and for every RDOM, so do it once here and get 
@@ -1366,7 +1429,14 @@ namespace TSOpt {
       // extended axes - time step loop is explicit
 
       // here more = more records
-      for (panelindex=first; panelindex<=last; panelindex++) {
+      first = task_init(panelnum,dynsched);
+      for (panelindex=first; panelindex>=0; panelindex=task_advance()) {
+	// step through external extended indices, first axis fastest
+	int rem = panelindex;
+	for (int i=g.dim+1; i<g.gdim; i++) {
+	  step[i] = start[i] + rem % (stop[i]-start[i]+1);
+	  rem /= stop[i]-start[i]+1;
+	}
 	/*
 	for (int i=0;i<w->getStateArray().size();i++) {
 	  if (int err=rd_a_zero(&((w->getStateArray()[i]->model).ld_a))) {
@@ -1382,13 +1452,13 @@ namespace TSOpt {
 	  if (panelindex==first) {
 	    drystr<<"\n*** IWaveSim: model="<<ic.iwave_model<<" fwd="<<fwd<<" deriv="<<order<<"\n";
 	  }
-	  drystr<<"    panel="<<panelindex<<" in range=["<<first<<", "<<last<<"], rank="<<retrieveGlobalRank()<<endl;
+	  drystr<<"    panel="<<panelindex<<" of "<<panelnum<<", rank="<<retrieveGlobalRank()<<endl;
 	}
 	else {
 	  if (panelindex==first && retrieveGlobalRank()==0) {
 	    announce<<"\n*** IWaveSim: model="<<ic.iwave_model<<" fwd="<<fwd<<" deriv="<<order<<"\n";
 	  }
-	  announce<<"    panel="<<panelindex<<" in range=["<<first<<", "<<last<<"], rank="<<retrieveGlobalRank()<<endl;
+	  announce<<"    panel="<<panelindex<<" of "<<panelnum<<", rank="<<retrieveGlobalRank()<<endl;
 
 #ifdef IWAVE_VERBOSE
 	  announce<<"simulation grid:\n";
@@ -1449,6 +1519,22 @@ namespace TSOpt {
 	    else { 
 	      //	      cerr<<"rk="<<retrieveGlobalRank()<<": timestep\n";
 	      for (int iv=0;iv<fd_numsubsteps(ic);iv++) {
+#ifdef IWAVE_USE_MPI
+		// overlap: update strips next to subdomain faces, post
+		// exchange, update interior while messages move
+		if (overlap && ic.get_partstep()) {
+		  IPNT wl, wr;
+		  synch_widths(w->getStateArray()[0],iv,ic,wl,wr);
+		  if (ic.get_partstep()(w->getRDOMArray(),fwd,iv,fdm,0,wl,wr)) {
+		    std::vector<MPI_Request> req;
+		    for (size_t k=0; k<w->getStateArray().size(); k++) 
+		      synch_post(w->getStateArray()[k],iv,ic,stream,req);
+		    ic.get_partstep()(w->getRDOMArray(),fwd,iv,fdm,1,wl,wr);
+		    synch_wait(req);
+		    continue;
+		  }
+		}
+#endif
 		//		cerr<<"timestep\n";
 		ic.get_timestep()(w->getRDOMArray(),fwd,iv,fdm);
 		//	      	cerr<<"synch\n";
@@ -1465,6 +1551,9 @@ namespace TSOpt {
 	  }
 	  
 	  if (dryrun) drystr<<"\n";
+	  // simulation done - fix next panel, so that samplers know
+	  // whether to save stacked output
+	  task_claim();
 	  step[g.dim]=stop[g.dim];
 	  for (size_t i=0; i<t.size(); i++) {
 	    if (s[i]) {
@@ -1538,6 +1627,7 @@ namespace TSOpt {
 	  if (dryrun) {
 	    drystr<<"->"<<at<<"; ref step = "<<it<<endl;
 	  }
+	  task_claim();
 	  step[g.dim]=at;
 
 	  for (size_t i=0; i<t.size(); i++) {
@@ -1560,19 +1650,6 @@ namespace TSOpt {
 	  ostringstream ostr;
 	  Revolve r(stop[g.dim]-start[g.dim],snaps,ostr);
 
-	  for (int i=0;i<snaps;i++) {
-	    for (int j=0;j<(int)pow2(order-1);j++) {
-	      for (int l=0;l<ndyn;l++) {
-		if (int err=ra_a_zero(&(cps[i][j][l]))) {
-		  RVLException e;
-		  e<<"Error: IWaveSim from ra_create - zero rarray\n"; 
-		  e<<"  snapindex="<<i<<" iwaveindex="<<j<<" rarrindex="<<l<<"\n";
-		  e<<"  err = "<<err<<"\n";
-		}
-	      }
-	    }
-	  }
-
 	  std::vector<int> cplist(snaps);
 	  int it = start[g.dim]; // ref state index
 	  int at = stop[g.dim];  // pert state index
@@ -1616,11 +1693,12 @@ namespace TSOpt {
 		int l = 0;
 		for (int k=0;k<RDOM_MAX_NARR;k++) {
 		  if (fd_isarr(k,w->getStateArray()[0]->model,ic) && fd_isdyn(k,ic)) {		  
-		    if (ra_a_copy(&(cps[cp][j][l]),&(((w->getRefRDOMArray())[j])->_s[k]))) {
-		      RVLException e;
-		      e<<"Error: IWaveSim::run\n";
-		      e<<"attempt to store checkpoint "<<cp
-		       <<" encountered error from ra_a_copy\n";
+		    try {
+		      cps->put(cp,j*ndyn+l,((w->getRefRDOMArray())[j])->_s[k]);
+		    }
+		    catch (RVLException & e) {
+		      e<<"\ncalled from IWaveSim::run\n";
+		      e<<"attempt to store checkpoint "<<cp<<"\n";
 		      e<<"IWAVE index = "<<j<<" checkpoint RARR index = "
 		       <<l<<" RDOM RARR index = "<<k<<"\n";
 		      throw e;
@@ -1780,11 +1858,12 @@ namespace TSOpt {
 		int l = 0;
 		for (int k=0;k<RDOM_MAX_NARR;k++) {
 		  if (fd_isarr(k,w->getStateArray()[0]->model,ic) && fd_isdyn(k,ic)) {		  
-		    if (ra_a_copy(&(((w->getRefRDOMArray())[j])->_s[k]),&(cps[cp][j][l]))) {
-		      RVLException e;
-		      e<<"Error: IWaveSim::run\n";
-		      e<<"attempt to restore checkpoint "<<cp
-		       <<" encountered error from ra_a_copy\n";
+		    try {
+		      cps->get(cp,j*ndyn+l,((w->getRefRDOMArray())[j])->_s[k]);
+		    }
+		    catch (RVLException & e) {
+		      e<<"\ncalled from IWaveSim::run\n";
+		      e<<"attempt to restore checkpoint "<<cp<<"\n";
 		      e<<"IWAVE index = "<<j<<" checkpoint RARR index = "
 		       <<l<<" RDOM RARR index = "<<k<<"\n";
 		      throw e;
@@ -1811,6 +1890,7 @@ namespace TSOpt {
 
 	  // final sample
 	  if (dryrun) drystr<<"\n";
+	  task_claim();
 	  step[g.dim]=at;
 	  for (size_t i=0; i<t.size(); i++) {
 	    // pert sample
@@ -1823,6 +1903,7 @@ namespace TSOpt {
 	  }
 	  // for dry run, dump revolve output to
 	  // dry run file. Else to sim output.
+	  cps->write(ostr);
 	  if (dryrun) drystr<<"\nRevolve report:\n"<<ostr.str()<<"\n";
 	  else (fprintf(stream,"\nRevolve report:\n%s\n",ostr.str().c_str()));
 
@@ -1845,7 +1926,8 @@ namespace TSOpt {
 	   }
 	   }
 	*/
-	// sanity check
+	// sanity check - step is reset from the next panelindex at the
+	// top of the loop, so advancing it here only checks and reports
 	if (!(next_step(g,step)) && (panelindex != panelnum-1)) {
 	  RVLException e;
 	  e<<"Error: IWaveSim::run\n";
@@ -1860,6 +1942,7 @@ namespace TSOpt {
 	  }
 	}
       }
+      task_close();
     }
     catch (RVLException & e) {
       e<<"\ncalled from IWaveSim::run\n";
@@ -1881,6 +1964,7 @@ namespace TSOpt {
     if (!fwd) {
       str<<"  number of checkpoint states = "<<snaps<<"\n";
       str<<"  number of checkpoint RARRs  = "<<narr<<"\n";
+      if (cps) cps->write(str);
     }
     return str;
   } 
@@ -155,8 +155,15 @@ namespace TSOpt {
 	if (suf.size()>0) e<<"  suffix = "<<suf<<"\n";
 	throw e;
       }
+      // BindParams: an in-core grid component (GridDC, single panel,
+      // native_float, serial build) binds its buffer to its file in
+      // the IWAVE file manager, so IWaveSim reads and writes the
+      // buffer instead of the file. Everything else is passed as a
+      // file, as with AssignParams: SEGY traces (SEGYDC keeps one
+      // trace in core at a time, so there is no image to bind),
+      // out-of-core grids, and all grids in MPI builds
       for (size_t i=0;i<sp.getKeys().size();i++) {
-	AssignParams ap(pars,sp.getKeys()[i]+suf,stream);
+	BindParams ap(pars,sp.getKeys()[i]+suf,stream);
 	cx[i].eval(ap);
       }
     }
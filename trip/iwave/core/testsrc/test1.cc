@@ -0,0 +1,129 @@
+// tests CheckpointStore lossless compression (cpcomp=1): records
+// of several lengths, stored in several checkpoints and overwritten,
+// must come back bit for bit - success if every restored record is
+// identical to the stored one, and the smooth records compress
+
+#include "usempi.h"
+#include "cpstore.hh"
+
+using namespace RVL;
+using namespace TSOpt;
+
+char ** xargv;
+
+// smooth wavefield with a zero border, a sign change and a few
+// special values, different for each seed
+static void fill(RARR & a, int seed) {
+  IPNT gs, ge;
+  ra_a_gse(&a,gs,ge);
+  int n0 = ge[0]-gs[0]+1;
+  int n1 = ge[1]-gs[1]+1;
+  for (int i1=0; i1<n1; i1++) {
+    for (int i0=0; i0<n0; i0++) {
+      ireal x = 0.0;
+      if (i0 > 4 && i0 < n0-5 && i1 > 4 && i1 < n1-5)
+	x = sin(0.3*i0+0.1*seed)*cos(0.2*i1)*exp(-0.01*(i1-n1/2)*(i1-n1/2));
+      a._s0[i0+n0*i1] = x;
+    }
+  }
+  a._s0[n0*n1/2] = -0.0;
+  a._s0[n0*n1/2+1] = 1.e-40*seed;
+  a._s0[n0*n1/2+2] = 3.e+30;
+}
+
+int main(int argc, char ** argv) {
+
+  int rk=0;
+
+#ifdef IWAVE_USE_MPI
+  MPI_Init(&argc,&argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rk);
+#endif
+
+  try {
+
+    if (rk==0) {
+
+      cout<<"CheckpointStore Unit Test 1"<<endl;
+      cout<<"lossless compression (cpcomp=1), 3 checkpoints of 2 records"<<endl;
+
+      PARARRAY * par = ps_new();
+      ps_slint(*par,"cpcomp",1);
+
+      IPNT gs, ge[2];
+      IASN(gs,IPNT_0);
+      ge[0][0]=60; ge[0][1]=46;
+      ge[1][0]=33; ge[1][1]=70;
+
+      int snaps=3;
+      std::vector<size_t> len(2);
+      std::vector<RARR> in(2*snaps);
+      for (int r=0; r<2; r++) {
+	len[r]=(ge[r][0]+1)*(ge[r][1]+1);
+	for (int cp=0; cp<snaps; cp++) {
+	  ra_setnull(&(in[cp*2+r]));
+	  ra_create(&(in[cp*2+r]),2,gs,ge[r]);
+	}
+      }
+      RARR out;
+      ra_setnull(&out);
+
+      CheckpointStore cps(*par,snaps,len);
+
+      // store all, then overwrite checkpoint 1 with new data
+      for (int cp=0; cp<snaps; cp++) {
+	for (int r=0; r<2; r++) {
+	  fill(in[cp*2+r],cp*2+r);
+	  cps.put(cp,r,in[cp*2+r]);
+	}
+      }
+      for (int r=0; r<2; r++) {
+	fill(in[2+r],10+r);
+	cps.put(1,r,in[2+r]);
+      }
+
+      // restore in reverse order, twice
+      bool same=true;
+      for (int pass=0; pass<2; pass++) {
+	for (int cp=snaps-1; cp>=0; cp--) {
+	  for (int r=0; r<2; r++) {
+	    ra_create(&out,2,gs,ge[r]);
+	    ra_zero(&out);
+	    cps.get(cp,r,out);
+	    if (memcmp(out._s0,in[cp*2+r]._s0,len[r]*sizeof(ireal))) {
+	      cout<<"checkpoint "<<cp<<" record "<<r<<" pass "<<pass<<" differs"<<endl;
+	      same=false;
+	    }
+	    ra_destroy(&out);
+	  }
+	}
+      }
+      cout<<"all records restored bit-exact = "<<(same ? "yes" : "no")<<endl;
+
+      // compression ratio, from the summary
+      ostringstream str;
+      cps.write(str);
+      size_t i=str.str().find("compression ratio = ");
+      float ratio=0.0f;
+      if (i!=string::npos)
+	sscanf(str.str().c_str()+i,"compression ratio = %f",&ratio);
+      cout<<"records compressed = "<<((ratio > 1.0f) ? "yes" : "no")<<endl;
+
+      for (size_t k=0; k<in.size(); k++) ra_destroy(&(in[k]));
+      ps_delete(&par);
+    }
+
+#ifdef IWAVE_USE_MPI
+    MPI_Finalize();
+#endif
+    return(0);
+  }
+  catch (RVLException & e) {
+    e.write(cerr);
+#ifdef IWAVE_USE_MPI
+    MPI_Abort(MPI_COMM_WORLD,0);
+#endif
+    exit(1);
+  }
+
+}
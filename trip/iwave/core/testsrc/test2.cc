@@ -0,0 +1,124 @@
+// tests CheckpointStore lossy compression (cpcomp=2): for several
+// values of cptol, the pointwise error of each restored record must
+// not exceed cptol times the max absolute value of the record -
+// success if the bound holds for every record, the nonzero records
+// are actually quantized (not stored losslessly), and a record of
+// zeros comes back exactly
+
+#include "usempi.h"
+#include "cpstore.hh"
+
+using namespace RVL;
+using namespace TSOpt;
+
+char ** xargv;
+
+// smooth wavefield with a zero border and a sharp spike, scaled by
+// amp, different for each seed
+static void fill(RARR & a, int seed, ireal amp) {
+  IPNT gs, ge;
+  ra_a_gse(&a,gs,ge);
+  int n0 = ge[0]-gs[0]+1;
+  int n1 = ge[1]-gs[1]+1;
+  for (int i1=0; i1<n1; i1++) {
+    for (int i0=0; i0<n0; i0++) {
+      ireal x = 0.0;
+      if (i0 > 4 && i0 < n0-5 && i1 > 4 && i1 < n1-5)
+	x = amp*sin(0.3*i0+0.1*seed)*cos(0.2*i1)*exp(-0.01*(i1-n1/2)*(i1-n1/2));
+      a._s0[i0+n0*i1] = x;
+    }
+  }
+  a._s0[n0*n1/3] = -2.0*amp;
+}
+
+int main(int argc, char ** argv) {
+
+  int rk=0;
+
+#ifdef IWAVE_USE_MPI
+  MPI_Init(&argc,&argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rk);
+#endif
+
+  try {
+
+    if (rk==0) {
+
+      cout<<"CheckpointStore Unit Test 2"<<endl;
+      cout<<"lossy compression (cpcomp=2), 2 checkpoints of 3 records"<<endl;
+
+      IPNT gs, ge;
+      IASN(gs,IPNT_0);
+      ge[0]=60; ge[1]=46;
+      int snaps=2;
+      std::vector<size_t> len(3,(ge[0]+1)*(ge[1]+1));
+      ireal amp[3] = {1.0, 1.e-6, 0.0};
+
+      std::vector<RARR> in(3*snaps);
+      for (size_t k=0; k<in.size(); k++) {
+	ra_setnull(&(in[k]));
+	ra_create(&(in[k]),2,gs,ge);
+	fill(in[k],k,amp[k%3]);
+      }
+      RARR out;
+      ra_setnull(&out);
+      ra_create(&out,2,gs,ge);
+
+      double tols[3] = {1.e-2, 1.e-4, 1.e-6};
+      for (int it=0; it<3; it++) {
+
+	PARARRAY * par = ps_new();
+	ps_slint(*par,"cpcomp",2);
+	ps_sldouble(*par,"cptol",tols[it]);
+	CheckpointStore cps(*par,snaps,len);
+
+	for (int cp=0; cp<snaps; cp++)
+	  for (int r=0; r<3; r++) cps.put(cp,r,in[cp*3+r]);
+
+	bool bound=true;
+	bool quant=true;
+	bool zero=true;
+	for (int cp=snaps-1; cp>=0; cp--) {
+	  for (int r=0; r<3; r++) {
+	    RARR & a = in[cp*3+r];
+	    ra_zero(&out);
+	    cps.get(cp,r,out);
+	    double amax=0.0, emax=0.0;
+	    for (size_t i=0; i<len[r]; i++) {
+	      amax = iwave_max(amax,fabs(a._s0[i]));
+	      emax = iwave_max(emax,fabs(out._s0[i]-a._s0[i]));
+	    }
+	    if (emax > tols[it]*amax) {
+	      cout<<"checkpoint "<<cp<<" record "<<r<<": error "<<emax
+		  <<" exceeds "<<tols[it]<<" * "<<amax<<endl;
+	      bound=false;
+	    }
+	    bool same = !memcmp(out._s0,a._s0,len[r]*sizeof(ireal));
+	    if (amp[r]==0.0 && !same) zero=false;
+	    if (amp[r]!=0.0 && same) quant=false;
+	  }
+	}
+	cout<<"cptol="<<tols[it]<<": error within bound = "<<(bound ? "yes" : "no")
+	    <<", quantized = "<<(quant ? "yes" : "no")
+	    <<", zero record exact = "<<(zero ? "yes" : "no")<<endl;
+	ps_delete(&par);
+      }
+
+      ra_destroy(&out);
+      for (size_t k=0; k<in.size(); k++) ra_destroy(&(in[k]));
+    }
+
+#ifdef IWAVE_USE_MPI
+    MPI_Finalize();
+#endif
+    return(0);
+  }
+  catch (RVLException & e) {
+    e.write(cerr);
+#ifdef IWAVE_USE_MPI
+    MPI_Abort(MPI_COMM_WORLD,0);
+#endif
+    exit(1);
+  }
+
+}
@@ -0,0 +1,139 @@
+// tests CheckpointStore spill to disk: with a memory budget (cpmem)
+// of about one record, most records go to the scratch file in cpdir -
+// success if records are spilled, every record comes back bit for
+// bit, also after all checkpoints are overwritten, with and without
+// lossless compression, and no scratch file is left in cpdir
+
+#include "usempi.h"
+#include "cpstore.hh"
+#include <dirent.h>
+
+using namespace RVL;
+using namespace TSOpt;
+
+char ** xargv;
+
+// smooth wavefield with a zero border, different for each seed
+static void fill(RARR & a, int seed) {
+  IPNT gs, ge;
+  ra_a_gse(&a,gs,ge);
+  int n0 = ge[0]-gs[0]+1;
+  int n1 = ge[1]-gs[1]+1;
+  for (int i1=0; i1<n1; i1++) {
+    for (int i0=0; i0<n0; i0++) {
+      ireal x = 0.0;
+      if (i0 > 4 && i0 < n0-5 && i1 > 4 && i1 < n1-5)
+	x = sin(0.3*i0+0.1*seed)*cos(0.2*i1+0.05*seed)*exp(-0.001*i1*i1);
+      a._s0[i0+n0*i1] = x;
+    }
+  }
+}
+
+// number of files in the working directory named like scratch files
+static int nscratch() {
+  int n=0;
+  DIR * d = opendir(".");
+  if (!d) return -1;
+  struct dirent * e;
+  while ((e = readdir(d)))
+    if (!strncmp(e->d_name,"cp.",3)) n++;
+  closedir(d);
+  return n;
+}
+
+int main(int argc, char ** argv) {
+
+  int rk=0;
+
+#ifdef IWAVE_USE_MPI
+  MPI_Init(&argc,&argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rk);
+#endif
+
+  try {
+
+    if (rk==0) {
+
+      cout<<"CheckpointStore Unit Test 3"<<endl;
+      cout<<"spill to scratch file (cpmem=0.02, records of 0.011 MB),"<<endl;
+      cout<<"4 checkpoints of 2 records, each checkpoint stored twice"<<endl;
+
+      IPNT gs, ge;
+      IASN(gs,IPNT_0);
+      ge[0]=60; ge[1]=46;
+      int snaps=4;
+      std::vector<size_t> len(2,(ge[0]+1)*(ge[1]+1));
+
+      std::vector<RARR> in(2*snaps);
+      for (size_t k=0; k<in.size(); k++) {
+	ra_setnull(&(in[k]));
+	ra_create(&(in[k]),2,gs,ge);
+      }
+      RARR out;
+      ra_setnull(&out);
+      ra_create(&out,2,gs,ge);
+
+      for (int comp=0; comp<2; comp++) {
+
+	PARARRAY * par = ps_new();
+	ps_slint(*par,"cpcomp",comp);
+	ps_sldouble(*par,"cpmem",0.02);
+	ps_slcstring(*par,"cpdir",".");
+
+	int nspill=0;
+	bool same=true;
+	{
+	  CheckpointStore cps(*par,snaps,len);
+
+	  for (int pass=0; pass<2; pass++) {
+	    for (int cp=0; cp<snaps; cp++) {
+	      for (int r=0; r<2; r++) {
+		fill(in[cp*2+r],10*pass+cp*2+r);
+		cps.put(cp,r,in[cp*2+r]);
+	      }
+	    }
+	    // restore in reverse order, as the adjoint loop does
+	    for (int cp=snaps-1; cp>=0; cp--) {
+	      for (int r=0; r<2; r++) {
+		ra_zero(&out);
+		cps.get(cp,r,out);
+		if (memcmp(out._s0,in[cp*2+r]._s0,len[r]*sizeof(ireal))) {
+		  cout<<"checkpoint "<<cp<<" record "<<r<<" pass "<<pass<<" differs"<<endl;
+		  same=false;
+		}
+	      }
+	    }
+	  }
+
+	  // number of records spilled, from the summary
+	  ostringstream str;
+	  cps.write(str);
+	  size_t i=str.str().find("spilled to . = ");
+	  if (i!=string::npos)
+	    sscanf(str.str().c_str()+i,"spilled to . = %d",&nspill);
+	}
+
+	cout<<"cpcomp="<<comp<<": records spilled = "<<((nspill > 0) ? "yes" : "no")
+	    <<", restored bit-exact = "<<(same ? "yes" : "no")
+	    <<", scratch file removed = "<<((nscratch()==0) ? "yes" : "no")<<endl;
+	ps_delete(&par);
+      }
+
+      ra_destroy(&out);
+      for (size_t k=0; k<in.size(); k++) ra_destroy(&(in[k]));
+    }
+
+#ifdef IWAVE_USE_MPI
+    MPI_Finalize();
+#endif
+    return(0);
+  }
+  catch (RVLException & e) {
+    e.write(cerr);
+#ifdef IWAVE_USE_MPI
+    MPI_Abort(MPI_COMM_WORLD,0);
+#endif
+    exit(1);
+  }
+
+}
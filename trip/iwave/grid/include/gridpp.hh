@@ -36,6 +36,9 @@ namespace TSOpt {
 
   using RVL::OCDC;
   using RVL::ConstContainer;
+  using RVL::FunctionObjectConstEval;
+  using RVL::AssignParams;
+  using RVL::BindParams;
   using RVL::STRING_PAIR;
   using RVL::RVLException;
   using RVL::ScalarFieldTraits;
@@ -72,6 +75,8 @@ namespace TSOpt {
     mutable int panelindex;   // chunk index
     int panelnum;             // number of chunks
     mutable bool rd;          // set if last op is read, unset on write
+    mutable bool istmp;       // data file is temporary
+    mutable bool bound;       // buffer bound to data file - see eval
 
     GridDC();
     GridDC(GridDC const &);
@@ -81,6 +86,11 @@ namespace TSOpt {
     /** private file access method - used in reset */
 
     void open_p() const;
+    /** bind buffer to data file in file manager (single panel,
+	serial, native format only - otherwise no-op) */
+    void bind_p() const;
+    /** write back bound buffer, release binding */
+    void unbind_p() const;
     ContentPackage<ireal,RARR> & get(bool & more);
     ContentPackage<ireal,RARR> const & get(bool & more) const;
     void put() const;
@@ -105,6 +115,24 @@ namespace TSOpt {
 	   ostream & _outfile = cerr);
     /** destructor */
     ~GridDC();
+
+    /** FOR eval: BindParams binds the in-core buffer to the data
+	file in the IWAVE file manager (iwave_fbind), so that the
+	serial rsfread and rsfwrite read and write the buffer and no
+	i/o takes place until the file is needed again. Any other
+	AssignParams hands out the filename to an evaluator which may
+	use the file directly, so brings it up to date and releases
+	the binding. Otherwise as for OCDC.
+
+	Only single-panel native_float grids in serial builds are
+	bound. In MPI builds mpirsfread and mpirsfwrite read and write
+	the file on rank 0 without the memory image, so the file stays
+	the data and BindParams acts as AssignParams.
+    */
+    using OCDC<ireal, RARR>::eval;
+    void eval(FunctionObjectConstEval & f, 
+	      vector<DataContainer const *> & x) const;
+
     bool isInCore() const;
     string getProtohdr() const;
     ostream & write(ostream & str) const;
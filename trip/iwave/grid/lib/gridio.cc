@@ -398,6 +398,8 @@ int rsfread_base(ireal * a,
 
   FILE * fp = NULL;
   float * fbuf;    /* input buffer for read */
+  float * mem = NULL; /* memory image of data file, if bound */
+  size_t mlen = 0; /* length of image (bytes) */
 
   /* XDR buffers etc. */
 #ifdef SUXDR
@@ -426,10 +428,12 @@ int rsfread_base(ireal * a,
    * END DECLARATIONS       *
    **************************/
 
-  /* open data file */
+  /* open data file - unless bound to memory image, in which case
+     the image is current and the file may not be */
 #ifdef IWAVE_USE_FMGR
-  fp=iwave_const_fopen(dname,"r",protodata,stream);
-  if (!fp) {
+  if (!strcmp(type,"native_float")) mem=(float *)iwave_fmem(dname,&mlen,0);
+  if (!mem) fp=iwave_const_fopen(dname,"r",protodata,stream);
+  if (!mem && !fp) {
     fprintf(stream,"Error: rsfread - read from iwave_fopen, file = %s\n",dname);
     return E_FILE;
   }
@@ -499,9 +503,27 @@ int rsfread_base(ireal * a,
   
   recsize_b = gl_na[0]*sizeof(float);
 
+  /* memory image copy loop */
+
+  if (mem) {
+    for (i=0;i<(int)noffs;i++) {
+      if (!err && (goffs[i]+gl_na[0])*sizeof(float) + cur_pos > mlen) {
+	fprintf(stream,"Error: rsfread - segment at file offset %ld beyond end of memory image\n",(intmax_t)(goffs[i]*sizeof(float)+cur_pos));
+	err=E_FILE;
+      }
+      if (!err) {
+#ifdef UPDATE
+	for (j=0;j<gl_na[0];j++) { *(a+loffs[i]+j)+=scale*mem[goffs[i]+cur_pos/sizeof(float)+j]; }
+#else
+	for (j=0;j<gl_na[0];j++) { *(a+loffs[i]+j)=mem[goffs[i]+cur_pos/sizeof(float)+j]; }
+#endif
+      }
+    }
+  }
+
   /* native read loop */
   
-  if (!strcmp(type,"native_float")) {
+  else if (!strcmp(type,"native_float")) {
 
     /* allocate read buffer */
     fbuf=(float *)usermalloc_(recsize_b);
@@ -596,13 +618,14 @@ int rsfread_base(ireal * a,
   }
 #endif
 
-  fflush(fp);
-
+  if (fp) {
+    fflush(fp);
 #ifdef IWAVE_USE_FMGR
-  iwave_fclose(fp);
+    iwave_fclose(fp);
 #else
-  fclose(fp);
+    fclose(fp);
 #endif
+  }
 
   /* extension loop - extend by const along axes dim-1,..,0.
    */
@@ -853,6 +876,8 @@ int rsfwrite_proto(ireal * a,
   IPNT gl_na;      /* lengths of grid intersection axes, local or global */
   FILE * fp = NULL;
   FILE * fph = NULL;
+  float * mem = NULL; /* memory image of data file, if bound */
+  size_t mlen = 0; /* length of image (bytes) */
   PARARRAY * par = NULL;
 
   /*  char * schar;*/
@@ -1022,11 +1047,13 @@ int rsfwrite_proto(ireal * a,
   */
   fp=NULL;
 #ifdef IWAVE_USE_FMGR
-  fp=iwave_const_fopen(ldname,"r+",NULL,stream);
+  /* bound to memory image: write image, which is then newer than file */
+  if (!strcmp(ltype,"native_float")) mem=(float *)iwave_fmem(ldname,&mlen,1);
+  if (!mem) fp=iwave_const_fopen(ldname,"r+",NULL,stream);
 #else
   p=fopen(ldname,"r+")
 #endif
-    if (!fp) {
+    if (!mem && !fp) {
       fprintf(stream,"Error: rsfwrite from fopen: cannot open file=%s\n",ldname);
       return E_FILE;
     }
@@ -1045,7 +1072,23 @@ int rsfwrite_proto(ireal * a,
   panelindex = panelindex % get_panelnum_grid(g);
   cur_pos = panelindex * get_datasize_grid(g) * sizeof(float);
 
-  if (!strcmp(ltype,"native_float")) {
+  if (mem) {
+    for (i=0;i<(int)noffs;i++) {
+      if (!err && (goffs[i]+na[0])*sizeof(float) + cur_pos > mlen) {
+	fprintf(stream,"Error: rsfwrite - segment at file offset %ld beyond end of memory image\n",(intmax_t)(goffs[i]*sizeof(float)+cur_pos));
+	err=E_FILE;
+      }
+      if (!err) {
+#ifdef UPDATE
+	for (j=0;j<na[0];j++) { mem[goffs[i]+cur_pos/sizeof(float)+j]=scale * (*(a+loffs[i]+j)); }
+#else
+	for (j=0;j<na[0];j++) { mem[goffs[i]+cur_pos/sizeof(float)+j]=*(a+loffs[i]+j); }
+#endif
+      }
+    }
+  }
+
+  else if (!strcmp(ltype,"native_float")) {
 
     /* allocate float buffer */
     fbuf=(float *)usermalloc_(recsize_b);
@@ -1162,12 +1205,14 @@ int rsfwrite_proto(ireal * a,
   userfree_(ldname);
   userfree_(ltype);
   ps_delete(&par);
-  fflush(fp);
+  if (fp) {
+    fflush(fp);
 #ifdef IWAVE_USE_FMGR
-  iwave_fclose(fp);
+    iwave_fclose(fp);
 #else
-  fclose(fp);
+    fclose(fp);
 #endif
+  }
 
   return err;
 }
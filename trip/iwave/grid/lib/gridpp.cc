@@ -104,6 +104,7 @@ namespace TSOpt {
 
       // record datafile for future use
       datafile = name;
+      istmp = true;
 	
 #ifdef FRUITCAKE
       outfile<<"  open_p: temp data file "<<datafile<<" opened on file ptr "<<fp<<"\n";
@@ -341,17 +342,18 @@ namespace TSOpt {
 	throw e;
       }
 
-      // read data into buffer
+      // read data into buffer - unless bound, in which case
+      // buffer is current
       size_t ngrid;
       ra_a_datasize(&(buf.getMetadata()),&ngrid);
       off_t cur_pos = panelindex * ngrid * sizeof(float);
-      if (fseeko(fp,cur_pos,SEEK_SET)) {
+      if (!bound && fseeko(fp,cur_pos,SEEK_SET)) {
 	RVLException e;
 	e<<"Error: GridDC::get (mutable)\n";
 	e<<"  from fseeko, metafile = "<<this->getFilename()<<"panelindex="<<panelindex<<"\n";
 	throw e;
       }
-      if (ngrid != fread(buf.getData(),sizeof(float),ngrid,fp)) {
+      if (!bound && ngrid != fread(buf.getData(),sizeof(float),ngrid,fp)) {
 	RVLException e;
 	e<<"Error: GridDC::get (mutable)\n";
 	e<<"  from fread, metafile = "<<this->getFilename()<<" panelindex="<<panelindex<<"\n";
@@ -406,17 +408,18 @@ namespace TSOpt {
 	throw e;
       }
 
-      // read data into buffer
+      // read data into buffer - unless bound, in which case
+      // buffer is current
       size_t ngrid;
       ra_a_datasize(&(buf.getMetadata()),&ngrid);
       off_t cur_pos = panelindex * ngrid * sizeof(float);
-      if (fseeko(fp,cur_pos,SEEK_SET)) {
+      if (!bound && fseeko(fp,cur_pos,SEEK_SET)) {
 	RVLException e;
 	e<<"Error: GridDC::get (const)\n";
 	e<<"  from fseeko, metafile = "<<this->getFilename()<<"panelindex="<<panelindex<<"\n";
 	throw e;
       }
-      if (ngrid != fread(buf.getData(),sizeof(float),ngrid,fp)) {
+      if (!bound && ngrid != fread(buf.getData(),sizeof(float),ngrid,fp)) {
 	RVLException e;
 	e<<"Error: GridDC::get (const)\n";
 	e<<"  from fread, metafile = "<<this->getFilename()<<"panelindex="<<panelindex<<"\n";
@@ -479,20 +482,22 @@ namespace TSOpt {
       size_t ngrid;
       ra_a_datasize(&(buf.getMetadata()),&ngrid);
       off_t cur_pos = panelindex * ngrid * sizeof(float);
-      if (fseeko(fp,cur_pos,SEEK_SET)) {
+      // bound: buffer is the data, flag file as stale
+      if (bound) iwave_fmem(datafile.c_str(),NULL,1);
+      if (!bound && fseeko(fp,cur_pos,SEEK_SET)) {
 	RVLException e;
 	e<<"Error: GridDC::put\n";
 	e<<"  from fseeko, metafile = "<<this->getFilename()<<"panelindex="<<panelindex<<"\n";
 	throw e;
       }
-      if (ngrid != fwrite(buf.getData(),sizeof(float),ngrid,fp)) {
+      if (!bound && ngrid != fwrite(buf.getData(),sizeof(float),ngrid,fp)) {
 	RVLException e;
 	e<<"Error: GridDC::put\n";
 	e<<"  from fwrite, metafile = "<<this->getFilename()<<"panelindex="<<panelindex<<"\n";
 	throw e;
       }
       
-      fflush(fp);
+      if (!bound) fflush(fp);
 #ifdef FRUITCAKE
       iwave_fprintall(stderr);
       outfile<<"  write "<<ngrid<<" floats at offset "<<cur_pos<<" FILE* = "<<fp<<endl;
@@ -548,7 +553,9 @@ namespace TSOpt {
       fp(NULL),
       panelindex(0),
       panelnum(1),
-      rd(false)
+      rd(false),
+      istmp(false),
+      bound(false)
        {
 
     // NB: no sanity tests here, compatibility presumed
@@ -603,10 +610,71 @@ namespace TSOpt {
     
   /** destructor */
   GridDC::~GridDC() {
+    // bound archival data has yet to reach the file, temp data is 
+    // scratch
+    if (bound) {
+      if (!istmp && iwave_fsync(fp)) 
+	outfile<<"Error: GridDC destructor - failed to write back data file "
+	       <<datafile<<"\n";
+      iwave_funbind(fp);
+    }
     iwave_fclose(fp);
     iwave_fclose(fph);
   }
 
+  void GridDC::bind_p() const {
+#ifndef IWAVE_USE_MPI
+    // mpirsfread does not use the file manager; the file remains the data
+    if (bound || panelnum != 1 || data_format != "native_float") return;
+    try {
+      // read buffer once, from here on it is current
+      bool more = true;
+      this->reset();
+      this->get(more);
+      this->reset();
+      rd=false;
+      size_t ngrid;
+      ra_a_datasize(&(buf.getMetadata()),&ngrid);
+      if (iwave_fbind(fp,buf.getData(),ngrid*sizeof(float))) {
+	RVLException e;
+	e<<"Error: GridDC::bind_p\n";
+	e<<"  data file "<<datafile<<" not in file manager\n";
+	throw e;
+      }
+      bound=true;
+    }
+    catch (RVLException & e) {
+      e<<"\ncalled from GridDC::bind_p\n";
+      throw e;
+    }
+#endif
+  }
+
+  void GridDC::unbind_p() const {
+    if (!bound) return;
+    if (iwave_fsync(fp)) {
+      RVLException e;
+      e<<"Error: GridDC::unbind_p\n";
+      e<<"  failed to write back data file "<<datafile<<"\n";
+      throw e;
+    }
+    iwave_funbind(fp);
+    bound=false;
+  }
+
+  void GridDC::eval(FunctionObjectConstEval & f, 
+		    vector<DataContainer const *> & x) const {
+    try {
+      OCDC<ireal, RARR>::eval(f,x);
+      if (dynamic_cast<BindParams *>(&f)) this->bind_p();
+      else if (dynamic_cast<AssignParams *>(&f)) this->unbind_p();
+    }
+    catch (RVLException & e) {
+      e<<"\ncalled from GridDC::eval(FOR)\n";
+      throw e;
+    }
+  }
+
   bool GridDC::isInCore() const { 
     if (panelnum==1) return true;
     return false;
@@ -746,6 +814,8 @@ namespace TSOpt {
   GridDCF::GridDCF(GridDCF const & f) 
     : protohdr(f.protohdr),
       protodata(f.protodata),
+      data_format(f.data_format),
+      data_type(f.data_type),
       outfile(f.outfile),
       protog(f.protog),
       scfac(f.scfac),
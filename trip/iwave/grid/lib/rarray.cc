@@ -1057,7 +1057,7 @@ int ra_setexchangeinfo(RARR *arr, EXCHANGEINFO *einfo)
 	{
 		err = MPI_Type_vector(n[1], n[0], arr->_dims[0].n0, IWAVE_MPI_REAL, &(einfo->type2));
 		if ( err != MPI_SUCCESS ) return E_MPI;
-		err = MPI_Type_hvector(n[2], 1, arr->_dims[0].n0 * arr->_dims[1].n0 * sizeof(ireal), einfo->type2, &(einfo->type));
+		err = MPI_Type_create_hvector(n[2], 1, arr->_dims[0].n0 * arr->_dims[1].n0 * sizeof(ireal), einfo->type2, &(einfo->type));
 		if ( err != MPI_SUCCESS )
 		{
 			MPI_Type_free(&(einfo->type2));
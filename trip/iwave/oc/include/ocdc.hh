@@ -182,6 +182,24 @@ namespace RVL {
     string getName() const { string ret="AssignParams"; return ret; }
   };
 
+  /** AssignParams for evaluators which do not need the file to be
+      up to date, because they reach the data by some other route
+      that the OCDC subclass provides. What that route is, and when
+      it applies, is up to the subclass. OCDCs which make no such
+      provision treat it exactly as AssignParams.
+  */
+  class BindParams: public AssignParams {
+  private:
+    BindParams();
+    BindParams(BindParams const &);
+  public:
+    BindParams(PARARRAY & par, FILE * _stream=stderr)
+      : AssignParams(par,_stream) {}
+    BindParams(PARARRAY & par, string _tag, FILE * _stream=stderr)
+      : AssignParams(par,_tag,_stream) {}
+    string getName() const { string ret="BindParams"; return ret; }
+  };
+
   /** OCDC - simply PackageContainer with file management
       attributes */
   template<typename T, typename M>
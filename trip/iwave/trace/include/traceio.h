@@ -137,6 +137,21 @@ typedef struct s_tracegeom {
   /** offset of trace in file */
   /*  off_t troff[MAX_TRACES]; */
   off_t * troff;
+  /** sampling operator, precomputed from ig, rg by sampletraces:
+      entries sprow[itr]...sprow[itr+1]-1 of offset and weight arrays
+      define the interpolation terms for trace itr */
+  int * sprow;
+  /** offsets of operator entries into sampled array */
+  int * spoff;
+  /** weights of operator entries */
+  ireal * spw;
+  /** operator set flag, and order and grid arguments for which it was built */
+  int spset;
+  int sporder;
+  IPNT spn0;
+  IPNT spgs0;
+  IPNT spn;
+  IPNT spgs;
 #ifdef IWAVE_USE_MPI
   /** datatype for trace augmented with file offset */
   MPI_Datatype p;
@@ -323,6 +338,12 @@ void print_tracegeom(tracegeom const * tg);
     factor of cell volume ratio is applied - that is, time step /
     volume of spatial cell.
 
+    Sampling is implemented by a sparse matrix (offsets and weights of
+    all interpolation terms falling in the computational grid), built
+    on first call and rebuilt only when order or grid arguments change
+    or a new record is initialized. Each call is then a gather (save)
+    or scatter (load) with the same weights.
+
     @param[out] tg (tracegeom) trace geometry - output for save, input for
     load. defines sampling of grid, samples saved to buffer tg.buf in save
     mode, loaded from tg.buf in load mode.
@@ -414,4 +435,28 @@ int writetraces(tracegeom const * tg,
 */
 void calc_group(int * first, int * last, int nrec);
 
+/* 18.10.26: task (record, panel) scheduling for groups
+
+   task_init - collective on global comm: start scheduling ntask
+   tasks, dynamic=1 lets groups pull tasks from a shared queue as they
+   finish, dynamic=0 gives each group its block from calc_group.
+   returns first task of this group, -1 if none.
+
+   task_claim - collective on group: fix the next task of this group,
+   call when the current task is done except for output. 
+
+   task_advance - collective on group: move on to the next task (claim
+   first if necessary), returns its index, -1 if none.
+
+   task_group - replaces calc_group while scheduling ntask tasks: first
+   task of this group, and last task once known (else ntask-1).
+
+   task_close - collective on global comm: end scheduling.
+*/
+int task_init(int ntask, int dynamic);
+void task_claim();
+int task_advance();
+void task_group(int * first, int * last, int ntask);
+void task_close();
+
 #endif
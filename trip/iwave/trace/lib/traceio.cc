@@ -115,10 +115,8 @@ void buildMPI_OFFSEGY(MPI_Datatype * ptr, int ns) {
   disps[0]=0;
   for (i=1;i<nblks;i++) 
     disps[i]=disps[i-1]+lengs[i-1]*sizes[i-1];
-  /* deprecated */
-  MPI_Type_struct(nblks,lengs,disps,types,ptr); 
-  /* supposedly more up-to-date */
-  /*  MPI_Type_create_struct(nblks,lengs,disps,types,ptr); */
+  /* MPI_Type_struct deprecated, removed in MPI-3 */
+  MPI_Type_create_struct(nblks,lengs,disps,types,ptr);
   MPI_Type_commit(ptr);
 
 }
@@ -165,6 +163,122 @@ void calc_group(int * first, int * last,
   
 }
 
+/* 18.10.26: dynamic task scheduling. With calc_group, each group 
+   simulates a fixed block of tasks (records, panels), so one slow 
+   task idles all other groups. Here group g starts with task g, 
+   then its root pulls the next task index from a counter held by 
+   global rank 0 when the current task is done (MPI one-sided 
+   fetch-and-add). The window is allocated by MPI, so that it can use 
+   shared memory or network atomics - with MPI_Win_create on user 
+   memory, Open MPI served requests only when rank 0 called MPI, 
+   which put every group back in step with group 0. Tasks 
+   of a group come in increasing order, so the last task overall 
+   (ntask-1) is also last in its group. Without MPI, or with 
+   dynamic=0, tasks are taken in the order of calc_group.
+*/
+
+static int tk_ntask=0;   /* number of tasks, 0 = not scheduling */
+static int tk_dyn=0;     /* dynamic flag */
+static int tk_first=0;   /* first task of this group */
+static int tk_last=-1;   /* last task of this group, static case */
+static int tk_cur=-1;    /* current task, -1 = none left */
+static int tk_next=-1;   /* next task, -1 = none left */
+static int tk_claimed=0; /* next task known */
+#ifdef IWAVE_USE_MPI
+static MPI_Win tk_win=MPI_WIN_NULL; /* counter window on global rank 0 */
+#endif
+
+int task_init(int ntask, int dynamic) {
+
+  int ng=retrieveNumGroups();
+  int g =retrieveGroupID();
+
+  tk_ntask=ntask;
+  tk_dyn=dynamic && (ng > 1);
+  tk_claimed=0;
+  tk_next=-1;
+
+  if (tk_dyn) {
+    tk_first=g;
+    tk_cur=(g < ntask) ? g : -1;
+#ifdef IWAVE_USE_MPI
+    {
+      int * count;
+      int rkw=retrieveGlobalRank();
+      MPI_Win_allocate((rkw==0) ? sizeof(int) : 0,sizeof(int),
+		       MPI_INFO_NULL,retrieveGlobalComm(),&count,&tk_win);
+      if (rkw==0) {
+	MPI_Win_lock(MPI_LOCK_EXCLUSIVE,0,0,tk_win);
+	*count=ng;
+	MPI_Win_unlock(0,tk_win);
+      }
+      MPI_Barrier(retrieveGlobalComm());
+    }
+#endif
+  }
+  else {
+    calc_group(&tk_first,&tk_last,ntask);
+    tk_cur=(tk_first <= tk_last) ? tk_first : -1;
+  }
+  return tk_cur;
+}
+
+void task_claim() {
+
+  if (tk_claimed || tk_ntask==0) return;
+  tk_claimed=1;
+  tk_next=-1;
+  if (tk_cur < 0) return;
+
+  if (!tk_dyn) {
+    if (tk_cur < tk_last) tk_next=tk_cur+1;
+    return;
+  }
+
+#ifdef IWAVE_USE_MPI
+  {
+    int one=1;
+    if (retrieveRank()==0) {
+      MPI_Win_lock(MPI_LOCK_SHARED,0,0,tk_win);
+      MPI_Fetch_and_op(&one,&tk_next,MPI_INT,0,0,MPI_SUM,tk_win);
+      MPI_Win_unlock(0,tk_win);
+      if (tk_next >= tk_ntask) tk_next=-1;
+    }
+    if (retrieveSize() > 1) 
+      MPI_Bcast(&tk_next,1,MPI_INT,0,retrieveComm());
+  }
+#else
+  if (tk_cur < tk_ntask-1) tk_next=tk_cur+1;
+#endif
+}
+
+int task_advance() {
+  task_claim();
+  tk_cur=tk_next;
+  tk_claimed=0;
+  return tk_cur;
+}
+
+void task_group(int * first, int * last, int ntask) {
+
+  if (tk_ntask != ntask) {
+    calc_group(first,last,ntask);
+    return;
+  }
+  *first=tk_first;
+  if (!tk_dyn) *last=tk_last;
+  else if (tk_claimed && tk_next < 0) *last=tk_cur;
+  else *last=ntask-1;
+}
+
+void task_close() {
+#ifdef IWAVE_USE_MPI
+  if (tk_win != MPI_WIN_NULL) MPI_Win_free(&tk_win);
+#endif
+  tk_ntask=0;
+  tk_claimed=0;
+}
+
 int traceserver_init(FILE ** fpin, const char * fin,
 		     int * irec, int * xrec, 
 		     int * first, int * last,
@@ -771,6 +885,154 @@ int traceserver_put(FILE * fp,
 }
 
 // dt, added 19.12.13 WWS
+/* 18.10.26: sampling operator precomputed as sparse matrix (CSR),
+   row itr = trace, one entry per interpolation term whose grid point
+   lies in the computational grid, in the order in which the terms
+   were formerly accumulated. Same weights used for save and load, so
+   these remain adjoint. Operator depends on grid arguments of
+   sampletraces, so is rebuilt whenever these change, and on
+   receiver positions, so is invalidated by init_tracegeom. */
+
+static void free_sampleop(tracegeom * tg) {
+  if (tg->sprow) userfree_(tg->sprow);
+  if (tg->spoff) userfree_(tg->spoff);
+  if (tg->spw) userfree_(tg->spw);
+  tg->sprow=NULL;
+  tg->spoff=NULL;
+  tg->spw=NULL;
+  tg->spset=0;
+}
+
+static int sampleop_valid(tracegeom const * tg,
+			  int order,
+			  IPNT n0,
+			  IPNT gs0,
+			  IPNT n,
+			  IPNT gs) {
+  int i;
+  if (!tg->spset || tg->sporder != order) return 0;
+  for (i=0;i<tg->ndim;i++) 
+    if (tg->spn0[i]!=n0[i] || tg->spgs0[i]!=gs0[i] ||
+	tg->spn[i]!=n[i] || tg->spgs[i]!=gs[i]) return 0;
+  return 1;
+}
+
+/* cell corners, in order of accumulation in former sampletraces */
+static const int sampleop_corner[8][3] = 
+  { {0,0,0}, {1,0,0}, {0,1,0}, {0,0,1},
+    {1,1,0}, {1,0,1}, {0,1,1}, {1,1,1} };
+
+/* offset and weight of term ic of trace itr, returns 0 if the term
+   does not contribute (corner off axis or outside computational grid) */
+static int sampleop_term(tracegeom const * tg,
+			 int itr,
+			 int ic,
+			 int order,
+			 IPNT n0,
+			 IPNT gs0,
+			 IPNT n,
+			 IPNT gs,
+			 int * ioff,
+			 ireal * w) {
+  int ndim = tg->ndim;
+  int i;
+  IPNT ind;
+  double wd;
+
+  /* skip corners along axes beyond problem dimension */
+  for (i=ndim;i<3;i++) if (sampleop_corner[ic][i]) return 0;
+  IASN(ind,IPNT_0);
+  *ioff=0;
+  for (i=ndim-1;i>-1;i--) {
+    ind[i]=(tg->ig)[itr][i]+sampleop_corner[ic][i];
+    *ioff=(*ioff)*n0[i]+ind[i]-gs0[i];
+  }
+  if (!ingrid(ndim,n,gs,ind)) return 0;
+  wd=1.0;
+  if (order==1) {
+    for (i=0;i<ndim;i++) {
+      if (i==0) wd = sampleop_corner[ic][0] ? (tg->rg)[itr][0] : (1.0-(tg->rg)[itr][0]);
+      else wd *= sampleop_corner[ic][i] ? (tg->rg)[itr][i] : (1.0-(tg->rg)[itr][i]);
+    }
+  }
+  *w=wd;
+  return 1;
+}
+
+static int build_sampleop(tracegeom * tg,
+			  int order,
+			  IPNT n0,
+			  IPNT gs0,
+			  IPNT n,
+			  IPNT gs) {
+  int nc = (order==0) ? 1 : 8;
+  int itr, ic, k;
+
+  free_sampleop(tg);
+  if (tg->ndim < 1 || tg->ndim > 3) return E_BADINPUT;
+
+  tg->sprow = (int *)usermalloc_((tg->ntraces+1)*sizeof(int));
+  if (tg->ntraces) {
+    tg->spoff = (int *)usermalloc_(tg->ntraces*nc*sizeof(int));
+    tg->spw = (ireal *)usermalloc_(tg->ntraces*nc*sizeof(ireal));
+  }
+  if (!tg->sprow || (tg->ntraces && (!tg->spoff || !tg->spw))) {
+    free_sampleop(tg);
+    return E_ALLOC;
+  }
+
+  k=0;
+  for (itr=0;itr<tg->ntraces;itr++) {
+    tg->sprow[itr]=k;
+    for (ic=0;ic<nc;ic++) 
+      if (sampleop_term(tg,itr,ic,order,n0,gs0,n,gs,
+			&(tg->spoff[k]),&(tg->spw[k]))) k++;
+  }
+  tg->sprow[tg->ntraces]=k;
+
+  tg->spset=1;
+  tg->sporder=order;
+  IASN(tg->spn0,n0);
+  IASN(tg->spgs0,gs0);
+  IASN(tg->spn,n);
+  IASN(tg->spgs,gs);
+
+  return 0;
+}
+
+/* fallback if the operator cannot be stored: same terms, same
+   arithmetic, recomputed for every trace */
+static void sampletraces_direct(tracegeom * tg,
+				int order,
+				int load,
+				int it,
+				IPNT n0,
+				IPNT gs0,
+				IPNT n,
+				IPNT gs,
+				ireal * d,
+				ireal fac) {
+  int nc = (order==0) ? 1 : 8;
+  int itr, ic, ioff;
+  ireal w;
+  float * b;
+
+  for (itr=0;itr<tg->ntraces;itr++) {
+    b = tg->buf+it+itr*tg->nt;
+    for (ic=0;ic<nc;ic++) {
+      if (!sampleop_term(tg,itr,ic,order,n0,gs0,n,gs,&ioff,&w)) continue;
+      if (load) {
+	if (order==0) d[ioff]+=fac*(*b);
+	else d[ioff]+=fac*w*(*b);
+      }
+      else {
+	if (order==0) *b+=fac*d[ioff];
+	else *b+=w*fac*d[ioff];
+      }
+    }
+  }
+}
+
 int construct_tracegeom(tracegeom * tg,
 			const char * data,
 			float dt, 
@@ -1196,6 +1458,9 @@ int init_tracegeom(tracegeom * tg,
 
   tg->ntraces=0;  /* number of traces located in grid */
 
+  /* receiver positions change, so sampling operator must be rebuilt */
+  free_sampleop(tg);
+
 
   /*  if (rk==0) fprintf(stderr,"in init: call tr_seek\n");*/
   /*  fprintf(stream,"rk=%d call traceserver_seek\n",retrieveRank()); */
@@ -1617,6 +1882,7 @@ void destroy_tracegeom(tracegeom * tg) {
   if (tg->tracf) userfree_(tg->tracf); tg->tracf=NULL;
   if (tg->fldr) userfree_(tg->fldr); tg->fldr=NULL;
   if (tg->troff) userfree_(tg->troff); tg->troff=NULL;
+  free_sampleop(tg);
 
 #ifdef IWAVE_USE_MPI
   MPI_Type_free(&(tg->p));
@@ -1650,6 +1916,11 @@ void setnull_tracegeom(tracegeom * tg) {
   tg->fldr=NULL;
   tg->troff=NULL;
   /* end addition */
+  tg->sprow=NULL;
+  tg->spoff=NULL;
+  tg->spw=NULL;
+  tg->spset=0;
+  tg->sporder=0;
   tg->ntraces=0;
   tg->nt=0;
   tg->ntout=0;
@@ -1805,375 +2076,60 @@ void sampletraces(tracegeom * tg,
    *****************************************/
 
   int itr;    /* trace counter */
-  int ioff=0;   /* offset into sampled array */
-  /*  int moff;   offset into multiplier array */
-  int ndim;   /* problem dimension */
-  IPNT ind;   /* integer part of sample coords */
-  
-  if (it<0 || it>tg->nt-1) return;
-  
-  ndim=tg->ndim;
-  IASN(ind,IPNT_0);
-  /*  default value for multiplier, just to make code simple 
-  // this is now an input - 03.12
-  //  mult=REAL_ONE; */
-  /* generic scale factor - accounts for weights on L2 norms for
-     viewing load option as adjoint of save
-  */
-  /* big change 03.12: scale by mult; also by ratio of cell vols for adjoint */
-  //  if (load) fac=mult*tg->dt/tg->dvol;
-  // else fac=mult;
-  /* bigger change 02.14: scale factor computed externally */
+  int k;      /* operator entry counter */
+  float * b;  /* current trace sample */
 
-  for (itr=0;itr<tg->ntraces;itr++) {
+  if (it<0 || it>tg->nt-1) return;
+  if (order!=0 && order!=1) return;
 
-    /* set up index tuple, grid offset */
-    if (ndim > 0) {
-      ind[0]=(tg->ig)[itr][0];
-      ioff = ind[0]-gs0[0];
-    }
-    if (ndim > 1) {
-      ind[1]=(tg->ig)[itr][1];
-      ioff+= (ind[1]-gs0[1] )*n0[0];
-    }
-    if (ndim > 2) {
-      ind[2]=(tg->ig)[itr][2];
-      ioff+= (ind[2]-gs0[2] )*n0[0] *n0[1];      
+  if (!sampleop_valid(tg,order,n0,gs0,n,gs)) {
+    if (build_sampleop(tg,order,n0,gs0,n,gs)) {
+      if (tg->ndim < 1 || tg->ndim > 3) {
+	fprintf(stderr,"Error: sampletraces\n");
+	fprintf(stderr,"grid dimension %d not in range [1,3]\n",tg->ndim);
+#ifdef IWAVE_USE_MPI
+	MPI_Abort(retrieveGlobalComm(),E_BADINPUT);
+#else
+	exit(1);
+#endif
+      }
+      /* out of memory for operator - sample without it */
+      sampletraces_direct(tg,order,load,it,n0,gs0,n,gs,d,fac);
+      return;
     }
+  }
 
-    if (load) {
-
-      //#ifdef IWAVE_VERBOSE
-      //      fprintf(stderr,"sampletraces load: itr=%d it=%d buf=%15.7e ioff=%d ind[0]=%d ind[1]=%d\n",itr,it,(tg->buf)[it+itr*tg->nt],ioff,ind[0],ind[1]);
-      //#endif	
-       
-      if (order==0) {
-	if (ingrid(ndim,n,gs,ind)) {
-	    /*	  mult=fac; */
-	    /*	  if (m && ingrid(ndim,nm,gsm,ind)) mult*=m[moff]; */
-	  d[ioff]+=fac*(tg->buf)[it+itr*tg->nt];
-	}
-      }
-
-      else if (order==1) {
-	if (ndim==1) {
-	  /* 0,0,0 */
-	  if (ingrid(ndim,n,gs,ind)) {
-	      /*	    moff=ind[0]-gs0m[0];
-	    //	    mult=fac;
-	    //	    if (m && ingrid(ndim,nm,gsm,ind)) mult*=m[moff]; */
-	    d[ioff]+=fac*
-	      (1.0-(tg->rg)[itr][0])*
-	      (tg->buf)[it+itr*tg->nt];
-	  }
-	  /* 1,0,0 */
-	  ind[0]++;
-	  if (ingrid(ndim,n,gs,ind)) {
-	      /*	    moff=ind[0]-gs0m[0];
-	    //	    mult=fac;
-	    //	    if (m && ingrid(ndim,nm,gsm,ind)) mult*=m[moff+1]; */
-	    d[ioff+1]+=fac*
-	      (tg->rg)[itr][0]*
-	      (tg->buf)[it+itr*tg->nt];
-	  }
-	  ind[0]--;
-	}
-	else if (ndim == 2) {
-	  /* 0,0,0 */
-	  if (ingrid(ndim,n,gs,ind)) {
-	      /*	    moff=ind[0]-gs0m[0] + (ind[1]-gs0m[1])*n0m[0];
-	    //	    mult=fac;
-	    //	    if (m && ingrid(ndim,nm,gsm,ind)) mult*=m[moff]; */	    
-	    d[ioff]+=fac*
-	      (1.0-(tg->rg)[itr][0])*
-	      (1.0-(tg->rg)[itr][1])*
-	      (tg->buf)[it+itr*tg->nt];
-	    /*	    printf("sampletraces: itr=%d ig=[0,0] ind=[%d,%d] moff=%d m=%20.14e\n",itr,ind[0],ind[1],moff,m[moff]); */
-	  }
-	  /* 1,0,0 */
-	  ind[0]++;
-	  if (ingrid(ndim,n,gs,ind)) {
-	      /*	    moff=ind[0]-gs0m[0] + (ind[1]-gs0m[1])*n0m[0];
-	    //	    mult=fac;
-	    //	    if (m && ingrid(ndim,nm,gsm,ind)) mult*=m[moff]; */
-	    d[ioff+1]+=fac*
-	      (tg->rg)[itr][0]*
-	      (1.0-(tg->rg)[itr][1])*
-	      (tg->buf)[it+itr*tg->nt];
-	    /*	    printf("sampletraces: itr=%d ig=[1,0] ind=[%d,%d] moff=%d m=%20.14e\n",itr,ind[0],ind[1],moff,m[moff]); */
-	  }
-	  ind[0]--;
-	  /* 0,1,0 */
-	  ind[1]++;
-	  if (ingrid(ndim,n,gs,ind)) {
-	      /*	    mult=fac;
-	    // 	    moff=ind[0]-gs0m[0] + (ind[1]-gs0m[1])*n0m[0];
-	    //	    if (m && ingrid(ndim,nm,gsm,ind)) mult*=m[moff]; */
-	    d[ioff+n0[0]]+=fac*
-	      (1.0-(tg->rg)[itr][0])*
-	      (tg->rg)[itr][1]*
-	      (tg->buf)[it+itr*tg->nt];
-	    /*	    printf("sampletraces: itr=%d ig=[0,1] ind=[%d,%d] moff=%d m=%20.14e\n",itr,ind[0],ind[1],moff,m[moff]); */
-	  }
-	  ind[1]--;
-	  /* 1,1,0 */
-	  ind[0]++;
-	  ind[1]++;
-	  if (ingrid(ndim,n,gs,ind)) {
-	      /*	    mult=fac;
-	    // 	    moff=ind[0]-gs0m[0] + (ind[1]-gs0m[1])*n0m[0];
-	    //	    if (m && ingrid(ndim,nm,gsm,ind)) mult*=m[moff+1+n0[0]]; */
-	    d[ioff+1+n0[0]]+=fac*
-	      (tg->rg)[itr][0]*
-	      (tg->rg)[itr][1]*
-	      (tg->buf)[it+itr*tg->nt];
-	    /*	    printf("sampletraces: itr=%d ig=[1,1] ind=[%d,%d] moff=%d m=%20.14e\n",itr,ind[0],ind[1],moff,m[moff]); */
-	  }
-	  ind[0]--;
-	  ind[1]--;
-	}
-	else if (ndim == 3) {
-	  /* 0,0,0 */
-	  if (ingrid(ndim,n,gs,ind)) {
-	      /*	    mult=fac;
-	    //	    moff=ind[0]-gs0m[0] + (ind[1]-gs0m[1])*n0m[0] + (ind[2]-gs0m[2])*n0m[0]*n0m[1];
-	    //	    if (m && ingrid(ndim,nm,gsm,ind)) 
-	    //	      mult*=m[moff]; */
-	    d[ioff]+=fac*
-	      (1.0-(tg->rg)[itr][0])*
-	      (1.0-(tg->rg)[itr][1])*
-	      (1.0-(tg->rg)[itr][2])*
-	      (tg->buf)[it+itr*tg->nt];
-	  }
-	  /* 1,0,0 */
-	  ind[0]++;
-	  if (ingrid(ndim,n,gs,ind)) {
-	      /*	    mult=fac;
-	    //	    moff=ind[0]-gs0m[0] + (ind[1]-gs0m[1])*n0m[0] + (ind[2]-gs0m[2])*n0m[0]*n0m[1];
-	    //	    if (m && ingrid(ndim,nm,gsm,ind)) 
-	    //	      mult*=m[moff+1]; */
-	    d[ioff+1]+=fac*
-	      (tg->rg)[itr][0]*
-	      (1.0-(tg->rg)[itr][1])*
-	      (1.0-(tg->rg)[itr][2])*
-	      (tg->buf)[it+itr*tg->nt];
-	  }
-	  ind[0]--;
-	  /* 0,1,0 */
-	  ind[1]++;
-	  if (ingrid(ndim,n,gs,ind)) {
-	      /*	    mult=fac;
-	    //	    moff=ind[0]-gs0m[0] + (ind[1]-gs0m[1])*n0m[0] + (ind[2]-gs0m[2])*n0m[0]*n0m[1];
-	    //	    if (m && ingrid(ndim,nm,gsm,ind)) 
-	    //	      mult*=m[moff+n0[0]]; */
-	    d[ioff+n0[0]]+=fac*
-	      (1.0-(tg->rg)[itr][0])*
-	      (tg->rg)[itr][1]*
-	      (1.0-(tg->rg)[itr][2])*
-	      (tg->buf)[it+itr*tg->nt];
-	  }
-	  ind[1]--;
-	  /* 0,0,1 */
-	  ind[2]++;
-	  if (ingrid(ndim,n,gs,ind)) {
-	      /*	    mult=fac;
-	    //	    moff=ind[0]-gs0m[0] + (ind[1]-gs0m[1])*n0m[0] + (ind[2]-gs0m[2])*n0m[0]*n0m[1];
-	    //	    if (m && ingrid(ndim,nm,gsm,ind)) 
-	    //	      mult*=m[moff+n0[0]*n0[1]]; */
-	    d[ioff+n0[0]*n0[1]]+=fac*
-	      (1.0-(tg->rg)[itr][0])*
-	      (1.0-(tg->rg)[itr][1])*
-	      (tg->rg)[itr][2]*
-	      (tg->buf)[it+itr*tg->nt];
-	  }
-	  ind[2]--;
-	  /* 1,1,0 */
-	  ind[0]++;
-	  ind[1]++;
-	  if (ingrid(ndim,n,gs,ind)) {
-	      /*	    mult=fac;
-	    //	    moff=ind[0]-gs0m[0] + (ind[1]-gs0m[1])*n0m[0] + (ind[2]-gs0m[2])*n0m[0]*n0m[1];
-	    //	    if (m && ingrid(ndim,nm,gsm,ind)) 
-	    //	      mult*=m[moff+1+n0[0]]; */
-	    d[ioff+1+n0[0]]+=fac*
-	      (tg->rg)[itr][0]*
-	      (tg->rg)[itr][1]*
-	      (1.0-(tg->rg)[itr][2])*
-	      (tg->buf)[it+itr*tg->nt];
-	  }
-	  ind[0]--;
-	  ind[1]--;
-	  /* 1,0,1 */
-	  ind[0]++;
-	  ind[2]++;
-	  if (ingrid(ndim,n,gs,ind)) {
-	      /*	    mult=fac;
-	    //	    moff=ind[0]-gs0m[0] + (ind[1]-gs0m[1])*n0m[0] + (ind[2]-gs0m[2])*n0m[0]*n0m[1];
-	    //	    if (m && ingrid(ndim,nm,gsm,ind)) 
-	    //	      mult*=m[moff+1+n0[0]*n0[1]]; */
-	    d[ioff+1+n0[0]*n0[1]]+=fac*
-	      (tg->rg)[itr][0]*
-	      (1.0-(tg->rg)[itr][1])*
-	      (tg->rg)[itr][2]*
-	      (tg->buf)[it+itr*tg->nt];
-	  }
-	  ind[0]--;
-	  ind[2]--;
-	  /* 0,1,1 */
-	  ind[1]++;
-	  ind[2]++;
-	  if (ingrid(ndim,n,gs,ind)) {
-	      /*	    mult=fac;
-	    //	    moff=ind[0]-gs0m[0] + (ind[1]-gs0m[1])*n0m[0] + (ind[2]-gs0m[2])*n0m[0]*n0m[1];
-	    //	    if (m && ingrid(ndim,nm,gsm,ind)) 
-	    //	      mult*=m[moff+n[0]+n0[0]*n0[1]]; */
-	    d[ioff+n0[0]+n0[0]*n0[1]]+=fac*
-	      (1.0-(tg->rg)[itr][0])*
-	      (tg->rg)[itr][1]*
-	      (tg->rg)[itr][2]*
-	      (tg->buf)[it+itr*tg->nt];
-	  }
-	  ind[1]--;
-	  ind[2]--;
-	  /* 1,1,1 */
-	  ind[0]++;
-	  ind[1]++;
-	  ind[2]++;
-	  if (ingrid(ndim,n,gs,ind)) {
-	      /*	    mult=fac;
-	    //	    moff=ind[0]-gs0m[0] + (ind[1]-gs0m[1])*n0m[0] + (ind[2]-gs0m[2])*n0m[0]*n0m[1];
-	    //	    if (m && ingrid(ndim,nm,gsm,ind))
-	    //	      mult*=m[moff+1+n0[0]+n0[0]*n0[1]]; */	    
-	    d[ioff+1+n0[0]+n0[0]*n0[1]]+=fac*
-	      (tg->rg)[itr][0]*
-	      (tg->rg)[itr][1]*
-	      (tg->rg)[itr][2]*
-	      (tg->buf)[it+itr*tg->nt];
-	  }
-	  ind[0]--;
-	  ind[1]--;
-	  ind[2]--;
-	}
-	else {
-	  return;
-	}
-      }
-      else {
-	return;
+  if (load) {
+    if (order==0) {
+      for (itr=0;itr<tg->ntraces;itr++) {
+	b = tg->buf+it+itr*tg->nt;
+	for (k=tg->sprow[itr];k<tg->sprow[itr+1];k++) 
+	  d[tg->spoff[k]]+=fac*(*b);
       }
     }
     else {
-      
-      /* this should be done ahead of time!!! */
-      /* (tg->buf)[it+itr*tg->nt]=REAL_ZERO;*/
-      
-      if (order==0) {
-	if (ingrid(ndim,n,gs,ind)) 
-	  (tg->buf)[it+itr*tg->nt]+=fac*d[ioff];
+      for (itr=0;itr<tg->ntraces;itr++) {
+	b = tg->buf+it+itr*tg->nt;
+	for (k=tg->sprow[itr];k<tg->sprow[itr+1];k++) 
+	  d[tg->spoff[k]]+=fac*tg->spw[k]*(*b);
       }
-
-      else if (order==1) {
-	if (ndim==1) {
-	  /* 0,0,0 */
-	  if (ingrid(ndim,n,gs,ind)) 
-	    (tg->buf)[it+itr*tg->nt]+=
-	      (1.0-(tg->rg)[itr][0])*fac*d[ioff];
-	  /* 1,0,0 */
-	  ind[0]++;
-	  if (ingrid(ndim,n,gs,ind)) 
-	    (tg->buf)[it+itr*tg->nt]+= (tg->rg)[itr][0]*fac*d[ioff+1];
-	  ind[0]--;
-	}
-	else if (ndim == 2) {
-	  /* 0,0,0 */
-	  if (ingrid(ndim,n,gs,ind)) 
-	    (tg->buf)[it+itr*tg->nt]+=
-	      (1.0-(tg->rg)[itr][0])*(1.0-(tg->rg)[itr][1])*fac*d[ioff];
-	  /* 1,0,0 */
-	  ind[0]++;
-	  if (ingrid(ndim,n,gs,ind)) 
-	    (tg->buf)[it+itr*tg->nt]+=
-	      (tg->rg)[itr][0]*(1.0-(tg->rg)[itr][1])*fac*d[ioff+1];
-	  ind[0]--;
-	  /* 0,1,0 */
-	  ind[1]++;
-	  if (ingrid(ndim,n,gs,ind)) 
-	    (tg->buf)[it+itr*tg->nt]+=
-	      (1.0-(tg->rg)[itr][0])*(tg->rg)[itr][1]*fac*d[ioff+n0[0]];
-	  ind[1]--;
-	  /* 1,1,0 */
-	  ind[0]++;
-	  ind[1]++;
-	  if (ingrid(ndim,n,gs,ind)) 
-	    (tg->buf)[it+itr*tg->nt]+=
-	      (tg->rg)[itr][0]*(tg->rg)[itr][1]*fac*d[ioff+1+n0[0]];
-	  ind[0]--;
-	  ind[1]--;
-	}
-	else if (ndim == 3) {
-	  /* 0,0,0 */
-	  if (ingrid(ndim,n,gs,ind)) 
-	    (tg->buf)[it+itr*tg->nt]+=
-	      (1.0-(tg->rg)[itr][0])*(1.0-(tg->rg)[itr][1])*(1.0-(tg->rg)[itr][2])*fac*d[ioff];
-	  /* 1,0,0 */
-	  ind[0]++;
-	  if (ingrid(ndim,n,gs,ind)) 
-	    (tg->buf)[it+itr*tg->nt]+=
-	      (tg->rg)[itr][0]*(1.0-(tg->rg)[itr][1])*(1.0-(tg->rg)[itr][2])*fac*d[ioff+1];
-	  ind[0]--;
-	  /* 0,1,0 */
-	  ind[1]++;
-	  if (ingrid(ndim,n,gs,ind)) 
-	    (tg->buf)[it+itr*tg->nt]+=
-	      (1.0-(tg->rg)[itr][0])*(tg->rg)[itr][1]*(1.0-(tg->rg)[itr][2])*fac*d[ioff+n0[0]];
-	  ind[1]--;
-	  /* 0,0,1 */
-	  ind[2]++;
-	  if (ingrid(ndim,n,gs,ind)) 
-	    (tg->buf)[it+itr*tg->nt]+=
-	      (1.0-(tg->rg)[itr][0])*(1.0-(tg->rg)[itr][1])*(tg->rg)[itr][2]*fac*d[ioff+n0[0]*n0[1]];
-	  ind[2]--;
-	  /* 1,1,0 */
-	  ind[0]++;
-	  ind[1]++;
-	  if (ingrid(ndim,n,gs,ind)) 
-	    (tg->buf)[it+itr*tg->nt]+=
-	      (tg->rg)[itr][0]*(tg->rg)[itr][1]*(1.0-(tg->rg)[itr][2])*fac*d[ioff+1+n0[0]];
-	  ind[0]--;
-	  ind[1]--;
-	  /* 1,0,1 */
-	  ind[0]++;
-	  ind[2]++;
-	  if (ingrid(ndim,n,gs,ind)) 
-	    (tg->buf)[it+itr*tg->nt]+=
-	      (tg->rg)[itr][0]*(1.0-(tg->rg)[itr][1])*(tg->rg)[itr][2]*fac*d[ioff+1+n0[0]*n0[1]];
-	  ind[0]--;
-	  ind[2]--;
-	  /* 0,1,1 */
-	  ind[1]++;
-	  ind[2]++;
-	  if (ingrid(ndim,n,gs,ind)) 
-	    (tg->buf)[it+itr*tg->nt]+=
-	      (1.0-(tg->rg)[itr][0])*(tg->rg)[itr][1]*(tg->rg)[itr][2]*fac*d[ioff+n0[0]+n0[0]*n0[1]];
-	  ind[1]--;
-	  ind[2]--;
-	  /* 1,1,1 */
-	  ind[0]++;
-	  ind[1]++;
-	  ind[2]++;
-	  if (ingrid(ndim,n,gs,ind)) 
-	    (tg->buf)[it+itr*tg->nt]+=
-	      (tg->rg)[itr][0]*(tg->rg)[itr][1]*(tg->rg)[itr][2]*fac*d[ioff+1+n0[0]+n0[0]*n0[1]];
-	  ind[0]--;
-	  ind[1]--;
-	  ind[2]--;
-	}
-	else {
-	  return;
-	}
+    }
+  }
+  else {
+    /* this should be done ahead of time!!! */
+    /* (tg->buf)[it+itr*tg->nt]=REAL_ZERO;*/
+    if (order==0) {
+      for (itr=0;itr<tg->ntraces;itr++) {
+	b = tg->buf+it+itr*tg->nt;
+	for (k=tg->sprow[itr];k<tg->sprow[itr+1];k++) 
+	  *b+=fac*d[tg->spoff[k]];
       }
-      else {
-	return;
+    }
+    else {
+      for (itr=0;itr<tg->ntraces;itr++) {
+	b = tg->buf+it+itr*tg->nt;
+	for (k=tg->sprow[itr];k<tg->sprow[itr+1];k++) 
+	  *b+=tg->spw[k]*fac*d[tg->spoff[k]];
       }
     }
   }
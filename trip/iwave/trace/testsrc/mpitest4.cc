@@ -0,0 +1,95 @@
+#include "traceio.h"
+#include <unistd.h>
+
+char ** xargv;
+
+/* task scheduler: every task done exactly once, last task of each
+   group flagged as such once claimed, and with dynamic scheduling a
+   slow group (rank 0) does fewer tasks than the others */
+
+#define NTASK 23
+
+int main(int argc, char ** argv) {
+
+  int rk=0;
+  int sz=1;
+  int dyn, it, first, last;
+  int cnt[NTASK];
+  int tot[NTASK];
+  int mine, nflag, badlast, ok, nslow, nmax;
+
+#ifdef IWAVE_USE_MPI
+  MPI_Init(&argc,&argv);
+  MPI_Comm_rank(MPI_COMM_WORLD,&rk);
+  MPI_Comm_size(MPI_COMM_WORLD,&sz);
+  storeGlobalComm(MPI_COMM_WORLD);
+  storeGlobalRank(rk);
+  storeGlobalSize(sz);
+  /* one process per group */
+  storeComm(MPI_COMM_SELF);
+#endif
+  storeRank(0);
+  storeSize(1);
+  storeNumGroups(sz);
+  storeGroupID(rk);
+
+  if (rk==0) {
+    printf("Task scheduler Unit Test 4\n");
+    printf("%d tasks over all groups, group 0 slow\n",NTASK);
+  }
+
+  for (dyn=0;dyn<2;dyn++) {
+
+    for (it=0;it<NTASK;it++) cnt[it]=0;
+    mine=0;
+    nflag=0;
+    badlast=0;
+
+    for (it=task_init(NTASK,dyn); it>=0; it=task_advance()) {
+      cnt[it]++;
+      mine++;
+      usleep((rk==0) ? 20000 : 1000);
+      /* before claim, last is a bound unless known from calc_group */
+      task_group(&first,&last,NTASK);
+      if (dyn && last==it && it!=NTASK-1) badlast++;
+      /* after claim, only the final task of the group is last */
+      task_claim();
+      task_group(&first,&last,NTASK);
+      if (it < first || it > last) badlast++;
+      if (last==it) nflag++;
+    }
+    if (mine > 0 && nflag != 1) badlast++;
+    task_close();
+
+#ifdef IWAVE_USE_MPI
+    MPI_Reduce(cnt,tot,NTASK,MPI_INT,MPI_SUM,0,MPI_COMM_WORLD);
+    MPI_Reduce(&badlast,&ok,1,MPI_INT,MPI_SUM,0,MPI_COMM_WORLD);
+    badlast=ok;
+    nslow=mine;
+    MPI_Bcast(&nslow,1,MPI_INT,0,MPI_COMM_WORLD);
+    MPI_Reduce(&mine,&nmax,1,MPI_INT,MPI_MAX,0,MPI_COMM_WORLD);
+#else
+    for (it=0;it<NTASK;it++) tot[it]=cnt[it];
+    nslow=mine;
+    nmax=mine;
+#endif
+
+    if (rk==0) {
+      ok=1;
+      for (it=0;it<NTASK;it++) ok = ok && (tot[it]==1);
+      printf("%s: each task done once = %s\n",
+	     dyn ? "dynamic" : "static ",ok ? "yes" : "no");
+      printf("%s: group range consistent = %s\n",
+	     dyn ? "dynamic" : "static ",badlast ? "no" : "yes");
+      if (dyn)
+	printf("dynamic: slow group does fewer tasks = %s\n",
+	       (sz==1 || nslow < nmax) ? "yes" : "no");
+    }
+  }
+
+#ifdef IWAVE_USE_MPI
+  MPI_Finalize();
+#endif
+
+  return(0);
+}
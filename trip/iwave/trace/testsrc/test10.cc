@@ -0,0 +1,417 @@
+// tests sampletraces against the per-trace interpolation loop it
+// replaced (copied below as oldsampletraces): orders 0 and 1, save and
+// load, in 1, 2 and 3 dimensions. Receivers lie inside the
+// computational grid, on its edges, in the ghost layer and off the
+// allocated grid, with relative coordinates from 0 to nearly 1. Order
+// 0 must be identical; order 1 must agree to float precision, as the
+// old loop mixed float and double products.
+
+#include "usempi.h"
+#include "traceio.h"
+
+#include <iostream>
+#include <cmath>
+
+using namespace std;
+
+int ingrid(int ndim, IPNT n, IPNT gs, IPNT itr);
+
+#define NT 3
+#define NPOS 6
+#define NFRAC 5
+
+static void oldsampletraces(tracegeom * tg,
+			     int order,
+			     int load,
+			     int it,
+			     IPNT n0,
+			     IPNT gs0,
+			     IPNT n,
+			     IPNT gs,
+			     ireal * d,
+			     ireal fac) {
+  int itr;
+  int ioff=0;
+  int ndim;
+  IPNT ind;
+  if (it<0 || it>tg->nt-1) return;
+  ndim=tg->ndim;
+  IASN(ind,IPNT_0);
+  for (itr=0;itr<tg->ntraces;itr++) {
+    if (ndim > 0) {
+      ind[0]=(tg->ig)[itr][0];
+      ioff = ind[0]-gs0[0];
+    }
+    if (ndim > 1) {
+      ind[1]=(tg->ig)[itr][1];
+      ioff+= (ind[1]-gs0[1] )*n0[0];
+    }
+    if (ndim > 2) {
+      ind[2]=(tg->ig)[itr][2];
+      ioff+= (ind[2]-gs0[2] )*n0[0] *n0[1];
+    }
+    if (load) {
+      if (order==0) {
+	if (ingrid(ndim,n,gs,ind)) {
+	  d[ioff]+=fac*(tg->buf)[it+itr*tg->nt];
+	}
+      }
+      else if (order==1) {
+	if (ndim==1) {
+	  if (ingrid(ndim,n,gs,ind)) {
+	    d[ioff]+=fac*
+	      (1.0-(tg->rg)[itr][0])*
+	      (tg->buf)[it+itr*tg->nt];
+	  }
+	  ind[0]++;
+	  if (ingrid(ndim,n,gs,ind)) {
+	    d[ioff+1]+=fac*
+	      (tg->rg)[itr][0]*
+	      (tg->buf)[it+itr*tg->nt];
+	  }
+	  ind[0]--;
+	}
+	else if (ndim == 2) {
+	  if (ingrid(ndim,n,gs,ind)) {
+	    d[ioff]+=fac*
+	      (1.0-(tg->rg)[itr][0])*
+	      (1.0-(tg->rg)[itr][1])*
+	      (tg->buf)[it+itr*tg->nt];
+	  }
+	  ind[0]++;
+	  if (ingrid(ndim,n,gs,ind)) {
+	    d[ioff+1]+=fac*
+	      (tg->rg)[itr][0]*
+	      (1.0-(tg->rg)[itr][1])*
+	      (tg->buf)[it+itr*tg->nt];
+	  }
+	  ind[0]--;
+	  ind[1]++;
+	  if (ingrid(ndim,n,gs,ind)) {
+	    d[ioff+n0[0]]+=fac*
+	      (1.0-(tg->rg)[itr][0])*
+	      (tg->rg)[itr][1]*
+	      (tg->buf)[it+itr*tg->nt];
+	  }
+	  ind[1]--;
+	  ind[0]++;
+	  ind[1]++;
+	  if (ingrid(ndim,n,gs,ind)) {
+	    d[ioff+1+n0[0]]+=fac*
+	      (tg->rg)[itr][0]*
+	      (tg->rg)[itr][1]*
+	      (tg->buf)[it+itr*tg->nt];
+	  }
+	  ind[0]--;
+	  ind[1]--;
+	}
+	else if (ndim == 3) {
+	  if (ingrid(ndim,n,gs,ind)) {
+	    d[ioff]+=fac*
+	      (1.0-(tg->rg)[itr][0])*
+	      (1.0-(tg->rg)[itr][1])*
+	      (1.0-(tg->rg)[itr][2])*
+	      (tg->buf)[it+itr*tg->nt];
+	  }
+	  ind[0]++;
+	  if (ingrid(ndim,n,gs,ind)) {
+	    d[ioff+1]+=fac*
+	      (tg->rg)[itr][0]*
+	      (1.0-(tg->rg)[itr][1])*
+	      (1.0-(tg->rg)[itr][2])*
+	      (tg->buf)[it+itr*tg->nt];
+	  }
+	  ind[0]--;
+	  ind[1]++;
+	  if (ingrid(ndim,n,gs,ind)) {
+	    d[ioff+n0[0]]+=fac*
+	      (1.0-(tg->rg)[itr][0])*
+	      (tg->rg)[itr][1]*
+	      (1.0-(tg->rg)[itr][2])*
+	      (tg->buf)[it+itr*tg->nt];
+	  }
+	  ind[1]--;
+	  ind[2]++;
+	  if (ingrid(ndim,n,gs,ind)) {
+	    d[ioff+n0[0]*n0[1]]+=fac*
+	      (1.0-(tg->rg)[itr][0])*
+	      (1.0-(tg->rg)[itr][1])*
+	      (tg->rg)[itr][2]*
+	      (tg->buf)[it+itr*tg->nt];
+	  }
+	  ind[2]--;
+	  ind[0]++;
+	  ind[1]++;
+	  if (ingrid(ndim,n,gs,ind)) {
+	    d[ioff+1+n0[0]]+=fac*
+	      (tg->rg)[itr][0]*
+	      (tg->rg)[itr][1]*
+	      (1.0-(tg->rg)[itr][2])*
+	      (tg->buf)[it+itr*tg->nt];
+	  }
+	  ind[0]--;
+	  ind[1]--;
+	  ind[0]++;
+	  ind[2]++;
+	  if (ingrid(ndim,n,gs,ind)) {
+	    d[ioff+1+n0[0]*n0[1]]+=fac*
+	      (tg->rg)[itr][0]*
+	      (1.0-(tg->rg)[itr][1])*
+	      (tg->rg)[itr][2]*
+	      (tg->buf)[it+itr*tg->nt];
+	  }
+	  ind[0]--;
+	  ind[2]--;
+	  ind[1]++;
+	  ind[2]++;
+	  if (ingrid(ndim,n,gs,ind)) {
+	    d[ioff+n0[0]+n0[0]*n0[1]]+=fac*
+	      (1.0-(tg->rg)[itr][0])*
+	      (tg->rg)[itr][1]*
+	      (tg->rg)[itr][2]*
+	      (tg->buf)[it+itr*tg->nt];
+	  }
+	  ind[1]--;
+	  ind[2]--;
+	  ind[0]++;
+	  ind[1]++;
+	  ind[2]++;
+	  if (ingrid(ndim,n,gs,ind)) {
+	    d[ioff+1+n0[0]+n0[0]*n0[1]]+=fac*
+	      (tg->rg)[itr][0]*
+	      (tg->rg)[itr][1]*
+	      (tg->rg)[itr][2]*
+	      (tg->buf)[it+itr*tg->nt];
+	  }
+	  ind[0]--;
+	  ind[1]--;
+	  ind[2]--;
+	}
+	else {
+	  return;
+	}
+      }
+      else {
+	return;
+      }
+    }
+    else {
+      if (order==0) {
+	if (ingrid(ndim,n,gs,ind))
+	  (tg->buf)[it+itr*tg->nt]+=fac*d[ioff];
+      }
+      else if (order==1) {
+	if (ndim==1) {
+	  if (ingrid(ndim,n,gs,ind))
+	    (tg->buf)[it+itr*tg->nt]+=
+	      (1.0-(tg->rg)[itr][0])*fac*d[ioff];
+	  ind[0]++;
+	  if (ingrid(ndim,n,gs,ind))
+	    (tg->buf)[it+itr*tg->nt]+= (tg->rg)[itr][0]*fac*d[ioff+1];
+	  ind[0]--;
+	}
+	else if (ndim == 2) {
+	  if (ingrid(ndim,n,gs,ind))
+	    (tg->buf)[it+itr*tg->nt]+=
+	      (1.0-(tg->rg)[itr][0])*(1.0-(tg->rg)[itr][1])*fac*d[ioff];
+	  ind[0]++;
+	  if (ingrid(ndim,n,gs,ind))
+	    (tg->buf)[it+itr*tg->nt]+=
+	      (tg->rg)[itr][0]*(1.0-(tg->rg)[itr][1])*fac*d[ioff+1];
+	  ind[0]--;
+	  ind[1]++;
+	  if (ingrid(ndim,n,gs,ind))
+	    (tg->buf)[it+itr*tg->nt]+=
+	      (1.0-(tg->rg)[itr][0])*(tg->rg)[itr][1]*fac*d[ioff+n0[0]];
+	  ind[1]--;
+	  ind[0]++;
+	  ind[1]++;
+	  if (ingrid(ndim,n,gs,ind))
+	    (tg->buf)[it+itr*tg->nt]+=
+	      (tg->rg)[itr][0]*(tg->rg)[itr][1]*fac*d[ioff+1+n0[0]];
+	  ind[0]--;
+	  ind[1]--;
+	}
+	else if (ndim == 3) {
+	  if (ingrid(ndim,n,gs,ind))
+	    (tg->buf)[it+itr*tg->nt]+=
+	      (1.0-(tg->rg)[itr][0])*(1.0-(tg->rg)[itr][1])*(1.0-(tg->rg)[itr][2])*fac*d[ioff];
+	  ind[0]++;
+	  if (ingrid(ndim,n,gs,ind))
+	    (tg->buf)[it+itr*tg->nt]+=
+	      (tg->rg)[itr][0]*(1.0-(tg->rg)[itr][1])*(1.0-(tg->rg)[itr][2])*fac*d[ioff+1];
+	  ind[0]--;
+	  ind[1]++;
+	  if (ingrid(ndim,n,gs,ind))
+	    (tg->buf)[it+itr*tg->nt]+=
+	      (1.0-(tg->rg)[itr][0])*(tg->rg)[itr][1]*(1.0-(tg->rg)[itr][2])*fac*d[ioff+n0[0]];
+	  ind[1]--;
+	  ind[2]++;
+	  if (ingrid(ndim,n,gs,ind))
+	    (tg->buf)[it+itr*tg->nt]+=
+	      (1.0-(tg->rg)[itr][0])*(1.0-(tg->rg)[itr][1])*(tg->rg)[itr][2]*fac*d[ioff+n0[0]*n0[1]];
+	  ind[2]--;
+	  ind[0]++;
+	  ind[1]++;
+	  if (ingrid(ndim,n,gs,ind))
+	    (tg->buf)[it+itr*tg->nt]+=
+	      (tg->rg)[itr][0]*(tg->rg)[itr][1]*(1.0-(tg->rg)[itr][2])*fac*d[ioff+1+n0[0]];
+	  ind[0]--;
+	  ind[1]--;
+	  ind[0]++;
+	  ind[2]++;
+	  if (ingrid(ndim,n,gs,ind))
+	    (tg->buf)[it+itr*tg->nt]+=
+	      (tg->rg)[itr][0]*(1.0-(tg->rg)[itr][1])*(tg->rg)[itr][2]*fac*d[ioff+1+n0[0]*n0[1]];
+	  ind[0]--;
+	  ind[2]--;
+	  ind[1]++;
+	  ind[2]++;
+	  if (ingrid(ndim,n,gs,ind))
+	    (tg->buf)[it+itr*tg->nt]+=
+	      (1.0-(tg->rg)[itr][0])*(tg->rg)[itr][1]*(tg->rg)[itr][2]*fac*d[ioff+n0[0]+n0[0]*n0[1]];
+	  ind[1]--;
+	  ind[2]--;
+	  ind[0]++;
+	  ind[1]++;
+	  ind[2]++;
+	  if (ingrid(ndim,n,gs,ind))
+	    (tg->buf)[it+itr*tg->nt]+=
+	      (tg->rg)[itr][0]*(tg->rg)[itr][1]*(tg->rg)[itr][2]*fac*d[ioff+1+n0[0]+n0[0]*n0[1]];
+	  ind[0]--;
+	  ind[1]--;
+	  ind[2]--;
+	}
+	else {
+	  return;
+	}
+      }
+      else {
+	return;
+      }
+    }
+  }
+}
+
+static float value(int i) {
+  return (float)((i*7919)%1009)/1009.0-0.5;
+}
+
+static float maxdiff(float const * x, float const * y, int len, float * xmax) {
+  float e=0.0;
+  *xmax=0.0;
+  for (int i=0;i<len;i++) {
+    e=max(e,fabsf(x[i]-y[i]));
+    *xmax=max(*xmax,fabsf(x[i]));
+  }
+  return e;
+}
+
+static void report(int order, int ndim, char const * mode,
+		   float e, float xmax, int nin) {
+  cout<<"order "<<order<<" ndim "<<ndim<<" "<<mode<<": ";
+  if (nin==0) cout<<"NO SAMPLES IN GRID";
+  else if (order==0) cout<<(e==0.0 ? "identical" : "DIFFER");
+  else cout<<(e <= 1.0e-6*xmax ? "agree to float precision" : "DIFFER");
+  cout<<endl;
+}
+
+int main(int argc, char ** argv) {
+
+  int rk=0;
+
+#ifdef IWAVE_USE_MPI
+  MPI_Init(&argc,&argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rk);
+#endif 
+
+  if (rk==0) {
+
+    /* receiver index per axis: off allocated grid, ghost layer, 
+       first, interior and last point of computational grid, off grid */
+    int pos[NPOS] = { -5, -2, -1, 1, 4, 7 };
+    float frac[NFRAC] = { 0.0, 0.25, 0.5, 0.3333333, 0.999 };
+
+    for (int ndim=1;ndim<4;ndim++) {
+
+      /* allocated grid -3...6, computational grid -1...4 on each axis */
+      IPNT n0, gs0, n, gs;
+      IASN(n0,IPNT_0);
+      IASN(gs0,IPNT_0);
+      IASN(n,IPNT_0);
+      IASN(gs,IPNT_0);
+      int len=1;
+      int ntr=1;
+      for (int i=0;i<ndim;i++) {
+	n0[i]=10; gs0[i]=-3;
+	n[i]=6;   gs[i]=-1;
+	len*=n0[i];
+	ntr*=NPOS;
+      }
+
+      tracegeom tg, tgold;
+      setnull_tracegeom(&tg);
+      tg.ndim=ndim;
+      tg.ntraces=ntr;
+      tg.nt=NT;
+      tg.ig=(IPNT *)usermalloc_(ntr*sizeof(IPNT));
+      tg.rg=(RPNT *)usermalloc_(ntr*sizeof(RPNT));
+      tg.buf=(float *)usermalloc_(ntr*NT*sizeof(float));
+      for (int itr=0;itr<ntr;itr++) {
+	IASN(tg.ig[itr],IPNT_0);
+	RASN(tg.rg[itr],RPNT_0);
+	int j=itr;
+	for (int i=0;i<ndim;i++) {
+	  tg.ig[itr][i]=pos[j%NPOS];
+	  tg.rg[itr][i]=frac[(itr+i)%NFRAC];
+	  j/=NPOS;
+	}
+      }
+      tgold=tg;
+      tgold.buf=(float *)usermalloc_(ntr*NT*sizeof(float));
+
+      float * d = (float *)usermalloc_(len*sizeof(float));
+      float * dold = (float *)usermalloc_(len*sizeof(float));
+      float fac=0.7;
+      float e, xmax;
+
+      for (int order=0;order<2;order++) {
+
+	/* save: accumulate grid samples onto traces, all time steps */
+	for (int i=0;i<ntr*NT;i++) tg.buf[i]=tgold.buf[i]=value(i);
+	int nin=0;
+	for (int it=0;it<NT;it++) {
+	  for (int i=0;i<len;i++) d[i]=value(i+it*len+1);
+	  sampletraces(&tg,order,0,it,n0,gs0,n,gs,d,fac);
+	  oldsampletraces(&tgold,order,0,it,n0,gs0,n,gs,d,fac);
+	}
+	for (int i=0;i<ntr*NT;i++) if (tg.buf[i]!=value(i)) nin++;
+	e=maxdiff(tg.buf,tgold.buf,ntr*NT,&xmax);
+	report(order,ndim,"save",e,xmax,nin);
+
+	/* load: spray trace samples into the grid */
+	for (int i=0;i<len;i++) d[i]=dold[i]=value(i);
+	nin=0;
+	for (int it=0;it<NT;it++) {
+	  sampletraces(&tg,order,1,it,n0,gs0,n,gs,d,fac);
+	  oldsampletraces(&tgold,order,1,it,n0,gs0,n,gs,dold,fac);
+	}
+	for (int i=0;i<len;i++) if (d[i]!=value(i)) nin++;
+	e=maxdiff(d,dold,len,&xmax);
+	report(order,ndim,"load",e,xmax,nin);
+      }
+
+      userfree_(tgold.buf);
+      userfree_(d);
+      userfree_(dold);
+#ifndef IWAVE_USE_MPI
+      destroy_tracegeom(&tg);
+#endif
+    }
+  }
+
+#ifdef IWAVE_USE_MPI
+  MPI_Finalize();
+#endif
+  return 0;
+}
@@ -0,0 +1,278 @@
+/*************************************************************************
+
+Copyright Rice University, 2011.
+All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, provided that the above copyright notice(s) and this
+permission notice appear in all copies of the Software and that both the
+above copyright notice(s) and this permission notice appear in supporting
+documentation.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT OF THIRD PARTY
+RIGHTS. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR HOLDERS INCLUDED IN THIS
+NOTICE BE LIABLE FOR ANY CLAIM, OR ANY SPECIAL INDIRECT OR CONSEQUENTIAL
+DAMAGES, OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR
+PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF
+THIS SOFTWARE.
+
+Except as contained in this notice, the name of a copyright holder shall
+not be used in advertising or otherwise to promote the sale, use or other
+dealings in this Software without prior written authorization of the
+copyright holder.
+
+**************************************************************************/
+#include "gtest/gtest.h"
+#include "rnspace.hh"
+#include "functions.hh"
+#include "fused.hh"
+#include "cgnealg.hh"
+#include "lbfgsalg.hh"
+
+#define RANDSEED 19490615
+
+namespace {
+
+  using namespace RVL;
+  using namespace RVLAlg;
+  using namespace RVLUmin;
+
+  // passes over memory = evaluations of function objects on vectors,
+  // streams = number of vectors read or written by these evaluations
+  size_t passes = 0;
+  size_t streams = 0;
+
+  /* RnArray counting the passes made over its data */
+  template<typename T>
+  class CountArray: public RnArray<T> {
+  public:
+    CountArray(size_t n): RnArray<T>(n) {}
+    CountArray(CountArray<T> const & x): RnArray<T>(x) {}
+    ~CountArray() {}
+    void eval(FunctionObject & f, vector<DataContainer const *> & x) {
+      passes++; streams += 1 + x.size();
+      RnArray<T>::eval(f,x);
+    }
+    void eval(FunctionObjectConstEval & f, vector<DataContainer const *> & x) const {
+      passes++; streams += 1 + x.size();
+      RnArray<T>::eval(f,x);
+    }
+  };
+
+  template<typename T>
+  class CountDCF: public RnDataContainerFactory<T> {
+    size_t n;
+  public:
+    CountDCF(size_t _n): RnDataContainerFactory<T>(_n), n(_n) {}
+    CountDCF(CountDCF<T> const & f): RnDataContainerFactory<T>(f), n(f.n) {}
+    LocalDataContainer<T> * buildLocal() const { return new CountArray<T>(n); }
+  };
+
+  /* same operations as RVLLinearAlgebraPackage, but not recognized
+     as fusable - reference for unfused algorithms */
+  template<typename T>
+  class PlainLAP: public LocalLinearAlgebraPackage<T,T> {
+    mutable RVLAssignConst<T> this_zero;
+    mutable RVLL2innerProd<T> this_inner;
+    mutable RVLLinCombObject<T> this_lco;
+  public:
+    PlainLAP(): this_zero(ScalarFieldTraits<T>::Zero()), this_inner(), this_lco() {}
+    PlainLAP(PlainLAP<T> const &)
+      : this_zero(ScalarFieldTraits<T>::Zero()), this_inner(), this_lco() {}
+    BinaryLocalFunctionObjectScalarRedn<T,T> & localinner() const { return this_inner; }
+    UnaryLocalFunctionObject<T> & localzero() const { return this_zero; }
+    LinCombObject<T> & linComb() const { return this_lco; }
+    bool compare(LinearAlgebraPackage<T> const & lap) const {
+      return (dynamic_cast<PlainLAP<T> const *>(&lap) != NULL);
+    }
+    void write(RVLException & e) const { e<<"PlainLAP\n"; }
+    ostream & write(ostream & str) const { str<<"PlainLAP\n"; return str; }
+  };
+
+  template<typename T>
+  class CountSpace: public LocalSpace<T> {
+    mutable CountDCF<T> f;
+    RVLLinearAlgebraPackage<T> flap;
+    PlainLAP<T> plap;
+    bool fused;
+  protected:
+    LocalDataContainerFactory<T> & getLDCF() const { return f; }
+  public:
+    CountSpace(size_t n, bool _fused): f(n), flap(), plap(), fused(_fused) {}
+    CountSpace(CountSpace<T> const & sp)
+      : f(sp.f), flap(), plap(), fused(sp.fused) {}
+    LinearAlgebraPackage<T> const & getLAP() const {
+      if (fused) return flap;
+      return plap;
+    }
+    void write(RVLException & e) const { e<<"CountSpace\n"; }
+    ostream & write(ostream & str) const { str<<"CountSpace\n"; return str; }
+  };
+
+  /* diagonal operator, one pass per application */
+  template<typename T>
+  class DiagOp: public LinearOp<T> {
+    Space<T> const & sp;
+    Vector<T> const & d;
+    mutable ElementwiseMultiply<T> mul;
+  protected:
+    LinearOp<T> * clone() const { return new DiagOp<T>(*this); }
+    void apply(Vector<T> const & x, Vector<T> & y) const { y.eval(mul,d,x); }
+    void applyAdj(Vector<T> const & x, Vector<T> & y) const { y.eval(mul,d,x); }
+  public:
+    DiagOp(Space<T> const & _sp, Vector<T> const & _d): sp(_sp), d(_d) {}
+    DiagOp(DiagOp<T> const & a): sp(a.sp), d(a.d) {}
+    Space<T> const & getDomain() const { return sp; }
+    Space<T> const & getRange() const { return sp; }
+    ostream & write(ostream & str) const { str<<"DiagOp\n"; return str; }
+  };
+
+  /* fills x with the same pseudo-random values in either space */
+  template<typename T>
+  void fill(Vector<T> & x, int seed, double lo, double hi) {
+    RVLRandomize<T> rnd(seed,(T)lo,(T)hi);
+    x.eval(rnd);
+  }
+
+  /* runs maxit steps of CGNE, returns solution in x and passes per
+     step; diagonal in [1,10] so that no step is the last */
+  template<typename T>
+  size_t CGNERun(Space<T> const & sp, int maxit, Vector<T> & x) {
+    Vector<T> d(sp);
+    Vector<T> b(sp);
+    fill(d,RANDSEED,1.0f,10.0f);
+    fill(b,2*RANDSEED,-1.0f,1.0f);
+    DiagOp<T> A(sp,d);
+    typename ScalarFieldTraits<T>::AbsType rnorm, nrnorm;
+    x.zero();
+    CGNEStep<T> step(A,x,b,rnorm,nrnorm);
+    size_t p0 = passes;
+    for (int i=0;i<maxit;i++) step.run();
+    return (passes-p0)/maxit;
+  }
+
+  /* m secant updates of LBFGS, then one application; returns passes
+     for the last update and for the application */
+  template<typename T>
+  void LBFGSRun(Space<T> const & sp, int m, Vector<T> & y,
+		size_t & pupd, size_t & papp) {
+    LBFGSOp<T> H(sp,1.0,m);
+    Vector<T> x0(sp), x1(sp), g0(sp), g1(sp), d(sp);
+    ElementwiseMultiply<T> mul;
+    fill(d,RANDSEED,1.0f,10.0f);
+    for (int i=0;i<m;i++) {
+      fill(x0,3*RANDSEED+i,-1.0f,1.0f);
+      fill(x1,5*RANDSEED+i,-1.0f,1.0f);
+      // gradients of a quadratic with diagonal Hessian
+      g0.eval(mul,d,x0);
+      g1.eval(mul,d,x1);
+      size_t p0 = passes;
+      H.update(x0,x1,g0,g1);
+      pupd = passes-p0;
+    }
+    Vector<T> g(sp);
+    fill(g,7*RANDSEED,-1.0f,1.0f);
+    size_t p0 = passes;
+    H.applyOp(g,y);
+    papp = passes-p0;
+  }
+
+  class FusedTest: public ::testing::Test {
+  public:
+    FusedTest() {}
+  };
+
+  TEST_F(FusedTest, fused_eval_lincomb_inner) {
+    typedef double T;
+    RnSpace<T> sp(1000);
+    Vector<T> u(sp), v(sp), w(sp), u0(sp);
+    fill(u,RANDSEED,-1.0,1.0);
+    fill(v,2*RANDSEED,-1.0,1.0);
+    fill(w,3*RANDSEED,-1.0,1.0);
+    u0.copy(u);
+    // u = 2v - u; u = u + 3w; <u,v>; u = 0.5u; |u|^2
+    RVLFusedEval<T> f;
+    f.linComb(2.0,1,-1.0);
+    f.linComb(3.0,2,1.0);
+    int k0 = f.inner(0,1);
+    f.scale(0.5);
+    int k1 = f.inner(0,0);
+    u.eval(f,v,w);
+    u0.linComb(2.0,v,-1.0);
+    u0.linComb(3.0,w);
+    T uv = u0.inner(v);
+    u0.scale(0.5);
+    T uu = u0.normsq();
+    u0.linComb(-1.0,u);
+    EXPECT_EQ(u0.norm(),0.0);
+    EXPECT_EQ(f.getValue(k0),uv);
+    EXPECT_EQ(f.getValue(k1),uu);
+    ScalarFieldTraits<T>::AbsType s;
+    EXPECT_TRUE(RVLFusedEval<T>::fusable(sp,s));
+    EXPECT_EQ(s,1.0);
+  }
+
+  TEST_F(FusedTest, cgne_passes) {
+    typedef float T;
+    int n = 100000;
+    int maxit = 5;
+    CountSpace<T> fsp(n,true);
+    CountSpace<T> psp(n,false);
+    Vector<T> xf(fsp);
+    Vector<T> xp(psp);
+    size_t sf = streams;
+    size_t nf = CGNERun(fsp,maxit,xf);
+    sf = streams - sf;
+    size_t sp = streams;
+    size_t np = CGNERun(psp,maxit,xp);
+    sp = streams - sp;
+    cerr<<"CGNE step: passes over memory fused = "<<nf<<" unfused = "<<np
+	<<", vector streams fused = "<<sf/maxit<<" unfused = "<<sp/maxit<<"\n";
+    EXPECT_LT(nf,np);
+    // same data, same arithmetic: results agree to rounding
+    LocalVector<T> lf(xf), lp(xp);
+    T emax = 0, xmax = 0;
+    for (int i=0;i<n;i++) {
+      emax = max(emax,(T)abs(lf.getData()[i]-lp.getData()[i]));
+      xmax = max(xmax,(T)abs(lp.getData()[i]));
+    }
+    EXPECT_LE(emax,1.0e-5f*xmax);
+  }
+
+  TEST_F(FusedTest, lbfgs_passes) {
+    typedef double T;
+    int n = 100000;
+    int m = 5;
+    CountSpace<T> fsp(n,true);
+    CountSpace<T> psp(n,false);
+    Vector<T> yf(fsp);
+    Vector<T> yp(psp);
+    size_t uf, af, up, ap;
+    LBFGSRun(fsp,m,yf,uf,af);
+    LBFGSRun(psp,m,yp,up,ap);
+    cerr<<"LBFGS m="<<m<<": update passes fused = "<<uf<<" unfused = "<<up
+	<<", apply passes fused = "<<af<<" unfused = "<<ap<<"\n";
+    EXPECT_LT(uf,up);
+    EXPECT_LT(af,ap);
+    LocalVector<T> lf(yf), lp(yp);
+    T emax = 0, ymax = 0;
+    for (int i=0;i<n;i++) {
+      emax = max(emax,abs(lf.getData()[i]-lp.getData()[i]));
+      ymax = max(ymax,abs(lp.getData()[i]));
+    }
+    EXPECT_LE(emax,1.0e-12*ymax);
+  }
+
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
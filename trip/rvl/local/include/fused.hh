@@ -0,0 +1,296 @@
+/*************************************************************************
+
+Copyright Rice University, 2004.
+All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, provided that the above copyright notice(s) and this
+permission notice appear in all copies of the Software and that both the
+above copyright notice(s) and this permission notice appear in supporting
+documentation.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT OF THIRD PARTY
+RIGHTS. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR HOLDERS INCLUDED IN THIS
+NOTICE BE LIABLE FOR ANY CLAIM, OR ANY SPECIAL INDIRECT OR CONSEQUENTIAL
+DAMAGES, OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR
+PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF
+THIS SOFTWARE.
+
+Except as contained in this notice, the name of a copyright holder shall
+not be used in advertising or otherwise to promote the sale, use or other
+dealings in this Software without prior written authorization of the
+copyright holder.
+
+**************************************************************************/
+
+#ifndef __RVL_FUSED
+#define __RVL_FUSED
+
+#include "locallinalg.hh"
+#include "productspace.hh"
+
+namespace RVL {
+
+  /** conjugate for real and complex scalars alike */
+  template<class Scalar>
+  inline Scalar fusedConj(Scalar const & x) { return x; }
+
+  template<class Scalar>
+  inline complex<Scalar> fusedConj(complex<Scalar> const & x) { return conj(x); }
+
+  /** Fused evaluation of a list of elementwise operations. Each
+      linear combination, scaling or inner product in an RVL algorithm
+      is normally its own pass over the data. This function object
+      records a short list of such operations on a target and up to
+      three sources, then executes the whole list block by block, so
+      that every operand is streamed through memory once per
+      evaluation rather than once per operation.
+
+      Operands are referred to by index: 0 = target, 1,2,3 = sources in
+      the order passed to Vector::eval. Operations act on the current
+      target values, i.e. an inner product involving the target sees
+      the result of the updates recorded before it.
+
+      Inner products are scaled as in RVLL2innerProd, so agree with
+      Vector::inner for spaces accepted by fusable(). Values accumulate
+      over evaluations (for example over the components of a product
+      vector) until reset by setValue().
+
+      Usage, for r = r - a*q followed by |r|^2:
+      <pre>
+      RVLFusedEval<Scalar> f(scale);
+      f.linComb(-a,1,1);
+      int k = f.inner(0,0);
+      r.eval(f,q);
+      rnormsq = abs(f.getValue(k));
+      </pre>
+  */
+  template<class Scalar>
+  class RVLFusedEval: public LocalFunctionObject<Scalar> {
+
+  public:
+
+    typedef typename ScalarFieldTraits<Scalar>::AbsType atype;
+
+  private:
+
+    /** block length, in scalars - operands of four ops fit in L1 */
+    static const size_t blk = 1024;
+
+    enum { LINCOMB, SCALE, INNER };
+
+    struct op {
+      int type;
+      int i;
+      int j;
+      Scalar a;
+      Scalar b;
+    };
+
+    std::vector<op> ops;
+    std::vector<Scalar> val;
+    atype ipscale;
+    int nsrc;
+
+    static bool fusable(Space<Scalar> const & sp, atype & scale, bool & first) {
+      StdSpace<Scalar,Scalar> const * ssp
+	= dynamic_cast<StdSpace<Scalar,Scalar> const *>(&sp);
+      if (ssp) {
+	RVLLinearAlgebraPackage<Scalar> const * lap
+	  = dynamic_cast<RVLLinearAlgebraPackage<Scalar> const *>(&(ssp->getLAP()));
+	if (!lap) return false;
+	RVLL2innerProd<Scalar> const * ip
+	  = dynamic_cast<RVLL2innerProd<Scalar> const *>(&(lap->localinner()));
+	if (!ip) return false;
+	if (first) { scale = ip->getScale(); first = false; }
+	return (scale == ip->getScale());
+      }
+      // product spaces with the canonical (block diagonal) inner product
+      if (dynamic_cast<StdProductSpace<Scalar> const *>(&sp) ||
+	  dynamic_cast<CartesianPowerSpace<Scalar> const *>(&sp)) {
+	ProductSpace<Scalar> const & psp =
+	  dynamic_cast<ProductSpace<Scalar> const &>(sp);
+	for (size_t i=0;i<psp.getSize();i++)
+	  if (!fusable(psp[i],scale,first)) return false;
+	return true;
+      }
+      return false;
+    }
+
+    void check(int i) {
+      if (i<0 || i>3) {
+	RVLException e;
+	e<<"Error: RVLFusedEval - operand index "<<i<<" not in range [0,3]\n";
+	throw e;
+      }
+      if (i>nsrc) nsrc=i;
+    }
+
+  public:
+
+    RVLFusedEval(atype _scale = ScalarFieldTraits<atype>::One())
+      : ops(), val(), ipscale(_scale), nsrc(0) {}
+    RVLFusedEval(RVLFusedEval<Scalar> const & f)
+      : ops(f.ops), val(f.val), ipscale(f.ipscale), nsrc(f.nsrc) {}
+    ~RVLFusedEval() {}
+
+    /** Determines whether vectors in sp can be evaluated by this FO:
+	the space must use RVLLinearAlgebraPackage, or be a standard
+	product of such spaces with common inner product scale. Returns
+	the scale, to be passed to the constructor. */
+    static bool fusable(Space<Scalar> const & sp, atype & scale) {
+      bool first = true;
+      return fusable(sp,scale,first);
+    }
+
+    /** target = a*x_i + b*target, i = 1,2,3 */
+    void linComb(Scalar a, int i, Scalar b) {
+      check(i);
+      if (i<1) {
+	RVLException e;
+	e<<"Error: RVLFusedEval::linComb - source index must be positive\n";
+	throw e;
+      }
+      op o; o.type=LINCOMB; o.i=i; o.j=0; o.a=a; o.b=b;
+      ops.push_back(o);
+    }
+
+    /** target = c*target */
+    void scale(Scalar c) {
+      op o; o.type=SCALE; o.i=0; o.j=0; o.a=c; o.b=ScalarFieldTraits<Scalar>::Zero();
+      ops.push_back(o);
+    }
+
+    /** accumulate inner product of operands i and j. Returns index
+	of result, for use in getValue. */
+    int inner(int i, int j) {
+      check(i);
+      check(j);
+      op o; o.type=INNER; o.i=i; o.j=j;
+      o.a=ScalarFieldTraits<Scalar>::Zero();
+      o.b=ScalarFieldTraits<Scalar>::Zero();
+      ops.push_back(o);
+      val.push_back(ScalarFieldTraits<Scalar>::Zero());
+      return val.size()-1;
+    }
+
+    /** value of k-th inner product */
+    Scalar getValue(int k) const {
+      if (k<0 || k>=(int)(val.size())) {
+	RVLException e;
+	e<<"Error: RVLFusedEval::getValue - index "<<k<<" out of range\n";
+	throw e;
+      }
+      return val[k];
+    }
+
+    /** reset inner products */
+    void setValue() {
+      for (size_t k=0;k<val.size();k++) val[k]=ScalarFieldTraits<Scalar>::Zero();
+    }
+
+    /** remove all operations */
+    void clear() { ops.clear(); val.clear(); nsrc=0; }
+
+    using RVL::LocalEvaluation<Scalar>::operator();
+    void operator()(LocalDataContainer<Scalar> & target,
+		    vector<LocalDataContainer<Scalar> const *> & sources) {
+      try {
+	if ((int)(sources.size()) < nsrc) {
+	  RVLException e;
+	  e<<"Error: RVLFusedEval::operator()\n";
+	  e<<"ops refer to "<<nsrc<<" sources, only "<<sources.size()<<" supplied\n";
+	  throw e;
+	}
+	size_t n = target.getSize();
+	Scalar * pu = target.getData();
+	Scalar const * px[4];
+	px[0] = pu;
+	for (size_t k=0;k<sources.size() && k<3;k++) {
+	  if (sources[k]->getSize() != n) {
+	    RVLException e;
+	    e<<"Error: RVLFusedEval::operator()\n";
+	    e<<"source "<<k+1<<" length "<<sources[k]->getSize()
+	     <<" differs from target length "<<n<<"\n";
+	    throw e;
+	  }
+	  px[k+1]=sources[k]->getData();
+	}
+
+	std::vector<Scalar> raw(val.size(),ScalarFieldTraits<Scalar>::Zero());
+	for (size_t i0=0;i0<n;i0+=blk) {
+	  size_t i1 = (i0+blk < n) ? i0+blk : n;
+	  int k = 0;
+	  for (size_t l=0;l<ops.size();l++) {
+	    op const & o = ops[l];
+	    if (o.type==LINCOMB) {
+	      Scalar const * pv = px[o.i];
+	      Scalar a = o.a;
+	      Scalar b = o.b;
+	      // as in RVLLinCombObject, b = 0 ignores old target values
+	      if (b == ScalarFieldTraits<Scalar>::Zero())
+		for (size_t i=i0;i<i1;i++) pu[i] = a*pv[i];
+	      else if (b == ScalarFieldTraits<Scalar>::One())
+		for (size_t i=i0;i<i1;i++) pu[i] = a*pv[i]+pu[i];
+	      else
+		for (size_t i=i0;i<i1;i++) pu[i] = a*pv[i]+b*pu[i];
+	    }
+	    else if (o.type==SCALE) {
+	      Scalar c = o.a;
+	      for (size_t i=i0;i<i1;i++) pu[i] = c*pu[i];
+	    }
+	    else {
+	      Scalar const * pv = px[o.i];
+	      Scalar const * pw = px[o.j];
+	      Scalar s = raw[k];
+	      for (size_t i=i0;i<i1;i++) s += pv[i]*fusedConj(pw[i]);
+	      raw[k++] = s;
+	    }
+	  }
+	}
+	for (size_t k=0;k<val.size();k++) val[k] += ipscale*raw[k];
+      }
+      catch (RVLException & e) {
+	e<<"\ncalled from RVLFusedEval::operator()\n";
+	throw e;
+      }
+    }
+
+    string getName() const { string s = "RVLFusedEval"; return s; }
+  };
+
+  /** y = a*x + b*y, returning the squared norm of the result, computed
+      in the same pass over the data if the space of y admits fused
+      evaluation, else by Vector::normsq. */
+  template<class Scalar>
+  typename ScalarFieldTraits<Scalar>::AbsType 
+  FusedLinCombNormsq(Scalar a, Vector<Scalar> const & x, 
+		     Scalar b, Vector<Scalar> & y) {
+    try {
+      typename ScalarFieldTraits<Scalar>::AbsType ipscale;
+      if (RVLFusedEval<Scalar>::fusable(y.getSpace(),ipscale)) {
+	RVLFusedEval<Scalar> f(ipscale);
+	f.linComb(a,1,b);
+	int k = f.inner(0,0);
+	y.eval(f,x);
+	return abs(f.getValue(k));
+      }
+      y.linComb(a,x,b);
+      return y.normsq();
+    }
+    catch (RVLException & e) {
+      e<<"\ncalled from FusedLinCombNormsq\n";
+      throw e;
+    }
+  }
+
+}
+
+#endif
@@ -11,7 +11,7 @@ namespace RVL {
     if (ich < 0 || ich > np-1) {
       cerr<<"Error: MPIRVL_SetRank helper function"<<endl;
       cerr<<"assigned destination "<<ich
-	  <<" out of process range [0,"<<np-1<<"]"<<cerr;
+	  <<" out of process range [0,"<<np-1<<"]"<<endl;
       return false;
     }
     idx=ich;;
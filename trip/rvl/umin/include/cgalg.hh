@@ -40,6 +40,7 @@ copyright holder.
 #include "alg.hh"
 #include "terminator.hh"
 #include "linop.hh"
+#include "fused.hh"
 
 namespace RVLUmin {
 
@@ -113,9 +114,9 @@ namespace RVLUmin {
       }
 
       x.linComb(alpha, p);    
-      r.linComb(-alpha, w);
       beta = rnormsq;
-      rnormsq = r.normsq();
+      // residual update and its norm in one pass
+      rnormsq = FusedLinCombNormsq(-alpha, w, ScalarFieldTraits<Scalar>::One(), r);
       
       if (ProtectedDivision<Scalar>(rnormsq,beta,beta)) {
 	CGException e;
@@ -163,8 +164,8 @@ namespace RVLUmin {
     void restart() {
       A.applyOp(x, w);
       r.copy(b);
-      r.linComb(-1.0, w);
-      rnormsq = r.normsq();
+      rnormsq = FusedLinCombNormsq(-ScalarFieldTraits<Scalar>::One(), w, 
+				   ScalarFieldTraits<Scalar>::One(), r);
       p.copy(r);
     }
 
@@ -45,6 +45,7 @@ copyright holder.
 #include "terminator.hh"
 #include "linop.hh"
 #include "table.hh"
+#include "fused.hh"
 
 using namespace RVLAlg;
 
@@ -98,12 +99,12 @@ namespace RVLUmin {
 	q(A.getRange()), p(A.getDomain()) { 
       // NOTE: initial x assumed to be zero vector
       //      cerr<<"cg initialize\n";
-      r.copy(b);
-      rnorm=r.norm();
+      rnorm=sqrt(FusedLinCombNormsq(ScalarFieldTraits<Scalar>::One(),b,
+				    ScalarFieldTraits<Scalar>::Zero(),r));
       A.applyAdjOp(r,g);
-      p.copy(g);
-      nrnorm=g.norm();
-      gamma = nrnorm*nrnorm;
+      gamma=FusedLinCombNormsq(ScalarFieldTraits<Scalar>::One(),g,
+			       ScalarFieldTraits<Scalar>::Zero(),p);
+      nrnorm=sqrt(gamma);
     }
       
     /**
@@ -127,7 +128,8 @@ namespace RVLUmin {
 
 	Scalar alpha=absalpha;
 	x.linComb(alpha,p);
-	r.linComb(-alpha,q);
+	// residual update and its norm in one pass
+	atype rnormsq = FusedLinCombNormsq(-alpha,q,ScalarFieldTraits<Scalar>::One(),r);
 	//	cerr<<"CGSTEP::run 3\n";
 
 	A.applyAdjOp(r,g);
@@ -145,7 +147,7 @@ namespace RVLUmin {
 	Scalar beta = absbeta;
 	p.linComb(ScalarFieldTraits<Scalar>::One(),g,beta);
 	gamma=newgamma;
-	rnorm=r.norm();
+	rnorm=sqrt(rnormsq);
 	nrnorm=sqrt(gamma);
 	//	cerr<<"CGSTEP::run 6\n";
 
@@ -234,8 +236,8 @@ namespace RVLUmin {
 	throw e;
       }
       // NOTE: initial x assumed to be zero vector
-      r.copy(b);
-      rnorm=r.norm();
+      rnorm=sqrt(FusedLinCombNormsq(ScalarFieldTraits<Scalar>::One(),b,
+				    ScalarFieldTraits<Scalar>::Zero(),r));
       A.applyAdjOp(r,ng);
       M.applyOp(ng,g);
       p.copy(g);
@@ -261,7 +263,8 @@ namespace RVLUmin {
 
 	Scalar alpha=absalpha;
 	x.linComb(alpha,p);
-	r.linComb(-alpha,q);
+	// residual update and its norm in one pass
+	atype rnormsq = FusedLinCombNormsq(-alpha,q,ScalarFieldTraits<Scalar>::One(),r);
 
 	A.applyAdjOp(r,ng);
 	M.applyOp(ng,g);
@@ -277,7 +280,7 @@ namespace RVLUmin {
 	Scalar beta = absbeta;
 	p.linComb(ScalarFieldTraits<Scalar>::One(),g,beta);
 	gamma=newgamma;
-	rnorm=r.norm();
+	rnorm=sqrt(rnormsq);
 	nrnorm=sqrt(gamma);
       }
       catch (RVLException & e) {
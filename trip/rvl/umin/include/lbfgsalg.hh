@@ -35,6 +35,7 @@ copyright holder.
 
 #include "uminstep.hh"
 #include "linop.hh"
+#include "fused.hh"
 
 
 namespace RVLUmin{
@@ -110,6 +111,52 @@ namespace RVLUmin{
 	// general case---the initial approximation has been updated
 	std::vector<Scalar> alpha(CurAllocated);
 	int i;
+
+	// fused version: each update of y shares its pass over the data
+	// with the inner product that follows it
+	typename ScalarFieldTraits<Scalar>::AbsType ipscale;
+	if (RVLFusedEval<Scalar>::fusable(sp,ipscale)) {
+	  Scalar one = ScalarFieldTraits<Scalar>::One();
+	  Scalar zip = ScalarFieldTraits<Scalar>::Zero();
+	  // storage order, newest to oldest
+	  std::vector<int> ord;
+	  for (i=CurNum-1;i>=0;--i) ord.push_back(i);
+	  for (i=CurAllocated-1;i>=CurNum;--i) ord.push_back(i);
+	  int m = ord.size();
+	  int k;
+	  RVLFusedEval<Scalar> f(ipscale);
+
+	  // y = x, alpha = rho <S,y> for newest pair
+	  f.linComb(one,1,zip);
+	  k=f.inner(2,0);
+	  y.eval(f,x,S[ord[0]]);
+	  alpha[ord[0]] = rho[ord[0]]*f.getValue(k);
+	  for (int l=1;l<m;l++) {
+	    f.clear();
+	    f.linComb(-alpha[ord[l-1]],1,one);
+	    k=f.inner(2,0);
+	    y.eval(f,Y[ord[l-1]],S[ord[l]]);
+	    alpha[ord[l]] = rho[ord[l]]*f.getValue(k);
+	  }
+
+	  // last update of first loop, initial Hessian, first beta
+	  f.clear();
+	  f.linComb(-alpha[ord[m-1]],1,one);
+	  f.scale(xscale);
+	  k=f.inner(1,0);
+	  y.eval(f,Y[ord[m-1]]);
+	  Scalar beta = rho[ord[m-1]]*f.getValue(k);
+	  for (int l=m-1;l>0;l--) {
+	    f.clear();
+	    f.linComb(alpha[ord[l]]-beta,1,one);
+	    k=f.inner(2,0);
+	    y.eval(f,S[ord[l]],Y[ord[l-1]]);
+	    beta = rho[ord[l-1]]*f.getValue(k);
+	  }
+	  y.linComb(alpha[ord[0]]-beta,S[ord[0]]);
+	  return;
+	}
+
 	y.copy(x);
 	for (i=CurNum-1;i>=0;--i) {
 	  alpha[i] = rho[i]*(S[i].inner(y));
@@ -203,13 +250,31 @@ namespace RVLUmin{
 	  CurAllocated++;
 	}
 
-	S[CurNum].copy(xnext);
-	S[CurNum].linComb(-1.0,x);
-	Y[CurNum].copy(gnext);
-	Y[CurNum].linComb(-1.0,g);
+	Scalar sy, yy;
+	typename ScalarFieldTraits<Scalar>::AbsType ipscale;
+	if (RVLFusedEval<Scalar>::fusable(sp,ipscale)) {
+	  // S = xnext - x, then Y = gnext - g with <S,Y>, <Y,Y>: two passes
+	  RVLFusedEval<Scalar> f(ipscale);
+	  f.linComb(ScalarFieldTraits<Scalar>::One(),1,ScalarFieldTraits<Scalar>::Zero());
+	  f.linComb(-ScalarFieldTraits<Scalar>::One(),2,ScalarFieldTraits<Scalar>::One());
+	  S[CurNum].eval(f,xnext,x);
+	  int ksy = f.inner(3,0);
+	  int kyy = f.inner(0,0);
+	  Y[CurNum].eval(f,gnext,g,S[CurNum]);
+	  sy = f.getValue(ksy);
+	  yy = abs(f.getValue(kyy));
+	}
+	else {
+	  S[CurNum].copy(xnext);
+	  S[CurNum].linComb(-1.0,x);
+	  Y[CurNum].copy(gnext);
+	  Y[CurNum].linComb(-1.0,g);
+	  sy = S[CurNum].inner(Y[CurNum]);
+	  yy = Y[CurNum].normsq();
+	}
 	
 	if (ProtectedDivision<Scalar>
-	    (1.0,S[CurNum].inner(Y[CurNum]),rho[CurNum])) {
+	    (1.0,sy,rho[CurNum])) {
 	  RVLException e;
 	  e<<"LBFGSOp::update\n";
 	  e<<"zerodivide in first protected div\n";
@@ -227,7 +292,7 @@ namespace RVLUmin{
 
 	Scalar tmp=0;
 	if (ProtectedDivision<Scalar>
-	    (1.0,rho[CurNum]*(Y[CurNum].normsq()),tmp)) {
+	    (1.0,rho[CurNum]*yy,tmp)) {
 	  RVLException e;
 	  e<<"LBFGSOp::update\n";
 	  e<<"zerodivide in second protected div\n";
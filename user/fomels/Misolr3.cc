@@ -57,6 +57,9 @@ int main(int argc, char** argv)
     int npk;
     par.get("npk",npk,20); // maximum rank
 
+    bool rnd;
+    par.get("rand",rnd,false); // if use threaded sampling with randomized rank detection
+
     par.get("dt",dt); // time step
 
     iRSF vel;
@@ -108,7 +111,11 @@ int main(int argc, char** argv)
     vector<int> lidx, ridx;
     FltNumMat mid;
 
-    iC( lowrank(m,n,sample,eps,npk,lidx,ridx,mid) );
+    if (rnd) {
+	iC( rlowrank(m,n,sample,eps,npk,lidx,ridx,mid) );
+    } else {
+	iC( lowrank(m,n,sample,eps,npk,lidx,ridx,mid) );
+    }
 
     int m2=mid.m();
     int n2=mid.n();
@@ -120,7 +127,7 @@ int main(int argc, char** argv)
 	nidx[k] = k;    
 
     FltNumMat lmat(m,m2);
-    iC ( sample(midx,lidx,lmat) );
+    iC ( psample(sample,midx,lidx,lmat) );
 
     FltNumMat lmat2(m,n2);
     iC( dgemm(1.0, lmat, mid, 0.0, lmat2) );
@@ -137,7 +144,7 @@ int main(int argc, char** argv)
     left << ldata;
 
     FltNumMat rmat(n2,n);
-    iC ( sample(ridx,nidx,rmat) );
+    iC ( psample(sample,ridx,nidx,rmat) );
     float *rdat = rmat.data();
 
     std::valarray<float> rdata(n2*n);    
@@ -21,24 +21,23 @@
 #include <omp.h>
 #endif
 
-#include "fftomp.h"
+#include "lrstep.h"
 #include "absorb.h"
 
 int main(int argc, char* argv[])
 {
     bool verb;
-    int it,iz,im,ik,ix,i,j, snap;     /* index variables */
+    int it,iz,ix, snap;     /* index variables */
     int nt,nz,nx, m2, nk, nzx, nz2, nx2, nzx2, n2, pad1, ny2;
     int nth;
-    float c, old, dt;
+    float dt;
 
     bool abc;
     int nbt,nbb,nbl,nbr; /* abc width */
     float ct,cb,cl,cr; /* decay parameter */
 
     float  *ww,*rr;      /* I/O arrays*/
-    sf_complex *cwave, *cwavem;
-    float **wave, *curr, *prev;
+    float *curr, *prev;
 
     sf_file Fw,Fr,Fo;    /* I/O files */
     sf_axis at,az,ax;    /* cube axes */
@@ -102,10 +101,7 @@ int main(int argc, char* argv[])
     if (verb) sf_warning(">>>> Using %d threads <<<<<", nth);
 #endif
 
-    nk = fft_init(pad1,nz,nx,1,&nz2,&nx2,&ny2,true,true);
-
     nzx = nz*nx;
-    nzx2 = nz2*nx2;
 
     /* propagator matrices */
     left = sf_input("left");
@@ -113,6 +109,9 @@ int main(int argc, char* argv[])
 
     if (!sf_histint(left,"n1",&n2) || n2 != nzx) sf_error("Need n1=%d in left",nzx);
     if (!sf_histint(left,"n2",&m2))  sf_error("Need n2= in left");
+
+    nk = lrstep_init(pad1,nz,nx,1,&nz2,&nx2,&ny2,m2);
+    nzx2 = nz2*nx2;
     
     if (!sf_histint(right,"n1",&n2) || n2 != m2) sf_error("Need n1=%d in right",m2);
     if (!sf_histint(right,"n2",&n2) || n2 != nk) sf_error("Need n2=%d in right",nk);
@@ -130,10 +129,6 @@ int main(int argc, char* argv[])
     curr = sf_floatalloc(nzx2);
     prev = sf_floatalloc(nzx2);
 
-    cwave  = sf_complexalloc(nk);
-    cwavem = sf_complexalloc(nk);
-    wave = sf_floatalloc2(nzx2,m2);
-
     for (iz=0; iz < nzx2; iz++) {
 	prev[iz]=0.;
 	curr[iz]=0.;
@@ -147,38 +142,12 @@ int main(int argc, char* argv[])
     for (it=0; it<nt; it++) {
 	if(verb) sf_warning("it=%d;",it);
 
-	/* matrix multiplication */
-	fft(curr,cwave);
-
-	for (im = 0; im < m2; im++) {
-	    for (ik = 0; ik < nk; ik++) {
-#ifdef SF_HAS_COMPLEX_H
-		cwavem[ik] = cwave[ik]*rt[ik][im];
-#else
-		cwavem[ik] = sf_crmul(cwave[ik],rt[ik][im]);
-#endif
-	    }
-	    ifft(wave[im],cwavem);
-	}
+	/* matrix multiplication and leapfrog */
+	lrstep(lt,rt,ww[it],rr,curr,prev);
 
-	for (ix = 0; ix < nx; ix++) {
-	    for (iz=0; iz < nz; iz++) {
-		i = iz+ix*nz;  /* original grid */
-		j = iz+ix*nz2; /* padded grid */
-		
-		old = c = curr[j];
-		c += c + ww[it] * rr[i] - prev[j];
-		prev[j] = old;
-
-		for (im = 0; im < m2; im++) {
-		    c += lt[im][i]*wave[im][j];
-		}
-
-		curr[j] = c;
-	    }
-	    	
-	    if (NULL != snaps && 0 == it%snap) {
-		/* write wavefield snapshots */
+	if (NULL != snaps && 0 == it%snap) {
+	    /* write wavefield snapshots */
+	    for (ix = 0; ix < nx; ix++) {
 		sf_floatwrite(curr+ix*nz2,nz,snaps);
 	    }
 	}
@@ -197,6 +166,6 @@ int main(int argc, char* argv[])
 	sf_floatwrite(curr+ix*nz2,nz,Fo); 
     }
 
-    fft_finalize();    
+    lrstep_close();
     exit (0);
 }
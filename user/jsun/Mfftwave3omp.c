@@ -18,18 +18,17 @@
 */
 #include <rsf.h>
 
-#include "fftomp.h"
+#include "lrstep.h"
 
 int main(int argc, char* argv[])
 {
     bool verb, cmplx;        
-    int it,iz,im,ik,ix,iy,i,j, snap;     /* index variables */
+    int it,iz,ix,iy, snap;     /* index variables */
     int nt,nz,nx,ny, m2, nk, nzx, nz2, nx2, ny2, nzx2, n2, pad1;
-    float c, old, dt;
+    float dt;
 
     float  *ww,*rr;      /* I/O arrays*/
-    sf_complex *cwave, *cwavem;
-    float **wave, *curr, *prev;
+    float *curr, *prev;
 
     sf_file Fw,Fr,Fo;    /* I/O files */
     sf_axis at,az,ax,ay;    /* cube axes */
@@ -77,10 +76,7 @@ int main(int argc, char* argv[])
 	snaps = NULL;
     }
 
-    nk = fft_init(pad1,nz,nx,ny,&nz2,&nx2,&ny2,true,true);
-
     nzx = nz*nx*ny;
-    nzx2 = nz2*nx2*ny2;
 
     /* propagator matrices */
     left = sf_input("left");
@@ -88,6 +84,9 @@ int main(int argc, char* argv[])
 
     if (!sf_histint(left,"n1",&n2) || n2 != nzx) sf_error("Need n1=%d in left",nzx);
     if (!sf_histint(left,"n2",&m2))  sf_error("Need n2=%d in left",m2);
+
+    nk = lrstep_init(pad1,nz,nx,ny,&nz2,&nx2,&ny2,m2);
+    nzx2 = nz2*nx2*ny2;
     
     if (!sf_histint(right,"n1",&n2) || n2 != m2) sf_error("Need n1=%d in right",m2);
     if (!sf_histint(right,"n2",&n2) || n2 != nk) sf_error("Need n2=%d in right",nk);
@@ -103,17 +102,10 @@ int main(int argc, char* argv[])
     rr=sf_floatalloc(nzx); sf_floatread(rr,nzx,Fr);
 
     curr = sf_floatalloc(nzx2);
-    prev = sf_floatalloc(nzx);
-
-    cwave  = sf_complexalloc(nk);
-    cwavem = sf_complexalloc(nk);
-    wave = sf_floatalloc2(nzx2,m2);
-
-    for (iz=0; iz < nzx; iz++) {
-	prev[iz]=0.;
-    }
+    prev = sf_floatalloc(nzx2);
 
     for (iz=0; iz < nzx2; iz++) {
+	prev[iz]=0.;
 	curr[iz]=0.;
     }
 
@@ -122,38 +114,8 @@ int main(int argc, char* argv[])
     for (it=0; it<nt; it++) {
 	if(verb) sf_warning("it=%d;",it);
 
-	/* matrix multiplication */
-	fft(curr,cwave);
-
-	for (im = 0; im < m2; im++) {
-	    for (ik = 0; ik < nk; ik++) {
-#ifdef SF_HAS_COMPLEX_H
-		cwavem[ik] = cwave[ik]*rt[ik][im];
-#else
-		cwavem[ik] = sf_crmul(cwave[ik],rt[ik][im]);
-#endif
-	    }
-	    ifft(wave[im],cwavem);
-	}
-
-	for (iy = 0; iy < ny; iy++) {
-	    for (ix = 0; ix < nx; ix++) {
-		for (iz=0; iz < nz; iz++) {
-		    i = iz+nz *(ix+nx *iy); /* original grid */
-		    j = iz+nz2*(ix+nx2*iy); /* padded grid */
-		
-		    old = c = curr[j];
-		    c += c + ww[it] * rr[i] - prev[i];
-		    prev[i] = old;
-
-		    for (im = 0; im < m2; im++) {
-			c += lt[im][i]*wave[im][j];
-		    }
-		    
-		    curr[j] = c;
-		}
-	    }
-	}
+	/* matrix multiplication and leapfrog */
+	lrstep(lt,rt,ww[it],rr,curr,prev);
 
 	if (NULL != snaps && 0 == it%snap) {
 	    for (iy = 0; iy < ny; iy++) {
@@ -173,6 +135,6 @@ int main(int argc, char* argv[])
 	}
     }
     
-    fft_finalize();
+    lrstep_close();
     exit (0);
 }
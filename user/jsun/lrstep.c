@@ -0,0 +1,444 @@
+/* Batched lowrank time stepping for 2-D and 3-D wave propagation */
+/*
+  Copyright (C) 2026 University of Texas at Austin
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+/*
+   One step computes
+
+   next = 2 curr - prev + w*rr + sum_m lt[m] * IFFT( rt[m] * FFT(curr) )
+
+   The m2 inverse transforms run as one batch: with FFTW as a single
+   many-transform plan, with Kiss-FFT as threaded passes over the
+   columns (and, in 3-D, the planes) of all rank components, followed
+   by one threaded pass over the rows, in which each row of all
+   components is transformed and immediately mixed with the left
+   matrix and the leapfrog update. The column passes need every row
+   of a component, so the spectra of all m2 components are stored
+   (nk*m2 complex values in wave); only the separate product, 
+   centering and mixing passes are saved.
+
+   n1 <-> nz, n2 <-> nx, n3 <-> ny.
+   2D -> ny=1.
+*/
+
+#include <rsf.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#ifdef SF_HAS_FFTW
+#include <fftw3.h>
+#endif
+
+#include "lrstep.h"
+
+static int nz, nx, ny, n1, n2, n3, nk, m2;
+static float wt;
+
+static sf_complex *cc=NULL, *wave=NULL;
+#ifdef SF_HAS_FFTW
+static sf_complex *dd=NULL;
+static fftwf_plan cfg=NULL, icfg=NULL;
+#else
+static int nth=1;
+static kiss_fft_cfg *cfg1=NULL, *icfg1=NULL, *cfg2=NULL, *icfg2=NULL, *cfg3=NULL, *icfg3=NULL;
+static kiss_fft_cpx *tmp=NULL, **ctrace=NULL, **ctrace2=NULL, **row=NULL;
+#endif
+
+int lrstep_init(int pad1 /* padding on the first axis */,
+		int nz_, int nx_, int ny_ /* model size */,
+		int *nz2, int *nx2, int *ny2 /* padded size */,
+		int m2_ /* rank */)
+/*< initialize, returns the number of wavenumbers >*/
+{
+#ifdef SF_HAS_FFTW
+    int nn[3];
+#else
+    int i, n;
+#endif
+
+    nz = nz_;
+    nx = nx_;
+    ny = ny_;
+    m2 = m2_;
+
+    if (nx==1 && ny>1) sf_error("For 2D, second axis should be nx!");
+
+    n1 = kiss_fft_next_fast_size(nz*pad1);
+    n2 = kiss_fft_next_fast_size(nx);
+    n3 = (ny>1)? kiss_fft_next_fast_size(ny): 1;
+    nk = n1*n2*n3;
+
+    cc   = sf_complexalloc(nk);
+    wave = sf_complexalloc(nk*m2);
+
+#ifdef SF_HAS_FFTW
+#ifdef _OPENMP
+    fftwf_init_threads();
+    fftwf_plan_with_nthreads(omp_get_max_threads());
+#endif
+
+    dd = sf_complexalloc(nk);
+
+    if (n3>1) {
+	nn[0] = n3; nn[1] = n2; nn[2] = n1;
+	cfg = fftwf_plan_dft_3d(n3,n2,n1,
+				(fftwf_complex *) cc,
+				(fftwf_complex *) dd,
+				FFTW_FORWARD, FFTW_MEASURE);
+    } else {
+	nn[0] = n2; nn[1] = n1;
+	cfg = fftwf_plan_dft_2d(n2,n1,
+				(fftwf_complex *) cc,
+				(fftwf_complex *) dd,
+				FFTW_FORWARD, FFTW_MEASURE);
+    }
+
+    /* all rank components in one plan */
+    icfg = fftwf_plan_many_dft((n3>1)? 3:2, nn, m2,
+			       (fftwf_complex *) wave, NULL, 1, nk,
+			       (fftwf_complex *) wave, NULL, 1, nk,
+			       FFTW_BACKWARD, FFTW_MEASURE);
+
+    if (NULL == cfg || NULL == icfg) sf_error("FFTW failure.");
+#else
+#ifdef _OPENMP
+#pragma omp parallel
+    {nth = omp_get_num_threads();}
+#endif
+
+    cfg1  = (kiss_fft_cfg *) sf_alloc(nth,sizeof(kiss_fft_cfg));
+    icfg1 = (kiss_fft_cfg *) sf_alloc(nth,sizeof(kiss_fft_cfg));
+    cfg2  = (kiss_fft_cfg *) sf_alloc(nth,sizeof(kiss_fft_cfg));
+    icfg2 = (kiss_fft_cfg *) sf_alloc(nth,sizeof(kiss_fft_cfg));
+    if (n3>1) {
+	cfg3  = (kiss_fft_cfg *) sf_alloc(nth,sizeof(kiss_fft_cfg));
+	icfg3 = (kiss_fft_cfg *) sf_alloc(nth,sizeof(kiss_fft_cfg));
+    }
+
+    for (i=0; i<nth; i++) {
+	cfg1[i] = kiss_fft_alloc(n1,0,NULL,NULL);
+	icfg1[i]= kiss_fft_alloc(n1,1,NULL,NULL);
+	cfg2[i] = kiss_fft_alloc(n2,0,NULL,NULL);
+	icfg2[i]= kiss_fft_alloc(n2,1,NULL,NULL);
+	if (n3>1) {
+	    cfg3[i] = kiss_fft_alloc(n3,0,NULL,NULL);
+	    icfg3[i]= kiss_fft_alloc(n3,1,NULL,NULL);
+	}
+    }
+
+    n = SF_MAX(n2,n3);
+    ctrace  = (kiss_fft_cpx **) sf_complexalloc2(n,nth);
+    ctrace2 = (kiss_fft_cpx **) sf_complexalloc2(n,nth);
+    /* one row of every rank component */
+    row = (kiss_fft_cpx **) sf_complexalloc2(n1*m2,nth);
+
+    tmp = (kiss_fft_cpx *) sf_alloc(nk,sizeof(kiss_fft_cpx));
+#endif
+
+    *nz2 = n1;
+    *nx2 = n2;
+    *ny2 = n3;
+
+    wt = 1.0/nk;
+
+    return nk;
+}
+
+static void forward(const float *curr)
+/* centered FFT of the padded wavefield into cc (dd with FFTW) */
+{
+    int i1, i2, i3, i23;
+#ifndef SF_HAS_FFTW
+    int ith=0;
+#endif
+
+#ifdef _OPENMP
+#pragma omp parallel for private(i23,i3,i2,i1) default(shared)
+#endif
+    for (i23=0; i23<n2*n3; i23++) {
+	i3 = i23/n2;
+	i2 = i23%n2;
+	for (i1=0; i1<n1; i1++) {
+	    cc[i23*n1+i1] = sf_cmplx((((i3%2==0)==(i2%2==0))==(i1%2==0))?
+				     curr[i23*n1+i1]:-curr[i23*n1+i1],0.);
+	}
+    }
+
+#ifdef SF_HAS_FFTW
+    fftwf_execute(cfg);
+#else
+    /* FFT over first axis */
+#ifdef _OPENMP
+#pragma omp parallel for private(i23,ith) default(shared)
+#endif
+    for (i23=0; i23<n2*n3; i23++) {
+#ifdef _OPENMP
+	ith = omp_get_thread_num();
+#endif
+	kiss_fft_stride(cfg1[ith],(kiss_fft_cpx *) (cc+i23*n1),tmp+i23*n1,1);
+    }
+
+    if (n3>1) {
+	/* FFT over second axis */
+#ifdef _OPENMP
+#pragma omp parallel for private(i3,i2,i1,ith) default(shared)
+#endif
+	for (i3=0; i3<n3; i3++) {
+#ifdef _OPENMP
+	    ith = omp_get_thread_num();
+#endif
+	    for (i1=0; i1<n1; i1++) {
+		kiss_fft_stride(cfg2[ith],tmp+i3*n2*n1+i1,ctrace[ith],n1);
+		for (i2=0; i2<n2; i2++) {
+		    tmp[(i3*n2+i2)*n1+i1]=ctrace[ith][i2];
+		}
+	    }
+	}
+
+	/* FFT over third axis */
+#ifdef _OPENMP
+#pragma omp parallel for private(i3,i2,i1,ith) default(shared)
+#endif
+	for (i2=0; i2<n2; i2++) {
+#ifdef _OPENMP
+	    ith = omp_get_thread_num();
+#endif
+	    for (i1=0; i1<n1; i1++) {
+		kiss_fft_stride(cfg3[ith],tmp+i2*n1+i1,ctrace[ith],n2*n1);
+		for (i3=0; i3<n3; i3++) {
+		    cc[(i3*n2+i2)*n1+i1] = ((sf_complex *) ctrace[ith])[i3];
+		}
+	    }
+	}
+    } else {
+	/* FFT over second axis */
+#ifdef _OPENMP
+#pragma omp parallel for private(i2,i1,ith) default(shared)
+#endif
+	for (i1=0; i1<n1; i1++) {
+#ifdef _OPENMP
+	    ith = omp_get_thread_num();
+#endif
+	    kiss_fft_stride(cfg2[ith],tmp+i1,ctrace[ith],n1);
+	    for (i2=0; i2<n2; i2++) {
+		cc[i2*n1+i1] = ((sf_complex *) ctrace[ith])[i2];
+	    }
+	}
+    }
+#endif
+}
+
+static void update(int i3, int i2, const sf_complex *wm, int stride,
+		   float **lt, float w, const float *rr,
+		   float *curr, float *prev)
+/* leapfrog update of one row, mixing the components with the left matrix */
+{
+    int i1, im, i, j;
+    float c, old, s;
+
+    for (i1=0; i1 < nz; i1++) {
+	i = i1+nz*(i2+nx*i3); /* original grid */
+	j = i1+n1*(i2+n2*i3); /* padded grid */
+
+	old = c = curr[j];
+	c += c + w * rr[i] - prev[j];
+	prev[j] = old;
+
+	/* centering and normalization */
+	s = (((i3%2==0)==(i2%2==0))==(i1%2==0))? wt:-wt;
+	for (im=0; im < m2; im++) {
+	    c += lt[im][i]*(s*crealf(wm[im*stride+i1]));
+	}
+
+	curr[j] = c;
+    }
+}
+
+void lrstep(float **lt /* left matrix [m2][nz*nx*ny] */,
+	    float **rt /* right matrix [nk][m2] */,
+	    float w    /* source amplitude */,
+	    const float *rr /* source distribution [nz*nx*ny] */,
+	    float *curr /* current -> next wavefield [nk] */,
+	    float *prev /* previous -> current wavefield [nk] */)
+/*< one time step on the padded grid >*/
+{
+    int im, ik, i23;
+    sf_complex *spec;
+#ifndef SF_HAS_FFTW
+    int i1, i2, i3, ith=0, n, stride;
+    kiss_fft_cpx *cwave;
+    kiss_fft_cfg icfg;
+#endif
+
+    forward(curr);
+
+#ifdef SF_HAS_FFTW
+    spec = dd;
+
+#ifdef _OPENMP
+#pragma omp parallel for private(ik,im) default(shared)
+#endif
+    for (ik=0; ik < nk; ik++) {
+	for (im=0; im < m2; im++) {
+#ifdef SF_HAS_COMPLEX_H
+	    wave[im*nk+ik] = spec[ik]*rt[ik][im];
+#else
+	    wave[im*nk+ik] = sf_crmul(spec[ik],rt[ik][im]);
+#endif
+	}
+    }
+
+    fftwf_execute(icfg);
+
+#ifdef _OPENMP
+#pragma omp parallel for private(i23) default(shared)
+#endif
+    for (i23=0; i23 < nx*ny; i23++) {
+	update(i23/nx,i23%nx,wave+(i23/nx*n2+i23%nx)*n1,nk,lt,w,rr,curr,prev);
+    }
+#else
+    spec = cc;
+    cwave = (kiss_fft_cpx *) wave;
+
+    /* IFFT over the last axis of every component, multiplying by
+       the right matrix on the way in */
+    if (n3>1) {
+	n = n3;
+	stride = n2*n1;
+    } else {
+	n = n2;
+	stride = n1;
+    }
+
+#ifdef _OPENMP
+#pragma omp parallel for private(i23,i1,i2,im,ik,ith,icfg) default(shared)
+#endif
+    for (i23=0; i23 < m2*stride; i23++) {
+#ifdef _OPENMP
+	ith = omp_get_thread_num();
+#endif
+	icfg = (n3>1)? icfg3[ith]: icfg2[ith];
+	im = i23/stride;
+	i1 = i23%stride;
+	for (i2=0; i2 < n; i2++) {
+	    ik = i2*stride+i1;
+#ifdef SF_HAS_COMPLEX_H
+	    ((sf_complex *) ctrace[ith])[i2] = spec[ik]*rt[ik][im];
+#else
+	    ((sf_complex *) ctrace[ith])[i2] = sf_crmul(spec[ik],rt[ik][im]);
+#endif
+	}
+	kiss_fft(icfg,ctrace[ith],ctrace2[ith]);
+	for (i2=0; i2 < n; i2++) {
+	    cwave[im*nk+i2*stride+i1] = ctrace2[ith][i2];
+	}
+    }
+
+    if (n3>1) {
+	/* IFFT over second axis, all components and planes at once */
+#ifdef _OPENMP
+#pragma omp parallel for private(i23,i1,i2,ik,ith) default(shared)
+#endif
+	for (i23=0; i23 < m2*ny; i23++) {
+#ifdef _OPENMP
+	    ith = omp_get_thread_num();
+#endif
+	    ik = (i23/ny)*nk+(i23%ny)*n2*n1;
+	    for (i1=0; i1 < n1; i1++) {
+		kiss_fft_stride(icfg2[ith],cwave+ik+i1,ctrace[ith],n1);
+		for (i2=0; i2 < n2; i2++) {
+		    cwave[ik+i2*n1+i1] = ctrace[ith][i2];
+		}
+	    }
+	}
+    }
+
+    /* IFFT over first axis and update, row by row;
+       rows in the padding are never needed */
+#ifdef _OPENMP
+#pragma omp parallel for private(i23,i2,i3,im,ith) default(shared)
+#endif
+    for (i23=0; i23 < nx*ny; i23++) {
+#ifdef _OPENMP
+	ith = omp_get_thread_num();
+#endif
+	i3 = i23/nx;
+	i2 = i23%nx;
+	for (im=0; im < m2; im++) {
+	    kiss_fft(icfg1[ith],cwave+im*nk+(i3*n2+i2)*n1,row[ith]+im*n1);
+	}
+	update(i3,i2,(sf_complex *) row[ith],n1,lt,w,rr,curr,prev);
+    }
+#endif
+}
+
+void lrstep_close(void)
+/*< free allocated storage >*/
+{
+#ifndef SF_HAS_FFTW
+    int i;
+#endif
+
+#ifdef SF_HAS_FFTW
+    /* plans must be destroyed before FFTW is cleaned up */
+    fftwf_destroy_plan(cfg);
+    cfg=NULL;
+    fftwf_destroy_plan(icfg);
+    icfg=NULL;
+#ifdef _OPENMP
+    fftwf_cleanup_threads();
+#else
+    fftwf_cleanup();
+#endif
+    free(dd);
+    dd=NULL;
+#else
+    for (i=0; i<nth; i++) {
+	free(cfg1[i]);
+	free(icfg1[i]);
+	free(cfg2[i]);
+	free(icfg2[i]);
+	if (n3>1) {
+	    free(cfg3[i]);
+	    free(icfg3[i]);
+	}
+    }
+    free(cfg1);
+    free(icfg1);
+    free(cfg2);
+    free(icfg2);
+    if (n3>1) {
+	free(cfg3);
+	free(icfg3);
+    }
+    free(*ctrace);
+    free(ctrace);
+    free(*ctrace2);
+    free(ctrace2);
+    free(*row);
+    free(row);
+    free(tmp);
+    cfg1=icfg1=cfg2=icfg2=cfg3=icfg3=NULL;
+    ctrace=ctrace2=row=NULL;
+    tmp=NULL;
+#endif
+
+    free(cc);
+    free(wave);
+    cc=wave=NULL;
+}
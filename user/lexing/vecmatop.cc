@@ -554,6 +554,248 @@ int lowrank(int m, int n, int (*sample)(vector<int>&, vector<int>&, FltNumMat&),
   return 0;
 }
 
+// ---------------------------------------------------------------------- 
+// blocked sampling: the block is split into pieces that are filled by
+// separate calls to sample, in parallel, so sample must be reentrant
+int psample(int (*sample)(vector<int>&, vector<int>&, FltNumMat&), 
+	    vector<int>& rs, vector<int>& cs, FltNumMat& res)
+{
+  int nr = rs.size();
+  int nc = cs.size();
+  res.resize(nr,nc);
+  if(nr==0 || nc==0) return 0;
+  bool byrow = (nr>=nc); //split the longer side
+  int nl = byrow ? nr : nc;
+  int bs = max(1, 65536/(byrow ? nc : nr)); //about 64K samples per piece
+  int nb = (nl+bs-1)/bs;
+  int err = 0;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) reduction(+:err)
+#endif
+  for(int b=0; b<nb; b++) {
+    int l0 = b*bs;
+    int l1 = min(nl, l0+bs);
+    FltNumMat blk;
+    if(byrow) {
+      vector<int> sub(rs.begin()+l0, rs.begin()+l1);
+      err += (*sample)(sub, cs, blk);
+      for(int j=0; j<nc; j++)
+	for(int i=l0; i<l1; i++)
+	  res(i,j) = blk(i-l0,j);
+    } else {
+      vector<int> sub(cs.begin()+l0, cs.begin()+l1);
+      err += (*sample)(rs, sub, blk);
+      for(int j=l0; j<l1; j++)
+	for(int i=0; i<nr; i++)
+	  res(i,j) = blk(i,j-l0);
+    }
+  }
+  iA(err==0);
+  return 0;
+}
+
+// ---------------------------------------------------------------------- 
+// Gram matrix in double precision, G = A^T A (trans=false) or A A^T
+// (trans=true), summed over a fixed number of slices of the long side
+// so that the result does not depend on the number of threads
+static int gram(const FltNumMat& A, bool trans, DblNumMat& G)
+{
+  const int NSLICE = 64;
+  int k = trans ? A.m() : A.n(); //size of G
+  int nl = trans ? A.n() : A.m(); //summed over
+  int ns = min(NSLICE, max(nl,1));
+  G.resize(k,k);    setvalue(G, 0.0);
+  vector<DblNumMat> part(ns);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+  for(int s=0; s<ns; s++) {
+    int l0 = int( (long) nl*s/ns );
+    int l1 = int( (long) nl*(s+1)/ns );
+    int len = l1-l0;
+    part[s].resize(k,k);    setvalue(part[s], 0.0);
+    if(len==0) continue;
+    DblNumMat D;
+    char uplo = 'U';
+    char tr;
+    double one = 1.0, zero = 0.0;
+    if(trans) { //columns l0..l1 of A, k x len
+      D.resize(k,len);
+      for(int j=0; j<len; j++)
+	for(int i=0; i<k; i++)
+	  D(i,j) = A(i,l0+j);
+      tr = 'N';
+      dsyrk_(&uplo, &tr, &k, &len, &one, D.data(), &k, &zero, part[s].data(), &k);
+    } else { //rows l0..l1 of A, len x k
+      D.resize(len,k);
+      for(int j=0; j<k; j++)
+	for(int i=0; i<len; i++)
+	  D(i,j) = A(l0+i,j);
+      tr = 'T';
+      dsyrk_(&uplo, &tr, &k, &len, &one, D.data(), &len, &zero, part[s].data(), &k);
+    }
+  }
+  for(int s=0; s<ns; s++)
+    for(int j=0; j<k; j++)
+      for(int i=0; i<=j; i++)
+	G(i,j) += part[s](i,j);
+  return 0;
+}
+
+// ---------------------------------------------------------------------- 
+// range of A (trans=false: column space, trans=true: row space) from the
+// Gram matrix; returns the numerical rank p relative to eps and the
+// p x l matrix W whose columns are the coordinates of the l rows
+// (columns) of A in an orthonormal basis, for pivoting
+static int range(const char* name, const FltNumMat& A, bool trans, float eps, int npk, 
+		 int& p, FltNumMat& W)
+{
+  DblNumMat G;    iC( gram(A, trans, G) );
+  int k = G.m();
+  DblNumVec lam(k);
+  {
+    char jobz = 'V';
+    char uplo = 'U';
+    int lwork = max(1, 3*k*k);
+    DblNumVec work(lwork);
+    int info;
+    dsyev_(&jobz, &uplo, &k, G.data(), &k, lam.data(), work.data(), &lwork, &info);    iA(info==0);
+  }
+  //singular values, decreasing
+  DblNumVec sig(k);
+  for(int a=0; a<k; a++)    sig(a) = sqrt(max(lam(k-1-a), 0.0));
+  double total = 0;
+  for(int a=0; a<k; a++)    total += sig(a)*sig(a);
+  p = 0;
+  for(int a=0; a<min(k,npk); a++)    if(sig(a)>eps*sig(0))      p++;
+  //rank versus relative error in the sample
+  cerr<<name<<" rank/err";
+  double tail = total;
+  for(int a=0; a<min(k,p+1); a++) {
+    tail -= sig(a)*sig(a);
+    cerr<<" "<<a+1<<":"<<sqrt(max(tail,0.0)/max(total,DBL_MIN));
+  }
+  cerr<<endl;
+  //basis scaled by the inverse singular values
+  FltNumMat B(p,k);
+  for(int a=0; a<p; a++)
+    for(int b=0; b<k; b++)
+      B(a,b) = float( G(b,k-1-a)/sig(a) );
+  int l = trans ? A.n() : A.m();
+  W.resize(p,l);
+  if(p==0) return 0;
+  char transa = 'N';
+  char transb = trans ? 'N' : 'T';
+  float one = 1.0, zero = 0.0;
+  int lda = A.m();
+  sgemm_(&transa, &transb, &p, &l, &k, &one, B.data(), &p, A.data(), &lda, &zero, W.data(), &p);
+  return 0;
+}
+
+// ---------------------------------------------------------------------- 
+// skeleton: the p columns of W picked by pivoted QR
+static int skeleton(FltNumMat& W, vector<int>& idx)
+{
+  int m = W.m();
+  int n = W.n();
+  idx.resize(m);
+  if(m==0) return 0;
+  int lda = m;
+  int lwork = 6*n;
+  int info;
+  NumVec<int> jpvt(n);    setvalue(jpvt, int(0));
+  FltNumVec tau(max(m,n));
+  FltNumVec work(lwork);
+  sgeqp3_(&m, &n, W.data(), &lda, jpvt.data(), tau.data(), work.data(), &lwork, &info);    iA(info==0);
+  for(int k=0; k<m; k++)      idx[k] = (jpvt(k)-1);
+  return 0;
+}
+
+static void randidx(int n, int npk, vector<int>& idx)
+{
+  int nc = min(npk,n);
+  idx.resize(nc);
+  for(int k=0; k<nc; k++)      idx[k] = int( floor(drand48()*(n-nc)) );
+  sort(idx.begin(), idx.end());
+  for(int k=0; k<nc; k++)      idx[k] += k;
+}
+
+static void merge(vector<int>& idx, const vector<int>& add)
+{
+  for(unsigned int k=0; k<add.size(); k++)      idx.push_back(add[k]);
+  sort(idx.begin(), idx.end());
+  vector<int>::iterator newend = unique(idx.begin(), idx.end());
+  idx.resize(newend-idx.begin());
+}
+
+// ---------------------------------------------------------------------- 
+// same decomposition as lowrank, with the samples filled in parallel
+// blocks (see psample) and the rank revealed by the spectrum of the
+// sampled blocks, so that pivoted QR only runs on p x m and p x n
+// matrices instead of npk x m and npk x n
+int rlowrank(int m, int n, int (*sample)(vector<int>&, vector<int>&, FltNumMat&), float eps, int npk, 
+	     vector<int>& cidx, vector<int>& ridx, FltNumMat& mid)
+{
+  iA(m>0 && n>0);
+  {
+    vector<int> cs;    randidx(n, npk, cs);
+    vector<int> rs(m);
+    for(int k=0; k<m; k++)      rs[k] = k;
+    FltNumMat M2;    iC( psample(sample, rs, cs, M2) );
+    int p;
+    FltNumMat W;    iC( range("ROWS", M2, false, eps, npk, p, W) );
+    iC( skeleton(W, ridx) );
+    cerr<<"ROWS "; for(unsigned int k=0; k<ridx.size(); k++)      cerr<<ridx[k]<<" ";    cerr<<endl;
+  }
+  {
+    vector<int> rs;    randidx(m, npk, rs);
+    merge(rs, ridx);
+    vector<int> cs(n);
+    for(int k=0; k<n; k++)      cs[k] = k;
+    FltNumMat M1;    iC( psample(sample, rs, cs, M1) );
+    int p;
+    FltNumMat W;    iC( range("COLS", M1, true, eps, npk, p, W) );
+    iC( skeleton(W, cidx) );
+    cerr<<"COLS "; for(unsigned int k=0; k<cidx.size(); k++)      cerr<<cidx[k]<<" ";    cerr<<endl;
+  }
+  {
+    vector<int> cs;    randidx(n, npk, cs);
+    merge(cs, cidx);
+    vector<int> rs;    randidx(m, npk, rs);
+    merge(rs, ridx);
+    FltNumMat M1;    iC( psample(sample,rs,cidx,M1) );
+    FltNumMat IM1;    iC( pinv(M1, (float) 1e-7, IM1) );
+    FltNumMat M2;    iC( psample(sample,ridx,cs,M2) );
+    FltNumMat IM2;    iC( pinv(M2, (float) 1e-7, IM2) );
+    FltNumMat M3;    iC( psample(sample,rs,cs,M3) );
+    FltNumMat tmp(M3.m(), IM2.n());
+    iC( dgemm(1.0, M3, IM2, 0.0, tmp) );
+    mid.resize(IM1.m(), tmp.n());
+    iC( dgemm(1.0, IM1, tmp, 0.0, mid) );
+  }
+  {
+    int nc = min(npk,n);
+    vector<int> cs(nc);
+    for(int k=0; k<nc; k++)      cs[k] = int( floor(drand48()*n) );
+    int nr = min(npk,m);
+    vector<int> rs(nr);
+    for(int k=0; k<nr; k++)      rs[k] = int( floor(drand48()*m) );
+    FltNumMat M1;    iC( psample(sample,rs,cidx,M1) );
+    FltNumMat M2;    iC( psample(sample,ridx,cs,M2) );
+    FltNumMat Mext;    iC( psample(sample,rs,cs,Mext) );
+    FltNumMat Mapp(rs.size(), cs.size());
+    FltNumMat tmp(mid.m(),M2.n());
+    iC( dgemm(1.0, mid, M2, 0.0, tmp) );
+    iC( dgemm(1.0, M1, tmp, 0.0, Mapp) );
+    FltNumMat Merr(Mext.m(), Mext.n());
+    for(int a=0; a<Mext.m(); a++)
+      for(int b=0; b<Mext.n(); b++)
+	Merr(a,b) = Mext(a,b) - Mapp(a,b);
+    cerr<<"rel err "<<sqrt(energy(Merr))/sqrt(energy(Mext))<<endl;
+  }
+  return 0;
+}
+
 //complex version
 int lowrank(int m, int n, int (*sample)(vector<int>&, vector<int>&, CpxNumMat&), float eps, int npk, 
 	    vector<int>& cidx, vector<int>& ridx, CpxNumMat& mid)
@@ -55,6 +55,10 @@ int ddpinv(const ZpxNumMat& M, double eps, ZpxNumMat& R);
 //--------------------------------------------------
 int lowrank(int m, int n, int (*sample)(vector<int>&, vector<int>&, FltNumMat&), float eps, int npk,
 	    vector<int>& cidx, vector<int>& ridx, FltNumMat& mid);
+int rlowrank(int m, int n, int (*sample)(vector<int>&, vector<int>&, FltNumMat&), float eps, int npk,
+	     vector<int>& cidx, vector<int>& ridx, FltNumMat& mid);
+int psample(int (*sample)(vector<int>&, vector<int>&, FltNumMat&), 
+	    vector<int>& rs, vector<int>& cs, FltNumMat& res);
 int ddlowrank(int m, int n, int (*sample)(vector<int>&, vector<int>&, DblNumMat&), double eps, int npk,
             vector<int>& cidx, vector<int>& ridx, DblNumMat& mid);
 int lowrank(int m, int n, int (*sample)(vector<int>&, vector<int>&, CpxNumMat&), float eps, int npk,
@@ -2,6 +2,12 @@
 
 The output is dimensionless (stepout in time measured in time samples). 
 
+With brick1=, brick2=, or brick3= smaller than the data, the cube is
+split into bricks extended by halo1, halo2, halo3 samples past their
+cores. Dips are estimated in each brick independently (in parallel
+with OpenMP) and blended with smooth taper weights in the overlaps. Only one slab of
+bricks along the third axis is kept in memory.
+
 June 2012 program of the month:
 http://ahay.org/blog/2012/06/02/program-of-the-month-sfdip/
 */
@@ -22,19 +28,321 @@ http://ahay.org/blog/2012/06/02/program-of-the-month-sfdip/
   along with this program; if not, write to the Free Software
   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 */
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+
 #include <rsf.h>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #include "dip3.h"
 #include "mask6.h"
 
+typedef struct {
+    sf_file file;
+    int first, count; /* planes held */
+    float *buf;
+} window;
+/* sliding window of planes along the third axis */
+
+typedef struct {
+    bool left;
+    int dip, nj, mask;
+    float init, pmin, pmax, sign;
+    window *idip;
+} field;
+/* one of the estimated dip fields */
+
+static int nn[3], brick[3], halo[3], taper[3], rect[3];
+static int niter, liter, order, nj1, nj2, nf, nth;
+static float eps;
+static bool both, verb;
+static field fields[4];
+
+static void window_init(window *w, sf_file file, int planes)
+/* allocate a window */
+{
+    w->file = file;
+    w->first = w->count = 0;
+    w->buf = (NULL == file)? NULL: sf_floatalloc(planes*nn[0]*nn[1]);
+}
+
+static void window_slide(window *w, int first, int last)
+/* hold planes [first,last), reading forward */
+{
+    int n12, drop;
+
+    if (NULL == w->file) return;
+    n12 = nn[0]*nn[1];
+
+    drop = first - w->first;
+    if (drop > w->count) drop = w->count;
+    if (drop > 0) {
+	memmove(w->buf,w->buf+drop*n12,(w->count-drop)*n12*sizeof(float));
+	w->count -= drop;
+	w->first += drop;
+    }
+    if (w->first + w->count < last) {
+	sf_floatread(w->buf+w->count*n12,(last-w->first-w->count)*n12,w->file);
+	w->count = last - w->first;
+    }
+}
+
+static void window_extract(const window *w, 
+			   const int *e0, const int *e1 /* brick extent */,
+			   float *x /* brick [m3][m2][m1] */)
+/* copy a brick out of a window */
+{
+    int i2, i3, m1;
+
+    m1 = e1[0]-e0[0];
+    for (i3=e0[2]; i3 < e1[2]; i3++) {
+	for (i2=e0[1]; i2 < e1[1]; i2++) {
+	    memcpy(x,w->buf+((i3-w->first)*nn[1]+i2)*nn[0]+e0[0],m1*sizeof(float));
+	    x += m1;
+	}
+    }
+}
+
+static float weight(int axis, int x, int c0, int c1)
+/* taper weight of core [c0,c1) at x, a partition of unity over cores */
+{
+    int t;
+    float s, w;
+
+    t = taper[axis];
+    w = 1.0f;
+    if (c0 > 0) {
+	if (x < c0-t) return 0.0f;
+	if (x < c0+t) {
+	    s = sinf(0.25f*SF_PI*(x-c0+t+0.5f)/t);
+	    w *= s*s;
+	}
+    }
+    if (c1 < nn[axis]) {
+	if (x >= c1+t) return 0.0f;
+	if (x >= c1-t) {
+	    s = cosf(0.25f*SF_PI*(x-c1+t+0.5f)/t);
+	    w *= s*s;
+	}
+    }
+    return w;
+}
+
+static void core(int axis, int ib, int *c0, int *c1)
+/* core of brick ib, the last one absorbs the remainder */
+{
+    int nb;
+
+    nb = SF_MAX(1,nn[axis]/brick[axis]);
+    *c0 = ib*brick[axis];
+    *c1 = (ib == nb-1)? nn[axis]: *c0+brick[axis];
+}
+
+static void tiled(int nr, sf_file in, sf_file out, 
+		  sf_file mask, sf_file idip0, sf_file xdip0)
+/* estimate dips brick by brick */
+{
+    int nb1, nb2, nb3, nb12, ir, ib3, ib, ith, f, i, i1, i2, i3, n12, mm;
+    int z0, z1, a0, a1, w1, m1, m2, m3, c0[3], c1[3], e0[3], e1[3];
+    int planes, acc3;
+    float **u, **y, ***res, **acc, *plane, wz, wy;
+    bool ***msk;
+    char *tmpname[4];
+    FILE *tmp[4];
+    window win, wmask, wx, wq;
+    dip3solver d;
+
+    n12 = nn[0]*nn[1];
+    nb1 = SF_MAX(1,nn[0]/brick[0]);
+    nb2 = SF_MAX(1,nn[1]/brick[1]);
+    nb3 = SF_MAX(1,nn[2]/brick[2]);
+    nb12 = nb1*nb2;
+
+    /* largest brick with halo */
+    mm = 1;
+    for (i=0; i < 3; i++) {
+	mm *= SF_MIN(nn[i],2*brick[i]-1+2*halo[i]);
+    }
+    planes = SF_MIN(nn[2],2*brick[2]-1+2*halo[2]);
+
+    window_init(&win,in,planes);
+    window_init(&wmask,mask,planes);
+    window_init(&wx,idip0,planes);
+    window_init(&wq,xdip0,planes);
+    for (f=0; f < nf; f++) {
+	fields[f].idip = (2==fields[f].dip)? &wq: &wx;
+    }
+
+    u = sf_floatalloc2(mm,nth);
+    y = sf_floatalloc2(mm,nth);
+    res = sf_floatalloc3(mm,nf,nth);
+    if (NULL != mask) {
+	msk = (bool***) sf_alloc(nth,sizeof(bool**));
+	for (ith=0; ith < nth; ith++) {
+	    msk[ith] = sf_boolalloc2(mm,both? 4:2);
+	}
+    } else {
+	msk = NULL;
+    }
+
+    /* output planes of a slab with its tapers */
+    acc3 = SF_MIN(nn[2],2*brick[2]-1)+2*taper[2];
+    acc = sf_floatalloc2(acc3*n12,nf);
+    plane = sf_floatalloc(n12);
+
+    for (f=1; f < nf; f++) {
+	tmp[f] = sf_tempfile(&tmpname[f],"w+b");
+    }
+
+    for (ir=0; ir < nr; ir++) {
+	win.first = win.count = 0;
+	wmask.first = wmask.count = 0;
+	wx.first = wx.count = 0;
+	wq.first = wq.count = 0;
+
+	for (f=1; f < nf; f++) {
+	    rewind(tmp[f]);
+	}
+	for (f=0; f < nf; f++) {
+	    memset(acc[f],0,acc3*n12*sizeof(float));
+	}
+
+	for (ib3=0; ib3 < nb3; ib3++) {
+	    if (verb) sf_warning("slab %d of %d;",ib3+1,nb3);
+
+	    core(2,ib3,&z0,&z1);
+	    e0[2] = SF_MAX(z0-halo[2],0);
+	    e1[2] = SF_MIN(z1+halo[2],nn[2]);
+
+	    window_slide(&win,e0[2],e1[2]);
+	    window_slide(&wmask,e0[2],e1[2]);
+	    window_slide(&wx,e0[2],e1[2]);
+	    window_slide(&wq,e0[2],e1[2]);
+
+	    /* first plane in acc */
+	    a0 = z0-taper[2];
+
+#ifdef _OPENMP
+#pragma omp parallel for ordered schedule(dynamic) private(ith,f,i,i1,i2,i3,c0,c1,e0,e1,m1,m2,m3,d,wz,wy)
+#endif
+	    for (ib=0; ib < nb12; ib++) {
+#ifdef _OPENMP
+		ith = omp_get_thread_num();
+#else
+		ith = 0;
+#endif
+		core(0,ib%nb1,c0,c1);
+		core(1,ib/nb1,c0+1,c1+1);
+		c0[2] = z0;
+		c1[2] = z1;
+		for (i=0; i < 3; i++) {
+		    e0[i] = SF_MAX(c0[i]-halo[i],0);
+		    e1[i] = SF_MIN(c1[i]+halo[i],nn[i]);
+		}
+		m1 = e1[0]-e0[0];
+		m2 = e1[1]-e0[1];
+		m3 = e1[2]-e0[2];
+
+		window_extract(&win,e0,e1,u[ith]);
+		if (NULL != mask) {
+		    window_extract(&wmask,e0,e1,y[ith]);
+		    mask32 (both, order, nj1, nj2, 
+			    m1, m2, m3, y[ith], msk[ith]);
+		}
+
+		d = dip3_init_r(m1, m2, m3, rect, liter, eps, false);
+
+		for (f=0; f < nf; f++) {
+		    if (NULL != fields[f].idip->file) {
+			window_extract(fields[f].idip,e0,e1,res[ith][f]);
+			for (i=0; i < m1*m2*m3; i++) {
+			    res[ith][f][i] *= fields[f].sign;
+			}
+		    } else {
+			for (i=0; i < m1*m2*m3; i++) {
+			    res[ith][f][i] = fields[f].init;
+			}
+		    }
+
+		    dip3_r(d, fields[f].left, fields[f].dip, niter, order, 
+			   fields[f].nj, u[ith], res[ith][f], 
+			   (NULL != mask)? msk[ith][fields[f].mask]: NULL, 
+			   fields[f].pmin, fields[f].pmax);
+		}
+
+		dip3_close_r(d);
+
+#ifdef _OPENMP
+#pragma omp ordered
+#endif
+		{
+		    /* blend in a fixed order */
+		    for (i3=SF_MAX(c0[2]-taper[2],0); 
+			 i3 < SF_MIN(c1[2]+taper[2],nn[2]); i3++) {
+			wz = weight(2,i3,c0[2],c1[2]);
+			for (i2=SF_MAX(c0[1]-taper[1],0); 
+			     i2 < SF_MIN(c1[1]+taper[1],nn[1]); i2++) {
+			    wy = wz*weight(1,i2,c0[1],c1[1]);
+			    for (i1=SF_MAX(c0[0]-taper[0],0); 
+				 i1 < SF_MIN(c1[0]+taper[0],nn[0]); i1++) {
+				i = ((i3-e0[2])*m2+i2-e0[1])*m1+i1-e0[0];
+				for (f=0; f < nf; f++) {
+				    acc[f][((i3-a0)*nn[1]+i2)*nn[0]+i1] += 
+					wy*weight(0,i1,c0[0],c1[0])*res[ith][f][i];
+				}
+			    }
+			}
+		    }
+		}
+	    }
+
+	    /* planes [a1,w1) are final */
+	    a1 = SF_MAX(a0,0);
+	    w1 = (ib3 == nb3-1)? nn[2]: z1-taper[2];
+	    for (f=0; f < nf; f++) {
+		if (0==f) {
+		    sf_floatwrite(acc[f]+(a1-a0)*n12,(w1-a1)*n12,out);
+		} else if ((w1-a1)*n12 != 
+			   fwrite(acc[f]+(a1-a0)*n12,sizeof(float),(w1-a1)*n12,tmp[f])) {
+		    sf_error("%s: trouble writing temporary file",__FILE__);
+		}
+
+		/* keep the overlap for the next slab */
+		memmove(acc[f],acc[f]+(w1-a0)*n12,(acc3-(w1-a0))*n12*sizeof(float));
+		memset(acc[f]+(acc3-(w1-a0))*n12,0,(w1-a0)*n12*sizeof(float));
+	    }
+	}
+	if (verb) sf_warning(".");
+
+	for (f=1; f < nf; f++) {
+	    rewind(tmp[f]);
+	    for (i3=0; i3 < nn[2]; i3++) {
+		if (n12 != fread(plane,sizeof(float),n12,tmp[f]))
+		    sf_error("%s: trouble reading temporary file",__FILE__);
+		sf_floatwrite(plane,n12,out);
+	    }
+	}
+    }
+
+    for (f=1; f < nf; f++) {
+	fclose(tmp[f]);
+	unlink(tmpname[f]);
+    }
+}
+
 int main (int argc, char *argv[])
 {
-    int n123, niter, order, nj1,nj2, i,j, liter, dim;
-    int n[SF_MAX_DIM], rect[3], n4, nr, ir; 
+    int n123, i,j, dim;
+    int n[SF_MAX_DIM], n4, nr, ir; 
     float p0, q0, *u, *p, *pi=NULL, *qi=NULL;
-    float pmin, pmax, qmin, qmax, eps;
-    char key[4];
-    bool verb, both, **mm;
+    float pmin, pmax, qmin, qmax;
+    char key[7];
+    bool tile, **mm;
     sf_file in, out, mask, idip0, xdip0;
 
     sf_init(argc,argv);
@@ -115,6 +423,60 @@ int main (int argc, char *argv[])
     if (!sf_getfloat("eps",&eps)) eps=0.0f;
     /* regularization */
 
+    tile = false;
+    for (j=0; j < 3; j++) {
+	nn[j] = n[j];
+	snprintf(key,7,"brick%d",j+1);
+	if (!sf_getint(key,brick+j) || brick[j] > n[j]) brick[j]=n[j];
+	/*( brick#=(n1,n2,n3) brick size on #-th axis for tiled estimation )*/
+	if (brick[j] < 1) sf_error("Need %s > 0",key);
+	if (brick[j] < n[j]) tile = true;
+	snprintf(key,7,"halo%d",j+1);
+	if (!sf_getint(key,halo+j)) halo[j]=2*rect[j]+order;
+	/*( halo#=(2*rect#+order) brick extension past its core on #-th axis )*/
+	taper[j] = SF_MIN(halo[j],brick[j])/2;
+    }
+
+    if (tile) {
+	nf = 0;
+	if (1 != n4) {
+	    fields[nf].left = false; fields[nf].dip = 1; fields[nf].nj = nj1;
+	    fields[nf].mask = 0; fields[nf].init = p0; fields[nf].sign = 1.0f;
+	    fields[nf].pmin = pmin; fields[nf].pmax = pmax;
+	    nf++;
+	}
+	if (0 != n4) {
+	    fields[nf].left = false; fields[nf].dip = 2; fields[nf].nj = nj2;
+	    fields[nf].mask = 1; fields[nf].init = q0; fields[nf].sign = 1.0f;
+	    fields[nf].pmin = qmin; fields[nf].pmax = qmax;
+	    nf++;
+	}
+	if (both) {
+	    for (j=0; j < nf; j++) {
+		fields[nf+j] = fields[j];
+		fields[nf+j].left = true;
+		fields[nf+j].mask += 2;
+		fields[nf+j].init = -fields[j].init;
+		fields[nf+j].sign = -1.0f;
+		fields[nf+j].pmin = -fields[j].pmax;
+		fields[nf+j].pmax = -fields[j].pmin;
+	    }
+	    nf *= 2;
+	}
+
+#ifdef _OPENMP
+	nth = omp_get_max_threads();
+#else
+	nth = 1;
+#endif
+
+	tiled(nr, in, out, 
+	      (NULL != sf_getstring("mask"))? sf_input("mask"): NULL,
+	      (NULL != sf_getstring("idip"))? sf_input("idip"): NULL,
+	      (NULL != sf_getstring("xdip"))? sf_input("xdip"): NULL);
+	exit(0);
+    }
+
     /* initialize dip estimation */
     dip3_init(n[0], n[1], n[2], rect, liter, eps, verb);
 
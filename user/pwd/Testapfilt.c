@@ -0,0 +1,103 @@
+#include <stdio.h>
+#include <math.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include <rsf.h>
+
+#include "apfilt.h"
+
+#define NP 50
+
+static void expected(int nw, float p, float *a)
+/* filter coefficients computed from scratch */
+{
+    int j, k, n;
+    double ak;
+
+    n = 2*nw;
+    for (k=0; k <= n; k++) {
+	ak = 1.0;
+	for (j=0; j < n; j++) {
+	    if (j < n-k) {
+		ak *= (k+j+1.0)/(2*(2*j+1)*(j+1))*(n-j-p);
+	    } else {
+		ak *= 1.0/(2*(2*j+1))*(p+j+1);
+	    }
+	}
+	a[k] = ak;
+    }
+}
+
+static int check(int nw)
+/* compare passfilter with the expected coefficients, return failures */
+{
+    int ip, k, bad;
+    float p, a[9], b[9];
+
+    bad = 0;
+    for (ip=0; ip < NP; ip++) {
+	p = -2.0+4.0*ip/NP;
+	passfilter(p,a);
+	expected(nw,p,b);
+	for (k=0; k <= 2*nw; k++) {
+	    if (fabsf(a[k]-b[k]) > 1.0e-6*(1.0+fabsf(b[k]))) bad++;
+	}
+    }
+    return bad;
+}
+
+int main(void) {
+    int i, bad, status;
+    pid_t pid;
+
+    /* two users of one order, the first to close leaves the
+       coefficients to the other */
+    apfilt_init(2);
+    apfilt_init(2);
+    apfilt_close();
+    bad = check(2);
+    apfilt_close();
+    if (bad) sf_error("order 2 after one close: %d wrong",bad);
+
+    /* once all users are gone, the order may change */
+    apfilt_init(1);
+    bad = check(1);
+    apfilt_close();
+    if (bad) sf_error("order 1: %d wrong",bad);
+
+    /* concurrent users, as in the bricks of sfdip */
+    bad = 0;
+#ifdef _OPENMP
+#pragma omp parallel for reduction(+:bad)
+#endif
+    for (i=0; i < 64; i++) {
+	apfilt_init(3);
+	bad += check(3);
+	apfilt_close();
+    }
+    if (bad) sf_error("concurrent order 3: %d wrong",bad);
+
+    /* the count is back to zero */
+    apfilt_init(4);
+    bad = check(4);
+    apfilt_close();
+    if (bad) sf_error("order 4 after concurrent use: %d wrong",bad);
+
+    /* a different order while in use is an error */
+    pid = fork();
+    if (pid < 0) sf_error("cannot fork");
+    if (0 == pid) {
+	freopen("/dev/null","w",stderr);
+	apfilt_init(2);
+	apfilt_init(1);
+	_exit(0);
+    }
+    if (pid != waitpid(pid,&status,0) ||
+	(WIFEXITED(status) && 0 == WEXITSTATUS(status)))
+	sf_error("order changed while in use");
+
+    printf("apfilt: init/close pairing ok\n");
+
+    exit(0);
+}
@@ -21,35 +21,54 @@
 
 #include "apfilt.h"
 
-static int n;
+static int n, users=0;
 static double *b;
 
 void apfilt_init(int nw /* filter order */)
-/*< initialize >*/
+/*< initialize (coefficients are shared between concurrent users, 
+  which must all use the same order; every init needs a close) >*/
 {
     int j, k;
     double bk;
 
-    n = nw*2;
-    b = (double*) sf_alloc(n+1,sizeof(double));
+#ifdef _OPENMP
+#pragma omp critical(apfilt)
+#endif
+    {
+	/* passfilter and aderfilter take the order from here */
+	if (users > 0 && n != nw*2) 
+	    sf_error("%s: order %d requested while %d users have order %d",
+		     __FILE__,nw,users,n/2);
 
-    for (k=0; k <= n; k++) {
-	bk = 1.0;
-	for (j=0; j < n; j++) {
-	    if (j < n-k) {
-		bk *= (k+j+1.0)/(2*(2*j+1)*(j+1));
-	    } else {
-		bk *= 1.0/(2*(2*j+1));
+	if (0==users) {
+	    n = nw*2;
+	    b = (double*) sf_alloc(n+1,sizeof(double));
+	    
+	    for (k=0; k <= n; k++) {
+		bk = 1.0;
+		for (j=0; j < n; j++) {
+		    if (j < n-k) {
+			bk *= (k+j+1.0)/(2*(2*j+1)*(j+1));
+		    } else {
+			bk *= 1.0/(2*(2*j+1));
+		    }
+		}
+		b[k] = bk;
 	    }
 	}
-	b[k] = bk;
+	users++;
     }
 }
 
 void apfilt_close(void)
 /*< free allocated storage >*/
 {
-    free(b);
+#ifdef _OPENMP
+#pragma omp critical(apfilt)
+#endif
+    {
+	if (users > 0 && 0 == --users) free(b);
+    }
 }
 
 void passfilter (float p  /* slope */, 
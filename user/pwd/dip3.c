@@ -26,8 +26,64 @@
 #include "dip3.h"
 #include "allp3.h"
 
-static float *u1, *u2, *dp, *p0, eps;
-static int n, n1, n2, n3, nn[3];
+#ifndef _dip3_h
+
+typedef struct Dip3 *dip3solver;
+/* abstract data type */
+/*^*/
+
+#endif
+
+struct Dip3 {
+    int n, n1, n2, n3;
+    float *u1, *u2, *dp, *p0, eps;
+    sf_divnsolver dv;
+};
+
+static dip3solver d0;
+
+dip3solver dip3_init_r(int m1, int m2, int m3 /* dimensions */, 
+		       int* rect              /* smoothing radius [3] */, 
+		       int niter              /* number of iterations */,
+		       float eps1             /* regularization */,      
+		       bool verb              /* verbosity flag */)
+/*< initialize a reentrant estimator, to be used with dip3_r >*/
+{
+    int nn[3];
+    dip3solver d;
+
+    d = (dip3solver) sf_alloc(1,sizeof(*d));
+
+    d->n1=m1;
+    d->n2=m2;
+    d->n3=m3;
+    d->n = m1*m2*m3;
+    d->eps = eps1;
+
+    d->u1 = sf_floatalloc(d->n);
+    d->u2 = sf_floatalloc(d->n);
+    d->dp = sf_floatalloc(d->n);
+    d->p0 = sf_floatalloc(d->n);
+
+    nn[0]=m1;
+    nn[1]=m2;
+    nn[2]=m3;
+
+    d->dv = sf_divn_init_r (3, d->n, nn, rect, niter, verb);
+
+    return d;
+}
+
+void dip3_close_r(dip3solver d)
+/*< free a reentrant estimator >*/
+{
+    free (d->u1);
+    free (d->u2);
+    free (d->dp);
+    free (d->p0);
+    sf_divn_close_r(d->dv);
+    free (d);
+}
 
 void dip3_init(int m1, int m2, int m3 /* dimensions */, 
 	       int* rect              /* smoothing radius [3] */, 
@@ -36,49 +92,38 @@ void dip3_init(int m1, int m2, int m3 /* dimensions */,
 	       bool verb              /* verbosity flag */)
 /*< initialize >*/
 {
-    n1=m1;
-    n2=m2;
-    n3=m3;
-    n = n1*n2*n3;
-    eps = eps1;
-
-    u1 = sf_floatalloc(n);
-    u2 = sf_floatalloc(n);
-    dp = sf_floatalloc(n);
-    p0 = sf_floatalloc(n);
-
-    nn[0]=n1;
-    nn[1]=n2;
-    nn[2]=n3;
-
-    sf_divn_init (3, n, nn, rect, niter, verb);
+    d0 = dip3_init_r(m1,m2,m3,rect,niter,eps1,verb);
 }
 
 void dip3_close(void)
 /*< free allocated storage >*/
 {
-    free (u1);
-    free (u2);
-    free (dp);
-    sf_divn_close();
+    dip3_close_r(d0);
 }
 
-void dip3(bool left               /* left or right prediction */,
-	  int dip                 /* 1 - inline, 2 - crossline */, 
-	  int niter               /* number of nonlinear iterations */, 
-	  int nw                  /* filter size */, 
-	  int nj                  /* filter stretch for aliasing */, 
-	  float *u                /* input data */, 
-	  float* p                /* output dip */, 
-	  bool* mask              /* input mask for known data */,
-	  float pmin, float pmax  /* minimum and maximum dip */)
-/*< estimate local dip >*/
+void dip3_r(dip3solver d,
+	    bool left               /* left or right prediction */,
+	    int dip                 /* 1 - inline, 2 - crossline */, 
+	    int niter               /* number of nonlinear iterations */, 
+	    int nw                  /* filter size */, 
+	    int nj                  /* filter stretch for aliasing */, 
+	    float *u                /* input data */, 
+	    float* p                /* output dip */, 
+	    bool* mask              /* input mask for known data */,
+	    float pmin, float pmax  /* minimum and maximum dip */)
+/*< estimate local dip, reentrant version >*/
 {
-    int i, iter, k;
-    float usum, usum2, pi, lam;
+    int i, iter, k, n;
+    float usum, usum2, pi, lam, *u1, *u2, *dp, *p0;
     allpass ap;
+
+    n = d->n;
+    u1 = d->u1;
+    u2 = d->u2;
+    dp = d->dp;
+    p0 = d->p0;
  
-    ap = allpass_init (nw,nj,n1,n2,n3,p);
+    ap = allpass_init (nw,nj,d->n1,d->n2,d->n3,p);
 
     if (dip == 1) {
 	allpass1 (left, false, ap, u,u2);
@@ -108,7 +153,7 @@ void dip3(bool left               /* left or right prediction */,
 	    }
 	}
 
-	sf_divne (u2, u1, dp, eps);
+	sf_divne_r (d->dv, u2, u1, dp, d->eps);
 
 	lam = 1.;
 	for (k=0; k < 8; k++) {
@@ -135,3 +180,17 @@ void dip3(bool left               /* left or right prediction */,
 
     allpass_close(ap);
 }
+
+void dip3(bool left               /* left or right prediction */,
+	  int dip                 /* 1 - inline, 2 - crossline */, 
+	  int niter               /* number of nonlinear iterations */, 
+	  int nw                  /* filter size */, 
+	  int nj                  /* filter stretch for aliasing */, 
+	  float *u                /* input data */, 
+	  float* p                /* output dip */, 
+	  bool* mask              /* input mask for known data */,
+	  float pmin, float pmax  /* minimum and maximum dip */)
+/*< estimate local dip >*/
+{
+    dip3_r(d0,left,dip,niter,nw,nj,u,p,mask,pmin,pmax);
+}